@@ -0,0 +1,25 @@
+#ifndef _CORE_CARTRIDGEIDENTIFICATION_H
+#define _CORE_CARTRIDGEIDENTIFICATION_H
+
+#include <libdragon.h>
+
+/**
+ * @brief The game type and localization of a cartridge
+ */
+typedef struct CartridgeIdentity
+{
+    uint8_t generation;
+    uint8_t specificGenVersion;
+    uint8_t localization;
+} CartridgeIdentity;
+
+/**
+ * @brief Looks up the cartridge in the table of known retail cartridges (see include/core/KnownCartridges.h),
+ * based on the title, destination code, version number and global checksum fields of its header.
+ *
+ * This way we don't have to probe the ROM over the transfer pak to figure out the game type and language.
+ * @return false if the cartridge isn't known. In that case, you need to fall back to the ROM probing functions of libpokemegb.
+ */
+bool identifyKnownCartridge(const gameboy_cartridge_header& header, CartridgeIdentity& outIdentity);
+
+#endif
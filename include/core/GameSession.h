@@ -0,0 +1,132 @@
+#ifndef _GAMESESSION_H
+#define _GAMESESSION_H
+
+#include "transferpak/TransferPakRomReader.h"
+#include "transferpak/TransferPakSaveManager.h"
+#include "gen1/Gen1GameReader.h"
+#include "gen2/Gen2GameReader.h"
+#include "core/SpeciesTableCache.h"
+#include "save/PokemonBoxIndex.h"
+
+/**
+ * @brief The maximum number of pokémon in the party
+ */
+#define GAME_SESSION_MAX_PARTY_SIZE 6
+
+/**
+ * @brief The size of the buffer of a cached pokémon nickname (10 characters + null terminator)
+ */
+#define GAME_SESSION_NICKNAME_SIZE 11
+
+/**
+ * @brief This class holds the game reader of the cartridge in the transfer pak for as long as PokeMe64 is running.
+ *
+ * It gets started by the InitTransferPakScene once the game has been detected. From then on, the menu functions and scenes
+ * can reuse the same reader instead of constructing a new TransferPakRomReader, TransferPakSaveManager and game reader every time.
+ *
+ * It also caches the save data that the menus need over and over (trainer info, party, current map), so that they don't need to be
+ * read over the transfer pak again. Changes made through the GameSession update the cache (write-through).
+ * Anything that modifies the save in another way (restoring a backup, injecting a pokémon,...) must call invalidate() afterwards.
+ *
+ * WARNING: reading data that isn't cached yet needs SRAM access. So like with the game readers themselves, the caller needs to
+ * enable it (TransferPakManager::setRAMEnabled()) before calling any of the getters.
+ */
+class GameSession
+{
+public:
+    GameSession(TransferPakManager& tpakManager);
+    ~GameSession();
+
+    /**
+     * @brief Creates the game reader for the given game. Any previous session is ended first.
+     */
+    void start(uint8_t generation, uint8_t specificGenVersion, uint8_t localization);
+
+    /**
+     * @brief Destroys the game reader and drops the cached data
+     */
+    void end();
+
+    bool isActive() const;
+    uint8_t getGeneration() const;
+
+    /**
+     * @brief Returns the game reader of the current session or nullptr if the session isn't for a Gen 1 game
+     */
+    Gen1GameReader* getGen1Reader();
+
+    /**
+     * @brief Returns the game reader of the current session or nullptr if the session isn't for a Gen 2 game
+     */
+    Gen2GameReader* getGen2Reader();
+
+    const char* getTrainerName();
+    uint16_t getTrainerID();
+
+    /**
+     * @brief Returns the map the player saved on (Gen 1 only)
+     */
+    uint8_t getGen1CurrentMap();
+
+    uint8_t getGen1PartySize();
+    bool getGen1PartyPokemon(uint8_t partyIndex, Gen1TrainerPokemon& outPoke);
+    const char* getGen1PartyPokemonNickname(uint8_t partyIndex);
+
+    /**
+     * @brief Writes the given pokémon to the party in the save, updates the main checksum and the cache.
+     * This goes through a SaveEditTransaction, so the checksum is updated incrementally and only the modified blocks get written.
+     */
+    bool setGen1PartyPokemon(uint8_t partyIndex, const Gen1TrainerPokemon& poke);
+
+    /**
+     * @brief Returns the index of the PC boxes of the save. It gets built on first use (which needs SRAM access) and is kept
+     * until the session is invalidated.
+     * @return nullptr if we don't know the box layout of this game
+     */
+    const PokemonBoxIndex* getBoxIndex();
+
+    /**
+     * @brief Reads the species tables of the game for at most maxSpecies species. This needs to be called from the frame loop
+     * until it returns true.
+     * @return true if all species tables have been read (or there's no active session)
+     */
+    bool stepSpeciesTables(uint16_t maxSpecies);
+
+    /**
+     * @brief Returns the species names, pokédex numbers, icon types and base stats of the game.
+     * These are read from the ROM in small steps after the session starts (see stepSpeciesTables()) and are kept until the session ends.
+     * Lookups of species that haven't been read yet go to the game reader.
+     */
+    const SpeciesTableCache& getSpeciesTables() const;
+
+    /**
+     * @brief Drops all cached save data. This needs to be called after the save was modified without going through the GameSession.
+     */
+    void invalidate();
+protected:
+private:
+    void loadTrainerInfo();
+    bool loadGen1Party();
+
+    TransferPakManager& tpakManager_;
+    TransferPakRomReader romReader_;
+    TransferPakSaveManager saveManager_;
+    Gen1GameReader* gen1Reader_;
+    Gen2GameReader* gen2Reader_;
+    PokemonBoxIndex* boxIndex_;
+    SpeciesTableCache speciesTables_;
+    Gen1TrainerPokemon gen1PartyPokemon_[GAME_SESSION_MAX_PARTY_SIZE];
+    char gen1PartyNicknames_[GAME_SESSION_MAX_PARTY_SIZE][GAME_SESSION_NICKNAME_SIZE];
+    char trainerName_[16];
+    uint16_t trainerID_;
+    uint8_t generation_;
+    uint8_t specificGenVersion_;
+    uint8_t localization_;
+    uint8_t gen1PartySize_;
+    uint8_t gen1CurrentMap_;
+    bool trainerInfoCached_;
+    bool gen1PartyCached_;
+    bool gen1CurrentMapCached_;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef _CORE_HASH_H
+#define _CORE_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+
+#define FNV1A64_OFFSET_BASIS 0xCBF29CE484222325ull
+
+/**
+ * @brief Calculates the 64 bit FNV-1a hash of the given buffer.
+ *
+ * FNV-1a only needs a multiply and a xor per byte, which is cheap enough on the VR4300
+ * to hash save data while it is being copied.
+ *
+ * You can hash data in multiple steps by passing the result of the previous call as the seed.
+ */
+uint64_t fnv1a64(const uint8_t* data, size_t size, uint64_t seed = FNV1A64_OFFSET_BASIS);
+
+/**
+ * @brief Calculates the CRC-32 (IEEE 802.3, the one zip and the No-Intro dat files use) of the given buffer.
+ *
+ * You can calculate the CRC in multiple steps by passing the result of the previous call as crc.
+ */
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _KNOWNCARTRIDGES_H
+#define _KNOWNCARTRIDGES_H
+
+// This file was generated by tools/generate_known_cartridges.py from tools/known_cartridges.csv. Don't edit it by hand!
+
+#include "gen1/Gen1Common.h"
+#include "gen2/Gen2Common.h"
+
+#define KNOWN_CARTRIDGE_TITLE_SIZE 15
+#define KNOWN_CARTRIDGE_ANY_VERSION 0xFF
+#define KNOWN_CARTRIDGE_ANY_GLOBAL_CHECKSUM 0x0000
+
+/**
+ * @brief The cartridge header fields of a known retail cartridge and the game type/localization it maps to
+ */
+typedef struct KnownCartridge
+{
+    // the title field of the header, including the manufacturer code (0x134-0x142)
+    char title[KNOWN_CARTRIDGE_TITLE_SIZE + 1];
+    uint8_t destinationCode;
+    uint8_t versionNumber;
+    uint16_t globalChecksum;
+    uint8_t generation;
+    uint8_t specificGenVersion;
+    uint8_t localization;
+} KnownCartridge;
+
+#define KNOWN_CARTRIDGE_COUNT 0
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef _CORE_LZCOMPRESSION_H
+#define _CORE_LZCOMPRESSION_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief The maximum number of bytes we compress as a single block.
+ * This keeps every match offset and every hash table position within 16 bits.
+ */
+#define LZ_MAX_BLOCK_SIZE 4096
+
+/**
+ * @brief The number of entries in the hash table used by lzCompressBlock()
+ */
+#define LZ_HASH_TABLE_ENTRIES 2048
+
+/**
+ * @brief Compresses the given block with an LZ4-style byte-oriented codec.
+ *
+ * There's no entropy coding and no bit-level I/O: every sequence is a token byte, the literals and a 2 byte match offset.
+ * That makes both compression and decompression only a handful of instructions per byte on the VR4300, which matters
+ * because we're doing this in between transfer pak reads.
+ *
+ * @param hashTable work buffer of LZ_HASH_TABLE_ENTRIES entries. Its contents don't need to be initialized.
+ * @return the size of the compressed data or 0 if it doesn't fit in dstCapacity bytes
+ * (in which case you should store the block uncompressed)
+ */
+uint16_t lzCompressBlock(const uint8_t* src, uint16_t srcSize, uint8_t* dst, uint16_t dstCapacity, uint16_t* hashTable);
+
+/**
+ * @brief Decompresses a block that was compressed with lzCompressBlock()
+ *
+ * @return the size of the decompressed data or 0 if the compressed data is corrupt
+ */
+uint16_t lzDecompressBlock(const uint8_t* src, uint16_t srcSize, uint8_t* dst, uint16_t dstCapacity);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef _CORE_SPECIESTABLECACHE_H
+#define _CORE_SPECIESTABLECACHE_H
+
+#include "gen1/Gen1GameReader.h"
+#include "gen2/Gen2GameReader.h"
+
+/**
+ * @brief The size of the name buffer of a single species (the decoded name can contain multi-byte UTF-8 characters)
+ */
+#define SPECIES_TABLE_CACHE_NAME_SIZE 20
+
+/**
+ * @brief Everything we keep in RAM about a single species
+ */
+typedef struct SpeciesTableEntry
+{
+    char name[SPECIES_TABLE_CACHE_NAME_SIZE];
+    uint8_t pokedexNumber;
+    uint8_t iconType;
+    bool valid;
+} SpeciesTableEntry;
+
+/**
+ * @brief The ROM table the SpeciesTableCache is currently reading
+ */
+enum class SpeciesTableBuildPhase
+{
+    NONE,
+    POKEDEX_NUMBERS,
+    NAMES,
+    STATS,
+    ICON_TYPES,
+    FINISHED
+};
+
+/**
+ * @brief This class keeps the species names, pokédex numbers, icon types and base stats of every species of the game in RAM.
+ *
+ * Looking any of these up with the game reader means a few small ROM reads over the transfer pak every time.
+ * Instead, the cache goes through each of the ROM tables once, in ascending species order.
+ * Reading all of them takes a while, so this happens in small steps (start() + step()) that are driven from the frame loop,
+ * just like the SaveChecksumValidator. A species only gets marked as cached once all of its tables have been read.
+ * Until then (and for species that aren't in the cache at all, like the Gen 1 MissingNo indices), lookups still go to the game reader.
+ *
+ * The species index is the index the game uses internally. For Gen 2 that's the pokédex number.
+ */
+class SpeciesTableCache
+{
+public:
+    SpeciesTableCache();
+    ~SpeciesTableCache();
+
+    /**
+     * @brief Prepares reading the tables of the 151 species of a Gen 1 game
+     */
+    void start(Gen1GameReader& gameReader);
+
+    /**
+     * @brief Prepares reading the tables of the 251 species of a Gen 2 game.
+     * The Korean version has a different character set that we can't decode, so there we don't cache the names.
+     */
+    void start(Gen2GameReader& gameReader, uint8_t localization);
+
+    /**
+     * @brief Reads the table entries of at most maxSpecies species.
+     * @return true if all tables have been read
+     */
+    bool step(uint16_t maxSpecies);
+
+    /**
+     * @brief Reads all tables of the given Gen 1 game at once
+     */
+    bool build(Gen1GameReader& gameReader);
+
+    /**
+     * @brief Reads all tables of the given Gen 2 game at once
+     */
+    bool build(Gen2GameReader& gameReader, uint8_t localization);
+
+    /**
+     * @brief Returns whether all tables have been read
+     */
+    bool isBuilt() const;
+
+    const char* getPokemonName(uint8_t speciesIndex) const;
+    uint8_t getPokemonNumber(uint8_t speciesIndex) const;
+    uint8_t getPokemonIconType(uint8_t speciesIndex) const;
+
+    bool getGen1PokeStats(uint8_t speciesIndex, Gen1PokeStats& outStats) const;
+    bool getGen2PokeStats(uint8_t speciesIndex, Gen2PokeStats& outStats) const;
+
+    /**
+     * @brief Frees the tables. This needs to happen when the cartridge session ends.
+     */
+    void reset();
+protected:
+private:
+    /**
+     * @brief Reads the entry of the given species in the table of the current build phase
+     */
+    void readTableEntry(uint8_t speciesIndex);
+
+    Gen1GameReader* gen1Reader_;
+    Gen2GameReader* gen2Reader_;
+    // indexed by the species index, so a lookup doesn't need to search
+    SpeciesTableEntry* entries_;
+    Gen1PokeStats* gen1Stats_;
+    Gen2PokeStats* gen2Stats_;
+    uint64_t buildStartTime_;
+    uint16_t buildIndex_;
+    uint16_t maxSpeciesIndex_;
+    SpeciesTableBuildPhase buildPhase_;
+    bool cacheNames_;
+};
+
+#endif
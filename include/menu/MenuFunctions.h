@@ -15,6 +15,15 @@ extern const DataCopyOperation DATACOPY_BACKUP_SAVE;
 extern const DataCopyOperation DATACOPY_BACKUP_ROM;
 extern const DataCopyOperation DATACOPY_RESTORE_SAVE;
 extern const DataCopyOperation DATACOPY_WIPE_SAVE;
+extern const DataCopyOperation DATACOPY_BACKUP_SAVE_SNAPSHOT;
+extern const DataCopyOperation DATACOPY_RESTORE_SAVE_SNAPSHOT;
+extern const DataCopyOperation DATACOPY_EXPORT_SAVE_SNAPSHOT;
+extern const DataCopyOperation DATACOPY_BACKUP_SAVE_COMPRESSED;
+extern const DataCopyOperation DATACOPY_BACKUP_ROM_COMPRESSED;
+extern const DataCopyOperation DATACOPY_BACKUP_SAVE_AND_ROM;
+extern const DataCopyOperation DATACOPY_CLONE_SAVE;
+extern const DataCopyOperation DATACOPY_BACKUP_SAVE_CONTROLLER_PAK;
+extern const DataCopyOperation DATACOPY_RESTORE_SAVE_CONTROLLER_PAK;
 
 extern const uint16_t GEN2_EVENTFLAG_DECORATION_PIKACHU_BED;
 extern const uint16_t GEN2_EVENTFLAG_DECORATION_UNOWN_DOLL;
@@ -28,6 +37,9 @@ void goToTestScene(void* context, const void* param);
 void goToPokeTransporterGBRef(void* context, const void* param);
 void goToAboutScene(void* context, const void* param);
 void goToDataCopyScene(void* context, const void* param);
+void goToSaveLibraryScene(void* context, const void* param);
+void goToPokemonBoxBrowserScene(void* context, const void* param);
+void goToPokemonImportScene(void* context, const void* param);
 void goToGen1MovesMenu(void* context, const void* param);
 void goToGen1DistributionPokemonMenu(void* context, const void* param);
 void goToGen2DistributionPokemonMenu(void* context, const void* param);
@@ -100,6 +112,14 @@ void gen2ReceiveGSBall(void* context, const void* param);
  */
 void gen2SetEventFlag(void* context, const void* param);
 
+/**
+ * This function will set the event flags of all gen II decorations that PokeMe64 can unlock in a single save edit
+ *
+ * @param context a MenuScene*
+ * @param param a nullpointer (dummy param)
+ */
+void gen2SetAllDecorationEventFlags(void* context, const void* param);
+
 /**
  * This function will ask for confirmation to wipe a save from the cartridge.
  *
@@ -107,6 +127,13 @@ void gen2SetEventFlag(void* context, const void* param);
  */
 void askConfirmationWipeSave(void* context, const void* param);
 
+/**
+ * This function will ask for confirmation to overwrite the save of the cartridge in the transfer pak of another controller.
+ *
+ * If confirmed by the user, the DataCopyScene will be navigated to with the DATACOPY_CLONE_SAVE command
+ */
+void askConfirmationCloneSave(void* context, const void* param);
+
 /**
  * This function will change an SRAM field to let gen 2 games prompt you
  * to reconfigure the game clock
@@ -116,4 +143,13 @@ void askConfirmationWipeSave(void* context, const void* param);
  */
 void resetRTC(void* context, const void* param);
 
+/**
+ * This function will revert the last change that PokeMe64 made to the save of the cartridge
+ * by writing back the original blocks from the undo journal on the SD card.
+ *
+ * @param context a MenuScene* context
+ * @param param a nullpointer (dummy param)
+ */
+void undoLastSaveChange(void* context, const void* param);
+
 #endif
\ No newline at end of file
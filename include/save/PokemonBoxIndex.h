@@ -0,0 +1,135 @@
+#ifndef _POKEMONBOXINDEX_H
+#define _POKEMONBOXINDEX_H
+
+#include "transferpak/TransferPakSaveManager.h"
+#include "core/SpeciesTableCache.h"
+
+/**
+ * @brief The maximum number of PC boxes of any supported game (Gen 2 has 14, Gen 1 has 12)
+ */
+#define POKEMON_BOX_INDEX_MAX_BOXES 14
+
+/**
+ * @brief The number of pokémon a single PC box can hold
+ */
+#define POKEMON_BOX_INDEX_SLOTS_PER_BOX 20
+
+/**
+ * @brief The offset of the first pokémon record in a PC box (it follows the count and the species list)
+ */
+#define POKEMON_BOX_RECORDS_OFFSET 0x16
+
+/**
+ * @brief The size of an (encoded) original trainer name or nickname in the save
+ */
+#define POKEMON_BOX_NAME_SIZE 11
+
+/**
+ * @brief PokemonBoxIndexEntry flag: the pokémon in this slot is an egg (Gen 2 only)
+ */
+#define POKEMON_BOX_INDEX_FLAG_EGG 0x1
+
+/**
+ * @brief The summary of a single occupied PC box slot
+ */
+typedef struct PokemonBoxIndexEntry
+{
+    // absolute SRAM offset of the box pokémon record of this slot
+    uint16_t recordOffset;
+    // absolute SRAM offset of the (encoded) nickname of this slot
+    uint16_t nicknameOffset;
+    uint8_t speciesIndex;
+    uint8_t level;
+    uint8_t iconType;
+    uint8_t flags;
+} PokemonBoxIndexEntry;
+
+/**
+ * @brief Describes where the PC boxes are stored in the save of a specific game
+ */
+typedef struct PokemonBoxLayout
+{
+    // SRAM offsets of the first box in bank 2 and bank 3
+    uint32_t bankOffsets[2];
+    uint32_t boxStride;
+    // the box that is currently selected in the game is stored in this copy instead of in its own slot
+    uint32_t currentBoxCopyOffset;
+    uint32_t currentBoxIndexOffset;
+    uint8_t currentBoxIndexMask;
+    // if non-zero: this bit of the current box index byte needs to be set, otherwise the other boxes haven't been initialized yet (Gen 1)
+    uint8_t boxesInitializedMask;
+    uint8_t numBoxes;
+    uint8_t boxesPerBank;
+    uint8_t recordSize;
+    // offset of the level inside a box pokémon record
+    uint8_t levelOffset;
+    // the party is stored like a box, but with 6 slots and larger records (which include the current stats)
+    uint32_t partyOffset;
+    uint8_t partyRecordSize;
+} PokemonBoxLayout;
+
+/**
+ * @brief Looks up where the party and the PC boxes are stored in the save of the given game.
+ * @return false if we don't know the layout for this game/localization (only the international versions are known)
+ */
+bool getPokemonBoxLayout(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, PokemonBoxLayout& outLayout);
+
+/**
+ * @brief Returns the SRAM offset of the given box. For the box that is currently selected in the game, this is the offset of its copy in bank 1.
+ */
+uint32_t getPokemonBoxOffset(const PokemonBoxLayout& layout, uint8_t boxIndex, uint8_t currentBoxIndex);
+
+/**
+ * @brief This class builds a compact index of all the PC boxes of a save in a single sequential pass over the box banks.
+ *
+ * Reading a box with the game reader means reading (and decoding) the whole box over the transfer pak. Doing that every time
+ * the user scrolls through the boxes would be way too slow. Instead, we only keep what a box list needs to display
+ * (species, level, icon type) and where the full record can be found. The full pokémon only gets read when the user opens a slot.
+ *
+ * We only know the box layout of the international versions (see getPokemonBoxLayout()). build() returns false for the other localizations.
+ *
+ * WARNING: build() needs SRAM access. The caller needs to enable it (TransferPakManager::setRAMEnabled()) first.
+ */
+class PokemonBoxIndex
+{
+public:
+    PokemonBoxIndex(TransferPakManager& pakManager);
+
+    /**
+     * @brief Builds the index of the save of the given game. The icon types come from the species tables.
+     */
+    bool build(const SpeciesTableCache& speciesTables, uint8_t generation, uint8_t specificGenVersion, uint8_t localization);
+
+    bool isBuilt() const;
+
+    uint8_t getNumberOfBoxes() const;
+
+    /**
+     * @brief Returns the (0-based) index of the box that is currently selected in the game
+     */
+    uint8_t getCurrentBoxIndex() const;
+
+    uint8_t getNumberOfPokemon(uint8_t boxIndex) const;
+
+    /**
+     * @brief Returns the entry of the given slot or nullptr if the slot is empty
+     */
+    const PokemonBoxIndexEntry* getEntry(uint8_t boxIndex, uint8_t slotIndex) const;
+
+    /**
+     * @brief Drops the index. It needs to be built again after the save was modified.
+     */
+    void reset();
+protected:
+private:
+    bool indexBox(const PokemonBoxLayout& layout, uint8_t boxIndex, uint32_t boxOffset, const SpeciesTableCache& speciesTables, bool hasEggs);
+
+    TransferPakSaveManager saveManager_;
+    PokemonBoxIndexEntry entries_[POKEMON_BOX_INDEX_MAX_BOXES][POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+    uint8_t numPokemon_[POKEMON_BOX_INDEX_MAX_BOXES];
+    uint8_t numBoxes_;
+    uint8_t currentBoxIndex_;
+    bool built_;
+};
+
+#endif
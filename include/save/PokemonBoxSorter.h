@@ -0,0 +1,65 @@
+#ifndef _POKEMONBOXSORTER_H
+#define _POKEMONBOXSORTER_H
+
+#include "save/PokemonBoxIndex.h"
+
+enum class PokemonBoxSortKey
+{
+    // by pokédex number. Eggs go last
+    SPECIES,
+    // highest level first. Pokémon of the same level are sorted by pokédex number
+    LEVEL
+};
+
+/**
+ * @brief The result of PokemonBoxSorter::sortBoxes()
+ */
+typedef struct PokemonBoxSortResult
+{
+    uint8_t numSortedBoxes;
+    uint16_t numMovedPokemon;
+    // the number of bytes that were actually written to SRAM (whole transfer pak blocks, checksums included)
+    uint32_t numBytesWritten;
+    // the number of bytes we would have written if we had rewritten every box
+    uint32_t numBytesFullRewrite;
+} PokemonBoxSortResult;
+
+/**
+ * @brief This class sorts every PC box on its own.
+ *
+ * The new order of every box is determined from the PokemonBoxIndex, so that doesn't need to read the save.
+ * Every box that isn't sorted yet becomes a single SORT_BOX edit in one SaveEditTransaction. That edit only moves the pokémon
+ * that don't end up in the same slot (cycle by cycle), so only the blocks of those slots get modified.
+ * All modified blocks are written at the end in ascending order (and therefore bank by bank) and the checksums are only updated once.
+ * The write is covered by the SaveUndoJournal.
+ *
+ * WARNING: sortBoxes() needs SRAM access. The caller needs to enable it (TransferPakManager::setRAMEnabled()) first.
+ */
+class PokemonBoxSorter
+{
+public:
+    PokemonBoxSorter(TransferPakManager& pakManager);
+
+    /**
+     * @brief Sorts every box of the given box index by the given key.
+     * @param speciesTables used to convert the species indices into pokédex numbers
+     * @return false if the box index doesn't match this game or if writing to the cartridge failed
+     */
+    bool sortBoxes(const PokemonBoxIndex& boxIndex, PokemonBoxSortKey key, const SpeciesTableCache& speciesTables, uint8_t generation, uint8_t specificGenVersion, uint8_t localization, PokemonBoxSortResult& outResult);
+protected:
+private:
+    /**
+     * @brief Determines the new order of the given box.
+     * @return the number of pokémon that end up in a different slot
+     */
+    uint8_t getSortedOrder(const PokemonBoxIndex& boxIndex, uint8_t box, PokemonBoxSortKey key, const SpeciesTableCache& speciesTables, uint8_t* outSourceSlots);
+
+    /**
+     * @brief Returns the value to sort on for the given pokémon. Lower values come first
+     */
+    uint16_t getSortValue(const PokemonBoxIndexEntry& entry, PokemonBoxSortKey key, const SpeciesTableCache& speciesTables);
+
+    TransferPakManager& pakManager_;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef _POKEMONEXPORTER_H
+#define _POKEMONEXPORTER_H
+
+#include "save/PokemonBoxIndex.h"
+
+/**
+ * @brief The size of a .pk1 file: a single-entry party list (count, species, terminator), the party record (44 bytes),
+ * the original trainer name and the nickname
+ */
+#define POKEMON_EXPORTER_PK1_SIZE 69
+
+/**
+ * @brief The size of a .pk2 file: a single-entry party list (count, species, terminator), the party record (48 bytes),
+ * the original trainer name and the nickname
+ */
+#define POKEMON_EXPORTER_PK2_SIZE 73
+
+/**
+ * @brief The size of the buffer that holds the path of the export directory
+ */
+#define POKEMON_EXPORTER_DIRECTORY_SIZE 48
+
+/**
+ * @brief This class exports every pokémon of the party and the PC boxes to its own .pk1/.pk2 file in sd:/PokeMe64/export/<trainer>/.
+ * These are the formats that PKHeX can import.
+ *
+ * The export happens in steps: every step() reads one whole list (the party or a box) from SRAM in a single read and
+ * writes all of its pokémon to the SD card afterwards. The lists are processed in the order in which they are stored
+ * (party and current box in bank 1, then the other boxes in bank 2 and 3), so SRAM is read in a single forward pass.
+ * Because every file is assembled in RAM first, each one gets written with a single write call.
+ *
+ * Box pokémon don't have the party-only fields (current stats). These are left at 0, except for the level.
+ *
+ * WARNING: step() needs SRAM access. The caller needs to enable it (TransferPakManager::setRAMEnabled()) first.
+ */
+class PokemonExporter
+{
+public:
+    PokemonExporter(TransferPakManager& pakManager);
+
+    /**
+     * @brief Prepares the export and creates the output directory.
+     * @return false if we don't know the layout of the save of this game or if the directory couldn't be created
+     */
+    bool start(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, const char* trainerName);
+
+    /**
+     * @brief Exports the next list (the party or a box).
+     * @return true once the export is finished
+     */
+    bool step();
+
+    bool isStarted() const;
+    bool isFinished() const;
+
+    /**
+     * @brief Returns whether reading the save or writing one of the files failed. The export stops at the first failure.
+     */
+    bool hasFailed() const;
+
+    uint16_t getNumberOfExportedPokemon() const;
+
+    /**
+     * @brief Returns the progress of the export in percent
+     */
+    uint8_t getProgress() const;
+
+    const char* getOutputDirectory() const;
+
+    void reset();
+protected:
+private:
+    /**
+     * @brief Reads the list at the given offset and writes each of its pokémon to its own file
+     * @param listNumber 0 for the party, the (1-based) box number otherwise
+     */
+    bool exportList(uint32_t listOffset, uint8_t capacity, uint8_t recordSize, uint8_t listNumber);
+
+    TransferPakSaveManager saveManager_;
+    PokemonBoxLayout layout_;
+    // holds the files of a single list until they are written
+    uint8_t fileBuffer_[POKEMON_BOX_INDEX_SLOTS_PER_BOX * POKEMON_EXPORTER_PK2_SIZE];
+    char outputDirectory_[POKEMON_EXPORTER_DIRECTORY_SIZE];
+    uint16_t numExported_;
+    uint8_t generation_;
+    uint8_t currentBoxIndex_;
+    // 0 = party, 1 = current box, 2 and up = the other boxes in the order in which they're stored
+    uint8_t nextStep_;
+    uint8_t numSteps_;
+    bool boxesInitialized_;
+    bool started_;
+    bool finished_;
+    bool failed_;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef _POKEMONIMPORTER_H
+#define _POKEMONIMPORTER_H
+
+#include "save/PokemonExporter.h"
+
+class SaveEditTransaction;
+
+/**
+ * @brief The directory from which the .pk1/.pk2 files are imported
+ */
+#define POKEMON_IMPORTER_DIRECTORY "sd:/PokeMe64/import"
+
+/**
+ * @brief The maximum number of files that can be imported at once. Every file is a separate edit in the SaveEditTransaction
+ */
+#define POKEMON_IMPORTER_MAX_FILES 40
+
+/**
+ * @brief The result of PokemonImporter::importFiles()
+ */
+typedef struct PokemonImportResult
+{
+    uint8_t numImported;
+    // files that couldn't be read or aren't a valid .pk1/.pk2 file for this game
+    uint8_t numInvalid;
+    // valid files for which there was no free box slot left
+    uint8_t numNoRoom;
+    // the number of bytes that were actually written to SRAM (whole transfer pak blocks, checksums included)
+    uint32_t numBytesWritten;
+} PokemonImportResult;
+
+/**
+ * @brief Checks whether the given .pk1 (generation 1) or .pk2 (generation 2) file contains a sane pokémon.
+ * It also converts the file in place into what we need to store it in a box: a Gen 1 box record keeps the level in a different spot
+ * than the party record.
+ *
+ * @return false if the file is invalid and must not be imported
+ */
+bool validatePokemonFile(uint8_t generation, uint8_t* file, uint32_t fileSize);
+
+/**
+ * @brief This class imports .pk1/.pk2 files (like the ones written by PokemonExporter or PKHeX) into free PC box slots.
+ *
+ * All files are read, validated and converted in RAM first. The box counts are read from SRAM once to determine the free slots.
+ * The pokémon are placed in the current box first and then in the other boxes in the order in which they're stored.
+ * (The party is left alone, just like the game does when you catch a pokémon with a full party).
+ *
+ * All pokémon are written with a single SaveEditTransaction, so every modified block is written once
+ * and the checksums are only updated once at the end. The write is covered by the SaveUndoJournal.
+ *
+ * WARNING: importFiles() needs SRAM access. The caller needs to enable it (TransferPakManager::setRAMEnabled()) first.
+ */
+class PokemonImporter
+{
+public:
+    PokemonImporter(TransferPakManager& pakManager);
+
+    /**
+     * @brief Imports the files at the given paths into free box slots.
+     * @return false if we don't know the layout of the save of this game or if writing to the cartridge failed
+     */
+    bool importFiles(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, const char* const* paths, uint8_t numPaths, PokemonImportResult& outResult);
+
+    /**
+     * @brief Imports numFiles .pk1/.pk2 files that are already in RAM (stored one after another in files) into free box slots.
+     * Unlike importFiles(), this is all or nothing: if any of the queued pokémon doesn't get its slot, nothing gets written.
+     *
+     * @param outImported receives for every file whether it was imported. May be nullptr
+     * @return false if we don't know the layout of the save of this game or if nothing could be written
+     */
+    bool importPokemon(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, uint8_t* files, uint8_t numFiles, bool* outImported, PokemonImportResult& outResult);
+protected:
+private:
+    /**
+     * @brief Queues the given (validated) file in the transaction for the first box with a free slot, in the order of boxOrder_
+     * @return false if there's no free slot left
+     */
+    bool queuePokemon(SaveEditTransaction& transaction, const uint8_t* file, uint8_t numUsableBoxes, uint8_t& boxOrderIndex);
+
+    /**
+     * @brief Commits the transaction, covered by the SaveUndoJournal
+     */
+    bool commitTransaction(SaveEditTransaction& transaction, uint16_t& outNumBlocksWritten);
+
+    /**
+     * @brief Reads the number of pokémon of every box and determines the order in which we fill the boxes.
+     * @return the number of boxes we can use
+     */
+    uint8_t readFreeSlots(const PokemonBoxLayout& layout);
+
+    /**
+     * @brief Reads the file at the given path into fileBuffer_
+     * @return the size of the file (up to the size of the buffer) or 0 if it couldn't be read
+     */
+    uint32_t readFile(const char* path);
+
+    TransferPakManager& pakManager_;
+    TransferPakSaveManager saveManager_;
+    // one more byte than a .pk2 file, so we can tell whether a file is too large
+    uint8_t fileBuffer_[POKEMON_EXPORTER_PK2_SIZE + 1];
+    uint8_t boxOrder_[POKEMON_BOX_INDEX_MAX_BOXES];
+    uint8_t freeSlots_[POKEMON_BOX_INDEX_MAX_BOXES];
+};
+
+#endif
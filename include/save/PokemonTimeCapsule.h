@@ -0,0 +1,127 @@
+#ifndef _POKEMONTIMECAPSULE_H
+#define _POKEMONTIMECAPSULE_H
+
+#include "save/PokemonImporter.h"
+#include "core/SpeciesTableCache.h"
+#include "transferpak/TransferPakManager.h"
+#include "transferpak/TransferPakRomReader.h"
+
+/**
+ * @brief The highest pokédex number that exists in Gen 1
+ */
+#define POKEMON_TIME_CAPSULE_GEN1_NUM_SPECIES 151
+
+enum class PokemonTimeCapsuleStatus
+{
+    OK,
+    // there's no transfer pak on any of the other controller ports
+    NO_SECOND_TRANSFER_PAK,
+    // the cartridge in the second transfer pak couldn't be read or isn't a pokémon game for which we know the box layout
+    UNSUPPORTED_GAME,
+    // the cartridge in the second transfer pak doesn't have a valid save
+    INVALID_SAVE,
+    // reading or writing one of the cartridges failed
+    TRANSFER_FAILED
+};
+
+/**
+ * @brief The result of PokemonTimeCapsule::moveBox()
+ */
+typedef struct PokemonTimeCapsuleResult
+{
+    uint8_t numMoved;
+    // pokémon that can't exist in the destination game (Gen 2 species, Gen 2 moves or eggs going to Gen 1)
+    uint8_t numIncompatible;
+    // pokémon for which there was no free box slot left on the destination cartridge
+    uint8_t numNoRoom;
+    // the number of bytes that were actually written to the SRAM of each cartridge (whole transfer pak blocks, checksums included)
+    uint32_t numBytesWrittenSource;
+    uint32_t numBytesWrittenDestination;
+} PokemonTimeCapsuleResult;
+
+/**
+ * @brief This class moves pokémon between the cartridges in two transfer paks, converting them between Gen 1 and Gen 2 on the way.
+ * It's the N64 version of the Time Capsule, without the second gameboy and the link cable.
+ *
+ * The source cartridge is the one of the session (in the transfer pak of SceneDependencies). The destination cartridge is the one
+ * in the transfer pak on any of the other controller ports. This class keeps its own TransferPakManager, game identification and
+ * species tables for it. Both need to stay in their transfer paks until moveBox() returns.
+ *
+ * A whole box is moved in a single pass:
+ * - The source box is read from SRAM with a single read.
+ * - Every pokémon gets converted in RAM into the .pk1/.pk2 format of the destination game (see PokemonExporter).
+ *   Just like the Time Capsule, pokémon that didn't exist in Gen 1 (species, moves or eggs) stay where they are.
+ *   Held items and Gen 1 catch rates are converted with the Time Capsule table. Gen 2-only data (friendship, pokérus, caught data) gets lost.
+ * - All of them are written to the destination cartridge with a single SaveEditTransaction (see PokemonImporter::importPokemon()).
+ * - Only then, the moved pokémon are removed from the source box with a single SaveEditTransaction.
+ * So every modified block is written once and the checksums of each cartridge are only updated once. If anything goes wrong
+ * in between, you end up with a copy of a pokémon on both cartridges, but you never lose one.
+ *
+ * Both transactions are covered by the SaveUndoJournal. Because there's only one journal, the source cartridge's (the last one) is kept.
+ */
+class PokemonTimeCapsule
+{
+public:
+    PokemonTimeCapsule(TransferPakManager& sourcePakManager);
+    ~PokemonTimeCapsule();
+
+    /**
+     * @brief Looks for the cartridge in the second transfer pak, identifies the game, validates its save and reads its species tables.
+     * The second transfer pak stays powered on until closeDestination() is called.
+     */
+    PokemonTimeCapsuleStatus openDestination();
+
+    /**
+     * @brief Powers off the second transfer pak and releases the species tables of its game (also done by the destructor)
+     */
+    void closeDestination();
+
+    bool isDestinationOpen() const;
+    joypad_port_t getDestinationPort() const;
+    uint8_t getDestinationGeneration() const;
+
+    /**
+     * @brief Moves every pokémon of the given box of the source cartridge (that can exist in the destination game) to free box slots
+     * on the destination cartridge. Both cartridges need to be opened. SRAM access gets enabled and disabled by this function.
+     */
+    PokemonTimeCapsuleStatus moveBox(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, const SpeciesTableCache& speciesTables, uint8_t boxIndex, PokemonTimeCapsuleResult& outResult);
+protected:
+private:
+    /**
+     * @brief Determines the generation, game and language of the destination cartridge
+     */
+    bool identifyDestinationGame();
+
+    /**
+     * @brief Reads the whole given box of the source cartridge into boxBuffer_
+     * @return the number of pokémon in the box or 0xFF if the box couldn't be read
+     */
+    uint8_t readSourceBox(const PokemonBoxLayout& layout, uint8_t boxIndex);
+
+    /**
+     * @brief Converts the pokémon in the given slot of boxBuffer_ into a .pk1/.pk2 file for the destination game
+     * @return false if the pokémon can't exist in the destination game
+     */
+    bool convertPokemon(uint8_t sourceGeneration, const PokemonBoxLayout& sourceLayout, const SpeciesTableCache& sourceSpeciesTables, uint8_t slotIndex, uint8_t* outFile);
+
+    TransferPakManager& sourcePakManager_;
+    TransferPakManager destinationPakManager_;
+    TransferPakRomReader destinationRomReader_;
+    TransferPakSaveManager destinationSaveManager_;
+    // only needed for a Gen 1 destination: a Gen 2 box record doesn't contain anything that depends on the species tables
+    Gen1GameReader* destinationGen1Reader_;
+    SpeciesTableCache destinationSpeciesTables_;
+    // the Gen 1 species index of every pokédex number
+    uint8_t destinationSpeciesIndices_[POKEMON_TIME_CAPSULE_GEN1_NUM_SPECIES + 1];
+    // count + species list + records + original trainer names + nicknames of the largest box (a Gen 1 box)
+    uint8_t boxBuffer_[POKEMON_BOX_RECORDS_OFFSET + POKEMON_BOX_INDEX_SLOTS_PER_BOX * (33 + 2 * POKEMON_BOX_NAME_SIZE)];
+    uint8_t fileBuffer_[POKEMON_BOX_INDEX_SLOTS_PER_BOX * POKEMON_EXPORTER_PK2_SIZE];
+    // the source slot of every file in fileBuffer_
+    uint8_t fileSourceSlots_[POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+    uint8_t destinationGeneration_;
+    uint8_t destinationSpecificGenVersion_;
+    uint8_t destinationLocalization_;
+    bool destinationOpen_;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef _SAVEBACKUPSTORE_H
+#define _SAVEBACKUPSTORE_H
+
+#include "transferpak/TransferPakDataCopier.h"
+
+#include <cstdint>
+
+/**
+ * @brief The size of the blocks in which we split the SRAM data before storing it.
+ * Gen 1/2 saves are 32 KB, so that gives us 32 blocks per snapshot.
+ *
+ * Smaller blocks deduplicate better, but every unique block is a separate file on the SD card.
+ * And creating files is much slower on the SD card than writing a few more bytes into one.
+ */
+#define SAVE_BACKUP_STORE_BLOCK_SIZE 1024
+
+/**
+ * @brief The maximum number of blocks in a snapshot. (128 KB: the largest SRAM size a gameboy cartridge header can indicate)
+ */
+#define SAVE_BACKUP_STORE_MAX_BLOCKS 128
+
+/**
+ * @brief The default directory in which the unique blocks are stored
+ */
+#define SAVE_BACKUP_STORE_DEFAULT_DIRECTORY "sd:/PokeMe64/store"
+
+/**
+ * @brief This is the header of a snapshot manifest file.
+ * It is followed by numBlocks uint64_t hashes: one for every block of the snapshot (in order).
+ */
+typedef struct SaveSnapshotManifestHeader
+{
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t blockSize;
+    uint32_t totalSize;
+    uint32_t numBlocks;
+} SaveSnapshotManifestHeader;
+
+/**
+ * @brief This class implements a content-addressed block store on the SD card.
+ *
+ * A save snapshot is split into blocks of SAVE_BACKUP_STORE_BLOCK_SIZE bytes. Every block is stored
+ * as a file named after the hash of its contents. If a file for that hash already exists, we don't need to write it again.
+ *
+ * This means that repeated backups of the same cartridge only cost us the blocks that actually changed
+ * plus a small manifest file that lists the hashes of the blocks.
+ */
+class SaveBackupStore
+{
+public:
+    SaveBackupStore(const char* storeDirectory = SAVE_BACKUP_STORE_DEFAULT_DIRECTORY);
+    ~SaveBackupStore();
+
+    /**
+     * @brief Creates the store directory if it doesn't exist yet.
+     */
+    bool prepare();
+
+    /**
+     * @brief Stores the given block if the store doesn't contain it yet.
+     *
+     * @param outHash the hash of the block. This is what you need to store in the manifest
+     * @param outWritten indicates whether we actually had to write the block to the SD card
+     */
+    bool storeBlock(const uint8_t* data, uint16_t size, uint64_t& outHash, bool& outWritten);
+
+    /**
+     * @brief Loads the block with the specified hash into outData
+     */
+    bool loadBlock(uint64_t hash, uint8_t* outData, uint16_t size);
+protected:
+private:
+    /**
+     * @brief Compares the contents of the block file at the given path with the given data
+     */
+    bool isStoredBlockEqual(const char* blockPath, const uint8_t* data, uint16_t size);
+
+    void buildBlockPath(char* outPath, size_t bufferSize, uint64_t hash, bool createSubDirectory);
+
+    const char* storeDirectory_;
+};
+
+/**
+ * @brief This ITransferPakDataCopyDestination implementation writes the incoming save data into a SaveBackupStore
+ * and writes a snapshot manifest file when closed.
+ */
+class SaveSnapshotCopyDestination : public ITransferPakDataCopyDestination
+{
+public:
+    SaveSnapshotCopyDestination(SaveBackupStore& store, const char* manifestPath);
+    virtual ~SaveSnapshotCopyDestination();
+
+    bool readyForTransfer() const override;
+
+    uint16_t getCurrentBankIndex() const override;
+    uint32_t getNumberOfBytesWritten() const override;
+
+    uint32_t write(uint8_t* buffer, uint32_t bytesToWrite) override;
+
+    void close() override;
+
+    /**
+     * @brief Returns the number of blocks in the snapshot so far
+     */
+    uint32_t getNumberOfBlocks() const;
+
+    /**
+     * @brief Returns the number of blocks we actually had to write to the SD card
+     * (because the store didn't contain them yet)
+     */
+    uint32_t getNumberOfNewBlocks() const;
+
+    /**
+     * @brief Returns whether storing any of the blocks or writing the manifest failed. This stays valid after close()
+     */
+    bool hasFailed() const;
+protected:
+private:
+    bool flushBlock();
+
+    SaveBackupStore& store_;
+    char* manifestPath_;
+    uint64_t blockHashes_[SAVE_BACKUP_STORE_MAX_BLOCKS];
+    uint8_t blockBuffer_[SAVE_BACKUP_STORE_BLOCK_SIZE];
+    uint32_t bytesWritten_;
+    uint16_t blockBufferUsed_;
+    uint16_t numBlocks_;
+    uint16_t numNewBlocks_;
+    bool failed_;
+    bool closed_;
+};
+
+/**
+ * @brief This ITransferPakDataCopySource implementation reconstructs the save data of a snapshot manifest
+ * from the blocks in the SaveBackupStore.
+ *
+ * Every block gets loaded and verified when the instance is created. If any of them is missing or corrupt, readyForTransfer()
+ * returns false, so the snapshot is refused before anything gets written to the cartridge.
+ */
+class SaveSnapshotCopySource : public ITransferPakDataCopySource
+{
+public:
+    SaveSnapshotCopySource(SaveBackupStore& store, const char* manifestPath);
+    virtual ~SaveSnapshotCopySource();
+
+    bool readyForTransfer() const override;
+
+    uint16_t getCurrentBankIndex() const override;
+    uint32_t getNumberOfBytesRead() const override;
+
+    uint32_t read(uint8_t* buffer, uint32_t bytesToRead) override;
+
+    /**
+     * @brief Returns the size of the save data described by the manifest
+     */
+    uint32_t getTotalSize() const;
+protected:
+private:
+    SaveBackupStore& store_;
+    SaveSnapshotManifestHeader header_;
+    uint64_t blockHashes_[SAVE_BACKUP_STORE_MAX_BLOCKS];
+    uint8_t blockBuffer_[SAVE_BACKUP_STORE_BLOCK_SIZE];
+    uint32_t bytesRead_;
+    int32_t loadedBlockIndex_;
+    bool valid_;
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef _SAVECHECKSUM_H
+#define _SAVECHECKSUM_H
+
+#include "transferpak/TransferPakSaveManager.h"
+
+class TransferPakManager;
+
+/**
+ * @brief A region of the save that is covered by a checksum
+ */
+typedef struct SaveChecksumRegion
+{
+    uint32_t startOffset;
+    // inclusive
+    uint32_t endOffset;
+    uint32_t checksumOffset;
+} SaveChecksumRegion;
+
+/**
+ * @brief Looks up the region of the save that is covered by the main checksum.
+ *
+ * Gen 1 stores the inverted 8 bit sum of this region. Gen 2 stores the 16 bit sum in little endian.
+ * @return false if we don't know the layout for this game/localization
+ */
+bool getMainChecksumRegion(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, SaveChecksumRegion& outRegion);
+
+/**
+ * @brief This class validates the main checksum of the save on the cartridge in small steps.
+ *
+ * Reading the whole checksummed region over the transfer pak takes a while. By only processing a limited number of bytes
+ * every frame, the UI can keep rendering (and show the progress) in the meantime.
+ */
+class SaveChecksumValidator
+{
+public:
+    SaveChecksumValidator(TransferPakManager& pakManager);
+
+    /**
+     * @brief Prepares the validation of the save of the given game.
+     * @return false if we don't know the checksum layout of the game. Use the game reader instead in that case.
+     */
+    bool start(uint8_t generation, uint8_t specificGenVersion, uint8_t localization);
+
+    /**
+     * @brief Processes at most maxBytes of the checksummed region. SRAM access must be enabled by the caller.
+     * @return true once the validation is finished
+     */
+    bool step(uint32_t maxBytes);
+
+    bool isStarted() const;
+    bool isFinished() const;
+
+    /**
+     * @brief Returns whether the checksum matched. Only meaningful once isFinished() returns true.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Returns the progress of the validation in percent
+     */
+    uint8_t getProgress() const;
+
+    /**
+     * @brief Resets the validator to its initial state
+     */
+    void reset();
+protected:
+private:
+    TransferPakSaveManager saveManager_;
+    SaveChecksumRegion region_;
+    uint32_t currentOffset_;
+    uint32_t byteSum_;
+    uint8_t generation_;
+    bool started_;
+    bool finished_;
+    bool valid_;
+};
+
+#endif
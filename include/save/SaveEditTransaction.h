@@ -0,0 +1,222 @@
+#ifndef _SAVEEDITTRANSACTION_H
+#define _SAVEEDITTRANSACTION_H
+
+#include "transferpak/TransferPakRomReader.h"
+#include "transferpak/TransferPakOverlaySaveManager.h"
+#include "save/PokemonExporter.h"
+#include "gen1/Gen1GameReader.h"
+#include "gen2/Gen2GameReader.h"
+
+/**
+ * @brief The maximum number of edits that can be queued in a single SaveEditTransaction
+ */
+#define SAVE_EDIT_TRANSACTION_MAX_EDITS 64
+
+enum class SaveEditType
+{
+    GEN1_SET_PARTY_POKEMON,
+    GEN1_ADD_POKEMON,
+    GEN2_ADD_POKEMON,
+    GEN2_SET_EVENT_FLAG,
+    GEN2_UNLOCK_GS_BALL_EVENT,
+    // appends the pokémon of a validated .pk1/.pk2 file to a PC box
+    IMPORT_BOX_POKEMON,
+    // reorders the pokémon of a PC box
+    SORT_BOX,
+    // removes pokémon from a PC box and moves the remaining ones up
+    REMOVE_BOX_POKEMON
+};
+
+/**
+ * @brief A single queued edit of a SaveEditTransaction
+ */
+typedef struct SaveEdit
+{
+    SaveEditType type;
+    union {
+        struct {
+            uint8_t partyIndex;
+            Gen1TrainerPokemon poke;
+        } gen1PartyPokemon;
+        struct {
+            Gen1TrainerPokemon poke;
+            char originalTrainerName[11];
+        } gen1Pokemon;
+        struct {
+            Gen2TrainerPokemon poke;
+            char originalTrainerName[11];
+            bool isEgg;
+        } gen2Pokemon;
+        struct {
+            uint16_t index;
+            bool value;
+        } eventFlag;
+        struct {
+            uint8_t boxIndex;
+            uint8_t file[POKEMON_EXPORTER_PK2_SIZE];
+        } importedPokemon;
+        struct {
+            uint8_t boxIndex;
+            uint8_t numPokemon;
+            // the slot that holds the pokémon that needs to end up in slot i
+            uint8_t sourceSlots[POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+        } sortedBox;
+        struct {
+            uint8_t boxIndex;
+            uint8_t numPokemon;
+            bool removedSlots[POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+        } removedBoxPokemon;
+    };
+} SaveEdit;
+
+/**
+ * @brief This class batches multiple save edits into a single write to the cartridge.
+ *
+ * Without it, every edit does its own checksum calculation over the transfer pak and writes its own blocks.
+ * Here, the edits are only queued. When the transaction is committed (or dry-run), all queued edits are applied by a game reader
+ * on top of a TransferPakOverlaySaveManager, so they only modify RAM. The checksum is then calculated once for all of them.
+ * Finally, commit() writes every modified block to the cartridge in ascending order.
+ *
+ * Because the actual writes go through the TransferPakManager, a SaveUndoJournal still sees all of them.
+ *
+ * The checksums are updated incrementally: they are simple byte sums, so the overlay can tell how much they change by only looking
+ * at the blocks that were modified. This avoids reading the entire checksummed region back over the transfer pak.
+ * For Gen 2, the modified main data bytes also get mirrored into the backup copy of the save.
+ * Saves for which we don't know the layout well enough fall back to the full recalculation of the game reader.
+ */
+class SaveEditTransaction
+{
+public:
+    SaveEditTransaction(TransferPakManager& pakManager, uint8_t generation, uint8_t specificGenVersion, uint8_t localization);
+    ~SaveEditTransaction();
+
+    /**
+     * @brief Returns a game reader that reads the save with the edits that have been applied so far (or nullptr if this transaction isn't for a Gen 1 game).
+     * This is useful to check things before queueing an edit. You shouldn't modify the save with it directly.
+     */
+    Gen1GameReader* getGen1Reader();
+
+    /**
+     * @brief Returns a game reader that reads the save with the edits that have been applied so far (or nullptr if this transaction isn't for a Gen 2 game).
+     * This is useful to check things before queueing an edit. You shouldn't modify the save with it directly.
+     */
+    Gen2GameReader* getGen2Reader();
+
+    // these functions queue an edit. They return false if the edit doesn't apply to this game or if the queue is full.
+    bool setGen1PartyPokemon(uint8_t partyIndex, const Gen1TrainerPokemon& poke);
+    bool addGen1Pokemon(const Gen1TrainerPokemon& poke, const char* originalTrainerName);
+    bool addGen2Pokemon(const Gen2TrainerPokemon& poke, bool isEgg, const char* originalTrainerName);
+    bool setGen2EventFlag(uint16_t flagIndex, bool value);
+    bool unlockGen2GSBallEvent();
+
+    /**
+     * @brief Queues appending the pokémon of the given .pk1/.pk2 file (see PokemonExporter) to the given PC box.
+     * The file must have been validated with validatePokemonFile() (see PokemonImporter) first. The edit fails when the box is full.
+     */
+    bool importBoxPokemon(uint8_t boxIndex, const uint8_t* pokemonFile);
+
+    /**
+     * @brief Queues reordering the given PC box: slot i will get the pokémon that is currently in slot sourceSlots[i].
+     * Only the slots whose pokémon actually moves get written. The edit fails when numPokemon doesn't match the box.
+     */
+    bool sortBox(uint8_t boxIndex, const uint8_t* sourceSlots, uint8_t numPokemon);
+
+    /**
+     * @brief Queues removing the pokémon of the given PC box for which removedSlots[i] is true. The remaining pokémon move up,
+     * just like when the player withdraws a pokémon. The edit fails when numPokemon doesn't match the box.
+     */
+    bool removeBoxPokemon(uint8_t boxIndex, const bool* removedSlots, uint8_t numPokemon);
+
+    uint8_t getNumberOfEdits() const;
+
+    /**
+     * @brief Returns the number of applied edits that the game reader couldn't do (for instance because there was no room left
+     * for a pokémon). The edits are applied by dryRun() and commit(), so check this after dryRun().
+     */
+    uint8_t getNumberOfFailedEdits() const;
+
+    /**
+     * @brief Applies the queued edits in RAM and reports which bytes of the save would change if the transaction were committed.
+     * Nothing gets written to the cartridge. SRAM access must be enabled by the caller.
+     * You can still commit() the transaction afterwards: the edits won't be applied a second time.
+     *
+     * @param outRanges buffer for the changed byte ranges. May be nullptr
+     * @param outNumRanges the total number of changed ranges (can be larger than maxRanges)
+     * @return the total number of bytes that would change or -1 if the edits don't fit in RAM
+     */
+    int32_t dryRun(SaveByteRange* outRanges, uint16_t maxRanges, uint16_t& outNumRanges);
+
+    /**
+     * @brief Applies the queued edits, calculates the checksum once and writes all modified blocks to the cartridge in one go.
+     * SRAM access must be enabled by the caller. Afterwards, the transaction is empty and can be reused.
+     *
+     * @param outNumBlocksWritten the number of 32 byte blocks that were actually written to the cartridge
+     */
+    bool commit(uint16_t& outNumBlocksWritten);
+
+    /**
+     * @brief Drops the queued edits and everything that was applied in RAM
+     */
+    void rollback();
+protected:
+private:
+    bool queueEdit(const SaveEdit& edit);
+
+    /**
+     * @brief Applies the edits that haven't been applied yet to the overlay and updates the checksum
+     */
+    void applyPendingEdits();
+
+    /**
+     * @brief Updates the checksum(s) based on the bytes that were changed in the overlay
+     * @return false if this can't be done for this game. In that case nothing was modified.
+     */
+    bool updateChecksumsIncrementally();
+
+    /**
+     * @brief Mirrors the modified bytes of the Gen 2 main data into the backup copy of the save
+     */
+    bool mirrorGen2MainDataToBackup();
+
+    /**
+     * @brief Writes the pokémon of the given IMPORT_BOX_POKEMON edit to the first free slot of its box in the overlay
+     */
+    bool applyImportedPokemon(const SaveEdit& edit);
+
+    /**
+     * @brief Moves the pokémon of the given SORT_BOX edit to their new slots in the overlay.
+     * The permutation is applied one cycle at a time, so every moved slot gets read and written exactly once.
+     */
+    bool applySortedBox(const SaveEdit& edit);
+
+    /**
+     * @brief Removes the pokémon of the given REMOVE_BOX_POKEMON edit from its box in the overlay.
+     * Only the slots from the first removed pokémon onwards get rewritten.
+     */
+    bool applyRemovedBoxPokemon(const SaveEdit& edit);
+
+    /**
+     * @brief Returns the offset of the given box in the save. For the current box, this is the copy in bank 1
+     */
+    uint32_t getBoxOffset(uint8_t boxIndex);
+
+    /**
+     * @brief Updates the checksums of the Gen 1 boxes in bank 2 and 3 (one over all boxes of the bank and one per box)
+     */
+    void updateGen1BoxChecksums();
+
+    TransferPakRomReader romReader_;
+    TransferPakOverlaySaveManager overlay_;
+    Gen1GameReader* gen1Reader_;
+    Gen2GameReader* gen2Reader_;
+    SaveEdit* edits_;
+    uint8_t numEdits_;
+    uint8_t numAppliedEdits_;
+    uint8_t numFailedEdits_;
+    PokemonBoxLayout boxLayout_;
+    uint8_t specificGenVersion_;
+    uint8_t localization_;
+    bool hasBoxLayout_;
+};
+
+#endif
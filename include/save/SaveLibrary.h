@@ -0,0 +1,107 @@
+#ifndef _SAVELIBRARY_H
+#define _SAVELIBRARY_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief The default path of the save library index on the SD card
+ */
+#define SAVE_LIBRARY_DEFAULT_PATH "sd:/PokeMe64/library.idx"
+
+/**
+ * @brief The directory in which the backups of the save library are stored
+ */
+#define SAVE_LIBRARY_DIRECTORY "sd:/PokeMe64"
+
+/**
+ * @brief Flags of a SaveLibraryEntry
+ */
+#define SAVE_LIBRARY_ENTRY_FLAG_CHECKSUM_VALID 0x01
+#define SAVE_LIBRARY_ENTRY_FLAG_HAS_PLAYTIME 0x02
+#define SAVE_LIBRARY_ENTRY_FLAG_COMPRESSED 0x04
+
+/**
+ * @brief This is the header of the save library index file.
+ * It is followed by numEntries SaveLibraryEntry structs
+ */
+typedef struct SaveLibraryHeader
+{
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t numEntries;
+    // the number we'll use for the file name of the next backup
+    uint32_t nextSequenceNumber;
+} SaveLibraryHeader;
+
+/**
+ * @brief The metadata of a single save backup in the library
+ */
+typedef struct SaveLibraryEntry
+{
+    // the full path of the backup file
+    char path[64];
+    // the title from the gameboy cartridge header. This identifies the game the backup belongs to
+    char gameTitle[12];
+    char trainerName[16];
+    uint32_t size;
+    uint32_t crc32;
+    uint16_t trainerID;
+    uint16_t playTimeHours;
+    uint8_t playTimeMinutes;
+    uint8_t generation;
+    uint8_t specificGenVersion;
+    uint8_t flags;
+} SaveLibraryEntry;
+
+/**
+ * @brief This class maintains an index of the save backups that were made with PokeMe64.
+ *
+ * Every backup gets a record with the metadata of the save (trainer, playtime, checksum validity, CRC-32,...)
+ * appended to a single index file. That gives us 2 things:
+ * - a unique file name for the next backup without having to probe the SD card for every existing backup
+ * - a list of the backups of a game, with metadata, without having to scan the directory or open the backups
+ */
+class SaveLibrary
+{
+public:
+    SaveLibrary(const char* indexPath = SAVE_LIBRARY_DEFAULT_PATH);
+    ~SaveLibrary();
+
+    /**
+     * @brief Reads the header of the index file.
+     * If the index doesn't exist yet, this results in an empty library.
+     * @return false if the index file exists, but isn't valid
+     */
+    bool load();
+
+    uint16_t getNumberOfEntries() const;
+
+    /**
+     * @brief Generates a unique path for a new backup of the given game.
+     * The file name is based on a sequence number in the index. So normally, this only needs to check 1 path on the SD card.
+     * (the check is still needed for backups that were made before the library existed)
+     */
+    void generateBackupPath(char* outputPath, size_t bufferSize, const char* gameTitle, const char* playerName, const char* extension);
+
+    /**
+     * @brief Appends the given entry to the index file
+     */
+    bool addEntry(const SaveLibraryEntry& entry);
+
+    /**
+     * @brief Reads the entries of the given game from the index file. The most recent backup comes first.
+     *
+     * @param gameTitle the title from the gameboy cartridge header. If nullptr, the entries of all games are returned.
+     * @return the number of entries that were stored in outEntries
+     */
+    uint16_t readEntries(SaveLibraryEntry* outEntries, uint16_t maxEntries, const char* gameTitle) const;
+protected:
+private:
+    const char* indexPath_;
+    SaveLibraryHeader header_;
+};
+
+#endif
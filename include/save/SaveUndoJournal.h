@@ -0,0 +1,130 @@
+#ifndef _SAVEUNDOJOURNAL_H
+#define _SAVEUNDOJOURNAL_H
+
+#include "transferpak/TransferPakManager.h"
+
+#include <cstdio>
+#include <cstdint>
+
+/**
+ * @brief The default path of the undo journal on the SD card
+ */
+#define SAVE_UNDO_JOURNAL_DEFAULT_PATH "sd:/PokeMe64/undo.jnl"
+
+/**
+ * @brief The number of SRAM banks for which we keep track of which blocks have already been journaled.
+ * Gen 1/2 cartridges have 4 banks of 8 KB. Blocks in other banks still get journaled, but may be journaled more than once.
+ */
+#define SAVE_UNDO_JOURNAL_MAX_BANKS 4
+
+/**
+ * @brief 1 bit per 32 byte block of every bank, for the first SAVE_UNDO_JOURNAL_MAX_BANKS banks
+ */
+typedef uint8_t SaveUndoJournalBlockMap[SAVE_UNDO_JOURNAL_MAX_BANKS][0x2000 / TPAK_BLOCK_SIZE / 8];
+
+/**
+ * @brief This is the header of the undo journal file.
+ * It is followed by any number of SaveUndoJournalEntry structs
+ */
+typedef struct SaveUndoJournalHeader
+{
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved;
+    // the global checksum of the cartridge rom. Together with the title, this identifies the game the journal belongs to
+    uint8_t globalChecksum[2];
+    char title[16];
+    // 0 for the cartridge in the transfer pak. For a virtual cartridge, this is a hash of the path of its .sav file
+    uint64_t saveSource;
+    // the fields above only identify the game and where the save lives. This identifies the save itself: a hash of the contents of every journaled block right after the edit.
+    // It's filled in by end(). 0 means the edit was never finished.
+    uint64_t saveFingerprint;
+} SaveUndoJournalHeader;
+
+/**
+ * @brief A single journal entry: the original contents of a 32 byte SRAM block before it was modified
+ */
+typedef struct SaveUndoJournalEntry
+{
+    uint8_t SRAMBankIndex;
+    uint8_t reserved;
+    uint16_t SRAMBankOffset;
+    uint8_t originalData[TPAK_BLOCK_SIZE];
+} SaveUndoJournalEntry;
+
+/**
+ * @brief This class keeps an undo journal of a save edit on the SD card.
+ *
+ * While it is active, it listens to the SRAM writes of the TransferPakManager. Before a block gets modified for the first time
+ * during the edit, its original 32 bytes are appended to the journal. Because the save checksum is just another SRAM block,
+ * it gets journaled along with the rest.
+ *
+ * undo() writes those blocks back, which reverts the last edit without needing a full backup.
+ * When the edit ends, the modified blocks get read back once to fingerprint the resulting save. undo() only goes ahead
+ * if the cartridge still has exactly that save, so the journal can't be applied to another save of the same game
+ * (another cartridge, a virtual cartridge or a save that has been played on since).
+ *
+ * The journal file only gets (re)created when the first block gets modified. So an edit that turns out to be a no-op
+ * doesn't destroy the journal of the previous edit.
+ */
+class SaveUndoJournal : public ITransferPakSRAMWriteListener
+{
+public:
+    SaveUndoJournal(TransferPakManager& pakManager, const char* journalPath = SAVE_UNDO_JOURNAL_DEFAULT_PATH);
+    virtual ~SaveUndoJournal();
+
+    /**
+     * @brief Starts journaling the SRAM writes of the TransferPakManager.
+     * @return false if the journal can't be used (for instance: there's no SD card). The edit can still go ahead, but it can't be undone.
+     */
+    bool begin();
+
+    /**
+     * @brief Stops journaling and fingerprints the modified save. This is also done by the destructor, so you only need to call this if you want to stop earlier.
+     * WARNING: make sure all writes are finished (TransferPakManager::finishWrites()) before calling this. Otherwise the last block isn't journaled.
+     * SRAM access must still be enabled: the modified blocks get read back. The previously selected SRAM bank gets selected again afterwards.
+     */
+    void end();
+
+    /**
+     * @brief Returns the number of blocks that were journaled since begin()
+     */
+    uint16_t getNumberOfJournaledBlocks() const;
+
+    void onBeforeSRAMBlockWrite(uint8_t SRAMBankIndex, uint16_t SRAMBankOffset, const uint8_t* originalData) override;
+
+    /**
+     * @brief Checks whether there's an undo journal for the save that is currently in the transfer pak.
+     * SRAM access must be enabled by the caller: the save gets compared with the fingerprint of the journal.
+     * @return the number of blocks in the journal (0 if there's nothing to undo)
+     */
+    static uint16_t getNumberOfUndoableBlocks(TransferPakManager& pakManager, const char* journalPath = SAVE_UNDO_JOURNAL_DEFAULT_PATH);
+
+    /**
+     * @brief Writes the original blocks from the journal back to the cartridge and removes the journal.
+     * SRAM access must be enabled by the caller. The previously selected SRAM bank gets selected again afterwards.
+     * Anything that caches save data (like the GameSession) must be invalidated by the caller afterwards.
+     * @return false if there's no (valid) journal for the current save or if writing any of the blocks failed.
+     * Nothing gets written if the save doesn't match the fingerprint of the journal.
+     */
+    static bool undo(TransferPakManager& pakManager, const char* journalPath = SAVE_UNDO_JOURNAL_DEFAULT_PATH);
+protected:
+private:
+    bool openJournalFile();
+
+    /**
+     * @brief Fills in the fingerprint of the modified save in the header of the journal file
+     */
+    bool writeSaveFingerprint();
+
+    TransferPakManager& pakManager_;
+    const char* journalPath_;
+    FILE* journalFile_;
+    SaveUndoJournalHeader header_;
+    SaveUndoJournalBlockMap journaledBlocks_;
+    uint16_t numJournaledBlocks_;
+    bool active_;
+    bool failed_;
+};
+
+#endif
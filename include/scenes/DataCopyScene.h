@@ -6,13 +6,30 @@
 #include "transferpak/TransferPakRomReader.h"
 #include "transferpak/TransferPakSaveManager.h"
 #include "transferpak/TransferPakDataCopier.h"
+#include "transferpak/CopyJobQueue.h"
+#include "transferpak/ControllerPakDataCopier.h"
+#include "save/SaveBackupStore.h"
+#include "save/SaveLibrary.h"
 
 enum class DataCopyOperation
 {
     BACKUP_SAVE,
     BACKUP_ROM,
     RESTORE_SAVE,
-    WIPE_SAVE
+    WIPE_SAVE,
+    BACKUP_SAVE_SNAPSHOT,
+    RESTORE_SAVE_SNAPSHOT,
+    // rebuilds a regular .sav file from a snapshot manifest (and its blocks) on the SD card
+    EXPORT_SAVE_SNAPSHOT,
+    BACKUP_SAVE_COMPRESSED,
+    BACKUP_ROM_COMPRESSED,
+    // backs up both the save and the rom in one go
+    BACKUP_SAVE_AND_ROM,
+    // copies the save straight to the cartridge in a transfer pak on another controller port
+    CLONE_SAVE,
+    // backs up/restores the save to/from a (compressed) note on a Controller Pak on another controller port. This doesn't need an SD card.
+    BACKUP_SAVE_CONTROLLER_PAK,
+    RESTORE_SAVE_CONTROLLER_PAK
 };
 
 typedef struct DataCopySceneContext
@@ -21,6 +38,31 @@ typedef struct DataCopySceneContext
     ManagedString saveToRestorePath;
 } DataCopySceneContext;
 
+/**
+ * @brief Keeps track of the scene-specific things of a single CopyJob
+ * All destination pointers are non-owning: the CopyJobQueue owns them.
+ */
+typedef struct DataCopyJobInfo
+{
+    DataCopyOperation operation;
+    // set during BACKUP_SAVE_SNAPSHOT
+    SaveSnapshotCopyDestination* snapshotDestination;
+    // set during BACKUP_SAVE_COMPRESSED and BACKUP_ROM_COMPRESSED
+    TransferPakCompressedFileCopyDestination* compressedDestination;
+    // set during RESTORE_SAVE, RESTORE_SAVE_SNAPSHOT and CLONE_SAVE
+    TransferPakSaveManagerDiffDestination* diffDestination;
+    // set during BACKUP_SAVE_CONTROLLER_PAK
+    ControllerPakCopyDestination* controllerPakDestination;
+    // additional destination that calculates the CRC-32 of backups in the same pass
+    TransferPakHashCopyDestination* hashDestination;
+    // whether libraryEntry needs to be added to the save library when the job succeeds (BACKUP_SAVE)
+    bool addToLibrary;
+    SaveLibraryEntry libraryEntry;
+    // non-owning: these DialogData instances are owned by the dialog chain
+    DialogData* resultDialog;
+    DialogData* statsDialog;
+} DataCopyJobInfo;
+
 class DataCopyScene : public SceneWithProgressBar
 {
 public:
@@ -38,16 +80,81 @@ protected:
     void setupDialog(DialogWidgetStyle& style) override;
     void setupProgressBar(ProgressBarWidgetStyle& style) override;
 private:
+    /**
+     * @brief Creates the source and destination for the given operation and adds them as a job to jobQueue_
+     * @return false if the job can't be done. In that case, the error text has been set in diag_
+     */
+    bool addCopyJob(DataCopyOperation operation, const gameboy_cartridge_header& gbHeader, const char* gameTitle);
+
+    /**
+     * @brief Updates the dialogs of the job with the given index after it has finished.
+     */
+    void onJobFinished(uint8_t jobIndex);
+
+    /**
+     * @brief Returns whether the destination of the given job failed to finish its output when it was closed
+     */
+    bool hasDestinationFailedOnClose(const DataCopyJobInfo& info) const;
+
+    /**
+     * @brief Fills in the statistics of a finished copy job (size, compression ratio, elapsed time,...)
+     */
+    void fillStatsDialog(const DataCopyJobInfo& info, const CopyJob& job);
+
+    /**
+     * @brief Fills in the size, elapsed time and throughput of every job when multiple jobs were done.
+     */
+    void fillSummaryDialog();
+
+    void fillWipeStatsDialog(uint32_t elapsedTimeInMs);
+
+    /**
+     * @brief Looks for a transfer pak on the other controller ports, powers it on and checks whether its cartridge
+     * has the same game and save size as the one in deps_.tpakManager.
+     * @return false if no suitable cartridge was found. In that case, the error text has been set in diag_
+     */
+    bool openCloneTargetPak(const gameboy_cartridge_header& sourceHeader);
+
+    /**
+     * @brief Disables RAM access and powers off the transfer pak that we cloned to (if any)
+     */
+    void closeCloneTargetPak();
+
+    /**
+     * @brief Looks for a Controller Pak on the controller ports that aren't used by deps_.tpakManager
+     * @return false if none was found
+     */
+    bool findControllerPakPort(joypad_port_t& outPort) const;
+
+    /**
+     * @brief Reads the metadata of the save in the cartridge (trainer, playtime, checksum validity) into the given SaveLibraryEntry
+     * This needs to be done before the copy job starts, because it moves the read position of saveManager_
+     */
+    void fillSaveLibraryEntry(SaveLibraryEntry& entry, const gameboy_cartridge_header& gbHeader, const char* path);
+
     TransferPakRomReader romReader_;
     TransferPakSaveManager saveManager_;
+    SaveBackupStore backupStore_;
+    SaveLibrary saveLibrary_;
+    // the transfer pak we write to during CLONE_SAVE. deps_.tpakManager stays the one we read from.
+    TransferPakManager cloneTargetPakManager_;
+    // only created once the clone target pak has been found and powered on
+    TransferPakSaveManager* cloneTargetSaveManager_;
     DataCopySceneContext* sceneContext_;
-    ITransferPakDataCopySource* copySource_;
-    ITransferPakDataCopyDestination* copyDestination_;
-    TransferPakDataCopier* copier_;
+    CopyJobQueue jobQueue_;
+    DataCopyJobInfo jobInfo_[COPY_JOB_QUEUE_MAX_JOBS];
+    // non-owning: these DialogData instances are owned by the dialog chain
+    DialogData* summaryDialog_;
+    DialogData* wipeStatsDialog_;
     sprite_t* dialogWidgetSprite_;
     sprite_t* progressBackgroundSprite_;
     DialogData diag_;
-    uint32_t totalBytesToCopy_;
+    uint32_t totalBytesToWipe_;
+    uint32_t bytesWiped_;
+    uint64_t wipeStartTime_;
+    bool copying_;
+    bool wiping_;
+    bool wipeFailed_;
 };
 
 void deleteDataCopySceneContext(void* context);
@@ -4,7 +4,6 @@
 #include "scenes/MenuScene.h"
 #include "widget/DistributionPokemonMenuItemWidget.h"
 #include "transferpak/TransferPakRomReader.h"
-#include "transferpak/TransferPakSaveManager.h"
 #include "gen1/Gen1GameReader.h"
 #include "gen2/Gen2GameReader.h"
 
@@ -65,6 +64,19 @@ public:
      */
     void injectPokemon(const void* data);
 
+    /**
+     * @brief Shows the "Saving..." dialog and schedules the injection of every pokémon of the list.
+     * The actual injection happens in the next handleUserInput() call, so that the dialog gets rendered first.
+     */
+    void triggerBulkInjection();
+
+    /**
+     * @brief Adds every pokémon of the list to the save in a single SaveEditTransaction and shows a summary afterwards.
+     * The game reader places them in the party and current box in RAM, the checksum is updated once and all modified blocks
+     * are written to the cartridge in a single, ascending pass.
+     */
+    void injectAllPokemon();
+
     void onDialogDone() override;
 protected:
     void setupMenu() override;
@@ -72,14 +84,14 @@ private:
     void loadDistributionPokemonList();
 
     TransferPakRomReader romReader_;
-    TransferPakSaveManager saveManager_;
-    Gen1GameReader gen1Reader_;
-    Gen2GameReader gen2Reader_;
     PokemonPartyIconFactory iconFactory_;
     ListItemFiller<VerticalList, DistributionPokemonMenuItemData, DistributionPokemonMenuItem, DistributionPokemonMenuItemStyle> customListFiller_;
     DialogData diag_;
+    DialogData summaryDiag_;
     sprite_t* iconBackgroundSprite_;
     const void* pokeToInject_;
+    bool bulkInjectionPending_;
+    bool startButtonPressed_;
 };
 
 void deleteDistributionPokemonListSceneContext(void* context);
@@ -8,6 +8,7 @@ class SceneManager;
 class AnimationManager;
 class FontManager;
 class TransferPakManager;
+class GameSession;
 
 typedef struct Rectangle Rectangle;
 
@@ -22,7 +23,10 @@ enum class SceneType
     POKETRANSPORTER_GB_REF,
     SELECT_FILE,
     COPY_DATA,
-    ABOUT
+    ABOUT,
+    SAVE_LIBRARY,
+    POKEMON_BOX_BROWSER,
+    IMPORT_POKEMON
 };
 
 typedef struct SceneDependencies
@@ -32,6 +36,8 @@ typedef struct SceneDependencies
     FontManager& fontManager;
     TransferPakManager& tpakManager;
     SceneManager& sceneManager;
+    // the game reader and cached save data of the cartridge in the transfer pak. Started by the InitTransferPakScene
+    GameSession& gameSession;
     char playerName[16];
     uint8_t generation;
     uint8_t specificGenVersion;
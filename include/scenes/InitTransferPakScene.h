@@ -3,12 +3,23 @@
 
 #include "scenes/SceneWithDialogWidget.h"
 #include "widget/TransferPakDetectionWidget.h"
+#include "core/common.h"
 
 class TransferPakManager;
 
+typedef struct InitTransferPakSceneContext
+{
+    // the .sav file on the SD card that should be used instead of the cartridge in the transfer pak.
+    // See TransferPakManager::openVirtualCartridge()
+    ManagedString virtualCartridgeSavePath;
+} InitTransferPakSceneContext;
+
 /**
  * @brief In this scene implementation, we do the detection of the N64 transfer pak and whether a supported Pokémon game was
  * detected.
+ *
+ * Instead of the cartridge in the transfer pak, the user can also press START to pick a .sav file on the SD card.
+ * In that case, this scene is shown again with an InitTransferPakSceneContext and the whole menu tree runs against that file.
  */
 class InitTransferPakScene : public SceneWithDialogWidget
 {
@@ -21,6 +32,8 @@ public:
 
     void render(RDPQGraphics& gfx, const Rectangle& sceneBounds) override;
 
+    bool handleUserInput(joypad_port_t port, const joypad_inputs_t& inputs) override;
+
     void onDialogDone();
     void onTransferPakWidgetStateChanged(TransferPakWidgetState newState);
 protected:
@@ -32,6 +45,13 @@ private:
     void loadSaveMetadata();
     const char* getGameTypeString();
 
+    /**
+     * @brief Lets the user pick a .sav file on the SD card to use as a virtual cartridge
+     */
+    void goToVirtualCartridgeFileSelection();
+
+    InitTransferPakSceneContext* context_;
+
     sprite_t* menu9SliceSprite_;
     TransferPakDetectionWidget tpakDetectWidget_;
     WidgetFocusChainSegment tpakDetectWidgetSegment_;
@@ -40,6 +60,10 @@ private:
     const char* gameTypeString_;
     // build up a random seed for srand(). I'm doing this in an attempt to truly randomize IVs and shininess.
     unsigned int randomSeed_;
+    bool startButtonPressed_;
+    bool virtualCartridgeFailed_;
 };
 
+void deleteInitTransferPakSceneContext(void* context);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef _POKEMONBOXBROWSERSCENE_H
+#define _POKEMONBOXBROWSERSCENE_H
+
+#include "scenes/MenuScene.h"
+#include "widget/DistributionPokemonMenuItemWidget.h"
+#include "transferpak/TransferPakRomReader.h"
+#include "save/PokemonBoxIndex.h"
+#include "save/PokemonExporter.h"
+#include "save/PokemonBoxSorter.h"
+#include "save/PokemonTimeCapsule.h"
+
+/**
+ * @brief The size of the title buffer of a single box slot in the PokemonBoxBrowserScene
+ */
+#define POKEMON_BOX_BROWSER_SCENE_TITLE_SIZE 24
+
+/**
+ * @brief This scene lets the user browse through the PC boxes of the save.
+ *
+ * The list is rendered from the PokemonBoxIndex of the GameSession, so moving the cursor or switching boxes (L/R or left/right)
+ * doesn't need to read the save again. Only when the user opens a slot, the full pokémon gets read and shown in the StatsScene.
+ *
+ * Pressing START exports every pokémon of the party and the boxes to .pk1/.pk2 files on the SD card (see PokemonExporter).
+ * Pressing Z sorts all boxes by species or level (see PokemonBoxSorter).
+ * Pressing C-right moves the current box to the Gen 1 or Gen 2 cartridge in a transfer pak on another controller (see PokemonTimeCapsule).
+ */
+class PokemonBoxBrowserScene : public MenuScene
+{
+public:
+    PokemonBoxBrowserScene(SceneDependencies& deps, void* context);
+    virtual ~PokemonBoxBrowserScene();
+
+    void init() override;
+    void destroy() override;
+
+    void render(RDPQGraphics& gfx, const Rectangle& sceneBounds) override;
+
+    bool handleUserInput(joypad_port_t port, const joypad_inputs_t& inputs) override;
+
+    void onDialogDone() override;
+
+    /**
+     * @brief Reads the full pokémon of the given slot from the save and shows it in the StatsScene
+     */
+    void openSlot(const PokemonBoxIndexEntry& entry);
+
+    /**
+     * @brief Called when the user picked a sort order in the sort dialog. The sort itself starts on the next handleUserInput() call
+     */
+    void onSortKeyChosen(PokemonBoxSortKey key);
+protected:
+    void setupMenu() override;
+private:
+    /**
+     * @brief Fills the menu entries with the contents of the given box. This only uses the box index.
+     */
+    void loadBox(uint8_t boxIndex);
+
+    /**
+     * @brief Replaces the list widgets with the contents of the box in the given direction (-1 or 1). 0 reloads the current box
+     */
+    void switchBox(int8_t direction);
+
+    /**
+     * @brief Starts the export of all pokémon. The export itself happens one list per frame in handleUserInput()
+     */
+    void startExport();
+
+    /**
+     * @brief Exports the next list and shows the result once the export is done
+     */
+    void stepExport();
+
+    /**
+     * @brief Asks the user by what the boxes should be sorted
+     */
+    void showSortOptions();
+
+    /**
+     * @brief Sorts all boxes, rebuilds the box index and shows how many bytes that took
+     */
+    void sortBoxes();
+
+    /**
+     * @brief Moves the pokémon of the current box to the cartridge in the second transfer pak, rebuilds the box index and shows the result
+     */
+    void moveBoxToOtherCartridge();
+
+    TransferPakRomReader romReader_;
+    PokemonPartyIconFactory iconFactory_;
+    ListItemFiller<VerticalList, DistributionPokemonMenuItemData, DistributionPokemonMenuItem, DistributionPokemonMenuItemStyle> customListFiller_;
+    DistributionPokemonMenuItemStyle itemStyle_;
+    DistributionPokemonMenuItemData entries_[POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+    char titles_[POKEMON_BOX_INDEX_SLOTS_PER_BOX][POKEMON_BOX_BROWSER_SCENE_TITLE_SIZE];
+    char headerText_[40];
+    TextRenderSettings headerTextSettings_;
+    DialogData diag_;
+    PokemonExporter exporter_;
+    PokemonBoxSorter sorter_;
+    PokemonTimeCapsule timeCapsule_;
+    DialogData sortDiag_;
+    MenuItemData sortOptions_[3];
+    const PokemonBoxIndex* boxIndex_;
+    sprite_t* iconBackgroundSprite_;
+    uint8_t currentBox_;
+    uint8_t numEntries_;
+    bool boxSwitchButtonPressed_;
+    bool startButtonPressed_;
+    bool zButtonPressed_;
+    bool cRightButtonPressed_;
+    PokemonBoxSortKey sortKey_;
+    // the user picked a sort order, but the "Sorting..." dialog hasn't been shown yet
+    bool sortKeyChosen_;
+    bool sortPending_;
+    // the "Looking for the other cartridge..." dialog is shown. The move happens on the next handleUserInput() call
+    bool timeCapsulePending_;
+};
+
+#endif
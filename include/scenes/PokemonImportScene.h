@@ -0,0 +1,61 @@
+#ifndef _POKEMONIMPORTSCENE_H
+#define _POKEMONIMPORTSCENE_H
+
+#include "scenes/MenuScene.h"
+#include "save/PokemonImporter.h"
+
+/**
+ * @brief The size of the path buffer of a single file in the PokemonImportScene
+ */
+#define POKEMON_IMPORT_SCENE_PATH_SIZE 64
+
+/**
+ * @brief The size of the title buffer of a single file in the PokemonImportScene
+ */
+#define POKEMON_IMPORT_SCENE_TITLE_SIZE 36
+
+/**
+ * @brief This scene lists the .pk1 (Gen 1) or .pk2 (Gen 2) files in sd:/PokeMe64/import.
+ * The user selects the files to import with A and imports all of them at once with START (see PokemonImporter).
+ */
+class PokemonImportScene : public MenuScene
+{
+public:
+    PokemonImportScene(SceneDependencies& deps, void* context);
+    virtual ~PokemonImportScene();
+
+    void init() override;
+    void destroy() override;
+
+    bool handleUserInput(joypad_port_t port, const joypad_inputs_t& inputs) override;
+
+    void onDialogDone() override;
+
+    /**
+     * @brief Selects or deselects the file at the given index
+     */
+    void toggleFile(uint8_t fileIndex);
+protected:
+    void setupMenu() override;
+private:
+    void loadFiles();
+
+    /**
+     * @brief Shows the "Importing..." dialog. The import itself happens on the next handleUserInput() call, so the dialog gets rendered first
+     */
+    void startImport();
+
+    void importSelectedFiles();
+
+    PokemonImporter importer_;
+    char paths_[POKEMON_IMPORTER_MAX_FILES][POKEMON_IMPORT_SCENE_PATH_SIZE];
+    char titles_[POKEMON_IMPORTER_MAX_FILES][POKEMON_IMPORT_SCENE_TITLE_SIZE];
+    bool selected_[POKEMON_IMPORTER_MAX_FILES];
+    DialogData diag_;
+    uint8_t numSelected_;
+    bool startButtonPressed_;
+    bool importPending_;
+    bool importDone_;
+};
+
+#endif
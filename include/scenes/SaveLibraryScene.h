@@ -0,0 +1,61 @@
+#ifndef _SAVELIBRARYSCENE_H
+#define _SAVELIBRARYSCENE_H
+
+#include "scenes/MenuScene.h"
+#include "save/SaveLibrary.h"
+
+/**
+ * @brief The maximum number of backups we show in the SaveLibraryScene
+ */
+#define SAVE_LIBRARY_SCENE_MAX_ENTRIES 32
+
+/**
+ * @brief The size of the title buffer of a single menu entry in the SaveLibraryScene
+ */
+#define SAVE_LIBRARY_SCENE_TITLE_SIZE 40
+
+struct SaveLibrarySceneContext : public MenuSceneContext
+{
+    // HACK: indicates that -instead of showing this scene- we want to navigate back to the previous scene instead
+    // See SelectFileSceneContext for the reason why.
+    bool goBackToPreviousSceneInstead;
+};
+
+typedef SaveLibrarySceneContext SaveLibrarySceneContext;
+
+/**
+ * @brief This scene shows the save backups of the current game from the SaveLibrary index, along with their metadata.
+ * Unlike SelectFileScene, this doesn't need to scan the SD card directory.
+ *
+ * Selecting a backup restores it to the cartridge with the DataCopyScene.
+ */
+class SaveLibraryScene : public MenuScene
+{
+public:
+    SaveLibraryScene(SceneDependencies& deps, void* context);
+    virtual ~SaveLibraryScene();
+
+    void init() override;
+    void destroy() override;
+
+    void onDialogDone() override;
+
+    /**
+     * @brief Restores the given backup to the cartridge by switching to the DataCopyScene
+     */
+    void onEntryConfirmed(const SaveLibraryEntry& entry);
+protected:
+    void setupMenu() override;
+private:
+    void loadLibraryEntries();
+
+    SaveLibrary saveLibrary_;
+    SaveLibraryEntry* entries_;
+    char* titles_;
+    DialogData diag_;
+    bool skipped_;
+};
+
+void deleteSaveLibrarySceneContext(void* context);
+
+#endif
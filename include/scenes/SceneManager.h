@@ -2,6 +2,7 @@
 #define _SCENEMANAGER_H
 
 #include "scenes/IScene.h"
+#include "core/GameSession.h"
 #include <vector>
 
 class RDPQGraphics;
@@ -61,6 +62,7 @@ private:
     void unloadScene(IScene* scene);
 
     std::vector<SceneHistorySegment> sceneHistory_;
+    GameSession gameSession_;
     SceneDependencies sceneDeps_;
     uint64_t blockInputStartTime_;
     IScene* scene_;
@@ -16,6 +16,7 @@ typedef struct SelectFileSceneContext
     // initial path. If left NULL, it will default to sd:/
     const char* initialPath;
     // file extension filter. if set, only files with the specified extension will be shown
+    // multiple extensions can be separated with '|'
     const char* fileExtensionFilter;
     // HACK: indicates that -instead of showing this scene- we want to navigate back to the previous scene instead
     // this is useful for influencing back behaviour after the DataCopyScene is done.
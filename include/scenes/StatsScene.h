@@ -5,8 +5,6 @@
 #include "gen1/Gen1Common.h"
 #include "gen2/Gen2Common.h"
 #include "core/Sprite.h"
-#include "transferpak/TransferPakRomReader.h"
-#include "transferpak/TransferPakSaveManager.h"
 #include "gen1/Gen1GameReader.h"
 #include "gen2/Gen2GameReader.h"
 
@@ -17,6 +15,8 @@ typedef struct StatsSceneContext
         Gen2TrainerPokemon poke_g2;
     };
     char trainerName[15];
+    // only used when showReceivedPokemonDialog is false
+    char nickname[11];
     bool showReceivedPokemonDialog;
     bool isEgg;
 } StatsSceneContext;
@@ -42,10 +42,6 @@ private:
     void loadPokemonSprite(uint8_t pokeIndex, bool shiny);
 
     DialogData diag_;
-    TransferPakRomReader romReader_;
-    TransferPakSaveManager saveManager_;
-    Gen1GameReader gen1GameReader_;
-    Gen2GameReader gen2GameReader_;
     sprite_t* menu9SliceSprite_;
     SpriteRenderSettings backgroundRenderSettings_;
     uint8_t fontMainFontSmallId_;
@@ -0,0 +1,124 @@
+#ifndef _CONTROLLERPAKDATACOPIER_H
+#define _CONTROLLERPAKDATACOPIER_H
+
+#include "transferpak/TransferPakDataCopier.h"
+
+/**
+ * @brief The size of a single Controller Pak page (block)
+ */
+#define CONTROLLER_PAK_PAGE_SIZE 256
+
+/**
+ * @brief The number of pages of a Controller Pak that can be used for notes
+ */
+#define CONTROLLER_PAK_NUM_DATA_PAGES 123
+
+/**
+ * @brief Generates the Controller Pak note name we use for the save backup of the given game.
+ * The name is "PM64 " followed by the (up to 11 character) title of the cartridge.
+ *
+ * @param outputName buffer of at least 17 bytes
+ */
+void generateControllerPakNoteName(char* outputName, const gameboy_cartridge_header& gbHeader);
+
+/**
+ * This class implements the ITransferPakDataCopyDestination interface by storing the data as a note on a Controller Pak.
+ *
+ * A Controller Pak only has 123 pages of 256 bytes available for notes, which is less than a 32 KB save.
+ * So the data gets compressed with the same format as TransferPakCompressedFileCopyDestination.
+ *
+ * Every chunk gets compressed right when it arrives (so in between the transfer pak reads) into a page-aligned image in RAM.
+ * Every page the compressor completes gets written right away to a free page of the Controller Pak, so the page writes are spread over the copy.
+ * Those pages aren't linked to anything until close() writes the page table and the note table entry. So if the copy fails halfway,
+ * the Controller Pak is left untouched. An existing note with the same name only gets deleted when we run out of free pages, or else
+ * after the new note has been written.
+ */
+class ControllerPakCopyDestination : public ITransferPakDataCopyDestination
+{
+public:
+    ControllerPakCopyDestination(joypad_port_t port, const char* noteName, bool resetRTC = false);
+    virtual ~ControllerPakCopyDestination();
+
+    bool readyForTransfer() const override;
+
+    uint16_t getCurrentBankIndex() const override;
+    uint32_t getNumberOfBytesWritten() const override;
+
+    uint32_t write(uint8_t *buffer, uint32_t bytesToWrite) override;
+
+    void close() override;
+
+    /**
+     * @brief Returns the number of Controller Pak pages the note takes (or will take)
+     */
+    uint8_t getNumberOfPages() const;
+
+    /**
+     * @brief Returns whether the note was actually stored on the Controller Pak.
+     * Only valid after close()
+     */
+    bool isStored() const;
+protected:
+private:
+    /**
+     * @brief Writes the pages of image_ up to (but not including) the given page index that haven't been written yet
+     */
+    bool writePages(uint8_t endPageIndex);
+
+    /**
+     * @brief Writes the given page of image_ to the Controller Pak. A free Controller Pak page gets allocated for it if it hasn't been written before
+     */
+    bool writePage(uint8_t pageIndex);
+
+    /**
+     * @brief Deletes the existing note with the same name and marks its pages as free in our copy of the page table
+     */
+    bool deleteExistingNote();
+
+    TransferPakCompressedFileCopyDestination* compressor_;
+    uint8_t* image_;
+    joypad_port_t port_;
+    char noteName_[19];
+    entry_structure_t existingEntry_;
+    // our copy of the page table (inode table) of the Controller Pak. The pages of our note only get linked in here until close() writes it back
+    uint8_t pageTable_[CONTROLLER_PAK_PAGE_SIZE];
+    // the Controller Pak page to which each page of image_ was written
+    uint8_t pakPages_[CONTROLLER_PAK_NUM_DATA_PAGES];
+    // the number of pages available to us: the free pages + the pages of an existing note with the same name
+    uint8_t numAvailablePages_;
+    uint8_t numPages_;
+    uint8_t numPagesWritten_;
+    bool hasExistingEntry_;
+    bool failed_;
+    bool stored_;
+};
+
+/**
+ * This class implements the ITransferPakDataCopySource interface for notes written by ControllerPakCopyDestination.
+ *
+ * The note is read from the Controller Pak when this instance is created. The data gets decompressed block by block while it's being read.
+ */
+class ControllerPakCopySource : public ITransferPakDataCopySource
+{
+public:
+    ControllerPakCopySource(joypad_port_t port, const char* noteName);
+    virtual ~ControllerPakCopySource();
+
+    bool readyForTransfer() const override;
+
+    uint16_t getCurrentBankIndex() const override;
+    uint32_t getNumberOfBytesRead() const override;
+
+    uint32_t read(uint8_t *buffer, uint32_t bytesToRead) override;
+
+    /**
+     * @brief Returns the uncompressed size of the data in the note
+     */
+    uint32_t getTotalSize() const;
+protected:
+private:
+    TransferPakCompressedFileCopySource* decompressor_;
+    uint8_t* image_;
+};
+
+#endif
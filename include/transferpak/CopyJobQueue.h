@@ -0,0 +1,83 @@
+#ifndef _COPYJOBQUEUE_H
+#define _COPYJOBQUEUE_H
+
+#include "transferpak/TransferPakDataCopier.h"
+
+/**
+ * @brief The maximum number of jobs a CopyJobQueue can hold
+ */
+#define COPY_JOB_QUEUE_MAX_JOBS 4
+
+typedef struct CopyJob
+{
+    ITransferPakDataCopySource* source;
+    ITransferPakDataCopyDestination* destination;
+    // optional: an additional destination that gets fed from the same source read (for example: a hash)
+    ITransferPakDataCopyDestination* extraDestination;
+    TransferPakDataCopier* copier;
+    uint32_t totalBytes;
+    uint64_t startTime;
+    uint64_t endTime;
+    bool failed;
+    bool done;
+} CopyJob;
+
+/**
+ * @brief This class runs a number of copy jobs back to back.
+ *
+ * This allows us to do multiple copy operations (for example: backing up the save AND the rom) in a single DataCopyScene
+ * with a single cartridge header read and RAM enable session and a combined progress bar.
+ *
+ * The queue takes ownership of the sources and destinations of its jobs. When a job is done (or has failed), its destinations are closed
+ * and we continue with the next one. A failing job doesn't abort the jobs after it.
+ */
+class CopyJobQueue
+{
+public:
+    CopyJobQueue();
+    ~CopyJobQueue();
+
+    /**
+     * @brief Adds a job to the queue. The queue takes ownership of source, destination and extraDestination
+     * (even if there's no room for the job anymore, in which case they're deleted right away)
+     *
+     * @return false if the queue is full
+     */
+    bool addJob(ITransferPakDataCopySource* source, ITransferPakDataCopyDestination* destination, uint32_t totalBytes, ITransferPakDataCopyDestination* extraDestination = nullptr);
+
+    uint8_t getNumberOfJobs() const;
+    const CopyJob& getJob(uint8_t index) const;
+
+    /**
+     * @brief Returns the index of the job that is currently being processed
+     * (or getNumberOfJobs() if all jobs are done)
+     */
+    uint8_t getCurrentJobIndex() const;
+
+    uint32_t getTotalBytes() const;
+    uint32_t getTotalBytesCopied() const;
+
+    bool isDone() const;
+    bool hasFailedJobs() const;
+
+    /**
+     * @brief Copies up to numBytesToCopy bytes for the current job. If the current job is done after that,
+     * it gets finished and the next call will continue with the next job.
+     */
+    void processChunk(uint32_t numBytesToCopy);
+
+    /**
+     * @brief Deletes all jobs (and their sources and destinations)
+     */
+    void clear();
+protected:
+private:
+    void startJob(CopyJob& job);
+    void finishJob(CopyJob& job);
+
+    CopyJob jobs_[COPY_JOB_QUEUE_MAX_JOBS];
+    uint8_t numJobs_;
+    uint8_t currentJobIndex_;
+};
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef _TRANSFERPAKDATACOPIER_H
 #define _TRANSFERPAKDATACOPIER_H
 
+#include "core/LZCompression.h"
+#include "transferpak/TransferPakManager.h"
+#include "save/SaveChecksum.h"
+
 #include <cstdio>
 #include <cstdint>
 
@@ -89,6 +93,46 @@ private:
     uint32_t bytesRead_;
 };
 
+/**
+ * This class implements the ITransferPakDataCopySource interface for files written by TransferPakCompressedFileCopyDestination.
+ * It decompresses the file one block at a time while the data is being read.
+ */
+class TransferPakCompressedFileCopySource : public ITransferPakDataCopySource
+{
+public:
+    TransferPakCompressedFileCopySource(const char *filePath);
+    /**
+     * @brief Reads the compressed data from an already opened stream (for example: one created with fmemopen()).
+     * This instance takes ownership of inputFile and closes it when it gets destroyed.
+     */
+    TransferPakCompressedFileCopySource(FILE *inputFile);
+    virtual ~TransferPakCompressedFileCopySource();
+
+    bool readyForTransfer() const override;
+
+    uint16_t getCurrentBankIndex() const override;
+    uint32_t getNumberOfBytesRead() const override;
+
+    uint32_t read(uint8_t *buffer, uint32_t bytesToRead) override;
+
+    /**
+     * @brief Returns the uncompressed size of the data in the file
+     */
+    uint32_t getTotalSize() const;
+protected:
+private:
+    bool loadNextBlock();
+
+    FILE *inputFile_;
+    uint8_t blockBuffer_[LZ_MAX_BLOCK_SIZE];
+    uint8_t compressedBuffer_[LZ_MAX_BLOCK_SIZE];
+    uint32_t bytesRead_;
+    uint32_t totalSize_;
+    uint16_t blockSize_;
+    uint16_t blockOffset_;
+    bool valid_;
+};
+
 class TransferPakNullCopySource : public ITransferPakDataCopySource
 {
 public:
@@ -148,6 +192,47 @@ private:
     uint32_t bytesWritten_;
 };
 
+/**
+ * This class implements the ITransferPakDataCopyDestination interface by only writing the 32 byte blocks
+ * that differ from what is already on the cartridge.
+ *
+ * Every block gets read from the cartridge first. Identical blocks are skipped, the others get written and read back
+ * to verify them. So when you're done, the whole save has been verified in the same pass.
+ */
+class TransferPakSaveManagerDiffDestination : public ITransferPakDataCopyDestination
+{
+public:
+    TransferPakSaveManagerDiffDestination(TransferPakSaveManager& saveManager);
+    virtual ~TransferPakSaveManagerDiffDestination();
+
+    bool readyForTransfer() const override;
+
+    uint16_t getCurrentBankIndex() const override;
+    uint32_t getNumberOfBytesWritten() const override;
+
+    uint32_t write(uint8_t *buffer, uint32_t bytesToWrite) override;
+
+    void close() override;
+
+    uint32_t getNumberOfBlocksCompared() const;
+    uint32_t getNumberOfBlocksWritten() const;
+    /**
+     * @brief Returns the number of blocks that didn't read back correctly or couldn't be transferred
+     */
+    uint32_t getNumberOfBlockErrors() const;
+protected:
+private:
+    void flushBlock();
+
+    TransferPakSaveManager& saveManager_;
+    uint8_t blockBuffer_[TPAK_BLOCK_SIZE];
+    uint32_t bytesWritten_;
+    uint32_t numBlocksCompared_;
+    uint32_t numBlocksWritten_;
+    uint32_t numBlockErrors_;
+    uint8_t blockBufferUsed_;
+};
+
 class TransferPakFileCopyDestination : public ITransferPakDataCopyDestination
 {
 public:
@@ -171,7 +256,113 @@ private:
 };
 
 /**
- * This class directs the copy process from the source to the specified output file
+ * This class implements the ITransferPakDataCopyDestination interface by compressing the data into a file on the SD card.
+ *
+ * The data is compressed in blocks of LZ_MAX_BLOCK_SIZE bytes as it arrives. Blocks that don't compress are stored as-is.
+ * Use TransferPakCompressedFileCopySource to read the file back.
+ */
+class TransferPakCompressedFileCopyDestination : public ITransferPakDataCopyDestination
+{
+public:
+    TransferPakCompressedFileCopyDestination(const char *pathOnSDCard, bool resetRTC = false);
+    /**
+     * @brief Writes the compressed data to an already opened stream (for example: one created with fmemopen()).
+     * This instance takes ownership of outputFile and closes it in close()
+     */
+    TransferPakCompressedFileCopyDestination(FILE *outputFile, bool resetRTC);
+    virtual ~TransferPakCompressedFileCopyDestination();
+
+    bool readyForTransfer() const override;
+
+    uint16_t getCurrentBankIndex() const override;
+    uint32_t getNumberOfBytesWritten() const override;
+
+    uint32_t write(uint8_t *buffer, uint32_t bytesToWrite) override;
+
+    void close() override;
+
+    /**
+     * @brief Returns the number of bytes actually written to the file so far (including headers)
+     */
+    uint32_t getNumberOfCompressedBytesWritten() const;
+
+    /**
+     * @brief Returns whether writing any of the blocks or the header failed. This stays valid after close().
+     * If the file was opened by this instance, it gets removed in that case.
+     */
+    bool hasFailed() const;
+protected:
+private:
+    bool flushBlock();
+
+    FILE *outputFile_;
+    // only known when the file was opened by this instance
+    char *outputPath_;
+    uint8_t blockBuffer_[LZ_MAX_BLOCK_SIZE];
+    uint8_t compressedBuffer_[LZ_MAX_BLOCK_SIZE];
+    uint16_t hashTable_[LZ_HASH_TABLE_ENTRIES];
+    uint32_t bytesWritten_;
+    uint32_t compressedBytesWritten_;
+    uint16_t blockBufferUsed_;
+    bool resetRTC_;
+    bool failed_;
+};
+
+/**
+ * This class implements the ITransferPakDataCopyDestination interface by calculating the CRC-32 of the data.
+ * Nothing gets stored. Use it as an additional destination to get a checksum of a backup without a second pass.
+ *
+ * For a save, it can also validate the main checksum of the game in the same pass (see setMainChecksumRegion()).
+ */
+class TransferPakHashCopyDestination : public ITransferPakDataCopyDestination
+{
+public:
+    TransferPakHashCopyDestination();
+    virtual ~TransferPakHashCopyDestination();
+
+    bool readyForTransfer() const override;
+
+    uint16_t getCurrentBankIndex() const override;
+    uint32_t getNumberOfBytesWritten() const override;
+
+    uint32_t write(uint8_t *buffer, uint32_t bytesToWrite) override;
+
+    void close() override;
+
+    uint32_t getCRC32() const;
+
+    /**
+     * @brief Validates the main checksum of the given region of the save while the data passes by.
+     * The data needs to start at the beginning of the save. Call this before the copy starts.
+     */
+    void setMainChecksumRegion(uint8_t generation, const SaveChecksumRegion& region);
+
+    /**
+     * @brief Returns whether the main checksum of the copied save matched.
+     * Only valid after close(). Always false if setMainChecksumRegion() wasn't called or if the data didn't cover the region.
+     */
+    bool isMainChecksumValid() const;
+protected:
+private:
+    void updateMainChecksum(const uint8_t* buffer, uint32_t size);
+
+    SaveChecksumRegion checksumRegion_;
+    uint32_t crc_;
+    uint32_t bytesWritten_;
+    uint32_t byteSum_;
+    uint16_t storedChecksum_;
+    // 0 if we don't validate a checksum
+    uint8_t checksumGeneration_;
+    bool checksumValid_;
+};
+
+/**
+ * @brief The maximum number of destinations a single TransferPakDataCopier can feed
+ */
+#define TRANSFERPAK_DATACOPIER_MAX_DESTINATIONS 4
+
+/**
+ * This class directs the copy process from the source to the specified output file(s)
  *
  * It exists to abstract the source (rom/SRAM) and control the copy flow/speed and to
  * allow us to give UI feedback on the copy process.
@@ -179,6 +370,10 @@ private:
  * After all: I found that the transfer pak is able to read 32 bytes every 1,5-2milliseconds
  * We don't want the UI to remain frozen during that time.
  * (source: http://n64devkit.square7.ch/pro-man/pro26/26-07.htm)
+ *
+ * Because reading from the transfer pak is so slow, every chunk is only read once and then fed to all destinations.
+ * (for example: a file, a compressed file and a hash)
+ * If a destination stops accepting data, it is marked as failed and skipped from then on. The other destinations continue.
  */
 class TransferPakDataCopier
 {
@@ -186,14 +381,33 @@ public:
     TransferPakDataCopier(ITransferPakDataCopySource &source, ITransferPakDataCopyDestination &destination);
     ~TransferPakDataCopier();
 
+    /**
+     * @brief Adds another destination to copy to. This must be done before the first copyChunk() call.
+     * @return false if there's no room for more destinations
+     */
+    bool addDestination(ITransferPakDataCopyDestination &destination);
+
     uint16_t getCurrentBankIndex() const;
     uint32_t getNumberOfBytesRead() const;
+
+    /**
+     * @brief Reads numBytesToCopy bytes from the source and writes them to every destination that hasn't failed
+     * @return the number of bytes read from the source
+     */
     size_t copyChunk(uint32_t numBytesToCopy);
 
+    /**
+     * @brief Returns whether the destination at the given index (in the order they were added) stopped accepting data
+     */
+    bool isDestinationFailed(uint8_t index) const;
 protected:
 private:
+    bool writeToDestination(uint8_t index, uint8_t *buffer, uint32_t bytesToWrite);
+
     ITransferPakDataCopySource &source_;
-    ITransferPakDataCopyDestination &destination_;
+    ITransferPakDataCopyDestination *destinations_[TRANSFERPAK_DATACOPIER_MAX_DESTINATIONS];
+    bool destinationFailed_[TRANSFERPAK_DATACOPIER_MAX_DESTINATIONS];
+    uint8_t numDestinations_;
 };
 
 #endif
\ No newline at end of file
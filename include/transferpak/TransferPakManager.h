@@ -2,6 +2,7 @@
 #define _TRANSFERPAKMANAGER_H
 
 #include <libdragon.h>
+#include "transferpak/VirtualCartridge.h"
 
 #ifdef __GNUC__
 #define likely(x)       __builtin_expect(!!(x), 1)
@@ -20,6 +21,26 @@ enum class TransferPakMode
 /** @brief Transfer Pak command block size (32 bytes) */
 #define TPAK_BLOCK_SIZE  0x20
 
+/**
+ * @brief This interface can be implemented to get notified before a SRAM block gets modified.
+ * See TransferPakManager::setSRAMWriteListener()
+ */
+class ITransferPakSRAMWriteListener
+{
+public:
+    virtual ~ITransferPakSRAMWriteListener();
+
+    /**
+     * @brief This function is called right before the 32 byte block at the given SRAM bank and SRAMBankOffset
+     * gets modified. originalData contains the contents of the block before the modification.
+     *
+     * The block hasn't been written at this point, so whatever you do with originalData, you can do it before the cartridge changes.
+     */
+    virtual void onBeforeSRAMBlockWrite(uint8_t SRAMBankIndex, uint16_t SRAMBankOffset, const uint8_t* originalData) = 0;
+protected:
+private:
+};
+
 /**
  * @brief This class manages the N64 transfer pak
  * Both SRAM and ROM access are implemented in the same class here
@@ -31,6 +52,9 @@ enum class TransferPakMode
  * 
  * So you can't implement ROM and SRAM reading in separate classes.
  * TransferPakManager manages and keeps track of all this and abstracts this complexity.
+ *
+ * Every save manager and rom reader goes through this class. That's why this is also where a VirtualCartridge can replace the
+ * cartridge in the transfer pak: see openVirtualCartridge().
  */
 class TransferPakManager
 {
@@ -56,6 +80,7 @@ public:
 
     /**
      * @brief This function enables/disables gameboy RAM/RTC access.
+     * With a virtual cartridge, disabling it writes back the pending changes to the .sav file instead.
      * WARNING: it switches to transfer pak bank 0
      */
     void setRAMEnabled(bool enabled);
@@ -66,6 +91,11 @@ public:
      */
     void switchGBSRAMBank(uint8_t bankIndex);
 
+    /**
+     * @brief Returns the Gameboy RAM bank index that was last switched to (0xFF if it isn't known)
+     */
+    uint8_t getCurrentGBSRAMBank() const;
+
     /**
      * For MBC1 controllers, this will effect the ROM or RAM modes, depending on what is written in $6000-$7FFF. 
      * If the mode is 0 (default), the RAM bank will be locked to 0, but the extended banks (bankindex > 0x1F)
@@ -106,8 +136,93 @@ public:
      * @brief This function writes the current writeBuffer immediately
      */
     void finishWrites();
+
+    /**
+     * @brief This function reads a single 32 byte block from the specified SRAMBankOffset directly into data.
+     * Unlike readSRAM(), it doesn't go through (or affect) the read buffer.
+     *
+     * SRAMBankOffset must be aligned to TPAK_BLOCK_SIZE.
+     * @return whether the transfer pak reported success
+     */
+    bool readSRAMBlock(uint16_t SRAMBankOffset, uint8_t* data);
+
+    /**
+     * @brief This function writes a single 32 byte block to the specified SRAMBankOffset immediately.
+     * Unlike writeSRAM(), it doesn't need to read the block first, because the whole block gets overwritten.
+     *
+     * SRAMBankOffset must be aligned to TPAK_BLOCK_SIZE.
+     * @return whether the transfer pak reported success
+     */
+    bool writeSRAMBlock(uint16_t SRAMBankOffset, const uint8_t* data);
+
+    /**
+     * @brief This function fills size bytes of SRAM at the specified SRAMBankOffset with the given value.
+     *
+     * Whole 32 byte blocks are written directly from a constant block without reading them first.
+     * Only partial blocks at the start and end (if the range isn't aligned) go through writeSRAM()
+     *
+     * @return false if the transfer pak reported an error (for instance: a joybus CRC mismatch) for any of the writes
+     */
+    bool fillSRAM(uint16_t SRAMBankOffset, uint8_t value, uint16_t size);
+
+    /**
+     * @brief Sets a listener that gets notified before every SRAM block modification (or nullptr to remove it)
+     * This is used for the undo journal.
+     *
+     * WARNING: with a listener set, writeSRAMBlock() and fillSRAM() need to read every block before writing it.
+     */
+    void setSRAMWriteListener(ITransferPakSRAMWriteListener* listener);
+
+    /**
+     * @brief Replaces the cartridge in the transfer pak with the .sav file at the given path (see VirtualCartridge).
+     * From then on, all SRAM access is served from a copy of the save in RAM. If there's a matching ROM file next to the .sav file,
+     * ROM access (and the cartridge header) is served from that file and the transfer pak isn't needed at all.
+     * Otherwise the ROM is still read from the cartridge in the transfer pak.
+     *
+     * The changes are written back to the .sav file whenever SRAM access gets disabled (setRAMEnabled(false)), which is
+     * at the end of every edit or copy job. writeBackVirtualCartridge() and closeVirtualCartridge() do the same.
+     */
+    bool openVirtualCartridge(const char* savePath);
+
+    /**
+     * @brief Writes the pending changes of the virtual cartridge back to its .sav file
+     */
+    bool writeBackVirtualCartridge();
+
+    /**
+     * @brief Writes back the pending changes and switches back to the cartridge in the transfer pak
+     * @return false if the changes couldn't be written back. The virtual cartridge stays open in that case
+     */
+    bool closeVirtualCartridge();
+
+    bool isVirtualCartridge() const;
+    const VirtualCartridge& getVirtualCartridge() const;
 protected:
 private:
+    /**
+     * @brief Returns whether the ROM is read from the ROM file of the virtual cartridge instead of the transfer pak
+     */
+    bool isVirtualROM() const;
+
+    /**
+     * @brief Reads a single 32 byte block at the given gameboy address from the transfer pak or the virtual cartridge
+     * @return 0 on success, just like tpak_read()
+     */
+    int readBlock(uint16_t gbAddress, uint8_t* data);
+
+    /**
+     * @brief Writes a single 32 byte block at the given gameboy address to the transfer pak or the virtual cartridge
+     * @return 0 on success, just like tpak_write()
+     */
+    int writeBlock(uint16_t gbAddress, const uint8_t* data);
+
+    /**
+     * @brief Reads the block at the given SRAMBankOffset and passes it to the SRAM write listener (if any)
+     */
+    void notifySRAMWriteListener(uint16_t SRAMBankOffset);
+
+    VirtualCartridge virtualCartridge_;
+    ITransferPakSRAMWriteListener* sramWriteListener_;
     joypad_port_t port_;
     bool isPoweredOn_;
     uint8_t currentSRAMBank_;
@@ -0,0 +1,129 @@
+#ifndef _TRANSFERPAKOVERLAYSAVEMANAGER_H
+#define _TRANSFERPAKOVERLAYSAVEMANAGER_H
+
+#include "transferpak/TransferPakSaveManager.h"
+#include "transferpak/TransferPakManager.h"
+
+/**
+ * @brief The maximum number of 32 byte blocks that can be modified in a TransferPakOverlaySaveManager
+ * This covers an entire 8 KB SRAM bank, which is enough for the Gen 2 backup copy of the main save data.
+ */
+#define TPAK_OVERLAY_MAX_BLOCKS 256
+
+/**
+ * @brief The maximum save size the TransferPakOverlaySaveManager supports (32 KB: 4 SRAM banks)
+ */
+#define TPAK_OVERLAY_MAX_SAVE_SIZE 0x8000
+
+/**
+ * @brief A range of consecutive bytes that differ between the overlay and the cartridge
+ */
+typedef struct SaveByteRange
+{
+    uint32_t offset;
+    uint16_t size;
+} SaveByteRange;
+
+/**
+ * @brief This ISaveManager implementation keeps all writes in RAM instead of writing them to the cartridge.
+ *
+ * The first time a 32 byte block gets written, its original contents are read from the cartridge. From then on, reads and writes of
+ * that block are served from RAM. Reads of untouched blocks still go to the cartridge.
+ *
+ * This allows a game reader to do any number of edits (including its checksum calculation) without a single write to the cartridge.
+ * commit() then writes all modified blocks in ascending order. getChangedRanges() tells you exactly what would be written.
+ */
+class TransferPakOverlaySaveManager : public BaseSaveManager
+{
+public:
+    TransferPakOverlaySaveManager(TransferPakManager& pakManager);
+    virtual ~TransferPakOverlaySaveManager();
+
+    bool readByte(uint8_t& outByte) override;
+    void writeByte(uint8_t byte) override;
+
+    bool read(uint8_t* outBuffer, uint32_t bytesToRead) override;
+    void write(const uint8_t* buffer, uint32_t bytesToWrite) override;
+
+    uint8_t peek() override;
+
+    bool advance(uint32_t numBytes = 1) override;
+    bool rewind(uint32_t numBytes = 1) override;
+
+    bool seek(uint32_t absoluteOffset) override;
+
+    uint8_t getCurrentBankIndex() const override;
+
+    /**
+     * @brief Returns whether a write couldn't be kept in RAM (because there were too many modified blocks
+     * or because the write was outside of the supported save size). If so, commit() will refuse to write anything.
+     */
+    bool hasOverflowed() const;
+
+    /**
+     * @brief Returns the number of blocks that have been written to (whether their contents actually changed or not)
+     */
+    uint16_t getNumberOfTouchedBlocks() const;
+
+    /**
+     * @brief Compares the modified blocks with their original contents and returns the ranges of bytes that differ, in ascending order.
+     *
+     * @param outRanges buffer for the ranges. May be nullptr if you're only interested in the numbers
+     * @param outNumRanges the total number of ranges (can be larger than maxRanges)
+     * @return the total number of bytes that differ
+     */
+    uint32_t getChangedRanges(SaveByteRange* outRanges, uint16_t maxRanges, uint16_t& outNumRanges) const;
+
+    /**
+     * @brief Returns (sum of the current bytes) - (sum of the original bytes) over the given range of the save.
+     * Only the modified blocks need to be looked at for this, so it doesn't cause any transfer pak traffic.
+     * Because the Gen 1 and Gen 2 checksums are simple byte sums, this is all you need to update them.
+     *
+     * @param endOffset the last offset of the range (inclusive)
+     */
+    int32_t getByteSumDelta(uint32_t startOffset, uint32_t endOffset) const;
+
+    /**
+     * @brief Reads the original contents (so: before any modification in the overlay) of the given range of the save.
+     * This doesn't change the current offset.
+     */
+    bool readOriginal(uint32_t absoluteOffset, uint8_t* outBuffer, uint32_t bytesToRead);
+
+    /**
+     * @brief Writes the modified blocks that differ from their original contents to the cartridge, in ascending order.
+     * SRAM access must be enabled by the caller.
+     *
+     * @param outNumBlocksWritten the number of blocks that were actually written
+     * @return false if the overlay has overflowed or if any of the writes failed
+     */
+    bool commit(uint16_t& outNumBlocksWritten);
+
+    /**
+     * @brief Drops all modifications
+     */
+    void reset();
+protected:
+private:
+    /**
+     * @brief Returns the overlay slot of the block at the given (absolute) offset or -1 if it wasn't modified
+     */
+    int16_t getSlot(uint32_t absoluteOffset) const;
+
+    /**
+     * @brief Returns the overlay slot of the block at the given (absolute) offset. If it isn't in the overlay yet, its original contents are
+     * read from the cartridge first.
+     * @return -1 if there are no slots left
+     */
+    int16_t getOrCreateSlot(uint32_t absoluteOffset);
+
+    TransferPakSaveManager cartridgeSaveManager_;
+    // for every block of the save, the index of its overlay slot (or -1)
+    int16_t blockSlots_[TPAK_OVERLAY_MAX_SAVE_SIZE / TPAK_BLOCK_SIZE];
+    uint8_t* modifiedBlocks_;
+    uint8_t* originalBlocks_;
+    uint32_t offset_;
+    uint16_t numSlotsUsed_;
+    bool overflowed_;
+};
+
+#endif
@@ -5,6 +5,18 @@
 
 class TransferPakManager;
 
+enum class SRAMBlockWriteResult
+{
+    // the block on the cartridge already contained the same data
+    UNCHANGED,
+    // the block was written and the read-back matched
+    WRITTEN,
+    // the block was written, but reading it back returned different data
+    VERIFY_FAILED,
+    // the transfer pak reported an error
+    TRANSFER_ERROR
+};
+
 class TransferPakSaveManager : public BaseSaveManager
 {
 public:
@@ -53,6 +65,22 @@ public:
      * @brief Returns the index of the current bank
      */
     uint8_t getCurrentBankIndex() const override;
+
+    /**
+     * @brief This function compares the 32 byte block at the current offset with the given data
+     * and only writes it to the cartridge if it is different. Written blocks are read back to verify them.
+     *
+     * The current offset must be aligned to TPAK_BLOCK_SIZE. The internal pointer is advanced by TPAK_BLOCK_SIZE bytes.
+     */
+    SRAMBlockWriteResult writeBlockIfChanged(const uint8_t* block);
+
+    /**
+     * @brief This function fills the next size bytes with the specified value and advances the internal pointer by size bytes.
+     * This is much faster than write(), because it doesn't need to read the blocks it overwrites.
+     *
+     * @return false if the transfer pak reported an error for any of the writes
+     */
+    bool fill(uint8_t value, uint32_t size);
 protected:
 private:
     TransferPakManager& pakManager_;
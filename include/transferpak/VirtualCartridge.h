@@ -0,0 +1,136 @@
+#ifndef _VIRTUALCARTRIDGE_H
+#define _VIRTUALCARTRIDGE_H
+
+#include <libdragon.h>
+#include <cstdio>
+
+/**
+ * @brief The size of the save a VirtualCartridge keeps in RAM (32 KB: 4 SRAM banks). This covers every Gen 1 and Gen 2 save.
+ */
+#define VIRTUAL_CARTRIDGE_SRAM_SIZE 0x8000
+
+/**
+ * @brief The size of a single gameboy SRAM bank
+ */
+#define VIRTUAL_CARTRIDGE_SRAM_BANK_SIZE 0x2000
+
+/**
+ * @brief The size of a single gameboy ROM bank
+ */
+#define VIRTUAL_CARTRIDGE_ROM_BANK_SIZE 0x4000
+
+/**
+ * @brief The granularity with which a VirtualCartridge tracks modified parts of the save (the transfer pak block size)
+ */
+#define VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE 0x20
+
+/**
+ * @brief The size of the buffer that holds the path of the .sav file
+ */
+#define VIRTUAL_CARTRIDGE_PATH_SIZE 256
+
+/**
+ * @brief This class emulates a gameboy cartridge with a .sav file (and optionally a .gb/.gbc ROM file) on the SD card.
+ * See TransferPakManager::openVirtualCartridge()
+ *
+ * The whole save is loaded into RAM with a single read when it is opened. From then on, all SRAM reads and writes are served from
+ * this in-RAM mirror. Writes only mark the modified 32 byte blocks as dirty: nothing is written to the SD card until writeBack()
+ * (or close()) is called. The TransferPakManager does that whenever SRAM access gets disabled, which is at the end of every edit
+ * or copy job. writeBack() then writes the dirty blocks in ascending order, one write per run of consecutive blocks.
+ * Anything beyond the first 32 KB of the file (like the RTC data some emulators append) is left alone.
+ *
+ * If a ROM file with the same name exists next to the .sav file (for instance "Pokemon Red.gb" for "Pokemon Red.sav"),
+ * it is used as the ROM of the virtual cartridge. Bank 0 stays in RAM and the switchable bank is read from the file (with a single read)
+ * the first time it is accessed after a bank switch. Without a ROM file, the ROM is read from the cartridge in the transfer pak instead.
+ */
+class VirtualCartridge
+{
+public:
+    VirtualCartridge();
+    ~VirtualCartridge();
+
+    /**
+     * @brief Loads the .sav file at the given path into RAM and opens the matching ROM file (if any)
+     * @return false if the file couldn't be read or if it's too small to be a Gen 1/Gen 2 save
+     */
+    bool open(const char* savePath);
+
+    /**
+     * @brief Writes back the pending changes and releases the save and ROM buffers
+     * @return false if writing back the changes failed. In that case, the virtual cartridge stays open with all of its changes
+     */
+    bool close();
+
+    /**
+     * @brief Writes all modified blocks of the save back to the .sav file
+     * @return false if the file couldn't be written
+     */
+    bool writeBack();
+
+    bool isOpen() const;
+
+    /**
+     * @brief Returns whether the virtual cartridge has its own ROM file. If not, the ROM needs to be read from the transfer pak
+     */
+    bool hasRom() const;
+
+    /**
+     * @brief Returns whether there are modifications that haven't been written back yet
+     */
+    bool isDirty() const;
+
+    const char* getSavePath() const;
+
+    /**
+     * @brief Copies the gameboy cartridge header from the ROM file
+     * @return false if the virtual cartridge has no ROM file
+     */
+    bool readCartridgeHeader(gameboy_cartridge_header& cartridgeHeader);
+
+    /**
+     * @brief Switches the ROM bank that is mapped to 0x4000-0x7FFF. The bank itself is only read on the next readROM() of that range
+     */
+    void switchROMBank(uint8_t bankIndex);
+
+    /**
+     * @brief Reads from the ROM at the given gameboy address (0x0000-0x7FFF). Bytes outside the ROM file read as 0xFF
+     */
+    void readROM(uint16_t gbAddress, uint8_t* data, uint16_t size);
+
+    /**
+     * @brief Reads from the in-RAM save at the given SRAM bank and offset. Bytes outside the save read as 0xFF
+     */
+    void readSRAM(uint8_t bankIndex, uint16_t SRAMBankOffset, uint8_t* data, uint16_t size);
+
+    /**
+     * @brief Writes to the in-RAM save at the given SRAM bank and offset and marks the affected blocks as dirty
+     */
+    void writeSRAM(uint8_t bankIndex, uint16_t SRAMBankOffset, const uint8_t* data, uint16_t size);
+protected:
+private:
+    /**
+     * @brief Reads the given ROM bank from the ROM file into the given buffer
+     */
+    bool loadROMBank(uint8_t bankIndex, uint8_t* buffer);
+
+    /**
+     * @brief Releases the save and ROM buffers without writing anything back
+     */
+    void release();
+
+    bool isBlockDirty(uint16_t blockIndex) const;
+
+    FILE* romFile_;
+    uint8_t* sram_;
+    uint8_t* romBank0_;
+    uint8_t* romBankX_;
+    uint32_t romSize_;
+    uint8_t dirtyBlocks_[VIRTUAL_CARTRIDGE_SRAM_SIZE / VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE / 8];
+    char savePath_[VIRTUAL_CARTRIDGE_PATH_SIZE];
+    uint8_t currentROMBank_;
+    // the bank that is currently in romBankX_. 0 means that no bank has been loaded yet
+    uint8_t loadedROMBank_;
+    bool dirty_;
+};
+
+#endif
@@ -126,6 +126,8 @@ public:
     /**
      * @brief Sets a file extension filter. The files that have such an extension will be shown,
      * whereas non-matching files WON'T be shown
+     *
+     * You can specify multiple extensions by separating them with '|'. (for example: ".sav|.sav.lz")
      */
     void setFileExtensionToFilter(const char* fileExtensionFilter);
 
@@ -38,6 +38,7 @@ public:
             itemWidget->setData(dataList[i]);
             itemWidget->setStyle(itemStyle);
             list_.addWidget(itemWidget);
+            widgets_.push_back(itemWidget);
         }
     }
 
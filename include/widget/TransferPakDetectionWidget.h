@@ -6,6 +6,8 @@
 #include "core/RDPQGraphics.h"
 #include "gen1/Gen1Common.h"
 #include "gen2/Gen2Common.h"
+#include "save/SaveChecksum.h"
+#include "core/CartridgeIdentification.h"
 
 class AnimationManager;
 class TransferPakManager;
@@ -104,6 +106,18 @@ public:
      */
     void retrieveGameType(Gen1GameType& outGen1Type, Gen2GameType& outGen2Type);
 
+    /**
+     * @brief Returns the localization language of the game (as a uint8_t, just like SceneDependencies::localization)
+     * This is determined while validating the save, so it's only available after the VALIDATING_GAME_SAVE state.
+     */
+    uint8_t getLocalization() const;
+
+    /**
+     * @brief Returns the get_ticks() value of the moment the detection was started.
+     * Useful for measuring the boot-to-menu latency.
+     */
+    uint64_t getDetectionStartTime() const;
+
     void setStyle(const TransferPakDetectionWidgetStyle& style);
     void setStateChangedCallback(void (*callback)(void*, TransferPakWidgetState), void* context);
 protected:
@@ -129,15 +143,39 @@ private:
     /**
      * @brief This function detects the Pokémon game type in the N64 transfer pak. 
      * It stores the found value in the gen1Type_ and gen2Type_ member vars. These values can be retrieved with retrieveGameType()
+     * For known retail cartridges, this comes straight from the table of known cartridges.
      * 
      * @return returns true if the connected game pak is a Gen1 or Gen2 pokémon gameboy game.
      */
     bool detectGameType();
 
+    /**
+     * @brief Applies the palette for the cartridge icon of the detected game and determines which label sprite should be loaded.
+     * The label sprite itself isn't loaded here: that happens in loadPendingCartridgeLabel() during the save validation,
+     * so that it doesn't delay the start of the validation.
+     */
     void updateCartridgeIcon();
 
+    void loadPendingCartridgeLabel();
+
+    /**
+     * @brief Validates the game save in one go with the libpokemegb game reader.
+     * This is the fallback for games for which SaveChecksumValidator doesn't know the checksum layout.
+     */
     bool validateGameSave();
 
+    /**
+     * @brief Starts the (time-sliced) validation of the game save. The actual work is done by stepGameSaveValidation() every frame
+     * @return false if the save can't be validated in steps.
+     */
+    bool startGameSaveValidation();
+
+    /**
+     * @brief Validates the next part of the game save
+     * @return true when the validation is finished
+     */
+    bool stepGameSaveValidation();
+
     TransferPakDetectionWidgetStyle style_;
     AnimationManager& animManager_;
     TransferPakManager& tpakManager_;
@@ -152,6 +190,13 @@ private:
     sprite_t* cartridgeLabelSprite_;
     SpriteRenderSettings cartridgeIconRenderSettings_;
     SpriteRenderSettings cartridgeLabelRenderSettings_;
+    SaveChecksumValidator saveValidator_;
+    const char* pendingLabelSpritePath_;
+    uint64_t detectionStartTime_;
+    uint64_t stateStartTime_;
+    CartridgeIdentity knownCartridge_;
+    uint8_t localization_;
+    bool isKnownCartridge_;
     bool focused_;
     bool visible_;
 };
@@ -0,0 +1,44 @@
+#include "core/CartridgeIdentification.h"
+#include "core/KnownCartridges.h"
+
+#include <cstring>
+
+bool identifyKnownCartridge(const gameboy_cartridge_header& header, CartridgeIdentity& outIdentity)
+{
+#if KNOWN_CARTRIDGE_COUNT > 0
+    char title[KNOWN_CARTRIDGE_TITLE_SIZE];
+
+    // in the header, the (new style) title is immediately followed by the manufacturer code.
+    // Older cartridges (like the Gen 1 games) use these bytes for a longer title, so we compare them all at once.
+    // That's why we copy from the 16 byte title field that covers both.
+    memcpy(title, header.title, KNOWN_CARTRIDGE_TITLE_SIZE);
+
+    for(const KnownCartridge& known : knownCartridges)
+    {
+        if(memcmp(title, known.title, KNOWN_CARTRIDGE_TITLE_SIZE) || header.destination_code != known.destinationCode)
+        {
+            continue;
+        }
+        if(known.versionNumber != KNOWN_CARTRIDGE_ANY_VERSION && header.version_number != known.versionNumber)
+        {
+            continue;
+        }
+        if(known.globalChecksum != KNOWN_CARTRIDGE_ANY_GLOBAL_CHECKSUM && header.global_checksum != known.globalChecksum)
+        {
+            continue;
+        }
+
+        outIdentity = CartridgeIdentity{
+            .generation = known.generation,
+            .specificGenVersion = known.specificGenVersion,
+            .localization = known.localization
+        };
+        return true;
+    }
+#else
+    // no dumps have been added to tools/known_cartridges.csv (yet). Every cartridge gets probed
+    (void)header;
+    (void)outIdentity;
+#endif
+    return false;
+}
@@ -0,0 +1,274 @@
+#include "core/GameSession.h"
+#include "save/SaveEditTransaction.h"
+
+#include <cstring>
+
+GameSession::GameSession(TransferPakManager& tpakManager)
+    : tpakManager_(tpakManager)
+    , romReader_(tpakManager)
+    , saveManager_(tpakManager)
+    , gen1Reader_(nullptr)
+    , gen2Reader_(nullptr)
+    , boxIndex_(nullptr)
+    , speciesTables_()
+    , gen1PartyPokemon_()
+    , gen1PartyNicknames_()
+    , trainerName_()
+    , trainerID_(0)
+    , generation_(0)
+    , specificGenVersion_(0)
+    , localization_(0)
+    , gen1PartySize_(0)
+    , gen1CurrentMap_(0)
+    , trainerInfoCached_(false)
+    , gen1PartyCached_(false)
+    , gen1CurrentMapCached_(false)
+{
+}
+
+GameSession::~GameSession()
+{
+    end();
+}
+
+void GameSession::start(uint8_t generation, uint8_t specificGenVersion, uint8_t localization)
+{
+    end();
+
+    if(generation == 1)
+    {
+        gen1Reader_ = new Gen1GameReader(romReader_, saveManager_, static_cast<Gen1GameType>(specificGenVersion), static_cast<Gen1LocalizationLanguage>(localization));
+        // the species tables are read in small steps from the frame loop (see stepSpeciesTables()) to avoid freezing the boot
+        speciesTables_.start(*gen1Reader_);
+    }
+    else if(generation == 2)
+    {
+        gen2Reader_ = new Gen2GameReader(romReader_, saveManager_, static_cast<Gen2GameType>(specificGenVersion), static_cast<Gen2LocalizationLanguage>(localization));
+        speciesTables_.start(*gen2Reader_, localization);
+    }
+    else
+    {
+        debugf("[GameSession]: ERROR: unsupported generation %hu\r\n", generation);
+        return;
+    }
+    generation_ = generation;
+    specificGenVersion_ = specificGenVersion;
+    localization_ = localization;
+}
+
+void GameSession::end()
+{
+    // the cache points to the game reader, so it needs to go first
+    speciesTables_.reset();
+    delete gen1Reader_;
+    gen1Reader_ = nullptr;
+    delete gen2Reader_;
+    gen2Reader_ = nullptr;
+    delete boxIndex_;
+    boxIndex_ = nullptr;
+    generation_ = 0;
+    invalidate();
+}
+
+bool GameSession::isActive() const
+{
+    return (generation_ != 0);
+}
+
+uint8_t GameSession::getGeneration() const
+{
+    return generation_;
+}
+
+Gen1GameReader* GameSession::getGen1Reader()
+{
+    return gen1Reader_;
+}
+
+Gen2GameReader* GameSession::getGen2Reader()
+{
+    return gen2Reader_;
+}
+
+const char* GameSession::getTrainerName()
+{
+    loadTrainerInfo();
+    return trainerName_;
+}
+
+uint16_t GameSession::getTrainerID()
+{
+    loadTrainerInfo();
+    return trainerID_;
+}
+
+uint8_t GameSession::getGen1CurrentMap()
+{
+    if(!gen1CurrentMapCached_ && gen1Reader_)
+    {
+        gen1CurrentMap_ = gen1Reader_->getCurrentMap();
+        gen1CurrentMapCached_ = true;
+    }
+    return gen1CurrentMap_;
+}
+
+uint8_t GameSession::getGen1PartySize()
+{
+    if(!loadGen1Party())
+    {
+        return 0;
+    }
+    return gen1PartySize_;
+}
+
+bool GameSession::getGen1PartyPokemon(uint8_t partyIndex, Gen1TrainerPokemon& outPoke)
+{
+    if(!loadGen1Party() || partyIndex >= gen1PartySize_)
+    {
+        return false;
+    }
+    outPoke = gen1PartyPokemon_[partyIndex];
+    return true;
+}
+
+const char* GameSession::getGen1PartyPokemonNickname(uint8_t partyIndex)
+{
+    if(!loadGen1Party() || partyIndex >= gen1PartySize_)
+    {
+        return "";
+    }
+    return gen1PartyNicknames_[partyIndex];
+}
+
+bool GameSession::setGen1PartyPokemon(uint8_t partyIndex, const Gen1TrainerPokemon& poke)
+{
+    uint16_t numBlocksWritten;
+
+    if(!gen1Reader_ || partyIndex >= getGen1PartySize())
+    {
+        return false;
+    }
+
+    SaveEditTransaction transaction(tpakManager_, generation_, specificGenVersion_, localization_);
+    transaction.setGen1PartyPokemon(partyIndex, poke);
+    if(!transaction.commit(numBlocksWritten))
+    {
+        return false;
+    }
+
+    if(gen1PartyCached_ && partyIndex < gen1PartySize_)
+    {
+        gen1PartyPokemon_[partyIndex] = poke;
+    }
+    return true;
+}
+
+const PokemonBoxIndex* GameSession::getBoxIndex()
+{
+    if(boxIndex_ && boxIndex_->isBuilt())
+    {
+        return boxIndex_;
+    }
+    if(!isActive())
+    {
+        return nullptr;
+    }
+    if(!boxIndex_)
+    {
+        // allocated on first use because of its size. Not every session needs it
+        boxIndex_ = new PokemonBoxIndex(tpakManager_);
+    }
+
+    return (boxIndex_->build(speciesTables_, generation_, specificGenVersion_, localization_)) ? boxIndex_ : nullptr;
+}
+
+bool GameSession::stepSpeciesTables(uint16_t maxSpecies)
+{
+    if(!isActive())
+    {
+        return true;
+    }
+    return speciesTables_.step(maxSpecies);
+}
+
+const SpeciesTableCache& GameSession::getSpeciesTables() const
+{
+    return speciesTables_;
+}
+
+void GameSession::invalidate()
+{
+    trainerInfoCached_ = false;
+    gen1PartyCached_ = false;
+    gen1CurrentMapCached_ = false;
+    if(boxIndex_)
+    {
+        boxIndex_->reset();
+    }
+}
+
+void GameSession::loadTrainerInfo()
+{
+    const char* trainerName;
+
+    if(trainerInfoCached_)
+    {
+        return;
+    }
+
+    if(gen1Reader_)
+    {
+        trainerName = gen1Reader_->getTrainerName();
+        trainerID_ = gen1Reader_->getTrainerID();
+    }
+    else if(gen2Reader_)
+    {
+        trainerName = gen2Reader_->getTrainerName();
+        trainerID_ = gen2Reader_->getTrainerID();
+    }
+    else
+    {
+        return;
+    }
+
+    strncpy(trainerName_, trainerName, sizeof(trainerName_) - 1);
+    trainerName_[sizeof(trainerName_) - 1] = '\0';
+    trainerInfoCached_ = true;
+}
+
+bool GameSession::loadGen1Party()
+{
+    if(gen1PartyCached_)
+    {
+        return true;
+    }
+
+    if(!gen1Reader_)
+    {
+        return false;
+    }
+
+    Gen1Party party = gen1Reader_->getParty();
+    gen1PartySize_ = party.getNumberOfPokemon();
+    if(gen1PartySize_ > GAME_SESSION_MAX_PARTY_SIZE)
+    {
+        debugf("[GameSession]: ERROR: invalid party size %hu\r\n", gen1PartySize_);
+        gen1PartySize_ = 0;
+        return false;
+    }
+
+    for(uint8_t i = 0; i < gen1PartySize_; ++i)
+    {
+        if(!party.getPokemon(i, gen1PartyPokemon_[i], false))
+        {
+            gen1PartySize_ = 0;
+            return false;
+        }
+        // getPokemonNickname() reuses the same internal buffer on every call. So we need to copy it
+        strncpy(gen1PartyNicknames_[i], party.getPokemonNickname(i), GAME_SESSION_NICKNAME_SIZE - 1);
+        gen1PartyNicknames_[i][GAME_SESSION_NICKNAME_SIZE - 1] = '\0';
+    }
+
+    gen1PartyCached_ = true;
+    return true;
+}
@@ -0,0 +1,55 @@
+#include "core/Hash.h"
+
+static const uint64_t FNV1A64_PRIME = 0x100000001B3ull;
+static const uint32_t CRC32_POLYNOMIAL = 0xEDB88320u;
+
+static uint32_t crc32Table[256];
+static bool crc32TableInitialized = false;
+
+static void initCRC32Table()
+{
+    uint32_t value;
+
+    for(uint32_t i = 0; i < 256; ++i)
+    {
+        value = i;
+        for(uint8_t bit = 0; bit < 8; ++bit)
+        {
+            value = (value & 1) ? (value >> 1) ^ CRC32_POLYNOMIAL : (value >> 1);
+        }
+        crc32Table[i] = value;
+    }
+    crc32TableInitialized = true;
+}
+
+uint64_t fnv1a64(const uint8_t* data, size_t size, uint64_t seed)
+{
+    uint64_t hash = seed;
+    const uint8_t* const end = data + size;
+
+    while(data < end)
+    {
+        hash ^= (*data);
+        hash *= FNV1A64_PRIME;
+        ++data;
+    }
+    return hash;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc)
+{
+    const uint8_t* const end = data + size;
+
+    if(!crc32TableInitialized)
+    {
+        initCRC32Table();
+    }
+
+    crc = ~crc;
+    while(data < end)
+    {
+        crc = crc32Table[(crc ^ (*data)) & 0xFF] ^ (crc >> 8);
+        ++data;
+    }
+    return ~crc;
+}
@@ -0,0 +1,257 @@
+#include "core/LZCompression.h"
+
+#include <cstring>
+
+static const uint16_t LZ_MIN_MATCH_LENGTH = 4;
+// the last bytes of a block are always stored as literals. This lets the match search read 4 bytes at a time without bounds checks
+static const uint16_t LZ_LAST_LITERALS = 5;
+static const uint16_t LZ_MATCH_SEARCH_LIMIT = 12;
+static const uint16_t LZ_EMPTY_HASH_ENTRY = 0xFFFF;
+
+static inline uint32_t read32(const uint8_t* src)
+{
+    // the VR4300 doesn't do unaligned loads. memcpy lets the compiler pick lwl/lwr
+    uint32_t ret;
+    memcpy(&ret, src, sizeof(ret));
+    return ret;
+}
+
+static inline uint16_t hash32(uint32_t sequence)
+{
+    // Knuth's multiplicative hash. The top 11 bits index the LZ_HASH_TABLE_ENTRIES sized table
+    return static_cast<uint16_t>((sequence * 2654435761u) >> 21);
+}
+
+/**
+ * @brief Writes the remainder of a length that didn't fit in the 4 bits of the token
+ * @return false if it doesn't fit in the output buffer
+ */
+static bool writeLengthExtension(uint8_t*& op, const uint8_t* const opEnd, uint32_t length)
+{
+    while(length >= 255)
+    {
+        if(op >= opEnd)
+        {
+            return false;
+        }
+        *op = 255;
+        ++op;
+        length -= 255;
+    }
+
+    if(op >= opEnd)
+    {
+        return false;
+    }
+    *op = static_cast<uint8_t>(length);
+    ++op;
+    return true;
+}
+
+/**
+ * @brief Writes a sequence: token, literal length extension, literals and (if matchLength > 0) offset + match length extension
+ * @return false if it doesn't fit in the output buffer
+ */
+static bool writeSequence(uint8_t*& op, const uint8_t* const opEnd, const uint8_t* literals, uint16_t literalLength, uint16_t offset, uint16_t matchLength)
+{
+    uint8_t* const token = op;
+    const uint16_t encodedMatchLength = (matchLength) ? matchLength - LZ_MIN_MATCH_LENGTH : 0;
+
+    if(op >= opEnd)
+    {
+        return false;
+    }
+    ++op;
+
+    *token = static_cast<uint8_t>(((literalLength < 15) ? literalLength : 15) << 4);
+    if(literalLength >= 15 && !writeLengthExtension(op, opEnd, literalLength - 15))
+    {
+        return false;
+    }
+
+    if(op + literalLength > opEnd)
+    {
+        return false;
+    }
+    memcpy(op, literals, literalLength);
+    op += literalLength;
+
+    if(!matchLength)
+    {
+        // the last sequence of a block only contains literals
+        return true;
+    }
+
+    if(op + 2 > opEnd)
+    {
+        return false;
+    }
+    op[0] = static_cast<uint8_t>(offset & 0xFF);
+    op[1] = static_cast<uint8_t>(offset >> 8);
+    op += 2;
+
+    *token |= static_cast<uint8_t>((encodedMatchLength < 15) ? encodedMatchLength : 15);
+    if(encodedMatchLength >= 15 && !writeLengthExtension(op, opEnd, encodedMatchLength - 15))
+    {
+        return false;
+    }
+    return true;
+}
+
+uint16_t lzCompressBlock(const uint8_t* src, uint16_t srcSize, uint8_t* dst, uint16_t dstCapacity, uint16_t* hashTable)
+{
+    const uint16_t searchLimit = (srcSize > LZ_MATCH_SEARCH_LIMIT) ? srcSize - LZ_MATCH_SEARCH_LIMIT : 0;
+    const uint16_t matchLimit = (srcSize > LZ_LAST_LITERALS) ? srcSize - LZ_LAST_LITERALS : 0;
+    uint8_t* op = dst;
+    const uint8_t* const opEnd = dst + dstCapacity;
+    uint16_t ip = 0;
+    uint16_t anchor = 0;
+    uint16_t ref;
+    uint16_t matchLength;
+    uint16_t hash;
+    uint32_t sequence;
+
+    if(srcSize > LZ_MAX_BLOCK_SIZE)
+    {
+        return 0;
+    }
+
+    memset(hashTable, 0xFF, LZ_HASH_TABLE_ENTRIES * sizeof(uint16_t));
+
+    while(ip < searchLimit)
+    {
+        sequence = read32(src + ip);
+        hash = hash32(sequence);
+        ref = hashTable[hash];
+        hashTable[hash] = ip;
+
+        if(ref == LZ_EMPTY_HASH_ENTRY || read32(src + ref) != sequence)
+        {
+            // no match: skip ahead faster the longer we haven't found one. Incompressible data (like compressed graphics in a ROM)
+            // would otherwise cost us a hash lookup for every single byte
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        matchLength = LZ_MIN_MATCH_LENGTH;
+        while(ip + matchLength < matchLimit && src[ref + matchLength] == src[ip + matchLength])
+        {
+            ++matchLength;
+        }
+
+        // extend the match backwards into the pending literals
+        while(ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+        {
+            --ip;
+            --ref;
+            ++matchLength;
+        }
+
+        if(!writeSequence(op, opEnd, src + anchor, ip - anchor, ip - ref, matchLength))
+        {
+            return 0;
+        }
+
+        ip += matchLength;
+        anchor = ip;
+
+        // make sure the position right before the next search is known as well. This catches a lot of repeating patterns (like 0xFF filler)
+        if(ip >= 2 && ip < searchLimit)
+        {
+            hashTable[hash32(read32(src + ip - 2))] = ip - 2;
+        }
+    }
+
+    if(!writeSequence(op, opEnd, src + anchor, srcSize - anchor, 0, 0))
+    {
+        return 0;
+    }
+    return static_cast<uint16_t>(op - dst);
+}
+
+uint16_t lzDecompressBlock(const uint8_t* src, uint16_t srcSize, uint8_t* dst, uint16_t dstCapacity)
+{
+    const uint8_t* ip = src;
+    const uint8_t* const ipEnd = src + srcSize;
+    uint8_t* op = dst;
+    const uint8_t* const opEnd = dst + dstCapacity;
+    const uint8_t* match;
+    uint32_t length;
+    uint16_t offset;
+    uint8_t token;
+
+    while(ip < ipEnd)
+    {
+        token = *ip;
+        ++ip;
+
+        length = (token >> 4);
+        if(length == 15)
+        {
+            do
+            {
+                if(ip >= ipEnd)
+                {
+                    return 0;
+                }
+                length += *ip;
+            } while(*(ip++) == 255);
+        }
+
+        if(ip + length > ipEnd || op + length > opEnd)
+        {
+            return 0;
+        }
+        memcpy(op, ip, length);
+        ip += length;
+        op += length;
+
+        if(ip >= ipEnd)
+        {
+            // last sequence: literals only
+            break;
+        }
+
+        if(ip + 2 > ipEnd)
+        {
+            return 0;
+        }
+        offset = static_cast<uint16_t>(ip[0] | (ip[1] << 8));
+        ip += 2;
+
+        if(offset == 0 || offset > (op - dst))
+        {
+            return 0;
+        }
+        match = op - offset;
+
+        length = (token & 0xF);
+        if(length == 15)
+        {
+            do
+            {
+                if(ip >= ipEnd)
+                {
+                    return 0;
+                }
+                length += *ip;
+            } while(*(ip++) == 255);
+        }
+        length += LZ_MIN_MATCH_LENGTH;
+
+        if(op + length > opEnd)
+        {
+            return 0;
+        }
+
+        // the match may overlap with the output (offset < length). That's how runs are encoded, so copy byte by byte
+        while(length > 0)
+        {
+            *op = *match;
+            ++op;
+            ++match;
+            --length;
+        }
+    }
+    return static_cast<uint16_t>(op - dst);
+}
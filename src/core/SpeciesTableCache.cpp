@@ -0,0 +1,257 @@
+#include "core/SpeciesTableCache.h"
+
+#include <libdragon.h>
+#include <cstring>
+
+static const uint16_t NUM_SPECIES_INDICES = 256;
+// Gen 1 uses internal species indices up to 190. The ones that aren't a real pokémon (MissingNo) have pokédex number 0
+static const uint8_t GEN1_MAX_SPECIES_INDEX = 190;
+static const uint8_t GEN2_NUM_SPECIES = 251;
+
+static void copyName(SpeciesTableEntry& entry, const char* name)
+{
+    strncpy(entry.name, name, SPECIES_TABLE_CACHE_NAME_SIZE - 1);
+    entry.name[SPECIES_TABLE_CACHE_NAME_SIZE - 1] = '\0';
+}
+
+SpeciesTableCache::SpeciesTableCache()
+    : gen1Reader_(nullptr)
+    , gen2Reader_(nullptr)
+    , entries_(nullptr)
+    , gen1Stats_(nullptr)
+    , gen2Stats_(nullptr)
+    , buildStartTime_(0)
+    , buildIndex_(0)
+    , maxSpeciesIndex_(0)
+    , buildPhase_(SpeciesTableBuildPhase::NONE)
+    , cacheNames_(false)
+{
+}
+
+SpeciesTableCache::~SpeciesTableCache()
+{
+    reset();
+}
+
+void SpeciesTableCache::start(Gen1GameReader& gameReader)
+{
+    reset();
+    gen1Reader_ = &gameReader;
+    entries_ = new SpeciesTableEntry[NUM_SPECIES_INDICES];
+    gen1Stats_ = new Gen1PokeStats[NUM_SPECIES_INDICES];
+    memset(entries_, 0, NUM_SPECIES_INDICES * sizeof(SpeciesTableEntry));
+
+    maxSpeciesIndex_ = GEN1_MAX_SPECIES_INDEX;
+    cacheNames_ = true;
+    buildIndex_ = 1;
+    buildPhase_ = SpeciesTableBuildPhase::POKEDEX_NUMBERS;
+    buildStartTime_ = get_ticks();
+}
+
+void SpeciesTableCache::start(Gen2GameReader& gameReader, uint8_t localization)
+{
+    reset();
+    gen2Reader_ = &gameReader;
+    entries_ = new SpeciesTableEntry[NUM_SPECIES_INDICES];
+    gen2Stats_ = new Gen2PokeStats[NUM_SPECIES_INDICES];
+    memset(entries_, 0, NUM_SPECIES_INDICES * sizeof(SpeciesTableEntry));
+
+    maxSpeciesIndex_ = GEN2_NUM_SPECIES;
+    cacheNames_ = (static_cast<Gen2LocalizationLanguage>(localization) != Gen2LocalizationLanguage::KOREAN);
+    buildIndex_ = 1;
+    buildPhase_ = SpeciesTableBuildPhase::POKEDEX_NUMBERS;
+    buildStartTime_ = get_ticks();
+}
+
+bool SpeciesTableCache::step(uint16_t maxSpecies)
+{
+    uint16_t numSpecies = 0;
+
+    if(buildPhase_ == SpeciesTableBuildPhase::NONE || buildPhase_ == SpeciesTableBuildPhase::FINISHED)
+    {
+        return (buildPhase_ == SpeciesTableBuildPhase::FINISHED);
+    }
+
+    // one table at a time, so we keep moving forward through the same ROM bank instead of jumping between the tables
+    while(numSpecies < maxSpecies)
+    {
+        if(buildIndex_ > maxSpeciesIndex_)
+        {
+            buildPhase_ = static_cast<SpeciesTableBuildPhase>(static_cast<uint8_t>(buildPhase_) + 1);
+            buildIndex_ = 1;
+            if(buildPhase_ == SpeciesTableBuildPhase::NAMES && !cacheNames_)
+            {
+                buildPhase_ = SpeciesTableBuildPhase::STATS;
+            }
+            if(buildPhase_ == SpeciesTableBuildPhase::FINISHED)
+            {
+                debugf("[SpeciesTableCache]: cached all species in %lu ms\r\n", static_cast<uint32_t>(TICKS_TO_MS(get_ticks() - buildStartTime_)));
+                return true;
+            }
+        }
+
+        readTableEntry(static_cast<uint8_t>(buildIndex_));
+        ++buildIndex_;
+        ++numSpecies;
+    }
+    return false;
+}
+
+bool SpeciesTableCache::build(Gen1GameReader& gameReader)
+{
+    start(gameReader);
+    while(!step(NUM_SPECIES_INDICES))
+    {
+    }
+    return true;
+}
+
+bool SpeciesTableCache::build(Gen2GameReader& gameReader, uint8_t localization)
+{
+    start(gameReader, localization);
+    while(!step(NUM_SPECIES_INDICES))
+    {
+    }
+    return true;
+}
+
+bool SpeciesTableCache::isBuilt() const
+{
+    return (buildPhase_ == SpeciesTableBuildPhase::FINISHED);
+}
+
+const char* SpeciesTableCache::getPokemonName(uint8_t speciesIndex) const
+{
+    if(entries_ && entries_[speciesIndex].valid && entries_[speciesIndex].name[0])
+    {
+        return entries_[speciesIndex].name;
+    }
+    else if(gen1Reader_)
+    {
+        return gen1Reader_->getPokemonName(speciesIndex);
+    }
+    else if(gen2Reader_)
+    {
+        return gen2Reader_->getPokemonName(speciesIndex);
+    }
+    return "";
+}
+
+uint8_t SpeciesTableCache::getPokemonNumber(uint8_t speciesIndex) const
+{
+    if(entries_ && entries_[speciesIndex].valid)
+    {
+        return entries_[speciesIndex].pokedexNumber;
+    }
+    else if(gen1Reader_)
+    {
+        return gen1Reader_->getPokemonNumber(speciesIndex);
+    }
+    // in Gen 2, the species index is the pokédex number
+    return speciesIndex;
+}
+
+uint8_t SpeciesTableCache::getPokemonIconType(uint8_t speciesIndex) const
+{
+    if(entries_ && entries_[speciesIndex].valid)
+    {
+        return entries_[speciesIndex].iconType;
+    }
+    else if(gen1Reader_)
+    {
+        return static_cast<uint8_t>(gen1Reader_->getPokemonIconType(speciesIndex));
+    }
+    else if(gen2Reader_)
+    {
+        return static_cast<uint8_t>(gen2Reader_->getPokemonIconType(speciesIndex));
+    }
+    return 0;
+}
+
+bool SpeciesTableCache::getGen1PokeStats(uint8_t speciesIndex, Gen1PokeStats& outStats) const
+{
+    if(gen1Stats_ && entries_[speciesIndex].valid)
+    {
+        outStats = gen1Stats_[speciesIndex];
+        return true;
+    }
+    else if(gen1Reader_)
+    {
+        return gen1Reader_->readPokemonStatsForIndex(speciesIndex, outStats);
+    }
+    return false;
+}
+
+bool SpeciesTableCache::getGen2PokeStats(uint8_t speciesIndex, Gen2PokeStats& outStats) const
+{
+    if(gen2Stats_ && entries_[speciesIndex].valid)
+    {
+        outStats = gen2Stats_[speciesIndex];
+        return true;
+    }
+    else if(gen2Reader_)
+    {
+        return gen2Reader_->readPokemonStatsForIndex(speciesIndex, outStats);
+    }
+    return false;
+}
+
+void SpeciesTableCache::readTableEntry(uint8_t speciesIndex)
+{
+    SpeciesTableEntry& entry = entries_[speciesIndex];
+
+    switch(buildPhase_)
+    {
+        case SpeciesTableBuildPhase::POKEDEX_NUMBERS:
+            // in Gen 2, the species index is the pokédex number
+            entry.pokedexNumber = (gen1Reader_) ? gen1Reader_->getPokemonNumber(speciesIndex) : speciesIndex;
+            break;
+        case SpeciesTableBuildPhase::NAMES:
+            if(entry.pokedexNumber)
+            {
+                copyName(entry, (gen1Reader_) ? gen1Reader_->getPokemonName(speciesIndex) : gen2Reader_->getPokemonName(speciesIndex));
+            }
+            break;
+        case SpeciesTableBuildPhase::STATS:
+            if(!entry.pokedexNumber)
+            {
+                break;
+            }
+            if(gen1Reader_)
+            {
+                gen1Reader_->readPokemonStatsForIndex(speciesIndex, gen1Stats_[speciesIndex]);
+            }
+            else
+            {
+                gen2Reader_->readPokemonStatsForIndex(speciesIndex, gen2Stats_[speciesIndex]);
+            }
+            break;
+        case SpeciesTableBuildPhase::ICON_TYPES:
+            if(!entry.pokedexNumber)
+            {
+                break;
+            }
+            entry.iconType = static_cast<uint8_t>((gen1Reader_) ? gen1Reader_->getPokemonIconType(speciesIndex) : gen2Reader_->getPokemonIconType(speciesIndex));
+            // this is the last table, so from now on the lookups for this species can use the cache
+            entry.valid = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void SpeciesTableCache::reset()
+{
+    delete[] entries_;
+    entries_ = nullptr;
+    delete[] gen1Stats_;
+    gen1Stats_ = nullptr;
+    delete[] gen2Stats_;
+    gen2Stats_ = nullptr;
+    gen1Reader_ = nullptr;
+    gen2Reader_ = nullptr;
+    buildIndex_ = 0;
+    maxSpeciesIndex_ = 0;
+    buildPhase_ = SpeciesTableBuildPhase::NONE;
+    cacheNames_ = false;
+}
@@ -6,6 +6,14 @@ MenuItemData gen1MenuEntries[] = {
         .title = "Backup/Restore",
         .onConfirmAction = goToBackupRestoreMenu
     },
+    {
+        .title = "PC Boxes",
+        .onConfirmAction = goToPokemonBoxBrowserScene
+    },
+    {
+        .title = "Import Pokémon",
+        .onConfirmAction = goToPokemonImportScene
+    },
     {
         .title = "Event Pokémon",
         .onConfirmAction = goToGen1DistributionPokemonMenu
@@ -50,6 +58,14 @@ MenuItemData gen2MenuEntries[] = {
         .title = "Backup/Restore",
         .onConfirmAction = goToBackupRestoreMenu
     },
+    {
+        .title = "PC Boxes",
+        .onConfirmAction = goToPokemonBoxBrowserScene
+    },
+    {
+        .title = "Import Pokémon",
+        .onConfirmAction = goToPokemonImportScene
+    },
     {
         .title = "Event Pokémon",
         .onConfirmAction = goToGen2DistributionPokemonMenu
@@ -83,6 +99,14 @@ MenuItemData gen2CrystalMenuEntries[] = {
         .title = "Backup/Restore",
         .onConfirmAction = goToBackupRestoreMenu
     },
+    {
+        .title = "PC Boxes",
+        .onConfirmAction = goToPokemonBoxBrowserScene
+    },
+    {
+        .title = "Import Pokémon",
+        .onConfirmAction = goToPokemonImportScene
+    },
     {
         .title = "Event Pokémon",
         .onConfirmAction = goToGen2DistributionPokemonMenu
@@ -130,6 +154,10 @@ MenuItemData gen2DecorationMenuEntries[] = {
         .title = "Tentacool Doll",
         .onConfirmAction = gen2SetEventFlag,
         .itemParam = &GEN2_EVENTFLAG_DECORATION_TENTACOOL_DOLL
+    },
+    {
+        .title = "All Decorations",
+        .onConfirmAction = gen2SetAllDecorationEventFlags
     }
 };
 
@@ -146,11 +174,63 @@ MenuItemData backupRestoreMenuEntries[] = {
         .onConfirmAction = goToDataCopyScene,
         .itemParam = &DATACOPY_BACKUP_ROM
     },
+    {
+        .title = "Backup Save (LZ)",
+        .onConfirmAction = goToDataCopyScene,
+        .itemParam = &DATACOPY_BACKUP_SAVE_COMPRESSED
+    },
+    {
+        .title = "Backup ROM (LZ)",
+        .onConfirmAction = goToDataCopyScene,
+        .itemParam = &DATACOPY_BACKUP_ROM_COMPRESSED
+    },
+    {
+        .title = "Backup Save + ROM",
+        .onConfirmAction = goToDataCopyScene,
+        .itemParam = &DATACOPY_BACKUP_SAVE_AND_ROM
+    },
     {
         .title = "Restore Save",
         .onConfirmAction = goToDataCopyScene,
         .itemParam = &DATACOPY_RESTORE_SAVE
     },
+    {
+        .title = "Save Library",
+        .onConfirmAction = goToSaveLibraryScene
+    },
+    {
+        .title = "Snapshot Save",
+        .onConfirmAction = goToDataCopyScene,
+        .itemParam = &DATACOPY_BACKUP_SAVE_SNAPSHOT
+    },
+    {
+        .title = "Restore Snapshot",
+        .onConfirmAction = goToDataCopyScene,
+        .itemParam = &DATACOPY_RESTORE_SAVE_SNAPSHOT
+    },
+    {
+        .title = "Export Snapshot",
+        .onConfirmAction = goToDataCopyScene,
+        .itemParam = &DATACOPY_EXPORT_SAVE_SNAPSHOT
+    },
+    {
+        .title = "Backup Save (CPak)",
+        .onConfirmAction = goToDataCopyScene,
+        .itemParam = &DATACOPY_BACKUP_SAVE_CONTROLLER_PAK
+    },
+    {
+        .title = "Restore Save (CPak)",
+        .onConfirmAction = goToDataCopyScene,
+        .itemParam = &DATACOPY_RESTORE_SAVE_CONTROLLER_PAK
+    },
+    {
+        .title = "Clone Save",
+        .onConfirmAction = askConfirmationCloneSave
+    },
+    {
+        .title = "Undo Last Change",
+        .onConfirmAction = undoLastSaveChange
+    },
     {
         .title = "Wipe Save",
         .onConfirmAction = askConfirmationWipeSave
@@ -1,15 +1,18 @@
 #include "menu/MenuFunctions.h"
 #include "menu/MenuEntries.h"
 #include "core/RDPQGraphics.h"
+#include "core/DragonUtils.h"
 #include "scenes/DistributionPokemonListScene.h"
 #include "scenes/StatsScene.h"
 #include "scenes/MenuScene.h"
 #include "scenes/SelectFileScene.h"
+#include "scenes/SaveLibraryScene.h"
 #include "scenes/SceneManager.h"
+#include "core/GameSession.h"
 #include "gen2/Gen2GameReader.h"
 #include "transferpak/TransferPakManager.h"
-#include "transferpak/TransferPakRomReader.h"
-#include "transferpak/TransferPakSaveManager.h"
+#include "save/SaveUndoJournal.h"
+#include "save/SaveEditTransaction.h"
 
 #define POKEMON_CRYSTAL_ITEM_ID_GS_BALL 0x73
 
@@ -20,6 +23,15 @@ const DataCopyOperation DATACOPY_BACKUP_SAVE = DataCopyOperation::BACKUP_SAVE;
 const DataCopyOperation DATACOPY_BACKUP_ROM = DataCopyOperation::BACKUP_ROM;
 const DataCopyOperation DATACOPY_RESTORE_SAVE = DataCopyOperation::RESTORE_SAVE;
 const DataCopyOperation DATACOPY_WIPE_SAVE = DataCopyOperation::WIPE_SAVE;
+const DataCopyOperation DATACOPY_BACKUP_SAVE_SNAPSHOT = DataCopyOperation::BACKUP_SAVE_SNAPSHOT;
+const DataCopyOperation DATACOPY_RESTORE_SAVE_SNAPSHOT = DataCopyOperation::RESTORE_SAVE_SNAPSHOT;
+const DataCopyOperation DATACOPY_EXPORT_SAVE_SNAPSHOT = DataCopyOperation::EXPORT_SAVE_SNAPSHOT;
+const DataCopyOperation DATACOPY_BACKUP_SAVE_COMPRESSED = DataCopyOperation::BACKUP_SAVE_COMPRESSED;
+const DataCopyOperation DATACOPY_BACKUP_ROM_COMPRESSED = DataCopyOperation::BACKUP_ROM_COMPRESSED;
+const DataCopyOperation DATACOPY_BACKUP_SAVE_AND_ROM = DataCopyOperation::BACKUP_SAVE_AND_ROM;
+const DataCopyOperation DATACOPY_CLONE_SAVE = DataCopyOperation::CLONE_SAVE;
+const DataCopyOperation DATACOPY_BACKUP_SAVE_CONTROLLER_PAK = DataCopyOperation::BACKUP_SAVE_CONTROLLER_PAK;
+const DataCopyOperation DATACOPY_RESTORE_SAVE_CONTROLLER_PAK = DataCopyOperation::RESTORE_SAVE_CONTROLLER_PAK;
 
 // based on https://github.com/kwsch/PKHeX/blob/master/PKHeX.Core/Resources/text/script/gen2/flags_c_en.txt
 const uint16_t GEN2_EVENTFLAG_DECORATION_PIKACHU_BED = 679;
@@ -92,16 +104,15 @@ static void goToDistributionPokemonListMenu(void* context, DistributionPokemonLi
     sceneManager.switchScene(SceneType::DISTRIBUTION_POKEMON_LIST, deleteDistributionPokemonListSceneContext, sceneContext);
 }
 
-static uint8_t gen1FindPikachuInParty(Gen1Party& party)
+static uint8_t gen1FindPikachuInParty(GameSession& session, Gen1TrainerPokemon& outPoke)
 {
     const uint8_t PIKACHU_INDEX_CODE = 0x54;
     uint8_t foundIndex = 0xFF;
-    const uint8_t numberOfPokemon = party.getNumberOfPokemon();
+    const uint8_t numberOfPokemon = session.getGen1PartySize();
     
     for(uint8_t i=0; i < numberOfPokemon; ++i)
     {
-        const uint8_t speciesIndex = party.getSpeciesAtIndex(i);
-        if(speciesIndex == PIKACHU_INDEX_CODE)
+        if(session.getGen1PartyPokemon(i, outPoke) && outPoke.poke_index == PIKACHU_INDEX_CODE)
         {
 //          debugf("Found Pikachu at index %hu\r\n", i);
             foundIndex = i;
@@ -173,16 +184,18 @@ void goToDataCopyScene(void* context, const void* param)
         .saveToRestorePath = nullptr
     };
 
-    if(operation == DataCopyOperation::RESTORE_SAVE)
+    if(operation == DataCopyOperation::RESTORE_SAVE || operation == DataCopyOperation::RESTORE_SAVE_SNAPSHOT || operation == DataCopyOperation::EXPORT_SAVE_SNAPSHOT)
     {
+        const bool isSnapshot = (operation != DataCopyOperation::RESTORE_SAVE);
         auto fileSelectContext = new SelectFileSceneContext{
-            .titleText = "Select Save file",
+            .titleText = (isSnapshot) ? "Select Snapshot file" : "Select Save file",
             .nextScene = {
                 .type = SceneType::COPY_DATA,
                 .context = dataCopyContext,
                 .deleteContextFunc = deleteDataCopySceneContext
             },
-            .fileExtensionFilter = ".sav"
+            .initialPath = (isSnapshot) ? "sd:/PokeMe64" : nullptr,
+            .fileExtensionFilter = (isSnapshot) ? ".snap" : ".sav|.sav.lz"
         };
         sceneManager.switchScene(SceneType::SELECT_FILE, deleteSelectFileSceneContext, fileSelectContext);
     }
@@ -192,6 +205,42 @@ void goToDataCopyScene(void* context, const void* param)
     }
 }
 
+void goToSaveLibraryScene(void* context, const void* param)
+{
+    MenuScene* scene = static_cast<MenuScene*>(context);
+    SceneManager& sceneManager = scene->getDependencies().sceneManager;
+
+    auto sceneContext = new SaveLibrarySceneContext;
+    sceneContext->menuEntries = nullptr;
+    sceneContext->numMenuEntries = 0;
+    sceneContext->bButtonMeansUserWantsToSwitchCartridge = false;
+    sceneContext->goBackToPreviousSceneInstead = false;
+
+    sceneManager.switchScene(SceneType::SAVE_LIBRARY, deleteSaveLibrarySceneContext, sceneContext);
+}
+
+void goToPokemonBoxBrowserScene(void* context, const void* param)
+{
+    MenuScene* scene = static_cast<MenuScene*>(context);
+    auto newSceneContext = new MenuSceneContext{
+        .menuEntries = nullptr,
+        .numMenuEntries = 0
+    };
+
+    scene->getDependencies().sceneManager.switchScene(SceneType::POKEMON_BOX_BROWSER, deleteMenuSceneContext, newSceneContext);
+}
+
+void goToPokemonImportScene(void* context, const void* param)
+{
+    MenuScene* scene = static_cast<MenuScene*>(context);
+    auto newSceneContext = new MenuSceneContext{
+        .menuEntries = nullptr,
+        .numMenuEntries = 0
+    };
+
+    scene->getDependencies().sceneManager.switchScene(SceneType::IMPORT_POKEMON, deleteMenuSceneContext, newSceneContext);
+}
+
 void goToGen1MovesMenu(void* context, const void* param)
 {
     MenuScene* scene = static_cast<MenuScene*>(context);
@@ -244,26 +293,21 @@ void gen1PrepareToTeachPikachu(void* context, const void* param)
 {
     MenuScene* scene = static_cast<MenuScene*>(context);
     TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
-    TransferPakRomReader romReader(tpakManager);
-    TransferPakSaveManager saveManager(tpakManager);
-    const Gen1GameType gameType = static_cast<Gen1GameType>(scene->getDependencies().specificGenVersion);
-    const Gen1LocalizationLanguage language = static_cast<Gen1LocalizationLanguage>(scene->getDependencies().localization);
-    Gen1GameReader gameReader(romReader, saveManager, gameType, language);
+    GameSession& session = scene->getDependencies().gameSession;
     DialogData* msg1 = nullptr;
     DialogData* msg2 = nullptr;
     uint8_t foundIndex;
     const Move moveType = *static_cast<const Move*>(param);
 
-    tpakManager.setRAMEnabled(true);
-
     Gen1TrainerPokemon poke;
-    Gen1Party party = gameReader.getParty();
 
-    foundIndex = gen1FindPikachuInParty(party);
+    // only needed if the party isn't cached yet
+    tpakManager.setRAMEnabled(true);
+    foundIndex = gen1FindPikachuInParty(session, poke);
+    tpakManager.setRAMEnabled(false);
 
     if(foundIndex == 0xFF)
     {
-        tpakManager.setRAMEnabled(false);
         msg1 = new DialogData{
             .shouldDeleteWhenDone = true
         };
@@ -272,15 +316,6 @@ void gen1PrepareToTeachPikachu(void* context, const void* param)
         return;
     }
 
-    if(!party.getPokemon(foundIndex, poke, false))
-    {
-        tpakManager.setRAMEnabled(false);
-        debugf("%s: ERROR while retrieving pokemon from party at index %hu\r\n", __FUNCTION__, foundIndex);
-        return;
-    }
-
-    tpakManager.setRAMEnabled(false);
-
     if(poke.index_move1 == (uint8_t)moveType || poke.index_move2 == (uint8_t)moveType || poke.index_move3 == (uint8_t)moveType || poke.index_move4 == (uint8_t)moveType)
     {
         msg1 = new DialogData{
@@ -363,11 +398,7 @@ void gen1TeachPikachu(void* context, const void* param)
 {
     MenuScene* scene = static_cast<MenuScene*>(context);
     TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
-    TransferPakRomReader romReader(tpakManager);
-    TransferPakSaveManager saveManager(tpakManager);
-    const Gen1GameType gameType = static_cast<Gen1GameType>(scene->getDependencies().specificGenVersion);
-    const Gen1LocalizationLanguage language = static_cast<Gen1LocalizationLanguage>(scene->getDependencies().localization);
-    Gen1GameReader gameReader(romReader, saveManager, gameType, language);
+    GameSession& session = scene->getDependencies().gameSession;
 
     const Gen1TeachPikachuParams* params = static_cast<const Gen1TeachPikachuParams*>(param);
     Gen1TrainerPokemon poke = params->poke;
@@ -404,16 +435,19 @@ void gen1TeachPikachu(void* context, const void* param)
     }
 
     tpakManager.setRAMEnabled(true);
-    
-    Gen1Party party = gameReader.getParty();
-    if(!party.setPokemon(params->partyIndex, poke))
+    // keep the original contents of the blocks we modify on the SD card, so this change can be undone
+    SaveUndoJournal undoJournal(tpakManager);
+    undoJournal.begin();
+
+    // this also updates the main checksum
+    if(!session.setGen1PartyPokemon(params->partyIndex, poke))
     {
         tpakManager.setRAMEnabled(false);
         debugf("%s: ERROR: can't update Pikachu at partyIndex %hu\r\n", __FUNCTION__, params->partyIndex);
         return;
     }
-    gameReader.updateMainChecksum();
     tpakManager.finishWrites();
+    undoJournal.end();
     tpakManager.setRAMEnabled(false);
 
     DialogData* msg1 = new DialogData{
@@ -448,22 +482,11 @@ void gen1MoveDeleterSelectPokemon(void* context, const void* param)
     DialogData* msg = nullptr;
     MenuScene* scene = static_cast<MenuScene*>(context);
     TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
-    TransferPakRomReader romReader(tpakManager);
-    TransferPakSaveManager saveManager(tpakManager);
-    const Gen1GameType gameType = static_cast<Gen1GameType>(scene->getDependencies().specificGenVersion);
-    const Gen1LocalizationLanguage language = static_cast<Gen1LocalizationLanguage>(scene->getDependencies().localization);
-    Gen1GameReader gameReader(romReader, saveManager, gameType, language);
-
-    // statically allocated storage for storing up to 6 pokemon nicknames.
-    // allocated statically to avoid having to care about memory management when passing them as a dialog option.
-    // see below for the reason why we need to do it like this.
-    static char nickNames[6][11];
-    const char* curNickname;
+    GameSession& session = scene->getDependencies().gameSession;
 
     tpakManager.setRAMEnabled(true);
 
-    Gen1Party party = gameReader.getParty();
-    const uint8_t numberOfPokemon = party.getNumberOfPokemon();
+    const uint8_t numberOfPokemon = session.getGen1PartySize();
 
     msg = new DialogData {
         .options = {
@@ -474,7 +497,7 @@ void gen1MoveDeleterSelectPokemon(void* context, const void* param)
         .shouldDeleteWhenDone = true
     };
 
-    if(!gen1_isAPokeCenter(gameReader.getCurrentMap()))
+    if(!gen1_isAPokeCenter(session.getGen1CurrentMap()))
     {
         delete[] msg->options.items;
         msg->options = {0};
@@ -487,13 +510,10 @@ void gen1MoveDeleterSelectPokemon(void* context, const void* param)
 
     for(uintptr_t i=0; i < numberOfPokemon; ++i)
     {
-        // every call to getPokemonNickname overwrites the data of the last one
-        // because the same internal buffer is getting reused on every call.
-        // since we want to preserve that data, we need to copy it before consumption.
-        curNickname = party.getPokemonNickname(i);
-        strncpy(nickNames[i], curNickname, 11);
+        // the GameSession keeps a copy of every nickname, so we can pass it as the title directly.
+        // It stays valid until the session gets invalidated, which doesn't happen while this dialog is shown.
         msg->options.items[i] = {
-            .title = nickNames[i],
+            .title = session.getGen1PartyPokemonNickname(i),
             .onConfirmAction = gen1MoveDeleterSelectMove,
             .context = context,
             .itemParam = (const void*)i
@@ -530,17 +550,11 @@ void gen1MoveDeleterSelectMove(void* context, const void* param)
     uint8_t moveIndex;
 
     TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
-    TransferPakRomReader romReader(tpakManager);
-    TransferPakSaveManager saveManager(tpakManager);
-    const Gen1GameType gameType = static_cast<Gen1GameType>(scene->getDependencies().specificGenVersion);
-    const Gen1LocalizationLanguage language = static_cast<Gen1LocalizationLanguage>(scene->getDependencies().localization);
-    Gen1GameReader gameReader(romReader, saveManager, gameType, language);
+    GameSession& session = scene->getDependencies().gameSession;
 
     tpakManager.setRAMEnabled(true);
 
-    Gen1Party party = gameReader.getParty();
-
-    if(!party.getPokemon(partyIndex, poke, false))
+    if(!session.getGen1PartyPokemon(partyIndex, poke))
     {
         // Could not retrieve pokémon from party at the given index.
         // this should never happen!
@@ -608,17 +622,14 @@ void gen1MoveDeleterApply(void* context, const void* param)
     const char* pokeName;
 
     TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
-    TransferPakRomReader romReader(tpakManager);
-    TransferPakSaveManager saveManager(tpakManager);
-    const Gen1GameType gameType = static_cast<Gen1GameType>(scene->getDependencies().specificGenVersion);
-    const Gen1LocalizationLanguage language = static_cast<Gen1LocalizationLanguage>(scene->getDependencies().localization);
-    Gen1GameReader gameReader(romReader, saveManager, gameType, language);
+    GameSession& session = scene->getDependencies().gameSession;
 
     tpakManager.setRAMEnabled(true);
+    // keep the original contents of the blocks we modify on the SD card, so this change can be undone
+    SaveUndoJournal undoJournal(tpakManager);
+    undoJournal.begin();
 
-    Gen1Party party = gameReader.getParty();
-
-    party.getPokemon(deleteParams->partyIndex, poke, true);
+    session.getGen1PartyPokemon(deleteParams->partyIndex, poke);
 
     switch(deleteParams->moveIndex)
     {
@@ -659,17 +670,18 @@ void gen1MoveDeleterApply(void* context, const void* param)
     poke.index_move4 = 0;
     poke.pp_move4 = 0;
 
-    if(!party.setPokemon(deleteParams->partyIndex, poke))
+    // this also updates the main checksum
+    if(!session.setGen1PartyPokemon(deleteParams->partyIndex, poke))
     {
         tpakManager.setRAMEnabled(false);
         debugf("%s: ERROR: can't update Pokémon at partyIndex %hu\r\n", __FUNCTION__, deleteParams->partyIndex);
         return;
     }
 
-    gameReader.updateMainChecksum();
     tpakManager.finishWrites();
+    undoJournal.end();
 
-    pokeName = party.getPokemonNickname(deleteParams->partyIndex);
+    pokeName = session.getGen1PartyPokemonNickname(deleteParams->partyIndex);
 
     tpakManager.setRAMEnabled(false);
 
@@ -691,20 +703,22 @@ void gen2ReceiveGSBall(void* context, const void* param)
 {
     MenuScene* scene = static_cast<MenuScene*>(context);
     TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
-    TransferPakRomReader romReader(tpakManager);
-    TransferPakSaveManager saveManager(tpakManager);
-    const Gen2LocalizationLanguage language = static_cast<Gen2LocalizationLanguage>(scene->getDependencies().localization);
-    Gen2GameReader gameReader(romReader, saveManager, Gen2GameType::CRYSTAL, language);
+    // this menu entry is only available for Crystal, so the session has a Crystal game reader
+    Gen2GameReader& gameReader = *scene->getDependencies().gameSession.getGen2Reader();
     DialogData* messageData = new DialogData{
         .shouldDeleteWhenDone = true
     };
 
     tpakManager.setRAMEnabled(true);
-  
+    // keep the original contents of the blocks we modify on the SD card, so this change can be undone
+    SaveUndoJournal undoJournal(tpakManager);
+    undoJournal.begin();
+
     // the unlockGsBallEvent() function does all the work. It's even repeatable!
     gameReader.unlockGsBallEvent();
     gameReader.finishSave();
     tpakManager.finishWrites();
+    undoJournal.end();
     tpakManager.setRAMEnabled(false);
     
     setDialogDataText(*messageData, "GS Ball event unlocked! Please go to the Golden Rod Pokémon Center and try to leave!");
@@ -715,28 +729,32 @@ void gen2ReceiveGSBall(void* context, const void* param)
 void gen2SetEventFlag(void* context, const void* param)
 {
     MenuScene* scene = static_cast<MenuScene*>(context);
-    TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
-    TransferPakRomReader romReader(tpakManager);
-    TransferPakSaveManager saveManager(tpakManager);
-    const Gen2LocalizationLanguage language = static_cast<Gen2LocalizationLanguage>(scene->getDependencies().localization);
-    Gen2GameReader gameReader(romReader, saveManager, static_cast<Gen2GameType>(scene->getDependencies().specificGenVersion), language);
+    SceneDependencies& deps = scene->getDependencies();
+    TransferPakManager& tpakManager = deps.tpakManager;
     DialogData* messageData = new DialogData{
         .shouldDeleteWhenDone = true
     };
     const uint16_t eventFlagIndex = *static_cast<const uint16_t*>(param);
+    uint16_t numBlocksWritten;
 
     tpakManager.setRAMEnabled(true);
 
-    const char* trainerName = scene->getDependencies().playerName;
-    if(gameReader.getEventFlag(eventFlagIndex))
+    SaveEditTransaction transaction(tpakManager, deps.generation, deps.specificGenVersion, deps.localization);
+    const char* trainerName = deps.playerName;
+    if(transaction.getGen2Reader()->getEventFlag(eventFlagIndex))
     {
         setDialogDataText(*messageData, "%s already has %s!", trainerName, convertGen2EventFlagToString(eventFlagIndex));
     }
     else
     {
-        gameReader.setEventFlag(eventFlagIndex, true);
-        gameReader.finishSave();
+        transaction.setGen2EventFlag(eventFlagIndex, true);
+
+        // keep the original contents of the blocks we modify on the SD card, so this change can be undone
+        SaveUndoJournal undoJournal(tpakManager);
+        undoJournal.begin();
+        transaction.commit(numBlocksWritten);
         tpakManager.finishWrites();
+        undoJournal.end();
 
         setDialogDataText(*messageData, "%s has unlocked %s!", trainerName, convertGen2EventFlagToString(eventFlagIndex));
     }
@@ -745,6 +763,53 @@ void gen2SetEventFlag(void* context, const void* param)
     scene->showDialog(messageData);
 }
 
+void gen2SetAllDecorationEventFlags(void* context, const void* param)
+{
+    static const uint16_t decorationEventFlags[] = {
+        GEN2_EVENTFLAG_DECORATION_PIKACHU_BED,
+        GEN2_EVENTFLAG_DECORATION_UNOWN_DOLL,
+        GEN2_EVENTFLAG_DECORATION_TENTACOOL_DOLL
+    };
+    MenuScene* scene = static_cast<MenuScene*>(context);
+    SceneDependencies& deps = scene->getDependencies();
+    TransferPakManager& tpakManager = deps.tpakManager;
+    DialogData* messageData = new DialogData{
+        .shouldDeleteWhenDone = true
+    };
+    uint16_t numBlocksWritten;
+
+    tpakManager.setRAMEnabled(true);
+
+    // all flags get set in a single transaction: one checksum calculation and one write to the cartridge
+    SaveEditTransaction transaction(tpakManager, deps.generation, deps.specificGenVersion, deps.localization);
+    for(uint8_t i = 0; i < sizeof(decorationEventFlags) / sizeof(decorationEventFlags[0]); ++i)
+    {
+        if(!transaction.getGen2Reader()->getEventFlag(decorationEventFlags[i]))
+        {
+            transaction.setGen2EventFlag(decorationEventFlags[i], true);
+        }
+    }
+
+    if(!transaction.getNumberOfEdits())
+    {
+        setDialogDataText(*messageData, "%s already has all decorations!", deps.playerName);
+    }
+    else
+    {
+        // keep the original contents of the blocks we modify on the SD card, so this change can be undone
+        SaveUndoJournal undoJournal(tpakManager);
+        undoJournal.begin();
+        transaction.commit(numBlocksWritten);
+        tpakManager.finishWrites();
+        undoJournal.end();
+
+        setDialogDataText(*messageData, "%s has unlocked all decorations!", deps.playerName);
+    }
+
+    tpakManager.setRAMEnabled(false);
+    scene->showDialog(messageData);
+}
+
 void askConfirmationWipeSave(void* context, const void* param)
 {
     MenuScene* scene = static_cast<MenuScene*>(context);
@@ -775,6 +840,36 @@ void askConfirmationWipeSave(void* context, const void* param)
     scene->showDialog(messageData);
 }
 
+void askConfirmationCloneSave(void* context, const void* param)
+{
+    MenuScene* scene = static_cast<MenuScene*>(context);
+
+    DialogData* messageData = new DialogData{
+        .options = {
+            .items = new MenuItemData[2]{
+                {
+                    .title = "Yes",
+                    .onConfirmAction = goToDataCopyScene,
+                    .context = context,
+                    .itemParam = &DATACOPY_CLONE_SAVE
+                },
+                {
+                    .title = "No",
+                    .onConfirmAction = advanceDialog,
+                    .context = context
+                }
+            },
+            .number = 2,
+            .shouldDeleteWhenDone = true
+        },
+        .shouldDeleteWhenDone = true,
+    };
+
+    setDialogDataText(*messageData, "This will overwrite the save of the cartridge in the transfer pak of the other controller. Are you sure?");
+
+    scene->showDialog(messageData);
+}
+
 void resetRTC(void* context, const void* param)
 {
     MenuScene* scene = static_cast<MenuScene*>(context);
@@ -790,18 +885,64 @@ void resetRTC(void* context, const void* param)
         return;
     }
 
-    const Gen2GameType gameType = static_cast<Gen2GameType>(scene->getDependencies().specificGenVersion);
-    const Gen2LocalizationLanguage language = static_cast<Gen2LocalizationLanguage>(scene->getDependencies().localization);
     TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
-    TransferPakRomReader romReader(tpakManager);
-    TransferPakSaveManager saveManager(tpakManager);
-    Gen2GameReader gameReader(romReader, saveManager, gameType, language);
+    Gen2GameReader& gameReader = *scene->getDependencies().gameSession.getGen2Reader();
 
     tpakManager.setRAMEnabled(true);
+    // keep the original contents of the blocks we modify on the SD card, so this change can be undone
+    SaveUndoJournal undoJournal(tpakManager);
+    undoJournal.begin();
+
     gameReader.resetRTC();
     tpakManager.finishWrites();
+    undoJournal.end();
     tpakManager.setRAMEnabled(false);
 
     setDialogDataText(*diag, "The games' clock was reset! Start the game to reconfigure it! Don't forget to save!");
     scene->showDialog(diag);
+}
+
+void undoLastSaveChange(void* context, const void* param)
+{
+    MenuScene* scene = static_cast<MenuScene*>(context);
+    TransferPakManager& tpakManager = scene->getDependencies().tpakManager;
+    uint16_t numBlocks;
+    bool success;
+
+    auto diag = new DialogData{
+        .shouldDeleteWhenDone = true
+    };
+
+    if(!sdcard_mounted)
+    {
+        setDialogDataText(*diag, "ERROR: SD card is not mounted!");
+        scene->showDialog(diag);
+        return;
+    }
+
+    // the journal is compared with the save, so SRAM access is needed from here on
+    tpakManager.setRAMEnabled(true);
+    numBlocks = SaveUndoJournal::getNumberOfUndoableBlocks(tpakManager);
+    if(!numBlocks)
+    {
+        tpakManager.setRAMEnabled(false);
+        setDialogDataText(*diag, "There is no change to undo for this save!");
+        scene->showDialog(diag);
+        return;
+    }
+
+    success = SaveUndoJournal::undo(tpakManager);
+    tpakManager.setRAMEnabled(false);
+    // whatever the undone change was, the cached save data is no longer accurate
+    scene->getDependencies().gameSession.invalidate();
+
+    if(success)
+    {
+        setDialogDataText(*diag, "The last change was undone! (%hu blocks were restored)", numBlocks);
+    }
+    else
+    {
+        setDialogDataText(*diag, "ERROR: The last change could not be undone completely! Please try again.");
+    }
+    scene->showDialog(diag);
 }
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "save/PokemonBoxIndex.h"
+
+#include <cstring>
+#include <libdragon.h>
+
+// a box starts with the number of pokémon, followed by the species list (20 entries + terminator), the pokémon records,
+// the original trainer names and the nicknames
+static const uint8_t BOX_SPECIES_LIST_OFFSET = 1;
+static const uint8_t GEN2_EGG_SPECIES_INDEX = 0xFD;
+
+static const PokemonBoxLayout gen1BoxLayout = {
+    .bankOffsets = { 0x4000, 0x6000 },
+    .boxStride = 0x462,
+    .currentBoxCopyOffset = 0x30C0,
+    .currentBoxIndexOffset = 0x284C,
+    .currentBoxIndexMask = 0x7F,
+    .boxesInitializedMask = 0x80,
+    .numBoxes = 12,
+    .boxesPerBank = 6,
+    .recordSize = 33,
+    .levelOffset = 3,
+    .partyOffset = 0x2F2C,
+    .partyRecordSize = 44
+};
+
+static const PokemonBoxLayout gen2GoldSilverBoxLayout = {
+    .bankOffsets = { 0x4000, 0x6000 },
+    .boxStride = 0x450,
+    .currentBoxCopyOffset = 0x2D6C,
+    .currentBoxIndexOffset = 0x2724,
+    .currentBoxIndexMask = 0x0F,
+    .boxesInitializedMask = 0,
+    .numBoxes = 14,
+    .boxesPerBank = 7,
+    .recordSize = 32,
+    .levelOffset = 0x1F,
+    .partyOffset = 0x288A,
+    .partyRecordSize = 48
+};
+
+static const PokemonBoxLayout gen2CrystalBoxLayout = {
+    .bankOffsets = { 0x4000, 0x6000 },
+    .boxStride = 0x450,
+    .currentBoxCopyOffset = 0x2D10,
+    .currentBoxIndexOffset = 0x2700,
+    .currentBoxIndexMask = 0x0F,
+    .boxesInitializedMask = 0,
+    .numBoxes = 14,
+    .boxesPerBank = 7,
+    .recordSize = 32,
+    .levelOffset = 0x1F,
+    .partyOffset = 0x2865,
+    .partyRecordSize = 48
+};
+
+bool getPokemonBoxLayout(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, PokemonBoxLayout& outLayout)
+{
+    if(generation == 1)
+    {
+        // the Japanese versions have 8 boxes of 30 pokémon and shorter names. We don't know that layout well enough
+        if(static_cast<Gen1LocalizationLanguage>(localization) == Gen1LocalizationLanguage::JAPANESE)
+        {
+            return false;
+        }
+        outLayout = gen1BoxLayout;
+        return true;
+    }
+    else if(generation == 2)
+    {
+        if(static_cast<Gen2LocalizationLanguage>(localization) == Gen2LocalizationLanguage::JAPANESE || static_cast<Gen2LocalizationLanguage>(localization) == Gen2LocalizationLanguage::KOREAN)
+        {
+            return false;
+        }
+        outLayout = (static_cast<Gen2GameType>(specificGenVersion) == Gen2GameType::CRYSTAL) ? gen2CrystalBoxLayout : gen2GoldSilverBoxLayout;
+        return true;
+    }
+    return false;
+}
+
+uint32_t getPokemonBoxOffset(const PokemonBoxLayout& layout, uint8_t boxIndex, uint8_t currentBoxIndex)
+{
+    if(boxIndex == currentBoxIndex)
+    {
+        // the slot of the current box in bank 2/3 is outdated. The game works on the copy in bank 1
+        return layout.currentBoxCopyOffset;
+    }
+    return layout.bankOffsets[boxIndex / layout.boxesPerBank] + (boxIndex % layout.boxesPerBank) * layout.boxStride;
+}
+
+PokemonBoxIndex::PokemonBoxIndex(TransferPakManager& pakManager)
+    : saveManager_(pakManager)
+    , entries_()
+    , numPokemon_()
+    , numBoxes_(0)
+    , currentBoxIndex_(0)
+    , built_(false)
+{
+}
+
+bool PokemonBoxIndex::isBuilt() const
+{
+    return built_;
+}
+
+uint8_t PokemonBoxIndex::getNumberOfBoxes() const
+{
+    return numBoxes_;
+}
+
+uint8_t PokemonBoxIndex::getCurrentBoxIndex() const
+{
+    return currentBoxIndex_;
+}
+
+uint8_t PokemonBoxIndex::getNumberOfPokemon(uint8_t boxIndex) const
+{
+    if(boxIndex >= numBoxes_)
+    {
+        return 0;
+    }
+    return numPokemon_[boxIndex];
+}
+
+const PokemonBoxIndexEntry* PokemonBoxIndex::getEntry(uint8_t boxIndex, uint8_t slotIndex) const
+{
+    if(boxIndex >= numBoxes_ || slotIndex >= numPokemon_[boxIndex])
+    {
+        return nullptr;
+    }
+    return &entries_[boxIndex][slotIndex];
+}
+
+void PokemonBoxIndex::reset()
+{
+    memset(numPokemon_, 0, sizeof(numPokemon_));
+    numBoxes_ = 0;
+    currentBoxIndex_ = 0;
+    built_ = false;
+}
+
+bool PokemonBoxIndex::build(const SpeciesTableCache& speciesTables, uint8_t generation, uint8_t specificGenVersion, uint8_t localization)
+{
+    const uint32_t startTime = get_ticks();
+    PokemonBoxLayout layout;
+    uint8_t currentBoxByte;
+    bool boxesInitialized;
+
+    reset();
+    if(!getPokemonBoxLayout(generation, specificGenVersion, localization, layout))
+    {
+        return false;
+    }
+
+    saveManager_.seek(layout.currentBoxIndexOffset);
+    if(!saveManager_.readByte(currentBoxByte))
+    {
+        return false;
+    }
+    currentBoxIndex_ = currentBoxByte & layout.currentBoxIndexMask;
+    if(currentBoxIndex_ >= layout.numBoxes)
+    {
+        debugf("[PokemonBoxIndex]: ERROR: invalid current box index %hu\r\n", currentBoxIndex_);
+        return false;
+    }
+    boxesInitialized = (!layout.boxesInitializedMask || (currentBoxByte & layout.boxesInitializedMask));
+    numBoxes_ = layout.numBoxes;
+
+    // apart from the current box, the boxes are stored one after another in bank 2 and 3. So this is a single sequential pass
+    for(uint8_t i = 0; i < layout.numBoxes; ++i)
+    {
+        if(i != currentBoxIndex_ && !boxesInitialized)
+        {
+            // the game only initializes the other boxes the first time the player switches boxes. Until then, they contain garbage
+            continue;
+        }
+
+        if(!indexBox(layout, i, getPokemonBoxOffset(layout, i, currentBoxIndex_), speciesTables, (generation == 2)))
+        {
+            reset();
+            return false;
+        }
+    }
+
+    built_ = true;
+    debugf("[PokemonBoxIndex]: indexed %hu boxes in %lu ms\r\n", numBoxes_, static_cast<uint32_t>(TICKS_TO_MS(get_ticks() - startTime)));
+    return true;
+}
+
+bool PokemonBoxIndex::indexBox(const PokemonBoxLayout& layout, uint8_t boxIndex, uint32_t boxOffset, const SpeciesTableCache& speciesTables, bool hasEggs)
+{
+    // count + species list + the largest possible records area
+    uint8_t buffer[POKEMON_BOX_RECORDS_OFFSET + POKEMON_BOX_INDEX_SLOTS_PER_BOX * 33];
+    const uint32_t nicknamesOffset = boxOffset + POKEMON_BOX_RECORDS_OFFSET + (POKEMON_BOX_INDEX_SLOTS_PER_BOX * (layout.recordSize + POKEMON_BOX_NAME_SIZE));
+    uint8_t numPokemon;
+    uint8_t speciesIndex;
+
+    saveManager_.seek(boxOffset);
+    if(!saveManager_.read(buffer, POKEMON_BOX_RECORDS_OFFSET))
+    {
+        return false;
+    }
+
+    numPokemon = buffer[0];
+    if(numPokemon > POKEMON_BOX_INDEX_SLOTS_PER_BOX)
+    {
+        // an uninitialized box. Treat it as empty instead of failing the whole index
+        debugf("[PokemonBoxIndex]: box %hu has an invalid count %hu. Treating it as empty\r\n", boxIndex, numPokemon);
+        numPokemon_[boxIndex] = 0;
+        return true;
+    }
+
+    // only read the records of the occupied slots. They directly follow the species list, so we don't need to seek again
+    if(numPokemon && !saveManager_.read(buffer + POKEMON_BOX_RECORDS_OFFSET, numPokemon * layout.recordSize))
+    {
+        return false;
+    }
+
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        PokemonBoxIndexEntry& entry = entries_[boxIndex][i];
+        const uint8_t* record = buffer + POKEMON_BOX_RECORDS_OFFSET + (i * layout.recordSize);
+
+        // the species list says 0xFD for eggs in Gen 2. The record itself contains the species that will hatch
+        speciesIndex = buffer[BOX_SPECIES_LIST_OFFSET + i];
+        entry.flags = 0;
+        if(hasEggs && speciesIndex == GEN2_EGG_SPECIES_INDEX)
+        {
+            entry.flags |= POKEMON_BOX_INDEX_FLAG_EGG;
+            entry.iconType = static_cast<uint8_t>(Gen2PokemonIconType::GEN2_ICONTYPE_EGG);
+        }
+        else
+        {
+            entry.iconType = speciesTables.getPokemonIconType(record[0]);
+        }
+        entry.speciesIndex = record[0];
+        entry.level = record[layout.levelOffset];
+        entry.recordOffset = static_cast<uint16_t>(boxOffset + POKEMON_BOX_RECORDS_OFFSET + (i * layout.recordSize));
+        entry.nicknameOffset = static_cast<uint16_t>(nicknamesOffset + (i * POKEMON_BOX_NAME_SIZE));
+    }
+    numPokemon_[boxIndex] = numPokemon;
+    return true;
+}
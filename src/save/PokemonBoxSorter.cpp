@@ -0,0 +1,140 @@
+#include "save/PokemonBoxSorter.h"
+#include "save/SaveEditTransaction.h"
+#include "save/SaveUndoJournal.h"
+
+#include <libdragon.h>
+#include <cstring>
+
+static const uint8_t MAX_LEVEL = 100;
+// sorts eggs after every species
+static const uint16_t EGG_SORT_VALUE = 0xFFFF;
+
+PokemonBoxSorter::PokemonBoxSorter(TransferPakManager& pakManager)
+    : pakManager_(pakManager)
+{
+}
+
+bool PokemonBoxSorter::sortBoxes(const PokemonBoxIndex& boxIndex, PokemonBoxSortKey key, const SpeciesTableCache& speciesTables, uint8_t generation, uint8_t specificGenVersion, uint8_t localization, PokemonBoxSortResult& outResult)
+{
+    PokemonBoxLayout layout;
+    uint8_t sourceSlots[POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+    uint16_t numRanges;
+    uint16_t numBlocksWritten = 0;
+    uint8_t numMoved;
+    bool success;
+
+    outResult = PokemonBoxSortResult{0};
+    if(!boxIndex.isBuilt() || !getPokemonBoxLayout(generation, specificGenVersion, localization, layout) || boxIndex.getNumberOfBoxes() != layout.numBoxes)
+    {
+        return false;
+    }
+    outResult.numBytesFullRewrite = static_cast<uint32_t>(layout.numBoxes) * (POKEMON_BOX_RECORDS_OFFSET + POKEMON_BOX_INDEX_SLOTS_PER_BOX * (layout.recordSize + 2 * POKEMON_BOX_NAME_SIZE));
+
+    // allocated on the heap because of the size of the queued edits
+    SaveEditTransaction* transaction = new SaveEditTransaction(pakManager_, generation, specificGenVersion, localization);
+
+    for(uint8_t i = 0; i < layout.numBoxes; ++i)
+    {
+        numMoved = getSortedOrder(boxIndex, i, key, speciesTables, sourceSlots);
+        if(!numMoved)
+        {
+            // this box is already sorted. Don't touch it at all
+            continue;
+        }
+
+        if(!transaction->sortBox(i, sourceSlots, boxIndex.getNumberOfPokemon(i)))
+        {
+            break;
+        }
+        ++outResult.numSortedBoxes;
+        outResult.numMovedPokemon += numMoved;
+    }
+
+    if(!outResult.numSortedBoxes)
+    {
+        // everything is sorted already
+        delete transaction;
+        transaction = nullptr;
+        return true;
+    }
+
+    // apply everything in RAM first. If the save doesn't match the index anymore, we don't write anything
+    transaction->dryRun(nullptr, 0, numRanges);
+    if(transaction->getNumberOfFailedEdits())
+    {
+        debugf("[PokemonBoxSorter]: ERROR: the box index is outdated\r\n");
+        delete transaction;
+        transaction = nullptr;
+        outResult = PokemonBoxSortResult{0};
+        return false;
+    }
+
+    // keep the original contents of the blocks we modify on the SD card, so the sort can be undone
+    SaveUndoJournal undoJournal(pakManager_);
+    undoJournal.begin();
+    success = transaction->commit(numBlocksWritten);
+    pakManager_.finishWrites();
+    undoJournal.end();
+
+    delete transaction;
+    transaction = nullptr;
+
+    outResult.numBytesWritten = static_cast<uint32_t>(numBlocksWritten) * TPAK_BLOCK_SIZE;
+    debugf("[PokemonBoxSorter]: moved %u pokémon in %hu boxes. %lu bytes written instead of %lu\r\n", outResult.numMovedPokemon, outResult.numSortedBoxes, outResult.numBytesWritten, outResult.numBytesFullRewrite);
+    return success;
+}
+
+uint8_t PokemonBoxSorter::getSortedOrder(const PokemonBoxIndex& boxIndex, uint8_t box, PokemonBoxSortKey key, const SpeciesTableCache& speciesTables, uint8_t* outSourceSlots)
+{
+    const uint8_t numPokemon = boxIndex.getNumberOfPokemon(box);
+    uint16_t sortValues[POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+    uint16_t value;
+    uint8_t slot;
+    uint8_t numMoved = 0;
+    int8_t j;
+
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        sortValues[i] = getSortValue(*boxIndex.getEntry(box, i), key, speciesTables);
+    }
+
+    // a stable insertion sort of the slot numbers. With at most 20 pokémon, this is all we need
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        slot = i;
+        value = sortValues[i];
+        for(j = static_cast<int8_t>(i) - 1; j >= 0 && sortValues[outSourceSlots[j]] > value; --j)
+        {
+            outSourceSlots[j + 1] = outSourceSlots[j];
+        }
+        outSourceSlots[j + 1] = slot;
+    }
+
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        if(outSourceSlots[i] != i)
+        {
+            ++numMoved;
+        }
+    }
+    return numMoved;
+}
+
+uint16_t PokemonBoxSorter::getSortValue(const PokemonBoxIndexEntry& entry, PokemonBoxSortKey key, const SpeciesTableCache& speciesTables)
+{
+    uint16_t pokedexNumber;
+
+    if(entry.flags & POKEMON_BOX_INDEX_FLAG_EGG)
+    {
+        return EGG_SORT_VALUE;
+    }
+
+    // Gen 1 stores the internal species index, which is in a completely different order than the pokédex
+    pokedexNumber = speciesTables.getPokemonNumber(entry.speciesIndex);
+
+    if(key == PokemonBoxSortKey::LEVEL)
+    {
+        return static_cast<uint16_t>(((MAX_LEVEL - entry.level) << 8) | pokedexNumber);
+    }
+    return pokedexNumber;
+}
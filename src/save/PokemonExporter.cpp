@@ -0,0 +1,261 @@
+#include "save/PokemonExporter.h"
+#include "core/DragonUtils.h"
+
+#include <libdragon.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+//missing function declaration in libdragons' system.h, but the definition exists in system.c
+int mkdir( const char * path, mode_t mode );
+
+static const uint8_t PARTY_CAPACITY = 6;
+static const uint8_t LIST_TERMINATOR = 0xFF;
+// offset of the level in the party-only part of a Gen 1 party record
+static const uint8_t GEN1_PARTY_LEVEL_OFFSET = 0x21;
+
+// count + species list + records + original trainer names + nicknames of the largest list (a Gen 1 box)
+static const uint16_t MAX_LIST_SIZE = 1 + (POKEMON_BOX_INDEX_SLOTS_PER_BOX + 1) + POKEMON_BOX_INDEX_SLOTS_PER_BOX * (33 + 2 * POKEMON_BOX_NAME_SIZE);
+
+PokemonExporter::PokemonExporter(TransferPakManager& pakManager)
+    : saveManager_(pakManager)
+    , layout_({0})
+    , fileBuffer_()
+    , outputDirectory_()
+    , numExported_(0)
+    , generation_(0)
+    , currentBoxIndex_(0)
+    , nextStep_(0)
+    , numSteps_(0)
+    , boxesInitialized_(false)
+    , started_(false)
+    , finished_(false)
+    , failed_(false)
+{
+}
+
+bool PokemonExporter::start(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, const char* trainerName)
+{
+    struct stat statStruct;
+    char safeTrainerName[POKEMON_BOX_NAME_SIZE];
+    uint8_t currentBoxByte;
+    uint8_t i;
+
+    reset();
+    if(!sdcard_mounted || !getPokemonBoxLayout(generation, specificGenVersion, localization, layout_))
+    {
+        return false;
+    }
+
+    // the trainer name can contain characters that aren't allowed in a path
+    for(i = 0; trainerName[i] && i < POKEMON_BOX_NAME_SIZE - 1; ++i)
+    {
+        safeTrainerName[i] = (isalnum(static_cast<unsigned char>(trainerName[i]))) ? trainerName[i] : '_';
+    }
+    safeTrainerName[i] = '\0';
+
+    mkdir("sd:/PokeMe64", 0777);
+    mkdir("sd:/PokeMe64/export", 0777);
+    snprintf(outputDirectory_, sizeof(outputDirectory_), "sd:/PokeMe64/export/%s", safeTrainerName);
+    mkdir(outputDirectory_, 0777);
+    if(stat(outputDirectory_, &statStruct) != 0)
+    {
+        debugf("[PokemonExporter]: ERROR: could not create %s\r\n", outputDirectory_);
+        return false;
+    }
+
+    saveManager_.seek(layout_.currentBoxIndexOffset);
+    if(!saveManager_.readByte(currentBoxByte))
+    {
+        return false;
+    }
+    currentBoxIndex_ = currentBoxByte & layout_.currentBoxIndexMask;
+    if(currentBoxIndex_ >= layout_.numBoxes)
+    {
+        debugf("[PokemonExporter]: ERROR: invalid current box index %hu\r\n", currentBoxIndex_);
+        return false;
+    }
+    boxesInitialized_ = (!layout_.boxesInitializedMask || (currentBoxByte & layout_.boxesInitializedMask));
+
+    generation_ = generation;
+    // the party + every box
+    numSteps_ = 1 + layout_.numBoxes;
+    started_ = true;
+    return true;
+}
+
+bool PokemonExporter::step()
+{
+    uint8_t boxIndex;
+    bool success;
+
+    if(!started_ || finished_)
+    {
+        return finished_;
+    }
+
+    if(nextStep_ == 0)
+    {
+        success = exportList(layout_.partyOffset, PARTY_CAPACITY, layout_.partyRecordSize, 0);
+    }
+    else if(nextStep_ == 1)
+    {
+        success = exportList(layout_.currentBoxCopyOffset, POKEMON_BOX_INDEX_SLOTS_PER_BOX, layout_.recordSize, currentBoxIndex_ + 1);
+    }
+    else if(!boxesInitialized_)
+    {
+        // the game only initializes the other boxes the first time the player switches boxes. Until then, they contain garbage
+        success = true;
+    }
+    else
+    {
+        // skip the current box. It was already exported from its copy in bank 1
+        boxIndex = nextStep_ - 2;
+        if(boxIndex >= currentBoxIndex_)
+        {
+            ++boxIndex;
+        }
+        success = exportList(getPokemonBoxOffset(layout_, boxIndex, currentBoxIndex_), POKEMON_BOX_INDEX_SLOTS_PER_BOX, layout_.recordSize, boxIndex + 1);
+    }
+
+    ++nextStep_;
+    if(!success)
+    {
+        failed_ = true;
+        finished_ = true;
+    }
+    else if(nextStep_ >= numSteps_)
+    {
+        finished_ = true;
+    }
+
+    if(finished_)
+    {
+        debugf("[PokemonExporter]: exported %u pokémon to %s%s\r\n", numExported_, outputDirectory_, (failed_) ? " (FAILED)" : "");
+    }
+    return finished_;
+}
+
+bool PokemonExporter::isStarted() const
+{
+    return started_;
+}
+
+bool PokemonExporter::isFinished() const
+{
+    return finished_;
+}
+
+bool PokemonExporter::hasFailed() const
+{
+    return failed_;
+}
+
+uint16_t PokemonExporter::getNumberOfExportedPokemon() const
+{
+    return numExported_;
+}
+
+uint8_t PokemonExporter::getProgress() const
+{
+    if(finished_)
+    {
+        return 100;
+    }
+    if(!started_)
+    {
+        return 0;
+    }
+    return static_cast<uint8_t>((nextStep_ * 100) / numSteps_);
+}
+
+const char* PokemonExporter::getOutputDirectory() const
+{
+    return outputDirectory_;
+}
+
+void PokemonExporter::reset()
+{
+    layout_ = PokemonBoxLayout{0};
+    outputDirectory_[0] = '\0';
+    numExported_ = 0;
+    generation_ = 0;
+    currentBoxIndex_ = 0;
+    nextStep_ = 0;
+    numSteps_ = 0;
+    boxesInitialized_ = false;
+    started_ = false;
+    finished_ = false;
+    failed_ = false;
+}
+
+bool PokemonExporter::exportList(uint32_t listOffset, uint8_t capacity, uint8_t recordSize, uint8_t listNumber)
+{
+    uint8_t listBuffer[MAX_LIST_SIZE];
+    char path[POKEMON_EXPORTER_DIRECTORY_SIZE + 20];
+    const uint32_t recordsOffset = 1 + (capacity + 1);
+    const uint32_t originalTrainerNamesOffset = recordsOffset + capacity * recordSize;
+    const uint32_t nicknamesOffset = originalTrainerNamesOffset + capacity * POKEMON_BOX_NAME_SIZE;
+    const uint32_t listSize = nicknamesOffset + capacity * POKEMON_BOX_NAME_SIZE;
+    const uint8_t fileSize = (generation_ == 1) ? POKEMON_EXPORTER_PK1_SIZE : POKEMON_EXPORTER_PK2_SIZE;
+    const char* extension = (generation_ == 1) ? "pk1" : "pk2";
+    uint8_t* file;
+    uint8_t numPokemon;
+
+    // read the whole list at once. This is the only SRAM access for this list
+    saveManager_.seek(listOffset);
+    if(!saveManager_.read(listBuffer, listSize))
+    {
+        return false;
+    }
+
+    numPokemon = listBuffer[0];
+    if(numPokemon > capacity)
+    {
+        // an uninitialized box: there's nothing to export
+        debugf("[PokemonExporter]: list %hu has an invalid count %hu. Skipping it\r\n", listNumber, numPokemon);
+        return true;
+    }
+
+    // assemble all files in RAM first
+    memset(fileBuffer_, 0, numPokemon * fileSize);
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        file = fileBuffer_ + (i * fileSize);
+
+        // a .pk1/.pk2 file is a party list with a single pokémon
+        file[0] = 1;
+        file[1] = listBuffer[1 + i];
+        file[2] = LIST_TERMINATOR;
+        memcpy(file + 3, listBuffer + recordsOffset + (i * recordSize), recordSize);
+        if(generation_ == 1 && recordSize == layout_.recordSize)
+        {
+            // a Gen 1 box record has the level at offset 3. The party record repeats it in its party-only part
+            file[3 + GEN1_PARTY_LEVEL_OFFSET] = file[3 + layout_.levelOffset];
+        }
+        memcpy(file + 3 + layout_.partyRecordSize, listBuffer + originalTrainerNamesOffset + (i * POKEMON_BOX_NAME_SIZE), POKEMON_BOX_NAME_SIZE);
+        memcpy(file + 3 + layout_.partyRecordSize + POKEMON_BOX_NAME_SIZE, listBuffer + nicknamesOffset + (i * POKEMON_BOX_NAME_SIZE), POKEMON_BOX_NAME_SIZE);
+    }
+
+    // then write them one after another, with a single write per file
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        if(listNumber == 0)
+        {
+            snprintf(path, sizeof(path), "%s/party_%hu.%s", outputDirectory_, static_cast<uint8_t>(i + 1), extension);
+        }
+        else
+        {
+            snprintf(path, sizeof(path), "%s/box%02hu_%02hu.%s", outputDirectory_, listNumber, static_cast<uint8_t>(i + 1), extension);
+        }
+
+        if(writeBufferToFile(path, fileBuffer_ + (i * fileSize), fileSize) != fileSize)
+        {
+            debugf("[PokemonExporter]: ERROR: could not write %s\r\n", path);
+            return false;
+        }
+        ++numExported_;
+    }
+    return true;
+}
@@ -0,0 +1,305 @@
+#include "save/PokemonImporter.h"
+#include "save/SaveEditTransaction.h"
+#include "save/SaveUndoJournal.h"
+
+#include <libdragon.h>
+#include <cstdio>
+#include <cstring>
+
+static const uint8_t LIST_TERMINATOR = 0xFF;
+static const uint8_t NAME_TERMINATOR = 0x50;
+static const uint8_t GEN2_EGG_SPECIES_INDEX = 0xFD;
+// the highest (internal) species index of Gen 1 and the highest pokédex number of Gen 2
+static const uint8_t GEN1_MAX_SPECIES_INDEX = 190;
+static const uint8_t GEN2_MAX_SPECIES_INDEX = 251;
+// offset of the level in a Gen 1 party record and in a Gen 1 box record
+static const uint8_t GEN1_PARTY_LEVEL_OFFSET = 0x21;
+static const uint8_t GEN1_BOX_LEVEL_OFFSET = 3;
+static const uint8_t GEN2_LEVEL_OFFSET = 0x1F;
+static const uint8_t MAX_LEVEL = 100;
+
+static bool isValidName(const uint8_t* name)
+{
+    return (memchr(name, NAME_TERMINATOR, POKEMON_BOX_NAME_SIZE) != nullptr);
+}
+
+bool validatePokemonFile(uint8_t generation, uint8_t* file, uint32_t fileSize)
+{
+    const uint8_t* record = file + 3;
+    uint32_t partyRecordSize;
+    uint8_t level;
+
+    if(generation == 1 && fileSize == POKEMON_EXPORTER_PK1_SIZE)
+    {
+        partyRecordSize = POKEMON_EXPORTER_PK1_SIZE - 3 - 2 * POKEMON_BOX_NAME_SIZE;
+        if(!record[0] || record[0] > GEN1_MAX_SPECIES_INDEX || file[1] != record[0])
+        {
+            return false;
+        }
+        level = record[GEN1_PARTY_LEVEL_OFFSET];
+    }
+    else if(generation == 2 && fileSize == POKEMON_EXPORTER_PK2_SIZE)
+    {
+        partyRecordSize = POKEMON_EXPORTER_PK2_SIZE - 3 - 2 * POKEMON_BOX_NAME_SIZE;
+        if(!record[0] || record[0] > GEN2_MAX_SPECIES_INDEX || (file[1] != record[0] && file[1] != GEN2_EGG_SPECIES_INDEX))
+        {
+            return false;
+        }
+        level = record[GEN2_LEVEL_OFFSET];
+    }
+    else
+    {
+        return false;
+    }
+
+    // a single-entry list: count 1 followed by the terminated species list
+    if(file[0] != 1 || file[2] != LIST_TERMINATOR || !level || level > MAX_LEVEL)
+    {
+        return false;
+    }
+    if(!isValidName(record + partyRecordSize) || !isValidName(record + partyRecordSize + POKEMON_BOX_NAME_SIZE))
+    {
+        return false;
+    }
+
+    if(generation == 1)
+    {
+        // the box record has the level at offset 3, which the game only uses as the level when the pokémon is in a box.
+        // Other tools don't always keep it in sync with the party level
+        file[3 + GEN1_BOX_LEVEL_OFFSET] = level;
+    }
+    return true;
+}
+
+PokemonImporter::PokemonImporter(TransferPakManager& pakManager)
+    : pakManager_(pakManager)
+    , saveManager_(pakManager)
+    , fileBuffer_()
+    , boxOrder_()
+    , freeSlots_()
+{
+}
+
+bool PokemonImporter::importFiles(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, const char* const* paths, uint8_t numPaths, PokemonImportResult& outResult)
+{
+    PokemonBoxLayout layout;
+    uint32_t fileSize;
+    uint16_t numRanges;
+    uint16_t numBlocksWritten = 0;
+    uint8_t numUsableBoxes;
+    uint8_t numQueued = 0;
+    uint8_t boxOrderIndex = 0;
+    bool success;
+
+    outResult = PokemonImportResult{0};
+    if(!getPokemonBoxLayout(generation, specificGenVersion, localization, layout))
+    {
+        return false;
+    }
+
+    // this is the only time we read the box counts. From here on, we keep track of the free slots ourselves
+    numUsableBoxes = readFreeSlots(layout);
+
+    // allocated on the heap because of the size of the queued edits
+    SaveEditTransaction* transaction = new SaveEditTransaction(pakManager_, generation, specificGenVersion, localization);
+
+    for(uint8_t i = 0; i < numPaths; ++i)
+    {
+        fileSize = readFile(paths[i]);
+        if(!validatePokemonFile(generation, fileBuffer_, fileSize))
+        {
+            debugf("[PokemonImporter]: %s is not a valid pokémon file for this game\r\n", paths[i]);
+            ++outResult.numInvalid;
+            continue;
+        }
+
+        if(!queuePokemon(*transaction, fileBuffer_, numUsableBoxes, boxOrderIndex))
+        {
+            ++outResult.numNoRoom;
+            continue;
+        }
+        ++numQueued;
+    }
+
+    // apply everything in RAM first, so we know how many pokémon actually got a slot before anything gets written
+    transaction->dryRun(nullptr, 0, numRanges);
+    outResult.numImported = numQueued - transaction->getNumberOfFailedEdits();
+    outResult.numNoRoom += transaction->getNumberOfFailedEdits();
+
+    success = commitTransaction(*transaction, numBlocksWritten);
+
+    delete transaction;
+    transaction = nullptr;
+
+    if(!success)
+    {
+        outResult.numImported = 0;
+    }
+    outResult.numBytesWritten = static_cast<uint32_t>(numBlocksWritten) * TPAK_BLOCK_SIZE;
+    debugf("[PokemonImporter]: imported %hu pokémon (%hu invalid, %hu without room). %lu bytes written\r\n", outResult.numImported, outResult.numInvalid, outResult.numNoRoom, outResult.numBytesWritten);
+    return success;
+}
+
+bool PokemonImporter::importPokemon(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, uint8_t* files, uint8_t numFiles, bool* outImported, PokemonImportResult& outResult)
+{
+    const uint32_t fileSize = (generation == 1) ? POKEMON_EXPORTER_PK1_SIZE : POKEMON_EXPORTER_PK2_SIZE;
+    PokemonBoxLayout layout;
+    uint8_t* file;
+    uint16_t numRanges;
+    uint16_t numBlocksWritten = 0;
+    uint8_t numUsableBoxes;
+    uint8_t numQueued = 0;
+    uint8_t boxOrderIndex = 0;
+    bool success;
+
+    outResult = PokemonImportResult{0};
+    if(outImported)
+    {
+        memset(outImported, 0, numFiles * sizeof(bool));
+    }
+    if(!getPokemonBoxLayout(generation, specificGenVersion, localization, layout))
+    {
+        return false;
+    }
+
+    numUsableBoxes = readFreeSlots(layout);
+    SaveEditTransaction* transaction = new SaveEditTransaction(pakManager_, generation, specificGenVersion, localization);
+
+    for(uint8_t i = 0; i < numFiles; ++i)
+    {
+        file = files + (i * fileSize);
+        if(!validatePokemonFile(generation, file, fileSize))
+        {
+            ++outResult.numInvalid;
+            continue;
+        }
+
+        if(!queuePokemon(*transaction, file, numUsableBoxes, boxOrderIndex))
+        {
+            ++outResult.numNoRoom;
+            continue;
+        }
+        if(outImported)
+        {
+            outImported[i] = true;
+        }
+        ++numQueued;
+    }
+
+    transaction->dryRun(nullptr, 0, numRanges);
+    if(transaction->getNumberOfFailedEdits())
+    {
+        // we wouldn't know which of the pokémon didn't make it
+        debugf("[PokemonImporter]: ERROR: %hu of the pokémon couldn't be placed. Nothing was imported\r\n", transaction->getNumberOfFailedEdits());
+        transaction->rollback();
+        success = false;
+    }
+    else
+    {
+        success = commitTransaction(*transaction, numBlocksWritten);
+    }
+
+    delete transaction;
+    transaction = nullptr;
+
+    if(success)
+    {
+        outResult.numImported = numQueued;
+    }
+    else if(outImported)
+    {
+        memset(outImported, 0, numFiles * sizeof(bool));
+    }
+    outResult.numBytesWritten = static_cast<uint32_t>(numBlocksWritten) * TPAK_BLOCK_SIZE;
+    debugf("[PokemonImporter]: imported %hu pokémon from RAM (%hu invalid, %hu without room). %lu bytes written\r\n", outResult.numImported, outResult.numInvalid, outResult.numNoRoom, outResult.numBytesWritten);
+    return success;
+}
+
+bool PokemonImporter::queuePokemon(SaveEditTransaction& transaction, const uint8_t* file, uint8_t numUsableBoxes, uint8_t& boxOrderIndex)
+{
+    // the boxes are filled in order, so we never need to look back at the boxes before boxOrderIndex
+    while(boxOrderIndex < numUsableBoxes && !freeSlots_[boxOrder_[boxOrderIndex]])
+    {
+        ++boxOrderIndex;
+    }
+
+    if(boxOrderIndex >= numUsableBoxes || !transaction.importBoxPokemon(boxOrder_[boxOrderIndex], file))
+    {
+        return false;
+    }
+    --freeSlots_[boxOrder_[boxOrderIndex]];
+    return true;
+}
+
+bool PokemonImporter::commitTransaction(SaveEditTransaction& transaction, uint16_t& outNumBlocksWritten)
+{
+    bool success;
+
+    // keep the original contents of the blocks we modify on the SD card, so the import can be undone
+    SaveUndoJournal undoJournal(pakManager_);
+    undoJournal.begin();
+    success = transaction.commit(outNumBlocksWritten);
+    pakManager_.finishWrites();
+    undoJournal.end();
+    return success;
+}
+
+uint8_t PokemonImporter::readFreeSlots(const PokemonBoxLayout& layout)
+{
+    uint8_t currentBoxByte;
+    uint8_t currentBoxIndex;
+    uint8_t numPokemon;
+    uint8_t numBoxes = 0;
+    bool boxesInitialized;
+
+    memset(freeSlots_, 0, sizeof(freeSlots_));
+
+    saveManager_.seek(layout.currentBoxIndexOffset);
+    if(!saveManager_.readByte(currentBoxByte))
+    {
+        return 0;
+    }
+    currentBoxIndex = currentBoxByte & layout.currentBoxIndexMask;
+    if(currentBoxIndex >= layout.numBoxes)
+    {
+        return 0;
+    }
+    // the game only initializes the other boxes the first time the player switches boxes. Until then, we can't put anything in them
+    boxesInitialized = (!layout.boxesInitializedMask || (currentBoxByte & layout.boxesInitializedMask));
+
+    // the current box first (that's where the game puts new pokémon as well), then the others in the order in which they're stored
+    boxOrder_[numBoxes++] = currentBoxIndex;
+    for(uint8_t i = 0; boxesInitialized && i < layout.numBoxes; ++i)
+    {
+        if(i != currentBoxIndex)
+        {
+            boxOrder_[numBoxes++] = i;
+        }
+    }
+
+    for(uint8_t i = 0; i < numBoxes; ++i)
+    {
+        saveManager_.seek(getPokemonBoxOffset(layout, boxOrder_[i], currentBoxIndex));
+        if(!saveManager_.readByte(numPokemon))
+        {
+            return 0;
+        }
+        // a garbage count means we don't touch the box
+        freeSlots_[boxOrder_[i]] = (numPokemon <= POKEMON_BOX_INDEX_SLOTS_PER_BOX) ? POKEMON_BOX_INDEX_SLOTS_PER_BOX - numPokemon : 0;
+    }
+    return numBoxes;
+}
+
+uint32_t PokemonImporter::readFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    uint32_t fileSize;
+
+    if(!file)
+    {
+        return 0;
+    }
+    fileSize = static_cast<uint32_t>(fread(fileBuffer_, 1, sizeof(fileBuffer_), file));
+    fclose(file);
+    return fileSize;
+}
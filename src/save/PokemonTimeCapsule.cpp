@@ -0,0 +1,495 @@
+#include "save/PokemonTimeCapsule.h"
+#include "save/SaveEditTransaction.h"
+#include "save/SaveUndoJournal.h"
+#include "core/CartridgeIdentification.h"
+#include "tpak.h"
+
+#include <libdragon.h>
+#include <cstring>
+
+static const uint8_t LIST_TERMINATOR = 0xFF;
+static const uint8_t GEN2_EGG_SPECIES_INDEX = 0xFD;
+// the highest move index of Gen 1 (Struggle)
+static const uint8_t GEN1_MAX_MOVE_INDEX = 165;
+static const uint8_t GEN1_MAX_SPECIES_INDEX = 190;
+static const uint8_t GEN1_PARTY_RECORD_SIZE = POKEMON_EXPORTER_PK1_SIZE - 3 - 2 * POKEMON_BOX_NAME_SIZE;
+static const uint8_t GEN2_PARTY_RECORD_SIZE = POKEMON_EXPORTER_PK2_SIZE - 3 - 2 * POKEMON_BOX_NAME_SIZE;
+
+// Gen 1 box record offsets
+static const uint8_t GEN1_CURRENT_HP_OFFSET = 0x01;
+static const uint8_t GEN1_BOX_LEVEL_OFFSET = 0x03;
+static const uint8_t GEN1_TYPE1_OFFSET = 0x05;
+static const uint8_t GEN1_TYPE2_OFFSET = 0x06;
+static const uint8_t GEN1_CATCH_RATE_OFFSET = 0x07;
+static const uint8_t GEN1_MOVES_OFFSET = 0x08;
+// offsets in the party-only part of a Gen 1 party record
+static const uint8_t GEN1_PARTY_LEVEL_OFFSET = 0x21;
+static const uint8_t GEN1_MAX_HP_OFFSET = 0x22;
+
+// Gen 2 box record offsets
+static const uint8_t GEN2_HELD_ITEM_OFFSET = 0x01;
+static const uint8_t GEN2_MOVES_OFFSET = 0x02;
+static const uint8_t GEN2_HP_STAT_EXP_OFFSET = 0x0B;
+static const uint8_t GEN2_DVS_OFFSET = 0x15;
+static const uint8_t GEN2_FRIENDSHIP_OFFSET = 0x1B;
+static const uint8_t GEN2_LEVEL_OFFSET = 0x1F;
+
+// moves, original trainer ID, experience, stat experience, DVs and PP are stored the same way in both generations
+static const uint8_t SHARED_FIELDS_SIZE = 25;
+static const uint8_t GEN2_BASE_FRIENDSHIP = 70;
+
+/**
+ * @brief A Gen 1 catch rate value that the Time Capsule turns into a different held item
+ */
+typedef struct CatchRateItem
+{
+    uint8_t catchRate;
+    uint8_t item;
+} CatchRateItem;
+
+// Gen 1 pokémon don't have a held item: the byte is the catch rate. Most of its values are items that can't be held
+// (or don't exist) in Gen 2, so the Time Capsule replaces them. Any other value is kept as the held item.
+static const CatchRateItem catchRateItems[] = {
+    { 0x19, 0x92 }, // LEFTOVERS
+    { 0x2D, 0x53 }, // BITTER BERRY
+    { 0x32, 0xAE }, // GOLD BERRY
+    { 0x5A, 0xAD }, // BERRY
+    { 0x64, 0xAD },
+    { 0x78, 0xAD },
+    { 0x87, 0xAD },
+    { 0xBE, 0xAD },
+    { 0xC3, 0xAD },
+    { 0xDC, 0xAD },
+    { 0xFA, 0xAD },
+    { 0xFF, 0xAD }
+};
+
+static uint8_t convertCatchRateIntoItem(uint8_t catchRate)
+{
+    for(uint8_t i = 0; i < sizeof(catchRateItems) / sizeof(catchRateItems[0]); ++i)
+    {
+        if(catchRateItems[i].catchRate == catchRate)
+        {
+            return catchRateItems[i].item;
+        }
+    }
+    return catchRate;
+}
+
+/**
+ * @brief Returns the smallest value whose square is at least the given value, capped at 255 (like the games do for stat experience)
+ */
+static uint16_t ceilSqrtCapped(uint16_t value)
+{
+    uint16_t result = 0;
+
+    while(result < 255 && result * result < value)
+    {
+        ++result;
+    }
+    return result;
+}
+
+/**
+ * @brief Calculates the max HP of a Gen 1 pokémon. The HP DV is made up of the lowest bit of each of the other DVs
+ */
+static uint16_t calculateGen1MaxHP(uint8_t baseHP, const uint8_t* dvs, uint16_t hpStatExp, uint8_t level)
+{
+    const uint8_t hpDV = ((dvs[0] & 0x10) >> 1) | ((dvs[0] & 0x01) << 2) | ((dvs[1] & 0x10) >> 3) | (dvs[1] & 0x01);
+    const uint32_t baseValue = (static_cast<uint32_t>(baseHP) + hpDV) * 2 + ceilSqrtCapped(hpStatExp) / 4;
+
+    return static_cast<uint16_t>((baseValue * level) / 100 + level + 10);
+}
+
+PokemonTimeCapsule::PokemonTimeCapsule(TransferPakManager& sourcePakManager)
+    : sourcePakManager_(sourcePakManager)
+    , destinationPakManager_()
+    , destinationRomReader_(destinationPakManager_)
+    , destinationSaveManager_(destinationPakManager_)
+    , destinationGen1Reader_(nullptr)
+    , destinationSpeciesTables_()
+    , destinationSpeciesIndices_()
+    , boxBuffer_()
+    , fileBuffer_()
+    , fileSourceSlots_()
+    , destinationGeneration_(0)
+    , destinationSpecificGenVersion_(0)
+    , destinationLocalization_(0)
+    , destinationOpen_(false)
+{
+}
+
+PokemonTimeCapsule::~PokemonTimeCapsule()
+{
+    closeDestination();
+}
+
+PokemonTimeCapsuleStatus PokemonTimeCapsule::openDestination()
+{
+    const uint64_t startTime = get_ticks();
+    PokemonBoxLayout layout;
+    uint8_t pokedexNumber;
+    bool found = false;
+    bool saveValid;
+
+    closeDestination();
+    for(int i = 0; i < JOYPAD_PORT_COUNT; ++i)
+    {
+        const joypad_port_t port = static_cast<joypad_port_t>(i);
+        if(port == sourcePakManager_.getPort())
+        {
+            continue;
+        }
+
+        destinationPakManager_.setPort(port);
+        if(destinationPakManager_.hasTransferPak())
+        {
+            found = true;
+            break;
+        }
+    }
+
+    if(!found)
+    {
+        return PokemonTimeCapsuleStatus::NO_SECOND_TRANSFER_PAK;
+    }
+
+    destinationPakManager_.setPower(true);
+    // we only know the box layouts of the international versions, so we can only get here with a MBC3 or MBC5 cartridge (no MBC1 banking mode)
+    if(!identifyDestinationGame() || !getPokemonBoxLayout(destinationGeneration_, destinationSpecificGenVersion_, destinationLocalization_, layout))
+    {
+        destinationPakManager_.setPower(false);
+        return PokemonTimeCapsuleStatus::UNSUPPORTED_GAME;
+    }
+
+    destinationPakManager_.setRAMEnabled(true);
+    if(destinationGeneration_ == 1)
+    {
+        destinationGen1Reader_ = new Gen1GameReader(destinationRomReader_, destinationSaveManager_, static_cast<Gen1GameType>(destinationSpecificGenVersion_), static_cast<Gen1LocalizationLanguage>(destinationLocalization_));
+        saveValid = destinationGen1Reader_->isMainChecksumValid();
+    }
+    else
+    {
+        Gen2GameReader gen2Reader(destinationRomReader_, destinationSaveManager_, static_cast<Gen2GameType>(destinationSpecificGenVersion_), static_cast<Gen2LocalizationLanguage>(destinationLocalization_));
+        saveValid = gen2Reader.isMainChecksumValid();
+    }
+    destinationPakManager_.setRAMEnabled(false);
+
+    if(!saveValid)
+    {
+        closeDestination();
+        return PokemonTimeCapsuleStatus::INVALID_SAVE;
+    }
+
+    if(destinationGen1Reader_)
+    {
+        // Gen 1 stores the species by its internal index, so we need the way back from the pokédex number
+        destinationSpeciesTables_.build(*destinationGen1Reader_);
+        memset(destinationSpeciesIndices_, 0, sizeof(destinationSpeciesIndices_));
+        for(uint16_t i = 1; i <= GEN1_MAX_SPECIES_INDEX; ++i)
+        {
+            pokedexNumber = destinationSpeciesTables_.getPokemonNumber(static_cast<uint8_t>(i));
+            if(pokedexNumber && pokedexNumber <= POKEMON_TIME_CAPSULE_GEN1_NUM_SPECIES)
+            {
+                destinationSpeciesIndices_[pokedexNumber] = static_cast<uint8_t>(i);
+            }
+        }
+    }
+
+    destinationOpen_ = true;
+    debugf("[PokemonTimeCapsule]: opened gen %hu game %hu in controller port %d in %lu ms\r\n", destinationGeneration_, destinationSpecificGenVersion_, static_cast<int>(destinationPakManager_.getPort()) + 1, static_cast<uint32_t>(TICKS_TO_MS(get_ticks() - startTime)));
+    return PokemonTimeCapsuleStatus::OK;
+}
+
+void PokemonTimeCapsule::closeDestination()
+{
+    destinationSpeciesTables_.reset();
+    delete destinationGen1Reader_;
+    destinationGen1Reader_ = nullptr;
+
+    if(destinationPakManager_.isPoweredOn())
+    {
+        destinationPakManager_.setRAMEnabled(false);
+        destinationPakManager_.setPower(false);
+    }
+    destinationGeneration_ = 0;
+    destinationSpecificGenVersion_ = 0;
+    destinationLocalization_ = 0;
+    destinationOpen_ = false;
+}
+
+bool PokemonTimeCapsule::isDestinationOpen() const
+{
+    return destinationOpen_;
+}
+
+joypad_port_t PokemonTimeCapsule::getDestinationPort() const
+{
+    return destinationPakManager_.getPort();
+}
+
+uint8_t PokemonTimeCapsule::getDestinationGeneration() const
+{
+    return destinationGeneration_;
+}
+
+PokemonTimeCapsuleStatus PokemonTimeCapsule::moveBox(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, const SpeciesTableCache& speciesTables, uint8_t boxIndex, PokemonTimeCapsuleResult& outResult)
+{
+    const uint64_t startTime = get_ticks();
+    const uint8_t fileSize = (destinationGeneration_ == 1) ? POKEMON_EXPORTER_PK1_SIZE : POKEMON_EXPORTER_PK2_SIZE;
+    PokemonBoxLayout layout;
+    PokemonImportResult importResult;
+    bool imported[POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+    bool removedSlots[POKEMON_BOX_INDEX_SLOTS_PER_BOX];
+    uint16_t numRanges;
+    uint16_t numBlocksWritten = 0;
+    uint8_t numPokemon;
+    uint8_t numFiles = 0;
+    bool success;
+
+    outResult = PokemonTimeCapsuleResult{0};
+    if(!destinationOpen_ || !getPokemonBoxLayout(generation, specificGenVersion, localization, layout))
+    {
+        return PokemonTimeCapsuleStatus::TRANSFER_FAILED;
+    }
+
+    // step 1: read the whole source box at once and convert all of its pokémon in RAM
+    sourcePakManager_.setRAMEnabled(true);
+    numPokemon = readSourceBox(layout, boxIndex);
+    if(numPokemon == LIST_TERMINATOR)
+    {
+        sourcePakManager_.setRAMEnabled(false);
+        return PokemonTimeCapsuleStatus::TRANSFER_FAILED;
+    }
+
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        if(!convertPokemon(generation, layout, speciesTables, i, fileBuffer_ + (numFiles * fileSize)))
+        {
+            ++outResult.numIncompatible;
+            continue;
+        }
+        fileSourceSlots_[numFiles] = i;
+        ++numFiles;
+    }
+
+    if(!numFiles)
+    {
+        sourcePakManager_.setRAMEnabled(false);
+        return PokemonTimeCapsuleStatus::OK;
+    }
+
+    // step 2: write them to the destination cartridge. This must succeed before we remove anything from the source cartridge
+    destinationPakManager_.setRAMEnabled(true);
+    PokemonImporter importer(destinationPakManager_);
+    success = importer.importPokemon(destinationGeneration_, destinationSpecificGenVersion_, destinationLocalization_, fileBuffer_, numFiles, imported, importResult);
+    destinationPakManager_.setRAMEnabled(false);
+
+    outResult.numBytesWrittenDestination = importResult.numBytesWritten;
+    outResult.numIncompatible += importResult.numInvalid;
+    if(!success)
+    {
+        sourcePakManager_.setRAMEnabled(false);
+        outResult.numNoRoom = importResult.numNoRoom;
+        // importPokemon() is all or nothing. If nothing was written because there's no room, that's not a failure of the transfer
+        return (importResult.numNoRoom) ? PokemonTimeCapsuleStatus::OK : PokemonTimeCapsuleStatus::TRANSFER_FAILED;
+    }
+    outResult.numMoved = importResult.numImported;
+
+    // step 3: remove the pokémon that were moved from the source box with a single transaction
+    memset(removedSlots, 0, sizeof(removedSlots));
+    for(uint8_t i = 0; i < numFiles; ++i)
+    {
+        removedSlots[fileSourceSlots_[i]] = imported[i];
+    }
+
+    SaveEditTransaction* transaction = new SaveEditTransaction(sourcePakManager_, generation, specificGenVersion, localization);
+    success = transaction->removeBoxPokemon(boxIndex, removedSlots, numPokemon);
+    if(success)
+    {
+        transaction->dryRun(nullptr, 0, numRanges);
+        success = (!transaction->getNumberOfFailedEdits());
+    }
+
+    if(success)
+    {
+        // this journal replaces the one of the destination cartridge: undoing it puts the pokémon back, so you get a copy on both cartridges
+        SaveUndoJournal undoJournal(sourcePakManager_);
+        undoJournal.begin();
+        success = transaction->commit(numBlocksWritten);
+        sourcePakManager_.finishWrites();
+        undoJournal.end();
+    }
+    else
+    {
+        transaction->rollback();
+    }
+    delete transaction;
+    transaction = nullptr;
+    sourcePakManager_.setRAMEnabled(false);
+
+    outResult.numBytesWrittenSource = static_cast<uint32_t>(numBlocksWritten) * TPAK_BLOCK_SIZE;
+    debugf("[PokemonTimeCapsule]: moved %hu pokémon of box %hu (%hu incompatible) in %lu ms. %lu + %lu bytes written%s\r\n", outResult.numMoved, boxIndex, outResult.numIncompatible, static_cast<uint32_t>(TICKS_TO_MS(get_ticks() - startTime)), outResult.numBytesWrittenSource, outResult.numBytesWrittenDestination, (success) ? "" : " (REMOVING THEM FROM THE SOURCE FAILED)");
+    return (success) ? PokemonTimeCapsuleStatus::OK : PokemonTimeCapsuleStatus::TRANSFER_FAILED;
+}
+
+bool PokemonTimeCapsule::identifyDestinationGame()
+{
+    gameboy_cartridge_header header;
+    GameboyCartridgeHeader cartridgeHeader;
+    CartridgeIdentity identity;
+    Gen1GameType gen1Type;
+    Gen2GameType gen2Type;
+
+    if(!destinationPakManager_.readCartridgeHeader(header) || !tpak_check_header(&header))
+    {
+        return false;
+    }
+
+    if(identifyKnownCartridge(header, identity))
+    {
+        destinationGeneration_ = identity.generation;
+        destinationSpecificGenVersion_ = identity.specificGenVersion;
+        destinationLocalization_ = identity.localization;
+        return true;
+    }
+
+    // not a known cartridge: probe the ROM, just like TransferPakDetectionWidget does
+    readGameboyCartridgeHeader(destinationRomReader_, cartridgeHeader);
+    gen1Type = gen1_determineGameType(cartridgeHeader);
+    gen2Type = gen2_determineGameType(cartridgeHeader);
+    if(gen1Type != Gen1GameType::INVALID)
+    {
+        destinationGeneration_ = 1;
+        destinationSpecificGenVersion_ = static_cast<uint8_t>(gen1Type);
+        destinationLocalization_ = static_cast<uint8_t>(gen1_determineGameLanguage(destinationRomReader_, gen1Type));
+        return true;
+    }
+    else if(gen2Type != Gen2GameType::INVALID)
+    {
+        destinationGeneration_ = 2;
+        destinationSpecificGenVersion_ = static_cast<uint8_t>(gen2Type);
+        destinationLocalization_ = static_cast<uint8_t>(gen2_determineGameLanguage(destinationRomReader_, gen2Type));
+        return true;
+    }
+    return false;
+}
+
+uint8_t PokemonTimeCapsule::readSourceBox(const PokemonBoxLayout& layout, uint8_t boxIndex)
+{
+    TransferPakSaveManager saveManager(sourcePakManager_);
+    const uint32_t boxSize = POKEMON_BOX_RECORDS_OFFSET + POKEMON_BOX_INDEX_SLOTS_PER_BOX * (layout.recordSize + 2 * POKEMON_BOX_NAME_SIZE);
+    uint8_t currentBoxByte;
+    uint8_t currentBoxIndex;
+
+    saveManager.seek(layout.currentBoxIndexOffset);
+    if(boxIndex >= layout.numBoxes || !saveManager.readByte(currentBoxByte))
+    {
+        return LIST_TERMINATOR;
+    }
+    currentBoxIndex = currentBoxByte & layout.currentBoxIndexMask;
+    if(currentBoxIndex >= layout.numBoxes)
+    {
+        return LIST_TERMINATOR;
+    }
+    if(boxIndex != currentBoxIndex && layout.boxesInitializedMask && !(currentBoxByte & layout.boxesInitializedMask))
+    {
+        // the game hasn't initialized the other boxes yet, so they're empty
+        return 0;
+    }
+
+    // the only SRAM read of the source box
+    saveManager.seek(getPokemonBoxOffset(layout, boxIndex, currentBoxIndex));
+    if(!saveManager.read(boxBuffer_, boxSize))
+    {
+        return LIST_TERMINATOR;
+    }
+    // a garbage count means we don't touch the box
+    return (boxBuffer_[0] <= POKEMON_BOX_INDEX_SLOTS_PER_BOX) ? boxBuffer_[0] : 0;
+}
+
+bool PokemonTimeCapsule::convertPokemon(uint8_t sourceGeneration, const PokemonBoxLayout& sourceLayout, const SpeciesTableCache& sourceSpeciesTables, uint8_t slotIndex, uint8_t* outFile)
+{
+    const uint8_t* sourceRecord = boxBuffer_ + POKEMON_BOX_RECORDS_OFFSET + (slotIndex * sourceLayout.recordSize);
+    const uint8_t* originalTrainerName = boxBuffer_ + POKEMON_BOX_RECORDS_OFFSET + (POKEMON_BOX_INDEX_SLOTS_PER_BOX * sourceLayout.recordSize) + (slotIndex * POKEMON_BOX_NAME_SIZE);
+    const uint8_t* nickname = originalTrainerName + (POKEMON_BOX_INDEX_SLOTS_PER_BOX * POKEMON_BOX_NAME_SIZE);
+    const uint8_t destinationPartyRecordSize = (destinationGeneration_ == 1) ? GEN1_PARTY_RECORD_SIZE : GEN2_PARTY_RECORD_SIZE;
+    uint8_t* record = outFile + 3;
+    Gen1PokeStats stats;
+    uint16_t maxHP;
+    uint8_t pokedexNumber;
+
+    memset(outFile, 0, (destinationGeneration_ == 1) ? POKEMON_EXPORTER_PK1_SIZE : POKEMON_EXPORTER_PK2_SIZE);
+    outFile[0] = 1;
+    outFile[2] = LIST_TERMINATOR;
+    memcpy(record + destinationPartyRecordSize, originalTrainerName, POKEMON_BOX_NAME_SIZE);
+    memcpy(record + destinationPartyRecordSize + POKEMON_BOX_NAME_SIZE, nickname, POKEMON_BOX_NAME_SIZE);
+
+    if(sourceGeneration == destinationGeneration_)
+    {
+        // nothing to convert
+        outFile[1] = boxBuffer_[1 + slotIndex];
+        memcpy(record, sourceRecord, sourceLayout.recordSize);
+        if(sourceGeneration == 1)
+        {
+            record[GEN1_PARTY_LEVEL_OFFSET] = record[GEN1_BOX_LEVEL_OFFSET];
+        }
+        return true;
+    }
+
+    if(sourceGeneration == 1)
+    {
+        pokedexNumber = sourceSpeciesTables.getPokemonNumber(sourceRecord[0]);
+        if(!pokedexNumber || pokedexNumber > POKEMON_TIME_CAPSULE_GEN1_NUM_SPECIES)
+        {
+            // MissingNo and friends
+            return false;
+        }
+
+        // Gen 2 uses the pokédex number as the species index
+        outFile[1] = pokedexNumber;
+        record[0] = pokedexNumber;
+        record[GEN2_HELD_ITEM_OFFSET] = convertCatchRateIntoItem(sourceRecord[GEN1_CATCH_RATE_OFFSET]);
+        memcpy(record + GEN2_MOVES_OFFSET, sourceRecord + GEN1_MOVES_OFFSET, SHARED_FIELDS_SIZE);
+        // pokérus and the caught data stay 0: that's what the Time Capsule does as well
+        record[GEN2_FRIENDSHIP_OFFSET] = GEN2_BASE_FRIENDSHIP;
+        record[GEN2_LEVEL_OFFSET] = sourceRecord[GEN1_BOX_LEVEL_OFFSET];
+        return true;
+    }
+
+    // Gen 2 -> Gen 1: only pokémon that could have existed in Gen 1 can go back
+    pokedexNumber = sourceRecord[0];
+    if(boxBuffer_[1 + slotIndex] == GEN2_EGG_SPECIES_INDEX || !pokedexNumber || pokedexNumber > POKEMON_TIME_CAPSULE_GEN1_NUM_SPECIES || !destinationSpeciesIndices_[pokedexNumber])
+    {
+        return false;
+    }
+    for(uint8_t i = 0; i < 4; ++i)
+    {
+        if(sourceRecord[GEN2_MOVES_OFFSET + i] > GEN1_MAX_MOVE_INDEX)
+        {
+            return false;
+        }
+    }
+    if(!destinationSpeciesTables_.getGen1PokeStats(destinationSpeciesIndices_[pokedexNumber], stats))
+    {
+        return false;
+    }
+
+    outFile[1] = destinationSpeciesIndices_[pokedexNumber];
+    record[0] = destinationSpeciesIndices_[pokedexNumber];
+    record[GEN1_BOX_LEVEL_OFFSET] = sourceRecord[GEN2_LEVEL_OFFSET];
+    record[GEN1_TYPE1_OFFSET] = stats.type1;
+    record[GEN1_TYPE2_OFFSET] = stats.type2;
+    // the held item ends up in the catch rate byte, so it comes back when the pokémon returns to Gen 2
+    record[GEN1_CATCH_RATE_OFFSET] = sourceRecord[GEN2_HELD_ITEM_OFFSET];
+    memcpy(record + GEN1_MOVES_OFFSET, sourceRecord + GEN2_MOVES_OFFSET, SHARED_FIELDS_SIZE);
+    record[GEN1_PARTY_LEVEL_OFFSET] = record[GEN1_BOX_LEVEL_OFFSET];
+
+    // a Gen 2 box record doesn't have the current HP. The pokémon arrives fully healed
+    maxHP = calculateGen1MaxHP(stats.base_hp, sourceRecord + GEN2_DVS_OFFSET, (sourceRecord[GEN2_HP_STAT_EXP_OFFSET] << 8) | sourceRecord[GEN2_HP_STAT_EXP_OFFSET + 1], record[GEN1_BOX_LEVEL_OFFSET]);
+    record[GEN1_CURRENT_HP_OFFSET] = static_cast<uint8_t>(maxHP >> 8);
+    record[GEN1_CURRENT_HP_OFFSET + 1] = static_cast<uint8_t>(maxHP & 0xFF);
+    record[GEN1_MAX_HP_OFFSET] = record[GEN1_CURRENT_HP_OFFSET];
+    record[GEN1_MAX_HP_OFFSET + 1] = record[GEN1_CURRENT_HP_OFFSET + 1];
+    return true;
+}
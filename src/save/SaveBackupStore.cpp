@@ -0,0 +1,405 @@
+#include "save/SaveBackupStore.h"
+#include "core/Hash.h"
+
+#include <libdragon.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+//missing function declaration in libdragons' system.h, but the definition exists in system.c
+int mkdir( const char * path, mode_t mode );
+
+static const char SNAPSHOT_MANIFEST_MAGIC[4] = {'P', 'M', 'S', 'S'};
+static const uint8_t SNAPSHOT_MANIFEST_VERSION = 1;
+
+SaveBackupStore::SaveBackupStore(const char* storeDirectory)
+    : storeDirectory_(storeDirectory)
+{
+}
+
+SaveBackupStore::~SaveBackupStore()
+{
+}
+
+bool SaveBackupStore::prepare()
+{
+    struct stat statStruct;
+
+    mkdir(storeDirectory_, 0777);
+    return (stat(storeDirectory_, &statStruct) == 0);
+}
+
+bool SaveBackupStore::storeBlock(const uint8_t* data, uint16_t size, uint64_t& outHash, bool& outWritten)
+{
+    char blockPath[256];
+    struct stat statStruct;
+    FILE* f;
+
+    outHash = fnv1a64(data, size);
+    outWritten = false;
+
+    buildBlockPath(blockPath, sizeof(blockPath), outHash, false);
+    if(stat(blockPath, &statStruct) == 0 && statStruct.st_size == size)
+    {
+        // a block with the same hash and size is most likely the same block. But a hash collision would make us restore the wrong data,
+        // so we only reuse it when the bytes match as well
+        if(!isStoredBlockEqual(blockPath, data, size))
+        {
+            debugf("[SaveBackupStore]: ERROR: %s has the same hash as the new block, but different contents\r\n", blockPath);
+            return false;
+        }
+        // we already have this block. No need to write it again
+        return true;
+    }
+
+    // the block doesn't exist yet. Make sure the subdirectory exists before writing it
+    buildBlockPath(blockPath, sizeof(blockPath), outHash, true);
+    f = fopen(blockPath, "w");
+    if(!f)
+    {
+        debugf("[SaveBackupStore]: ERROR: could not open %s for writing\r\n", blockPath);
+        return false;
+    }
+
+    const size_t ret = fwrite(data, sizeof(char), size, f);
+    fclose(f);
+
+    if(ret != size)
+    {
+        debugf("[SaveBackupStore]: ERROR: could only write %u of %hu bytes to %s\r\n", static_cast<unsigned>(ret), size, blockPath);
+        // don't leave a truncated block around. It would be picked up by a later backup as if it were valid.
+        remove(blockPath);
+        return false;
+    }
+    outWritten = true;
+    return true;
+}
+
+bool SaveBackupStore::loadBlock(uint64_t hash, uint8_t* outData, uint16_t size)
+{
+    char blockPath[256];
+    FILE* f;
+
+    buildBlockPath(blockPath, sizeof(blockPath), hash, false);
+    f = fopen(blockPath, "r");
+    if(!f)
+    {
+        debugf("[SaveBackupStore]: ERROR: missing block %s\r\n", blockPath);
+        return false;
+    }
+
+    const size_t ret = fread(outData, sizeof(char), size, f);
+    fclose(f);
+
+    if(ret != size || fnv1a64(outData, size) != hash)
+    {
+        debugf("[SaveBackupStore]: ERROR: block %s is corrupt\r\n", blockPath);
+        return false;
+    }
+    return true;
+}
+
+bool SaveBackupStore::isStoredBlockEqual(const char* blockPath, const uint8_t* data, uint16_t size)
+{
+    uint8_t buffer[128];
+    uint16_t currentRead;
+    bool equal = true;
+    FILE* f;
+
+    f = fopen(blockPath, "r");
+    if(!f)
+    {
+        return false;
+    }
+
+    while(size > 0 && equal)
+    {
+        currentRead = std::min<uint16_t>(size, sizeof(buffer));
+        equal = (fread(buffer, sizeof(char), currentRead, f) == currentRead && !memcmp(buffer, data, currentRead));
+        data += currentRead;
+        size -= currentRead;
+    }
+    fclose(f);
+    return equal;
+}
+
+void SaveBackupStore::buildBlockPath(char* outPath, size_t bufferSize, uint64_t hash, bool createSubDirectory)
+{
+    // We spread the blocks over 256 subdirectories based on the first byte of the hash.
+    // FAT directory lookups are linear, so we don't want thousands of files in a single directory.
+    const uint8_t subDirectoryIndex = static_cast<uint8_t>(hash >> 56);
+
+    snprintf(outPath, bufferSize, "%s/%02hhx", storeDirectory_, subDirectoryIndex);
+    if(createSubDirectory)
+    {
+        mkdir(outPath, 0777);
+    }
+    snprintf(outPath, bufferSize, "%s/%02hhx/%08lx%08lx.blk", storeDirectory_, subDirectoryIndex, static_cast<unsigned long>(hash >> 32), static_cast<unsigned long>(hash & 0xFFFFFFFFu));
+}
+
+SaveSnapshotCopyDestination::SaveSnapshotCopyDestination(SaveBackupStore& store, const char* manifestPath)
+    : store_(store)
+    , manifestPath_(strdup(manifestPath))
+    , blockHashes_()
+    , blockBuffer_()
+    , bytesWritten_(0)
+    , blockBufferUsed_(0)
+    , numBlocks_(0)
+    , numNewBlocks_(0)
+    , failed_(false)
+    , closed_(false)
+{
+    failed_ = !store_.prepare();
+}
+
+SaveSnapshotCopyDestination::~SaveSnapshotCopyDestination()
+{
+    close();
+    free(manifestPath_);
+    manifestPath_ = nullptr;
+}
+
+bool SaveSnapshotCopyDestination::readyForTransfer() const
+{
+    return (!failed_ && manifestPath_);
+}
+
+uint16_t SaveSnapshotCopyDestination::getCurrentBankIndex() const
+{
+    return 1;
+}
+
+uint32_t SaveSnapshotCopyDestination::getNumberOfBytesWritten() const
+{
+    return bytesWritten_;
+}
+
+uint32_t SaveSnapshotCopyDestination::write(uint8_t* buffer, uint32_t bytesToWrite)
+{
+    uint32_t bytesRemaining = bytesToWrite;
+    uint16_t currentWrite;
+
+    if(failed_)
+    {
+        return 0;
+    }
+
+    while(bytesRemaining > 0)
+    {
+        currentWrite = static_cast<uint16_t>(std::min<uint32_t>(bytesRemaining, SAVE_BACKUP_STORE_BLOCK_SIZE - blockBufferUsed_));
+        memcpy(blockBuffer_ + blockBufferUsed_, buffer, currentWrite);
+
+        blockBufferUsed_ += currentWrite;
+        buffer += currentWrite;
+        bytesRemaining -= currentWrite;
+
+        if(blockBufferUsed_ == SAVE_BACKUP_STORE_BLOCK_SIZE && !flushBlock())
+        {
+            break;
+        }
+    }
+
+    const uint32_t ret = bytesToWrite - bytesRemaining;
+    bytesWritten_ += ret;
+    return ret;
+}
+
+void SaveSnapshotCopyDestination::close()
+{
+    SaveSnapshotManifestHeader header;
+    FILE* f;
+
+    if(closed_)
+    {
+        return;
+    }
+    closed_ = true;
+
+    // a partial block at the end is stored as a full block padded with zeroes.
+    // the manifest stores the real total size, so it gets cut off again on restore
+    if(blockBufferUsed_)
+    {
+        memset(blockBuffer_ + blockBufferUsed_, 0, SAVE_BACKUP_STORE_BLOCK_SIZE - blockBufferUsed_);
+        flushBlock();
+    }
+
+    if(failed_ || !numBlocks_)
+    {
+        // don't write a manifest that refers to blocks that were never stored
+        return;
+    }
+
+    memcpy(header.magic, SNAPSHOT_MANIFEST_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_MANIFEST_VERSION;
+    header.reserved = 0;
+    header.blockSize = SAVE_BACKUP_STORE_BLOCK_SIZE;
+    header.totalSize = bytesWritten_;
+    header.numBlocks = numBlocks_;
+
+    f = fopen(manifestPath_, "w");
+    if(!f)
+    {
+        debugf("[SaveSnapshotCopyDestination]: ERROR: could not write manifest %s\r\n", manifestPath_);
+        failed_ = true;
+        return;
+    }
+
+    if(fwrite(&header, sizeof(header), 1, f) != 1 || fwrite(blockHashes_, sizeof(uint64_t), numBlocks_, f) != numBlocks_)
+    {
+        failed_ = true;
+    }
+    if(fclose(f) != 0)
+    {
+        failed_ = true;
+    }
+
+    if(failed_)
+    {
+        debugf("[SaveSnapshotCopyDestination]: ERROR: could not write manifest %s\r\n", manifestPath_);
+        // a partial manifest can't be restored. Don't leave it around
+        remove(manifestPath_);
+    }
+}
+
+uint32_t SaveSnapshotCopyDestination::getNumberOfBlocks() const
+{
+    return numBlocks_;
+}
+
+uint32_t SaveSnapshotCopyDestination::getNumberOfNewBlocks() const
+{
+    return numNewBlocks_;
+}
+
+bool SaveSnapshotCopyDestination::hasFailed() const
+{
+    return failed_;
+}
+
+bool SaveSnapshotCopyDestination::flushBlock()
+{
+    bool written;
+
+    if(numBlocks_ >= SAVE_BACKUP_STORE_MAX_BLOCKS)
+    {
+        debugf("[SaveSnapshotCopyDestination]: ERROR: the save is too big for a snapshot\r\n");
+        failed_ = true;
+        return false;
+    }
+
+    if(!store_.storeBlock(blockBuffer_, SAVE_BACKUP_STORE_BLOCK_SIZE, blockHashes_[numBlocks_], written))
+    {
+        failed_ = true;
+        return false;
+    }
+
+    ++numBlocks_;
+    if(written)
+    {
+        ++numNewBlocks_;
+    }
+    blockBufferUsed_ = 0;
+    return true;
+}
+
+SaveSnapshotCopySource::SaveSnapshotCopySource(SaveBackupStore& store, const char* manifestPath)
+    : store_(store)
+    , header_()
+    , blockHashes_()
+    , blockBuffer_()
+    , bytesRead_(0)
+    , loadedBlockIndex_(-1)
+    , valid_(false)
+{
+    FILE* f = fopen(manifestPath, "r");
+    if(!f)
+    {
+        return;
+    }
+
+    if(fread(&header_, sizeof(header_), 1, f) == 1 &&
+        !memcmp(header_.magic, SNAPSHOT_MANIFEST_MAGIC, sizeof(header_.magic)) &&
+        header_.version == SNAPSHOT_MANIFEST_VERSION &&
+        header_.blockSize == SAVE_BACKUP_STORE_BLOCK_SIZE &&
+        header_.numBlocks <= SAVE_BACKUP_STORE_MAX_BLOCKS &&
+        header_.totalSize <= header_.numBlocks * SAVE_BACKUP_STORE_BLOCK_SIZE)
+    {
+        valid_ = (fread(blockHashes_, sizeof(uint64_t), header_.numBlocks, f) == header_.numBlocks);
+    }
+    fclose(f);
+
+    // read() only gets called while the cartridge is being written. So make sure every block is there and intact up front:
+    // we don't want to restore a partially corrupted save
+    for(uint16_t i = 0; valid_ && i < header_.numBlocks; ++i)
+    {
+        valid_ = store_.loadBlock(blockHashes_[i], blockBuffer_, SAVE_BACKUP_STORE_BLOCK_SIZE);
+        loadedBlockIndex_ = (valid_) ? static_cast<int32_t>(i) : -1;
+    }
+}
+
+SaveSnapshotCopySource::~SaveSnapshotCopySource()
+{
+}
+
+bool SaveSnapshotCopySource::readyForTransfer() const
+{
+    return valid_;
+}
+
+uint16_t SaveSnapshotCopySource::getCurrentBankIndex() const
+{
+    return 1;
+}
+
+uint32_t SaveSnapshotCopySource::getNumberOfBytesRead() const
+{
+    return bytesRead_;
+}
+
+uint32_t SaveSnapshotCopySource::read(uint8_t* buffer, uint32_t bytesToRead)
+{
+    uint32_t bytesRemaining;
+    uint32_t blockIndex;
+    uint16_t blockOffset;
+    uint16_t currentRead;
+
+    if(!valid_)
+    {
+        return 0;
+    }
+
+    bytesRemaining = std::min<uint32_t>(bytesToRead, header_.totalSize - bytesRead_);
+    const uint32_t bytesToReturn = bytesRemaining;
+
+    while(bytesRemaining > 0)
+    {
+        blockIndex = bytesRead_ / SAVE_BACKUP_STORE_BLOCK_SIZE;
+        blockOffset = static_cast<uint16_t>(bytesRead_ % SAVE_BACKUP_STORE_BLOCK_SIZE);
+
+        if(loadedBlockIndex_ != static_cast<int32_t>(blockIndex))
+        {
+            if(!store_.loadBlock(blockHashes_[blockIndex], blockBuffer_, SAVE_BACKUP_STORE_BLOCK_SIZE))
+            {
+                // the block was verified by the constructor, so the SD card must have failed in the meantime
+                valid_ = false;
+                return 0;
+            }
+            loadedBlockIndex_ = static_cast<int32_t>(blockIndex);
+        }
+
+        currentRead = static_cast<uint16_t>(std::min<uint32_t>(bytesRemaining, SAVE_BACKUP_STORE_BLOCK_SIZE - blockOffset));
+        memcpy(buffer, blockBuffer_ + blockOffset, currentRead);
+
+        buffer += currentRead;
+        bytesRemaining -= currentRead;
+        bytesRead_ += currentRead;
+    }
+    return bytesToReturn;
+}
+
+uint32_t SaveSnapshotCopySource::getTotalSize() const
+{
+    return header_.totalSize;
+}
@@ -0,0 +1,153 @@
+#include "save/SaveChecksum.h"
+#include "transferpak/TransferPakManager.h"
+#include "gen1/Gen1Common.h"
+#include "gen2/Gen2Common.h"
+
+static const SaveChecksumRegion gen1MainChecksumRegion = { .startOffset = 0x2598, .endOffset = 0x3522, .checksumOffset = 0x3523 };
+static const SaveChecksumRegion gen1JapaneseMainChecksumRegion = { .startOffset = 0x2598, .endOffset = 0x3593, .checksumOffset = 0x3594 };
+
+static const SaveChecksumRegion gen2GoldSilverMainChecksumRegion = { .startOffset = 0x2009, .endOffset = 0x2D68, .checksumOffset = 0x2D69 };
+static const SaveChecksumRegion gen2CrystalMainChecksumRegion = { .startOffset = 0x2009, .endOffset = 0x2B82, .checksumOffset = 0x2D0D };
+
+bool getMainChecksumRegion(uint8_t generation, uint8_t specificGenVersion, uint8_t localization, SaveChecksumRegion& outRegion)
+{
+    if(generation == 1)
+    {
+        outRegion = (static_cast<Gen1LocalizationLanguage>(localization) == Gen1LocalizationLanguage::JAPANESE) ? gen1JapaneseMainChecksumRegion : gen1MainChecksumRegion;
+        return true;
+    }
+    else if(generation == 2)
+    {
+        // we only know the layout of the international versions
+        if(static_cast<Gen2LocalizationLanguage>(localization) == Gen2LocalizationLanguage::JAPANESE || static_cast<Gen2LocalizationLanguage>(localization) == Gen2LocalizationLanguage::KOREAN)
+        {
+            return false;
+        }
+        outRegion = (static_cast<Gen2GameType>(specificGenVersion) == Gen2GameType::CRYSTAL) ? gen2CrystalMainChecksumRegion : gen2GoldSilverMainChecksumRegion;
+        return true;
+    }
+    return false;
+}
+
+SaveChecksumValidator::SaveChecksumValidator(TransferPakManager& pakManager)
+    : saveManager_(pakManager)
+    , region_({0})
+    , currentOffset_(0)
+    , byteSum_(0)
+    , generation_(0)
+    , started_(false)
+    , finished_(false)
+    , valid_(false)
+{
+}
+
+bool SaveChecksumValidator::start(uint8_t generation, uint8_t specificGenVersion, uint8_t localization)
+{
+    reset();
+    if(!getMainChecksumRegion(generation, specificGenVersion, localization, region_))
+    {
+        return false;
+    }
+    generation_ = generation;
+    currentOffset_ = region_.startOffset;
+    started_ = true;
+    return true;
+}
+
+bool SaveChecksumValidator::step(uint32_t maxBytes)
+{
+    uint8_t buffer[TPAK_BLOCK_SIZE];
+    uint8_t storedChecksum[2];
+    uint32_t bytesToRead;
+    uint32_t bytesRemaining;
+
+    if(!started_ || finished_)
+    {
+        return finished_;
+    }
+
+    saveManager_.seek(currentOffset_);
+    while(maxBytes > 0 && currentOffset_ <= region_.endOffset)
+    {
+        // read up to the next block boundary, so that we never read the same block twice
+        bytesToRead = TPAK_BLOCK_SIZE - (currentOffset_ % TPAK_BLOCK_SIZE);
+        bytesRemaining = region_.endOffset - currentOffset_ + 1;
+        if(bytesToRead > bytesRemaining)
+        {
+            bytesToRead = bytesRemaining;
+        }
+        if(bytesToRead > maxBytes)
+        {
+            bytesToRead = maxBytes;
+        }
+
+        saveManager_.read(buffer, bytesToRead);
+        for(uint32_t i = 0; i < bytesToRead; ++i)
+        {
+            byteSum_ += buffer[i];
+        }
+        currentOffset_ += bytesToRead;
+        maxBytes -= bytesToRead;
+    }
+
+    if(currentOffset_ <= region_.endOffset)
+    {
+        return false;
+    }
+
+    saveManager_.seek(region_.checksumOffset);
+    if(generation_ == 1)
+    {
+        saveManager_.read(storedChecksum, 1);
+        valid_ = (storedChecksum[0] == static_cast<uint8_t>(~byteSum_));
+    }
+    else
+    {
+        saveManager_.read(storedChecksum, 2);
+        valid_ = ((storedChecksum[0] | (storedChecksum[1] << 8)) == static_cast<uint16_t>(byteSum_));
+    }
+    debugf("[SaveChecksumValidator]: main checksum %s\r\n", (valid_) ? "valid" : "INVALID");
+    finished_ = true;
+    return true;
+}
+
+bool SaveChecksumValidator::isStarted() const
+{
+    return started_;
+}
+
+bool SaveChecksumValidator::isFinished() const
+{
+    return finished_;
+}
+
+bool SaveChecksumValidator::isValid() const
+{
+    return valid_;
+}
+
+uint8_t SaveChecksumValidator::getProgress() const
+{
+    const uint32_t regionSize = region_.endOffset - region_.startOffset + 1;
+
+    if(finished_)
+    {
+        return 100;
+    }
+    if(!started_)
+    {
+        return 0;
+    }
+    return static_cast<uint8_t>(((currentOffset_ - region_.startOffset) * 100) / regionSize);
+}
+
+void SaveChecksumValidator::reset()
+{
+    region_ = SaveChecksumRegion{0};
+    currentOffset_ = 0;
+    byteSum_ = 0;
+    generation_ = 0;
+    started_ = false;
+    finished_ = false;
+    valid_ = false;
+}
@@ -0,0 +1,693 @@
+#include "save/SaveEditTransaction.h"
+#include "save/SaveChecksum.h"
+
+#include <cstring>
+
+/**
+ * @brief A part of the Gen 2 main data and the location of its copy in the backup save data
+ */
+typedef struct Gen2BackupChunk
+{
+    uint32_t mainStartOffset;
+    // inclusive
+    uint32_t mainEndOffset;
+    uint32_t backupStartOffset;
+} Gen2BackupChunk;
+
+// In Gold/Silver, the backup copy is scattered over several locations of the save
+static const Gen2BackupChunk gen2GoldSilverBackupChunks[] = {
+    { .mainStartOffset = 0x2009, .mainEndOffset = 0x222E, .backupStartOffset = 0x15C7 },
+    { .mainStartOffset = 0x222F, .mainEndOffset = 0x23D8, .backupStartOffset = 0x3D96 },
+    { .mainStartOffset = 0x23D9, .mainEndOffset = 0x2855, .backupStartOffset = 0x0C6B },
+    { .mainStartOffset = 0x2856, .mainEndOffset = 0x2889, .backupStartOffset = 0x7E39 },
+    { .mainStartOffset = 0x288A, .mainEndOffset = 0x2D68, .backupStartOffset = 0x10E8 }
+};
+static const uint32_t GEN2_GOLDSILVER_BACKUP_CHECKSUM_OFFSET = 0x7E6D;
+
+static const Gen2BackupChunk gen2CrystalBackupChunks[] = {
+    { .mainStartOffset = 0x2009, .mainEndOffset = 0x2B82, .backupStartOffset = 0x1209 }
+};
+static const uint32_t GEN2_CRYSTAL_BACKUP_CHECKSUM_OFFSET = 0x1F0D;
+
+// Gen 1 stores a checksum over all boxes of bank 2 and 3 right after the last box of the bank, followed by a checksum per box
+static const uint8_t GEN1_BOX_CHECKSUMS_PER_BANK = 6;
+
+// the maximum number of separate changed ranges we can mirror into the Gen 2 backup save data
+static const uint16_t GEN2_MAX_MIRRORED_RANGES = 64;
+
+/**
+ * @brief Everything that belongs to a single box slot. Within a box, these are stored in 4 separate arrays
+ */
+typedef struct BoxSlot
+{
+    uint8_t species;
+    uint8_t record[33];
+    uint8_t originalTrainerName[POKEMON_BOX_NAME_SIZE];
+    uint8_t nickname[POKEMON_BOX_NAME_SIZE];
+} BoxSlot;
+
+static void readBoxSlot(TransferPakOverlaySaveManager& overlay, const PokemonBoxLayout& layout, uint32_t boxOffset, uint8_t slotIndex, BoxSlot& outSlot)
+{
+    const uint32_t recordsOffset = boxOffset + POKEMON_BOX_RECORDS_OFFSET;
+    const uint32_t originalTrainerNamesOffset = recordsOffset + POKEMON_BOX_INDEX_SLOTS_PER_BOX * layout.recordSize;
+    const uint32_t nicknamesOffset = originalTrainerNamesOffset + POKEMON_BOX_INDEX_SLOTS_PER_BOX * POKEMON_BOX_NAME_SIZE;
+
+    overlay.seek(boxOffset + 1 + slotIndex);
+    overlay.readByte(outSlot.species);
+    overlay.seek(recordsOffset + slotIndex * layout.recordSize);
+    overlay.read(outSlot.record, layout.recordSize);
+    overlay.seek(originalTrainerNamesOffset + slotIndex * POKEMON_BOX_NAME_SIZE);
+    overlay.read(outSlot.originalTrainerName, POKEMON_BOX_NAME_SIZE);
+    overlay.seek(nicknamesOffset + slotIndex * POKEMON_BOX_NAME_SIZE);
+    overlay.read(outSlot.nickname, POKEMON_BOX_NAME_SIZE);
+}
+
+static void writeBoxSlot(TransferPakOverlaySaveManager& overlay, const PokemonBoxLayout& layout, uint32_t boxOffset, uint8_t slotIndex, const BoxSlot& slot)
+{
+    const uint32_t recordsOffset = boxOffset + POKEMON_BOX_RECORDS_OFFSET;
+    const uint32_t originalTrainerNamesOffset = recordsOffset + POKEMON_BOX_INDEX_SLOTS_PER_BOX * layout.recordSize;
+    const uint32_t nicknamesOffset = originalTrainerNamesOffset + POKEMON_BOX_INDEX_SLOTS_PER_BOX * POKEMON_BOX_NAME_SIZE;
+
+    overlay.seek(boxOffset + 1 + slotIndex);
+    overlay.writeByte(slot.species);
+    overlay.seek(recordsOffset + slotIndex * layout.recordSize);
+    overlay.write(slot.record, layout.recordSize);
+    overlay.seek(originalTrainerNamesOffset + slotIndex * POKEMON_BOX_NAME_SIZE);
+    overlay.write(slot.originalTrainerName, POKEMON_BOX_NAME_SIZE);
+    overlay.seek(nicknamesOffset + slotIndex * POKEMON_BOX_NAME_SIZE);
+    overlay.write(slot.nickname, POKEMON_BOX_NAME_SIZE);
+}
+
+/**
+ * @brief Applies the given byte sum delta to the Gen 1 (inverted 8 bit) checksum at the given offset.
+ */
+static void updateGen1Checksum(TransferPakOverlaySaveManager& overlay, uint32_t checksumOffset, int32_t delta)
+{
+    uint8_t checksum;
+
+    // the Gen 1 checksum is the inverted 8 bit sum of the bytes in the region.
+    // So when the sum goes up by delta, the checksum goes down by delta.
+    overlay.readOriginal(checksumOffset, &checksum, 1);
+    checksum = static_cast<uint8_t>(checksum - delta);
+
+    overlay.seek(checksumOffset);
+    overlay.writeByte(checksum);
+}
+
+/**
+ * @brief Applies the given byte sum delta to the Gen 2 (16 bit, little endian) checksum at the given offset.
+ */
+static void updateGen2Checksum(TransferPakOverlaySaveManager& overlay, uint32_t checksumOffset, int32_t delta)
+{
+    uint8_t checksumBytes[2];
+    uint16_t checksum;
+
+    // we start from the checksum that was on the cartridge, because the delta is relative to the original contents
+    overlay.readOriginal(checksumOffset, checksumBytes, sizeof(checksumBytes));
+    checksum = static_cast<uint16_t>(checksumBytes[0] | (checksumBytes[1] << 8));
+    checksum = static_cast<uint16_t>(checksum + delta);
+    checksumBytes[0] = static_cast<uint8_t>(checksum & 0xFF);
+    checksumBytes[1] = static_cast<uint8_t>(checksum >> 8);
+
+    overlay.seek(checksumOffset);
+    overlay.write(checksumBytes, sizeof(checksumBytes));
+}
+
+SaveEditTransaction::SaveEditTransaction(TransferPakManager& pakManager, uint8_t generation, uint8_t specificGenVersion, uint8_t localization)
+    : romReader_(pakManager)
+    , overlay_(pakManager)
+    , gen1Reader_(nullptr)
+    , gen2Reader_(nullptr)
+    , edits_(new SaveEdit[SAVE_EDIT_TRANSACTION_MAX_EDITS])
+    , numEdits_(0)
+    , numAppliedEdits_(0)
+    , numFailedEdits_(0)
+    , boxLayout_({0})
+    , specificGenVersion_(specificGenVersion)
+    , localization_(localization)
+    , hasBoxLayout_(getPokemonBoxLayout(generation, specificGenVersion, localization, boxLayout_))
+{
+    if(generation == 1)
+    {
+        gen1Reader_ = new Gen1GameReader(romReader_, overlay_, static_cast<Gen1GameType>(specificGenVersion), static_cast<Gen1LocalizationLanguage>(localization));
+    }
+    else if(generation == 2)
+    {
+        gen2Reader_ = new Gen2GameReader(romReader_, overlay_, static_cast<Gen2GameType>(specificGenVersion), static_cast<Gen2LocalizationLanguage>(localization));
+    }
+}
+
+SaveEditTransaction::~SaveEditTransaction()
+{
+    delete gen1Reader_;
+    gen1Reader_ = nullptr;
+    delete gen2Reader_;
+    gen2Reader_ = nullptr;
+    delete[] edits_;
+    edits_ = nullptr;
+}
+
+Gen1GameReader* SaveEditTransaction::getGen1Reader()
+{
+    return gen1Reader_;
+}
+
+Gen2GameReader* SaveEditTransaction::getGen2Reader()
+{
+    return gen2Reader_;
+}
+
+bool SaveEditTransaction::setGen1PartyPokemon(uint8_t partyIndex, const Gen1TrainerPokemon& poke)
+{
+    SaveEdit edit = {
+        .type = SaveEditType::GEN1_SET_PARTY_POKEMON
+    };
+
+    if(!gen1Reader_)
+    {
+        return false;
+    }
+    edit.gen1PartyPokemon.partyIndex = partyIndex;
+    edit.gen1PartyPokemon.poke = poke;
+    return queueEdit(edit);
+}
+
+bool SaveEditTransaction::addGen1Pokemon(const Gen1TrainerPokemon& poke, const char* originalTrainerName)
+{
+    SaveEdit edit = {
+        .type = SaveEditType::GEN1_ADD_POKEMON
+    };
+
+    if(!gen1Reader_)
+    {
+        return false;
+    }
+    edit.gen1Pokemon.poke = poke;
+    strncpy(edit.gen1Pokemon.originalTrainerName, originalTrainerName, sizeof(edit.gen1Pokemon.originalTrainerName) - 1);
+    return queueEdit(edit);
+}
+
+bool SaveEditTransaction::addGen2Pokemon(const Gen2TrainerPokemon& poke, bool isEgg, const char* originalTrainerName)
+{
+    SaveEdit edit = {
+        .type = SaveEditType::GEN2_ADD_POKEMON
+    };
+
+    if(!gen2Reader_)
+    {
+        return false;
+    }
+    edit.gen2Pokemon.poke = poke;
+    edit.gen2Pokemon.isEgg = isEgg;
+    strncpy(edit.gen2Pokemon.originalTrainerName, originalTrainerName, sizeof(edit.gen2Pokemon.originalTrainerName) - 1);
+    return queueEdit(edit);
+}
+
+bool SaveEditTransaction::setGen2EventFlag(uint16_t flagIndex, bool value)
+{
+    SaveEdit edit = {
+        .type = SaveEditType::GEN2_SET_EVENT_FLAG
+    };
+
+    if(!gen2Reader_)
+    {
+        return false;
+    }
+    edit.eventFlag.index = flagIndex;
+    edit.eventFlag.value = value;
+    return queueEdit(edit);
+}
+
+bool SaveEditTransaction::unlockGen2GSBallEvent()
+{
+    const SaveEdit edit = {
+        .type = SaveEditType::GEN2_UNLOCK_GS_BALL_EVENT
+    };
+
+    if(!gen2Reader_)
+    {
+        return false;
+    }
+    return queueEdit(edit);
+}
+
+bool SaveEditTransaction::importBoxPokemon(uint8_t boxIndex, const uint8_t* pokemonFile)
+{
+    SaveEdit edit = {
+        .type = SaveEditType::IMPORT_BOX_POKEMON
+    };
+
+    if(!hasBoxLayout_ || boxIndex >= boxLayout_.numBoxes)
+    {
+        return false;
+    }
+    edit.importedPokemon.boxIndex = boxIndex;
+    memcpy(edit.importedPokemon.file, pokemonFile, (gen1Reader_) ? POKEMON_EXPORTER_PK1_SIZE : POKEMON_EXPORTER_PK2_SIZE);
+    return queueEdit(edit);
+}
+
+bool SaveEditTransaction::sortBox(uint8_t boxIndex, const uint8_t* sourceSlots, uint8_t numPokemon)
+{
+    SaveEdit edit = {
+        .type = SaveEditType::SORT_BOX
+    };
+
+    if(!hasBoxLayout_ || boxIndex >= boxLayout_.numBoxes || numPokemon > POKEMON_BOX_INDEX_SLOTS_PER_BOX)
+    {
+        return false;
+    }
+    edit.sortedBox.boxIndex = boxIndex;
+    edit.sortedBox.numPokemon = numPokemon;
+    memcpy(edit.sortedBox.sourceSlots, sourceSlots, numPokemon);
+    return queueEdit(edit);
+}
+
+bool SaveEditTransaction::removeBoxPokemon(uint8_t boxIndex, const bool* removedSlots, uint8_t numPokemon)
+{
+    SaveEdit edit = {
+        .type = SaveEditType::REMOVE_BOX_POKEMON
+    };
+
+    if(!hasBoxLayout_ || boxIndex >= boxLayout_.numBoxes || numPokemon > POKEMON_BOX_INDEX_SLOTS_PER_BOX)
+    {
+        return false;
+    }
+    edit.removedBoxPokemon.boxIndex = boxIndex;
+    edit.removedBoxPokemon.numPokemon = numPokemon;
+    memcpy(edit.removedBoxPokemon.removedSlots, removedSlots, numPokemon * sizeof(bool));
+    return queueEdit(edit);
+}
+
+uint8_t SaveEditTransaction::getNumberOfEdits() const
+{
+    return numEdits_;
+}
+
+uint8_t SaveEditTransaction::getNumberOfFailedEdits() const
+{
+    return numFailedEdits_;
+}
+
+int32_t SaveEditTransaction::dryRun(SaveByteRange* outRanges, uint16_t maxRanges, uint16_t& outNumRanges)
+{
+    applyPendingEdits();
+
+    if(overlay_.hasOverflowed())
+    {
+        outNumRanges = 0;
+        return -1;
+    }
+    return static_cast<int32_t>(overlay_.getChangedRanges(outRanges, maxRanges, outNumRanges));
+}
+
+bool SaveEditTransaction::commit(uint16_t& outNumBlocksWritten)
+{
+    bool success;
+
+    applyPendingEdits();
+    success = overlay_.commit(outNumBlocksWritten);
+
+    rollback();
+    return success;
+}
+
+void SaveEditTransaction::rollback()
+{
+    overlay_.reset();
+    numEdits_ = 0;
+    numAppliedEdits_ = 0;
+    numFailedEdits_ = 0;
+}
+
+bool SaveEditTransaction::queueEdit(const SaveEdit& edit)
+{
+    if(numEdits_ >= SAVE_EDIT_TRANSACTION_MAX_EDITS)
+    {
+        debugf("[SaveEditTransaction]: ERROR: too many edits in a single transaction!\r\n");
+        return false;
+    }
+    edits_[numEdits_] = edit;
+    ++numEdits_;
+    return true;
+}
+
+void SaveEditTransaction::applyPendingEdits()
+{
+    if(numAppliedEdits_ == numEdits_)
+    {
+        return;
+    }
+
+    for(uint8_t i = numAppliedEdits_; i < numEdits_; ++i)
+    {
+        const SaveEdit& edit = edits_[i];
+        switch(edit.type)
+        {
+            case SaveEditType::GEN1_SET_PARTY_POKEMON:
+            {
+                Gen1Party party = gen1Reader_->getParty();
+                if(!party.setPokemon(edit.gen1PartyPokemon.partyIndex, edit.gen1PartyPokemon.poke))
+                {
+                    debugf("[SaveEditTransaction]: ERROR: can't update the pokémon at partyIndex %hu\r\n", edit.gen1PartyPokemon.partyIndex);
+                    ++numFailedEdits_;
+                }
+                break;
+            }
+            case SaveEditType::GEN1_ADD_POKEMON:
+                // addPokemon() returns 0xFF when there's no room left in the party and the current box
+                if(gen1Reader_->addPokemon(const_cast<Gen1TrainerPokemon&>(edit.gen1Pokemon.poke), edit.gen1Pokemon.originalTrainerName) == 0xFF)
+                {
+                    ++numFailedEdits_;
+                }
+                break;
+            case SaveEditType::GEN2_ADD_POKEMON:
+                if(gen2Reader_->addPokemon(const_cast<Gen2TrainerPokemon&>(edit.gen2Pokemon.poke), edit.gen2Pokemon.isEgg, edit.gen2Pokemon.originalTrainerName) == 0xFF)
+                {
+                    ++numFailedEdits_;
+                }
+                break;
+            case SaveEditType::GEN2_SET_EVENT_FLAG:
+                gen2Reader_->setEventFlag(edit.eventFlag.index, edit.eventFlag.value);
+                break;
+            case SaveEditType::GEN2_UNLOCK_GS_BALL_EVENT:
+                gen2Reader_->unlockGsBallEvent();
+                break;
+            case SaveEditType::IMPORT_BOX_POKEMON:
+                if(!applyImportedPokemon(edit))
+                {
+                    ++numFailedEdits_;
+                }
+                break;
+            case SaveEditType::SORT_BOX:
+                if(!applySortedBox(edit))
+                {
+                    ++numFailedEdits_;
+                }
+                break;
+            case SaveEditType::REMOVE_BOX_POKEMON:
+                if(!applyRemovedBoxPokemon(edit))
+                {
+                    ++numFailedEdits_;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    numAppliedEdits_ = numEdits_;
+
+    // this is the whole point: the checksum only gets updated once for all the edits
+    if(updateChecksumsIncrementally())
+    {
+        return;
+    }
+
+    if(gen1Reader_)
+    {
+        gen1Reader_->updateMainChecksum();
+    }
+    else if(gen2Reader_)
+    {
+        gen2Reader_->finishSave();
+    }
+}
+
+bool SaveEditTransaction::updateChecksumsIncrementally()
+{
+    SaveChecksumRegion region;
+
+    if(overlay_.hasOverflowed() || !getMainChecksumRegion((gen1Reader_) ? 1 : 2, specificGenVersion_, localization_, region))
+    {
+        return false;
+    }
+
+    if(gen1Reader_)
+    {
+        if(hasBoxLayout_)
+        {
+            updateGen1BoxChecksums();
+        }
+        updateGen1Checksum(overlay_, region.checksumOffset, overlay_.getByteSumDelta(region.startOffset, region.endOffset));
+        return true;
+    }
+    else if(gen2Reader_)
+    {
+        // Finishing a Gen 2 save also involves updating the backup copy
+        if(!mirrorGen2MainDataToBackup())
+        {
+            return false;
+        }
+        updateGen2Checksum(overlay_, region.checksumOffset, overlay_.getByteSumDelta(region.startOffset, region.endOffset));
+        return true;
+    }
+    return false;
+}
+
+bool SaveEditTransaction::mirrorGen2MainDataToBackup()
+{
+    SaveByteRange ranges[GEN2_MAX_MIRRORED_RANGES];
+    uint8_t buffer[TPAK_BLOCK_SIZE];
+    const Gen2BackupChunk* chunks;
+    uint8_t numChunks;
+    uint32_t backupChecksumOffset;
+    uint32_t rangeStart;
+    uint32_t rangeEnd;
+    uint32_t start;
+    uint32_t end;
+    uint32_t size;
+    uint16_t numRanges;
+    int32_t backupDelta = 0;
+
+    if(static_cast<Gen2GameType>(specificGenVersion_) == Gen2GameType::CRYSTAL)
+    {
+        chunks = gen2CrystalBackupChunks;
+        numChunks = sizeof(gen2CrystalBackupChunks) / sizeof(gen2CrystalBackupChunks[0]);
+        backupChecksumOffset = GEN2_CRYSTAL_BACKUP_CHECKSUM_OFFSET;
+    }
+    else
+    {
+        chunks = gen2GoldSilverBackupChunks;
+        numChunks = sizeof(gen2GoldSilverBackupChunks) / sizeof(gen2GoldSilverBackupChunks[0]);
+        backupChecksumOffset = GEN2_GOLDSILVER_BACKUP_CHECKSUM_OFFSET;
+    }
+
+    overlay_.getChangedRanges(ranges, GEN2_MAX_MIRRORED_RANGES, numRanges);
+    if(numRanges > GEN2_MAX_MIRRORED_RANGES)
+    {
+        // too scattered. Let the game reader copy everything instead.
+        return false;
+    }
+
+    for(uint16_t i = 0; i < numRanges; ++i)
+    {
+        rangeStart = ranges[i].offset;
+        rangeEnd = ranges[i].offset + ranges[i].size - 1;
+        for(uint8_t chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+        {
+            const Gen2BackupChunk& chunk = chunks[chunkIndex];
+            if(rangeEnd < chunk.mainStartOffset || rangeStart > chunk.mainEndOffset)
+            {
+                continue;
+            }
+            start = (rangeStart > chunk.mainStartOffset) ? rangeStart : chunk.mainStartOffset;
+            end = (rangeEnd < chunk.mainEndOffset) ? rangeEnd : chunk.mainEndOffset;
+
+            // the changed main data bytes are in the overlay, so this doesn't need the transfer pak for reading
+            while(start <= end)
+            {
+                size = end - start + 1;
+                if(size > sizeof(buffer))
+                {
+                    size = sizeof(buffer);
+                }
+                overlay_.seek(start);
+                overlay_.read(buffer, size);
+                overlay_.seek(chunk.backupStartOffset + (start - chunk.mainStartOffset));
+                overlay_.write(buffer, size);
+                start += size;
+            }
+        }
+    }
+
+    // the backup checksum covers all the chunks
+    for(uint8_t chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+    {
+        const Gen2BackupChunk& chunk = chunks[chunkIndex];
+        backupDelta += overlay_.getByteSumDelta(chunk.backupStartOffset, chunk.backupStartOffset + (chunk.mainEndOffset - chunk.mainStartOffset));
+    }
+    updateGen2Checksum(overlay_, backupChecksumOffset, backupDelta);
+    return !overlay_.hasOverflowed();
+}
+
+bool SaveEditTransaction::applyImportedPokemon(const SaveEdit& edit)
+{
+    const uint8_t* file = edit.importedPokemon.file;
+    const uint8_t terminator = 0xFF;
+    const uint32_t boxOffset = getBoxOffset(edit.importedPokemon.boxIndex);
+    uint8_t numPokemon;
+
+    overlay_.seek(boxOffset);
+    overlay_.readByte(numPokemon);
+    if(numPokemon >= POKEMON_BOX_INDEX_SLOTS_PER_BOX)
+    {
+        debugf("[SaveEditTransaction]: ERROR: box %hu is full\r\n", edit.importedPokemon.boxIndex);
+        return false;
+    }
+
+    // count + species list (the file's species list entry is 0xFD for eggs, just like in the box)
+    overlay_.seek(boxOffset);
+    overlay_.writeByte(numPokemon + 1);
+    overlay_.seek(boxOffset + 1 + numPokemon);
+    overlay_.writeByte(file[1]);
+    overlay_.writeByte(terminator);
+
+    // a box record is the first part of the party record in the file
+    overlay_.seek(boxOffset + POKEMON_BOX_RECORDS_OFFSET + numPokemon * boxLayout_.recordSize);
+    overlay_.write(file + 3, boxLayout_.recordSize);
+
+    // original trainer name and nickname
+    overlay_.seek(boxOffset + POKEMON_BOX_RECORDS_OFFSET + POKEMON_BOX_INDEX_SLOTS_PER_BOX * boxLayout_.recordSize + numPokemon * POKEMON_BOX_NAME_SIZE);
+    overlay_.write(file + 3 + boxLayout_.partyRecordSize, POKEMON_BOX_NAME_SIZE);
+    overlay_.seek(boxOffset + POKEMON_BOX_RECORDS_OFFSET + POKEMON_BOX_INDEX_SLOTS_PER_BOX * (boxLayout_.recordSize + POKEMON_BOX_NAME_SIZE) + numPokemon * POKEMON_BOX_NAME_SIZE);
+    overlay_.write(file + 3 + boxLayout_.partyRecordSize + POKEMON_BOX_NAME_SIZE, POKEMON_BOX_NAME_SIZE);
+    return true;
+}
+
+void SaveEditTransaction::updateGen1BoxChecksums()
+{
+    uint32_t bankStart;
+    uint32_t bankEnd;
+    uint32_t boxStart;
+    int32_t delta;
+
+    for(uint8_t bank = 0; bank < 2; ++bank)
+    {
+        bankStart = boxLayout_.bankOffsets[bank];
+        bankEnd = bankStart + boxLayout_.boxesPerBank * boxLayout_.boxStride - 1;
+
+        // Don't skip the boxes when the whole bank's sum didn't change: edits in different boxes of the same bank can cancel each other out
+        delta = overlay_.getByteSumDelta(bankStart, bankEnd);
+        if(delta)
+        {
+            updateGen1Checksum(overlay_, bankEnd + 1, delta);
+        }
+
+        for(uint8_t i = 0; i < GEN1_BOX_CHECKSUMS_PER_BANK; ++i)
+        {
+            boxStart = bankStart + i * boxLayout_.boxStride;
+            delta = overlay_.getByteSumDelta(boxStart, boxStart + boxLayout_.boxStride - 1);
+            if(delta)
+            {
+                updateGen1Checksum(overlay_, bankEnd + 2 + i, delta);
+            }
+        }
+    }
+}
+
+bool SaveEditTransaction::applySortedBox(const SaveEdit& edit)
+{
+    const uint8_t* sourceSlots = edit.sortedBox.sourceSlots;
+    const uint32_t boxOffset = getBoxOffset(edit.sortedBox.boxIndex);
+    bool done[POKEMON_BOX_INDEX_SLOTS_PER_BOX] = {0};
+    BoxSlot firstSlot;
+    BoxSlot slot;
+    uint8_t numPokemon;
+    uint8_t current;
+    uint8_t next;
+
+    overlay_.seek(boxOffset);
+    overlay_.readByte(numPokemon);
+    if(numPokemon != edit.sortedBox.numPokemon)
+    {
+        // the box changed since the permutation was determined
+        debugf("[SaveEditTransaction]: ERROR: box %hu has %hu pokémon instead of %hu\r\n", edit.sortedBox.boxIndex, numPokemon, edit.sortedBox.numPokemon);
+        return false;
+    }
+    // every slot needs to be used exactly once. Otherwise, the cycles below would never end
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        if(sourceSlots[i] >= numPokemon || done[sourceSlots[i]])
+        {
+            return false;
+        }
+        done[sourceSlots[i]] = true;
+    }
+    memset(done, 0, sizeof(done));
+
+    for(uint8_t start = 0; start < numPokemon; ++start)
+    {
+        if(done[start] || sourceSlots[start] == start)
+        {
+            // already moved as part of an earlier cycle or the pokémon stays where it is
+            continue;
+        }
+
+        // keep the first slot of the cycle aside, then shift every pokémon of the cycle into place
+        readBoxSlot(overlay_, boxLayout_, boxOffset, start, firstSlot);
+        current = start;
+        while(true)
+        {
+            done[current] = true;
+            next = sourceSlots[current];
+            if(next == start)
+            {
+                writeBoxSlot(overlay_, boxLayout_, boxOffset, current, firstSlot);
+                break;
+            }
+            readBoxSlot(overlay_, boxLayout_, boxOffset, next, slot);
+            writeBoxSlot(overlay_, boxLayout_, boxOffset, current, slot);
+            current = next;
+        }
+    }
+    return true;
+}
+
+bool SaveEditTransaction::applyRemovedBoxPokemon(const SaveEdit& edit)
+{
+    const bool* removedSlots = edit.removedBoxPokemon.removedSlots;
+    const uint8_t terminator = 0xFF;
+    const uint32_t boxOffset = getBoxOffset(edit.removedBoxPokemon.boxIndex);
+    BoxSlot slot;
+    uint8_t numPokemon;
+    uint8_t numRemaining = 0;
+
+    overlay_.seek(boxOffset);
+    overlay_.readByte(numPokemon);
+    if(numPokemon != edit.removedBoxPokemon.numPokemon)
+    {
+        // the box changed since the pokémon to remove were determined
+        debugf("[SaveEditTransaction]: ERROR: box %hu has %hu pokémon instead of %hu\r\n", edit.removedBoxPokemon.boxIndex, numPokemon, edit.removedBoxPokemon.numPokemon);
+        return false;
+    }
+
+    for(uint8_t i = 0; i < numPokemon; ++i)
+    {
+        if(removedSlots[i])
+        {
+            continue;
+        }
+        // slots before the first removed one stay where they are
+        if(numRemaining != i)
+        {
+            readBoxSlot(overlay_, boxLayout_, boxOffset, i, slot);
+            writeBoxSlot(overlay_, boxLayout_, boxOffset, numRemaining, slot);
+        }
+        ++numRemaining;
+    }
+
+    // just like the game, we leave the contents of the slots after the terminator alone
+    overlay_.seek(boxOffset);
+    overlay_.writeByte(numRemaining);
+    overlay_.seek(boxOffset + 1 + numRemaining);
+    overlay_.writeByte(terminator);
+    return true;
+}
+
+uint32_t SaveEditTransaction::getBoxOffset(uint8_t boxIndex)
+{
+    uint8_t currentBoxByte;
+
+    overlay_.seek(boxLayout_.currentBoxIndexOffset);
+    overlay_.readByte(currentBoxByte);
+    return getPokemonBoxOffset(boxLayout_, boxIndex, currentBoxByte & boxLayout_.currentBoxIndexMask);
+}
@@ -0,0 +1,157 @@
+#include "save/SaveLibrary.h"
+
+#include <libdragon.h>
+#include <sys/stat.h>
+#include <cstring>
+
+static const char SAVE_LIBRARY_MAGIC[4] = {'P', 'M', 'L', 'I'};
+static const uint8_t SAVE_LIBRARY_VERSION = 1;
+
+static void initHeader(SaveLibraryHeader& header)
+{
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SAVE_LIBRARY_MAGIC, sizeof(SAVE_LIBRARY_MAGIC));
+    header.version = SAVE_LIBRARY_VERSION;
+}
+
+SaveLibrary::SaveLibrary(const char* indexPath)
+    : indexPath_(indexPath)
+    , header_()
+{
+    initHeader(header_);
+}
+
+SaveLibrary::~SaveLibrary()
+{
+}
+
+bool SaveLibrary::load()
+{
+    SaveLibraryHeader header;
+    FILE* f;
+
+    initHeader(header_);
+
+    f = fopen(indexPath_, "r");
+    if(!f)
+    {
+        // no backups were made yet
+        return true;
+    }
+
+    if(fread(&header, 1, sizeof(header), f) != sizeof(header) || memcmp(header.magic, SAVE_LIBRARY_MAGIC, sizeof(SAVE_LIBRARY_MAGIC)) || header.version != SAVE_LIBRARY_VERSION)
+    {
+        debugf("[SaveLibrary]: ERROR: %s is not a valid save library index\r\n", indexPath_);
+        fclose(f);
+        return false;
+    }
+
+    fclose(f);
+    header_ = header;
+    return true;
+}
+
+uint16_t SaveLibrary::getNumberOfEntries() const
+{
+    return header_.numEntries;
+}
+
+void SaveLibrary::generateBackupPath(char* outputPath, size_t bufferSize, const char* gameTitle, const char* playerName, const char* extension)
+{
+    struct stat statStruct;
+
+    do
+    {
+        if(playerName[0] != '\0')
+        {
+            snprintf(outputPath, bufferSize - 1, SAVE_LIBRARY_DIRECTORY "/%s_%s_%lu%s", gameTitle, playerName, static_cast<unsigned long>(header_.nextSequenceNumber), extension);
+        }
+        else
+        {
+            snprintf(outputPath, bufferSize - 1, SAVE_LIBRARY_DIRECTORY "/%s_%lu%s", gameTitle, static_cast<unsigned long>(header_.nextSequenceNumber), extension);
+        }
+        // the new sequence number only gets stored in the index file by addEntry().
+        // If the backup fails, the next one can just reuse the same number.
+        ++header_.nextSequenceNumber;
+    } while(stat(outputPath, &statStruct) == 0);
+}
+
+bool SaveLibrary::addEntry(const SaveLibraryEntry& entry)
+{
+    FILE* f = fopen(indexPath_, "r+");
+    bool success;
+
+    if(!f)
+    {
+        f = fopen(indexPath_, "w");
+        if(!f)
+        {
+            debugf("[SaveLibrary]: ERROR: could not create %s\r\n", indexPath_);
+            return false;
+        }
+        header_.numEntries = 0;
+        if(fwrite(&header_, 1, sizeof(header_), f) != sizeof(header_))
+        {
+            fclose(f);
+            return false;
+        }
+    }
+
+    // write the entry before the header. If the entry write fails halfway, the header still has the old number of entries
+    success = !fseek(f, static_cast<long>(sizeof(SaveLibraryHeader) + header_.numEntries * sizeof(SaveLibraryEntry)), SEEK_SET)
+        && fwrite(&entry, 1, sizeof(entry), f) == sizeof(entry);
+
+    if(success)
+    {
+        ++header_.numEntries;
+        success = !fseek(f, 0, SEEK_SET) && fwrite(&header_, 1, sizeof(header_), f) == sizeof(header_);
+    }
+
+    fclose(f);
+    if(!success)
+    {
+        debugf("[SaveLibrary]: ERROR: could not write to %s\r\n", indexPath_);
+    }
+    return success;
+}
+
+uint16_t SaveLibrary::readEntries(SaveLibraryEntry* outEntries, uint16_t maxEntries, const char* gameTitle) const
+{
+    uint16_t numEntries = 0;
+    FILE* f;
+
+    if(!header_.numEntries)
+    {
+        return 0;
+    }
+
+    f = fopen(indexPath_, "r");
+    if(!f)
+    {
+        return 0;
+    }
+
+    // go through the entries in reverse order: the most recent backup is the most interesting one
+    for(uint16_t i = header_.numEntries; i > 0 && numEntries < maxEntries; --i)
+    {
+        SaveLibraryEntry& entry = outEntries[numEntries];
+        if(fseek(f, static_cast<long>(sizeof(SaveLibraryHeader) + (i - 1) * sizeof(SaveLibraryEntry)), SEEK_SET) || fread(&entry, 1, sizeof(entry), f) != sizeof(entry))
+        {
+            break;
+        }
+
+        if(gameTitle && strncmp(entry.gameTitle, gameTitle, sizeof(entry.gameTitle)))
+        {
+            continue;
+        }
+
+        // make sure we can use the strings, even if the index was corrupted
+        entry.path[sizeof(entry.path) - 1] = '\0';
+        entry.gameTitle[sizeof(entry.gameTitle) - 1] = '\0';
+        entry.trainerName[sizeof(entry.trainerName) - 1] = '\0';
+        ++numEntries;
+    }
+
+    fclose(f);
+    return numEntries;
+}
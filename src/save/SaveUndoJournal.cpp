@@ -0,0 +1,361 @@
+#include "save/SaveUndoJournal.h"
+#include "core/DragonUtils.h"
+#include "core/Hash.h"
+
+#include <cstddef>
+#include <cstring>
+
+static const char SAVE_UNDO_JOURNAL_MAGIC[4] = {'P', 'M', 'U', 'J'};
+static const uint8_t SAVE_UNDO_JOURNAL_VERSION = 3;
+static const uint16_t SAVE_UNDO_JOURNAL_BLOCKS_PER_BANK = 0x2000 / TPAK_BLOCK_SIZE;
+
+static void fillJournalHeader(SaveUndoJournalHeader& header, const gameboy_cartridge_header& gbHeader, TransferPakManager& pakManager)
+{
+    const char* savePath;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SAVE_UNDO_JOURNAL_MAGIC, sizeof(SAVE_UNDO_JOURNAL_MAGIC));
+    header.version = SAVE_UNDO_JOURNAL_VERSION;
+    memcpy(header.globalChecksum, &gbHeader.global_checksum, sizeof(header.globalChecksum));
+    memcpy(header.title, gbHeader.new_title.title, 11);
+    if(pakManager.isVirtualCartridge())
+    {
+        // a .sav file of the same game as the cartridge in the transfer pak must not get the journal of the cartridge (or of another .sav file)
+        savePath = pakManager.getVirtualCartridge().getSavePath();
+        header.saveSource = fnv1a64(reinterpret_cast<const uint8_t*>(savePath), strlen(savePath));
+    }
+}
+
+/**
+ * @brief Hashes the current contents (and location) of every block in the given map.
+ * The previously selected SRAM bank gets selected again afterwards.
+ * @return the fingerprint or 0 if any of the blocks couldn't be read
+ */
+static uint64_t calculateSaveFingerprint(TransferPakManager& pakManager, const SaveUndoJournalBlockMap& blocks)
+{
+    const uint8_t previousSRAMBankIndex = pakManager.getCurrentGBSRAMBank();
+    uint8_t block[TPAK_BLOCK_SIZE];
+    uint8_t location[3];
+    uint64_t fingerprint = FNV1A64_OFFSET_BASIS;
+    uint16_t SRAMBankOffset;
+    bool bankSelected;
+    bool success = true;
+
+    for(uint8_t bank = 0; success && bank < SAVE_UNDO_JOURNAL_MAX_BANKS; ++bank)
+    {
+        bankSelected = false;
+        for(uint16_t i = 0; i < SAVE_UNDO_JOURNAL_BLOCKS_PER_BANK; ++i)
+        {
+            if(!(blocks[bank][i / 8] & (1 << (i % 8))))
+            {
+                continue;
+            }
+
+            if(!bankSelected)
+            {
+                pakManager.switchGBSRAMBank(bank);
+                bankSelected = true;
+            }
+
+            SRAMBankOffset = static_cast<uint16_t>(i * TPAK_BLOCK_SIZE);
+            if(!pakManager.readSRAMBlock(SRAMBankOffset, block))
+            {
+                success = false;
+                break;
+            }
+
+            location[0] = bank;
+            location[1] = static_cast<uint8_t>(SRAMBankOffset >> 8);
+            location[2] = static_cast<uint8_t>(SRAMBankOffset & 0xFF);
+            fingerprint = fnv1a64(location, sizeof(location), fingerprint);
+            fingerprint = fnv1a64(block, TPAK_BLOCK_SIZE, fingerprint);
+        }
+    }
+
+    if(previousSRAMBankIndex != 0xFF)
+    {
+        pakManager.switchGBSRAMBank(previousSRAMBankIndex);
+    }
+
+    if(!success)
+    {
+        return 0;
+    }
+    // 0 means "no fingerprint" in the journal header
+    return (fingerprint) ? fingerprint : 1;
+}
+
+/**
+ * @brief Checks whether the save in the transfer pak still matches the given fingerprint. f must point to the first journal entry.
+ */
+static bool matchesSaveFingerprint(TransferPakManager& pakManager, FILE* f, uint16_t numEntries, uint64_t saveFingerprint)
+{
+    SaveUndoJournalBlockMap journaledBlocks;
+    SaveUndoJournalEntry entry;
+    uint16_t blockIndex;
+
+    memset(journaledBlocks, 0, sizeof(journaledBlocks));
+    for(uint16_t i = 0; i < numEntries; ++i)
+    {
+        if(fread(&entry, 1, sizeof(entry), f) != sizeof(entry))
+        {
+            return false;
+        }
+        // end() only fingerprints the blocks it keeps track of
+        if(entry.SRAMBankIndex < SAVE_UNDO_JOURNAL_MAX_BANKS)
+        {
+            blockIndex = entry.SRAMBankOffset / TPAK_BLOCK_SIZE;
+            journaledBlocks[entry.SRAMBankIndex][blockIndex / 8] |= static_cast<uint8_t>(1 << (blockIndex % 8));
+        }
+    }
+    return (calculateSaveFingerprint(pakManager, journaledBlocks) == saveFingerprint);
+}
+
+/**
+ * @brief Opens the journal file and checks whether it belongs to the save in the transfer pak
+ * @return the opened journal file or nullptr
+ */
+static FILE* openJournalForCurrentCartridge(TransferPakManager& pakManager, const char* journalPath, uint16_t& outNumEntries)
+{
+    gameboy_cartridge_header gbHeader;
+    SaveUndoJournalHeader expectedHeader;
+    SaveUndoJournalHeader header;
+    long fileSize;
+    uint16_t numEntries;
+    FILE* f;
+
+    outNumEntries = 0;
+    if(!sdcard_mounted || !pakManager.readCartridgeHeader(gbHeader))
+    {
+        return nullptr;
+    }
+
+    f = fopen(journalPath, "r");
+    if(!f)
+    {
+        return nullptr;
+    }
+
+    fillJournalHeader(expectedHeader, gbHeader, pakManager);
+    if(fread(&header, 1, sizeof(header), f) != sizeof(header) || memcmp(&header, &expectedHeader, offsetof(SaveUndoJournalHeader, saveFingerprint)))
+    {
+        debugf("[SaveUndoJournal]: the journal doesn't belong to this cartridge or .sav file\r\n");
+        fclose(f);
+        return nullptr;
+    }
+
+    fseek(f, 0, SEEK_END);
+    fileSize = ftell(f);
+    numEntries = static_cast<uint16_t>((fileSize - static_cast<long>(sizeof(header))) / static_cast<long>(sizeof(SaveUndoJournalEntry)));
+
+    // the same game isn't enough: writing the blocks of another save (another cartridge or a save that was played on since) would corrupt it
+    if(!header.saveFingerprint || fseek(f, static_cast<long>(sizeof(header)), SEEK_SET) || !matchesSaveFingerprint(pakManager, f, numEntries, header.saveFingerprint))
+    {
+        debugf("[SaveUndoJournal]: the journal doesn't belong to this save\r\n");
+        fclose(f);
+        return nullptr;
+    }
+
+    outNumEntries = numEntries;
+    return f;
+}
+
+SaveUndoJournal::SaveUndoJournal(TransferPakManager& pakManager, const char* journalPath)
+    : pakManager_(pakManager)
+    , journalPath_(journalPath)
+    , journalFile_(nullptr)
+    , header_()
+    , journaledBlocks_()
+    , numJournaledBlocks_(0)
+    , active_(false)
+    , failed_(false)
+{
+}
+
+SaveUndoJournal::~SaveUndoJournal()
+{
+    end();
+}
+
+bool SaveUndoJournal::begin()
+{
+    gameboy_cartridge_header gbHeader;
+
+    if(!sdcard_mounted || !pakManager_.readCartridgeHeader(gbHeader))
+    {
+        debugf("[SaveUndoJournal]: journal not available. This change can't be undone!\r\n");
+        return false;
+    }
+
+    fillJournalHeader(header_, gbHeader, pakManager_);
+    memset(journaledBlocks_, 0, sizeof(journaledBlocks_));
+    numJournaledBlocks_ = 0;
+    failed_ = false;
+
+    pakManager_.setSRAMWriteListener(this);
+    active_ = true;
+    return true;
+}
+
+void SaveUndoJournal::end()
+{
+    if(active_)
+    {
+        pakManager_.setSRAMWriteListener(nullptr);
+        active_ = false;
+
+        if(journalFile_ && !writeSaveFingerprint())
+        {
+            debugf("[SaveUndoJournal]: ERROR: could not fingerprint the save. This change can't be undone!\r\n");
+            // without a fingerprint, undo() refuses the journal anyway
+            fclose(journalFile_);
+            journalFile_ = nullptr;
+            remove(journalPath_);
+        }
+    }
+
+    if(journalFile_)
+    {
+        fclose(journalFile_);
+        journalFile_ = nullptr;
+    }
+}
+
+uint16_t SaveUndoJournal::getNumberOfJournaledBlocks() const
+{
+    return numJournaledBlocks_;
+}
+
+void SaveUndoJournal::onBeforeSRAMBlockWrite(uint8_t SRAMBankIndex, uint16_t SRAMBankOffset, const uint8_t* originalData)
+{
+    const uint16_t blockIndex = SRAMBankOffset / TPAK_BLOCK_SIZE;
+    SaveUndoJournalEntry entry;
+
+    if(failed_)
+    {
+        return;
+    }
+
+    if(SRAMBankIndex < SAVE_UNDO_JOURNAL_MAX_BANKS)
+    {
+        if(journaledBlocks_[SRAMBankIndex][blockIndex / 8] & (1 << (blockIndex % 8)))
+        {
+            // we already have the original contents of this block
+            return;
+        }
+        journaledBlocks_[SRAMBankIndex][blockIndex / 8] |= static_cast<uint8_t>(1 << (blockIndex % 8));
+    }
+
+    if(!journalFile_ && !openJournalFile())
+    {
+        failed_ = true;
+        return;
+    }
+
+    entry.SRAMBankIndex = SRAMBankIndex;
+    entry.reserved = 0;
+    entry.SRAMBankOffset = SRAMBankOffset;
+    memcpy(entry.originalData, originalData, TPAK_BLOCK_SIZE);
+
+    // the entry needs to be on the SD card before the block gets modified. Otherwise we can't undo if something goes wrong halfway
+    if(fwrite(&entry, 1, sizeof(entry), journalFile_) != sizeof(entry) || fflush(journalFile_))
+    {
+        debugf("[SaveUndoJournal]: ERROR: could not write to the journal. This change can't be undone!\r\n");
+        // a partial journal would only revert part of the change. That's worse than not being able to undo at all
+        fclose(journalFile_);
+        journalFile_ = nullptr;
+        remove(journalPath_);
+        failed_ = true;
+        return;
+    }
+    ++numJournaledBlocks_;
+}
+
+uint16_t SaveUndoJournal::getNumberOfUndoableBlocks(TransferPakManager& pakManager, const char* journalPath)
+{
+    uint16_t numEntries;
+    FILE* f = openJournalForCurrentCartridge(pakManager, journalPath, numEntries);
+
+    if(f)
+    {
+        fclose(f);
+    }
+    return numEntries;
+}
+
+bool SaveUndoJournal::undo(TransferPakManager& pakManager, const char* journalPath)
+{
+    SaveUndoJournalEntry entry;
+    uint16_t numEntries;
+    bool success = true;
+    const uint8_t previousSRAMBankIndex = pakManager.getCurrentGBSRAMBank();
+    FILE* f = openJournalForCurrentCartridge(pakManager, journalPath, numEntries);
+
+    if(!f || !numEntries)
+    {
+        if(f)
+        {
+            fclose(f);
+        }
+        return false;
+    }
+
+    // go through the entries in reverse order: if a block was journaled more than once, the first entry has the original contents
+    for(uint16_t i = numEntries; i > 0; --i)
+    {
+        if(fseek(f, static_cast<long>(sizeof(SaveUndoJournalHeader) + (i - 1) * sizeof(SaveUndoJournalEntry)), SEEK_SET) || fread(&entry, 1, sizeof(entry), f) != sizeof(entry))
+        {
+            success = false;
+            break;
+        }
+
+        pakManager.switchGBSRAMBank(entry.SRAMBankIndex);
+        if(!pakManager.writeSRAMBlock(entry.SRAMBankOffset, entry.originalData))
+        {
+            success = false;
+        }
+    }
+
+    fclose(f);
+
+    // leave the cartridge on the SRAM bank it was on, so that we don't pull the bank from under anyone else's feet
+    if(previousSRAMBankIndex != 0xFF)
+    {
+        pakManager.switchGBSRAMBank(previousSRAMBankIndex);
+    }
+
+    if(success)
+    {
+        // the journal has been used up. Undoing it twice would be harmless, but also pointless.
+        remove(journalPath);
+    }
+    return success;
+}
+
+bool SaveUndoJournal::openJournalFile()
+{
+    journalFile_ = fopen(journalPath_, "w");
+    if(!journalFile_)
+    {
+        debugf("[SaveUndoJournal]: ERROR: could not create %s\r\n", journalPath_);
+        return false;
+    }
+
+    if(fwrite(&header_, 1, sizeof(header_), journalFile_) != sizeof(header_))
+    {
+        fclose(journalFile_);
+        journalFile_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool SaveUndoJournal::writeSaveFingerprint()
+{
+    header_.saveFingerprint = calculateSaveFingerprint(pakManager_, journaledBlocks_);
+    if(!header_.saveFingerprint)
+    {
+        return false;
+    }
+    return (!fseek(journalFile_, 0, SEEK_SET) && fwrite(&header_, 1, sizeof(header_), journalFile_) == sizeof(header_) && !fflush(journalFile_));
+}
\ No newline at end of file
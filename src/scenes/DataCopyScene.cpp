@@ -4,6 +4,7 @@
 #include "menu/MenuFunctions.h"
 #include "gen1/Gen1Common.h"
 #include "gen2/Gen2Common.h"
+#include "core/GameSession.h"
 
 #include <system.h>
 
@@ -28,6 +29,13 @@ int mkdir( const char * path, mode_t mode );
  */
 static int COPY_CHUNK_SIZE_IN_BYTES = 4096;
 
+/**
+ * The SRAM offsets of the playtime of the international versions of the games. These are stored in the save library.
+ */
+static const uint32_t GEN1_PLAYTIME_OFFSET = 0x2CED;
+static const uint32_t GEN2_GOLDSILVER_PLAYTIME_OFFSET = 0x2053;
+static const uint32_t GEN2_CRYSTAL_PLAYTIME_OFFSET = 0x2052;
+
 static void dialogFinishedCallback(void* context)
 {
     DataCopyScene* scene = (DataCopyScene*)context;
@@ -90,7 +98,7 @@ static void generateRomTitle(char* outputPath, const gameboy_cartridge_header& g
     }
 }
 
-static void generateSaveFileName(char* savOutputPath, size_t bufferSize, const char* gameTitle, const char* playerName)
+static void generateSaveFileName(char* savOutputPath, size_t bufferSize, const char* gameTitle, const char* playerName, const char* extension)
 {
     struct stat statStruct;
     unsigned uniqueNumber = 0;
@@ -98,41 +106,95 @@ static void generateSaveFileName(char* savOutputPath, size_t bufferSize, const c
 
     if(playerNameSize)
     {
-        snprintf(savOutputPath, bufferSize - 1, "sd:/PokeMe64/%s_%s.sav", gameTitle, playerName);
+        snprintf(savOutputPath, bufferSize - 1, "sd:/PokeMe64/%s_%s%s", gameTitle, playerName, extension);
     }
     else
     {
-        snprintf(savOutputPath, bufferSize - 1, "sd:/PokeMe64/%s.sav", gameTitle);
+        snprintf(savOutputPath, bufferSize - 1, "sd:/PokeMe64/%s%s", gameTitle, extension);
     }
 
     while(stat(savOutputPath, &statStruct) == 0)
     {
         if(playerNameSize)
         {
-            snprintf(savOutputPath, bufferSize - 1, "sd:/PokeMe64/%s_%s_%u.sav", gameTitle, playerName, uniqueNumber);
+            snprintf(savOutputPath, bufferSize - 1, "sd:/PokeMe64/%s_%s_%u%s", gameTitle, playerName, uniqueNumber, extension);
         }
         else
         {
-            snprintf(savOutputPath, bufferSize - 1, "sd:/PokeMe64/%s_%u.sav", gameTitle, uniqueNumber);
+            snprintf(savOutputPath, bufferSize - 1, "sd:/PokeMe64/%s_%u%s", gameTitle, uniqueNumber, extension);
         }
         ++uniqueNumber;
     }
 }
 
+/**
+ * @brief Generates the path of the .sav file we export a snapshot manifest to: the same path, but with the .sav extension instead.
+ * If such a file already exists, a unique number is appended.
+ */
+static void generateExportFileName(char* savOutputPath, size_t bufferSize, const char* manifestPath)
+{
+    struct stat statStruct;
+    unsigned uniqueNumber = 0;
+    const char* extension = strrchr(manifestPath, '.');
+    const int baseLength = (extension) ? static_cast<int>(extension - manifestPath) : static_cast<int>(strlen(manifestPath));
+
+    snprintf(savOutputPath, bufferSize - 1, "%.*s.sav", baseLength, manifestPath);
+    while(stat(savOutputPath, &statStruct) == 0)
+    {
+        snprintf(savOutputPath, bufferSize - 1, "%.*s_%u.sav", baseLength, manifestPath, uniqueNumber);
+        ++uniqueNumber;
+    }
+}
+
+/**
+ * @brief Returns a short name for the given operation. This is used in the summary of a multi-job copy.
+ */
+static const char* getOperationName(DataCopyOperation operation)
+{
+    switch(operation)
+    {
+        case DataCopyOperation::BACKUP_SAVE:
+            return "Save";
+        case DataCopyOperation::BACKUP_ROM:
+            return "ROM";
+        case DataCopyOperation::BACKUP_SAVE_COMPRESSED:
+            return "Save (LZ)";
+        case DataCopyOperation::BACKUP_ROM_COMPRESSED:
+            return "ROM (LZ)";
+        case DataCopyOperation::BACKUP_SAVE_SNAPSHOT:
+            return "Snapshot";
+        case DataCopyOperation::CLONE_SAVE:
+            return "Clone";
+        case DataCopyOperation::BACKUP_SAVE_CONTROLLER_PAK:
+            return "Controller Pak";
+        default:
+            return "Copy";
+    }
+}
+
 DataCopyScene::DataCopyScene(SceneDependencies& deps, void* context)
     : SceneWithProgressBar(deps)
     , romReader_(deps.tpakManager)
     , saveManager_(deps.tpakManager)
+    , backupStore_()
+    , saveLibrary_()
+    , cloneTargetPakManager_()
+    , cloneTargetSaveManager_(nullptr)
     , sceneContext_((DataCopySceneContext*)context)
-    , copySource_(nullptr)
-    , copyDestination_(nullptr)
-    , copier_(nullptr)
+    , jobQueue_()
+    , jobInfo_()
+    , summaryDialog_(nullptr)
+    , wipeStatsDialog_(nullptr)
     , dialogWidgetSprite_(nullptr)
     , progressBackgroundSprite_(nullptr)
     , diag_({0})
-    , totalBytesToCopy_(0)
+    , totalBytesToWipe_(0)
+    , bytesWiped_(0)
+    , wipeStartTime_(0)
+    , copying_(false)
+    , wiping_(false)
+    , wipeFailed_(false)
 {
-    (void)context;
 }
 
 DataCopyScene::~DataCopyScene()
@@ -141,190 +203,777 @@ DataCopyScene::~DataCopyScene()
 
 void DataCopyScene::init()
 {
-    char savOutputPath[4096];
-    char romOutputPath[4096];
     char gameTitle[12];
+    DialogData* lastDialog;
     dialogWidgetSprite_ = sprite_load("rom://menu-bg-9slice.sprite");
     progressBackgroundSprite_ = sprite_load("rom://bg-nineslice-transparant-border.sprite");
 
     SceneWithProgressBar::init();
 
-    // check if the n64 flashcart is supported
-    if(!doesN64FlashCartSupportSDCardAccess())
+    // these operations only use the joybus, so they don't need the SD card
+    if(sceneContext_->operation != DataCopyOperation::CLONE_SAVE && sceneContext_->operation != DataCopyOperation::BACKUP_SAVE_CONTROLLER_PAK && sceneContext_->operation != DataCopyOperation::RESTORE_SAVE_CONTROLLER_PAK)
+    {
+        // check if the n64 flashcart is supported
+        if(!doesN64FlashCartSupportSDCardAccess())
+        {
+            setDialogDataText(diag_, "Sorry! This is only supported on 64Drive, Everdrive64, ED64Plus and SummerCart64!");
+            showDialog(&diag_);
+            return;
+        }
+
+        // check if the sd card is mounted
+        if(!sdcard_mounted)
+        {
+            setDialogDataText(diag_, "ERROR: SD card is not mounted!");
+            showDialog(&diag_);
+            return;
+        }
+
+        mkdir("sd:/PokeMe64", 0777);
+
+        if(!saveLibrary_.load())
+        {
+            // we can still make the backup. It just won't show up in the save library
+            debugf("[DataCopyScene]: WARN: could not load the save library\r\n");
+        }
+    }
+
+    // the cartridge header is read only once for all the jobs
+    gameboy_cartridge_header gbHeader;
+    deps_.tpakManager.readCartridgeHeader(gbHeader);
+
+    generateRomTitle(gameTitle, gbHeader, deps_.generation, deps_.specificGenVersion);
+
+    if(sceneContext_->operation == DataCopyOperation::WIPE_SAVE)
     {
-        setDialogDataText(diag_, "Sorry! This is only supported on 64Drive, Everdrive64, ED64Plus and SummerCart64!");
+        // wiping doesn't need a copy source and destination. We fill the SRAM directly instead
+        totalBytesToWipe_ = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
+
+        auto msg2 = new DialogData{
+            .shouldDeleteWhenDone = true
+        };
+        setDialogDataText(*msg2, "The save file was wiped from the cartridge!");
+        // the statistics are only known when the wipe is done. The text will be filled in at that point.
+        wipeStatsDialog_ = new DialogData{
+            .shouldDeleteWhenDone = true
+        };
+        msg2->next = wipeStatsDialog_;
+
+        setDialogDataText(diag_, "Wiping. Please Wait...");
+        diag_.userAdvanceBlocked = true;
+        diag_.next = msg2;
         showDialog(&diag_);
+
+        deps_.tpakManager.setRAMEnabled(true);
+        wipeStartTime_ = get_ticks();
+        wiping_ = true;
         return;
     }
 
-    // check if the sd card is mounted
-    if(!sdcard_mounted)
+    bool success;
+    if(sceneContext_->operation == DataCopyOperation::BACKUP_SAVE_AND_ROM)
     {
-        setDialogDataText(diag_, "ERROR: SD card is not mounted!");
+        success = addCopyJob(DataCopyOperation::BACKUP_SAVE, gbHeader, gameTitle) && addCopyJob(DataCopyOperation::BACKUP_ROM, gbHeader, gameTitle);
+    }
+    else
+    {
+        success = addCopyJob(sceneContext_->operation, gbHeader, gameTitle);
+    }
+
+    if(!success)
+    {
+        // addCopyJob() has set the error text in diag_. Get rid of the jobs that were already added
+        for(uint8_t i = 0; i < jobQueue_.getNumberOfJobs(); ++i)
+        {
+            delete jobInfo_[i].resultDialog;
+            jobInfo_[i].resultDialog = nullptr;
+        }
+        jobQueue_.clear();
+        closeCloneTargetPak();
+
+        // now show the error dialog
         showDialog(&diag_);
         return;
     }
 
-    mkdir("sd:/PokeMe64", 0777);
+    // chain the result dialogs of all jobs after the "Please Wait" dialog
+    lastDialog = &diag_;
+    for(uint8_t i = 0; i < jobQueue_.getNumberOfJobs(); ++i)
+    {
+        DataCopyJobInfo& info = jobInfo_[i];
+        lastDialog->next = info.resultDialog;
+        lastDialog = info.resultDialog;
 
-    gameboy_cartridge_header gbHeader;
-    deps_.tpakManager.readCartridgeHeader(gbHeader);
+        if(jobQueue_.getNumberOfJobs() == 1 && (info.snapshotDestination || info.compressedDestination || info.diffDestination || info.controllerPakDestination || info.hashDestination))
+        {
+            // the statistics are only known when the copy is done. The text will be filled in at that point.
+            info.statsDialog = new DialogData{
+                .shouldDeleteWhenDone = true
+            };
+            lastDialog->next = info.statsDialog;
+            lastDialog = info.statsDialog;
+        }
+    }
 
-    generateRomTitle(gameTitle, gbHeader, deps_.generation, deps_.specificGenVersion);
+    if(jobQueue_.getNumberOfJobs() > 1)
+    {
+        // with multiple jobs, we show a single summary of all of them instead of statistics per job
+        summaryDialog_ = new DialogData{
+            .shouldDeleteWhenDone = true
+        };
+        lastDialog->next = summaryDialog_;
+    }
+
+    setDialogDataText(diag_, "Copying. Please Wait...");
+    diag_.userAdvanceBlocked = true;
+    showDialog(&diag_);
+
+    // all the jobs share the same RAM enable session
+    deps_.tpakManager.setRAMEnabled(true);
+    copying_ = true;
+}
 
-    auto msg2 = new DialogData{
+void DataCopyScene::destroy()
+{
+    sprite_free(dialogWidgetSprite_);
+    dialogWidgetSprite_ = nullptr;
+    sprite_free(progressBackgroundSprite_);
+    progressBackgroundSprite_ = nullptr;
+
+    // this also closes any destination that is still open
+    jobQueue_.clear();
+    closeCloneTargetPak();
+
+    deps_.tpakManager.setRAMEnabled(false);
+    SceneWithProgressBar::destroy();
+}
+
+void DataCopyScene::processUserInput()
+{
+    if(wiping_)
+    {
+        // filling doesn't need to read the blocks first, so we can do twice as much per frame
+        const uint32_t numBytesToWipe = std::min<uint32_t>(COPY_CHUNK_SIZE_IN_BYTES * 2, totalBytesToWipe_ - bytesWiped_);
+        if(numBytesToWipe && !saveManager_.fill(0, numBytesToWipe))
+        {
+            wipeFailed_ = true;
+        }
+        bytesWiped_ += numBytesToWipe;
+
+        // a cartridge without SRAM has nothing to wipe
+        setProgress((totalBytesToWipe_) ? static_cast<double>(bytesWiped_) / static_cast<double>(totalBytesToWipe_) : 1.0);
+
+        if(bytesWiped_ >= totalBytesToWipe_)
+        {
+            deps_.tpakManager.setRAMEnabled(false);
+            deps_.gameSession.invalidate();
+            fillWipeStatsDialog(static_cast<uint32_t>(TICKS_TO_MS(get_ticks() - wipeStartTime_)));
+            wipeStatsDialog_ = nullptr;
+            wiping_ = false;
+
+            // The wipe operation is done, now advance the blocked dialog entry to the final one
+            advanceDialog();
+        }
+    }
+
+    if(copying_)
+    {
+        const uint8_t jobIndex = jobQueue_.getCurrentJobIndex();
+
+        jobQueue_.processChunk(COPY_CHUNK_SIZE_IN_BYTES);
+        setProgress((jobQueue_.getTotalBytes()) ? static_cast<double>(jobQueue_.getTotalBytesCopied()) / static_cast<double>(jobQueue_.getTotalBytes()) : 1.0);
+
+        if(jobQueue_.getCurrentJobIndex() != jobIndex)
+        {
+            onJobFinished(jobIndex);
+        }
+
+        if(jobQueue_.isDone())
+        {
+            deps_.tpakManager.setRAMEnabled(false);
+            closeCloneTargetPak();
+            if(summaryDialog_)
+            {
+                fillSummaryDialog();
+                summaryDialog_ = nullptr;
+            }
+            copying_ = false;
+
+            // All copy operations are done, now advance the blocked dialog entry to the first result
+            advanceDialog();
+        }
+    }
+
+    SceneWithProgressBar::processUserInput();
+}
+
+void DataCopyScene::render(RDPQGraphics& gfx, const Rectangle& sceneBounds)
+{
+    SceneWithProgressBar::render(gfx, sceneBounds);
+}
+
+void DataCopyScene::onDialogDone()
+{
+    deps_.sceneManager.goBackToPreviousScene();
+}
+
+bool DataCopyScene::addCopyJob(DataCopyOperation operation, const gameboy_cartridge_header& gbHeader, const char* gameTitle)
+{
+    char outputPath[4096];
+    const char* inputPath = nullptr;
+    bool hasOutputPath = false;
+    ITransferPakDataCopySource* source = nullptr;
+    ITransferPakDataCopyDestination* destination = nullptr;
+    uint32_t totalBytes = 0;
+    SaveSnapshotCopySource* snapshotSource;
+    TransferPakCompressedFileCopySource* compressedSource = nullptr;
+    ControllerPakCopySource* controllerPakSource;
+    joypad_port_t controllerPakPort;
+    char noteName[19];
+    size_t inputPathLength;
+    SaveChecksumRegion checksumRegion;
+    DataCopyJobInfo info = {
+        .operation = operation
+    };
+    auto resultDialog = new DialogData{
         .shouldDeleteWhenDone = true
     };
 
-    switch(sceneContext_->operation)
+    switch(operation)
     {
         case DataCopyOperation::BACKUP_SAVE:
-            generateSaveFileName(savOutputPath, sizeof(savOutputPath), gameTitle, deps_.playerName);
-            copySource_ = new TransferPakSaveManagerCopySource(saveManager_);
-            copyDestination_ = new TransferPakFileCopyDestination(savOutputPath, (deps_.generation == 2));
-            totalBytesToCopy_ = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
-            setDialogDataText(*msg2, "The save was backed up to %s!", savOutputPath);
+            saveLibrary_.generateBackupPath(outputPath, sizeof(outputPath), gameTitle, deps_.playerName, ".sav");
+            hasOutputPath = true;
+            fillSaveLibraryEntry(info.libraryEntry, gbHeader, outputPath);
+            info.addToLibrary = true;
+            source = new TransferPakSaveManagerCopySource(saveManager_);
+            destination = new TransferPakFileCopyDestination(outputPath, (deps_.generation == 2));
+            totalBytes = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
+            setDialogDataText(*resultDialog, "The save was backed up to %s!", outputPath);
             break;
         case DataCopyOperation::BACKUP_ROM:
-            snprintf(romOutputPath, sizeof(savOutputPath) - 1, "sd:/PokeMe64/%s.gbc", gameTitle);
-            copySource_ = new TransferPakRomReaderCopySource(romReader_);
-            copyDestination_ = new TransferPakFileCopyDestination(romOutputPath);
-            totalBytesToCopy_ = convertROMSizeIntoNumBytes(gbHeader.rom_size_code);
-            setDialogDataText(*msg2, "The cartridge rom was backed up to %s!", romOutputPath);
+            snprintf(outputPath, sizeof(outputPath) - 1, "sd:/PokeMe64/%s.gbc", gameTitle);
+            hasOutputPath = true;
+            source = new TransferPakRomReaderCopySource(romReader_);
+            destination = new TransferPakFileCopyDestination(outputPath);
+            totalBytes = convertROMSizeIntoNumBytes(gbHeader.rom_size_code);
+            setDialogDataText(*resultDialog, "The cartridge rom was backed up to %s!", outputPath);
+            break;
+        case DataCopyOperation::BACKUP_SAVE_COMPRESSED:
+            saveLibrary_.generateBackupPath(outputPath, sizeof(outputPath), gameTitle, deps_.playerName, ".sav.lz");
+            hasOutputPath = true;
+            fillSaveLibraryEntry(info.libraryEntry, gbHeader, outputPath);
+            info.libraryEntry.flags |= SAVE_LIBRARY_ENTRY_FLAG_COMPRESSED;
+            info.addToLibrary = true;
+            source = new TransferPakSaveManagerCopySource(saveManager_);
+            info.compressedDestination = new TransferPakCompressedFileCopyDestination(outputPath, (deps_.generation == 2));
+            destination = info.compressedDestination;
+            totalBytes = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
+            setDialogDataText(*resultDialog, "The save was backed up to %s!", outputPath);
+            break;
+        case DataCopyOperation::BACKUP_ROM_COMPRESSED:
+            snprintf(outputPath, sizeof(outputPath) - 1, "sd:/PokeMe64/%s.gbc.lz", gameTitle);
+            hasOutputPath = true;
+            source = new TransferPakRomReaderCopySource(romReader_);
+            info.compressedDestination = new TransferPakCompressedFileCopyDestination(outputPath);
+            destination = info.compressedDestination;
+            totalBytes = convertROMSizeIntoNumBytes(gbHeader.rom_size_code);
+            setDialogDataText(*resultDialog, "The cartridge rom was backed up to %s!", outputPath);
             break;
         case DataCopyOperation::RESTORE_SAVE:
-            copySource_ = new TransferPakFileCopySource(sceneContext_->saveToRestorePath.get());
-            copyDestination_ = new TransferPakSaveManagerDestination(saveManager_);
-            totalBytesToCopy_ = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
-            setDialogDataText(*msg2, "The save was restored to the cartridge!", romOutputPath);
+            inputPath = sceneContext_->saveToRestorePath.get();
+            inputPathLength = strlen(inputPath);
+            info.diffDestination = new TransferPakSaveManagerDiffDestination(saveManager_);
+            destination = info.diffDestination;
+            totalBytes = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
+            if(inputPathLength > 3 && !strcmp(inputPath + inputPathLength - 3, ".lz"))
+            {
+                compressedSource = new TransferPakCompressedFileCopySource(inputPath);
+                source = compressedSource;
+            }
+            else
+            {
+                source = new TransferPakFileCopySource(inputPath);
+            }
+            setDialogDataText(*resultDialog, "The save was restored to the cartridge!");
+            break;
+        case DataCopyOperation::BACKUP_SAVE_SNAPSHOT:
+            generateSaveFileName(outputPath, sizeof(outputPath), gameTitle, deps_.playerName, ".snap");
+            hasOutputPath = true;
+            source = new TransferPakSaveManagerCopySource(saveManager_);
+            info.snapshotDestination = new SaveSnapshotCopyDestination(backupStore_, outputPath);
+            destination = info.snapshotDestination;
+            totalBytes = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
+            setDialogDataText(*resultDialog, "The save snapshot was stored to %s!", outputPath);
+            break;
+        case DataCopyOperation::RESTORE_SAVE_SNAPSHOT:
+            inputPath = sceneContext_->saveToRestorePath.get();
+            snapshotSource = new SaveSnapshotCopySource(backupStore_, inputPath);
+            source = snapshotSource;
+            info.diffDestination = new TransferPakSaveManagerDiffDestination(saveManager_);
+            destination = info.diffDestination;
+            totalBytes = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
+            if(snapshotSource->readyForTransfer() && snapshotSource->getTotalSize() != totalBytes)
+            {
+                setDialogDataText(diag_, "ERROR: The backup size doesn't match the save size of this cartridge!");
+                delete source;
+                delete destination;
+                delete resultDialog;
+                return false;
+            }
+            setDialogDataText(*resultDialog, "The save snapshot was restored to the cartridge!");
             break;
-        case DataCopyOperation::WIPE_SAVE:
-            copySource_ = new TransferPakNullCopySource();
-            copyDestination_ = new TransferPakSaveManagerDestination(saveManager_);
-            totalBytesToCopy_ = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
-            setDialogDataText(*msg2, "The save file was wiped from the cartridge!");
+        case DataCopyOperation::EXPORT_SAVE_SNAPSHOT:
+            inputPath = sceneContext_->saveToRestorePath.get();
+            generateExportFileName(outputPath, sizeof(outputPath), inputPath);
+            hasOutputPath = true;
+            snapshotSource = new SaveSnapshotCopySource(backupStore_, inputPath);
+            source = snapshotSource;
+            // just like a regular .sav backup
+            destination = new TransferPakFileCopyDestination(outputPath, (deps_.generation == 2));
+            totalBytes = snapshotSource->getTotalSize();
+            setDialogDataText(*resultDialog, "The save snapshot was exported to %s!", outputPath);
             break;
+        case DataCopyOperation::CLONE_SAVE:
+            if(!openCloneTargetPak(gbHeader))
+            {
+                delete resultDialog;
+                return false;
+            }
+            // every chunk gets read from the source pak and then written to the target pak before we continue with the next one.
+            // The diff destination only writes the blocks that differ and verifies them, so re-cloning the same save is cheap.
+            source = new TransferPakSaveManagerCopySource(saveManager_);
+            info.diffDestination = new TransferPakSaveManagerDiffDestination(*cloneTargetSaveManager_);
+            destination = info.diffDestination;
+            totalBytes = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
+            setDialogDataText(*resultDialog, "The save was cloned to the cartridge in controller port %d!", static_cast<int>(cloneTargetPakManager_.getPort()) + 1);
+            break;
+        case DataCopyOperation::BACKUP_SAVE_CONTROLLER_PAK:
+        case DataCopyOperation::RESTORE_SAVE_CONTROLLER_PAK:
+            if(!findControllerPakPort(controllerPakPort))
+            {
+                setDialogDataText(diag_, "ERROR: Please connect a second controller with a Controller Pak!");
+                delete resultDialog;
+                return false;
+            }
+            generateControllerPakNoteName(noteName, gbHeader);
+            totalBytes = convertSRAMSizeIntoNumBytes(gbHeader.ram_size_code);
+
+            if(operation == DataCopyOperation::BACKUP_SAVE_CONTROLLER_PAK)
+            {
+                source = new TransferPakSaveManagerCopySource(saveManager_);
+                info.controllerPakDestination = new ControllerPakCopyDestination(controllerPakPort, noteName, (deps_.generation == 2));
+                destination = info.controllerPakDestination;
+                if(!destination->readyForTransfer())
+                {
+                    setDialogDataText(diag_, "ERROR: The Controller Pak in controller port %d is full or not formatted!", static_cast<int>(controllerPakPort) + 1);
+                    delete source;
+                    delete destination;
+                    delete resultDialog;
+                    return false;
+                }
+                setDialogDataText(*resultDialog, "The save was backed up to the Controller Pak in controller port %d!", static_cast<int>(controllerPakPort) + 1);
+            }
+            else
+            {
+                controllerPakSource = new ControllerPakCopySource(controllerPakPort, noteName);
+                source = controllerPakSource;
+                info.diffDestination = new TransferPakSaveManagerDiffDestination(saveManager_);
+                destination = info.diffDestination;
+                if(!source->readyForTransfer() || controllerPakSource->getTotalSize() != totalBytes)
+                {
+                    setDialogDataText(diag_, "ERROR: No valid backup of this game was found on the Controller Pak in controller port %d!", static_cast<int>(controllerPakPort) + 1);
+                    delete source;
+                    delete destination;
+                    delete resultDialog;
+                    return false;
+                }
+                setDialogDataText(*resultDialog, "The save was restored from the Controller Pak!");
+            }
+            break;
+        default:
+            debugf("[DataCopyScene]: ERROR: operation %d can't be used as a copy job\r\n", static_cast<int>(operation));
+            setDialogDataText(diag_, "ERROR: Unsupported operation!");
+            delete resultDialog;
+            return false;
+    }
+
+    if(compressedSource && compressedSource->readyForTransfer() && compressedSource->getTotalSize() != totalBytes)
+    {
+        setDialogDataText(diag_, "ERROR: The backup size doesn't match the save size of this cartridge!");
+        delete source;
+        delete destination;
+        delete resultDialog;
+        return false;
     }
 
-    if(!copySource_->readyForTransfer())
+    if(!source->readyForTransfer())
     {
-        if(sceneContext_->operation == DataCopyOperation::RESTORE_SAVE)
+        if(inputPath)
         {
-            setDialogDataText(diag_, "ERROR: Could not read from file %s!", sceneContext_->saveToRestorePath.get());
+            setDialogDataText(diag_, "ERROR: Could not read from file %s!", inputPath);
         }
         else
         {
             setDialogDataText(diag_, "ERROR: Could not read from cartridge!");
         }
-
-        // not needed
-        delete msg2;
-        msg2 = nullptr;
-        
-        // now show the error dialog
-        showDialog(&diag_);
-        return;
+        delete source;
+        delete destination;
+        delete resultDialog;
+        return false;
     }
 
-    if(!copyDestination_->readyForTransfer())
+    if(!destination->readyForTransfer())
     {
-        if(sceneContext_->operation == DataCopyOperation::RESTORE_SAVE)
+        if(!hasOutputPath)
         {
             setDialogDataText(diag_, "ERROR: Could not write to cartridge!");
         }
         else
         {
-            const char* outputPath = (sceneContext_->operation == DataCopyOperation::BACKUP_SAVE) ? savOutputPath : romOutputPath;
             setDialogDataText(diag_, "ERROR: Could not write to file %s!", outputPath);
         }
+        delete source;
+        delete destination;
+        delete resultDialog;
+        return false;
+    }
 
-        // not needed
-        delete msg2;
-        msg2 = nullptr;
-        // now show the error dialog
-        showDialog(&diag_);
-        return;
+    switch(operation)
+    {
+        case DataCopyOperation::BACKUP_SAVE:
+        case DataCopyOperation::BACKUP_ROM:
+        case DataCopyOperation::BACKUP_SAVE_COMPRESSED:
+        case DataCopyOperation::BACKUP_ROM_COMPRESSED:
+            // calculate the CRC-32 of the backup in the same pass
+            info.hashDestination = new TransferPakHashCopyDestination();
+            break;
+        default:
+            break;
     }
 
-    if(sceneContext_->operation == DataCopyOperation::WIPE_SAVE)
+    // for the save library, the main checksum of a save backup gets validated in the same pass as well
+    if(info.addToLibrary && info.hashDestination && getMainChecksumRegion(deps_.generation, deps_.specificGenVersion, deps_.localization, checksumRegion))
     {
-        setDialogDataText(diag_, "Wiping. Please Wait...");
+        info.hashDestination->setMainChecksumRegion(deps_.generation, checksumRegion);
     }
+
+    if(!jobQueue_.addJob(source, destination, totalBytes, info.hashDestination))
     {
-        setDialogDataText(diag_, "Copying. Please Wait...");
+        // the queue has deleted source and destination already
+        setDialogDataText(diag_, "ERROR: Too many copy operations!");
+        delete resultDialog;
+        return false;
     }
-    diag_.userAdvanceBlocked = true;
-    diag_.next = msg2;
-    showDialog(&diag_);
 
-    deps_.tpakManager.setRAMEnabled(true);
-    copier_ = new TransferPakDataCopier(*copySource_, *copyDestination_);
+    info.resultDialog = resultDialog;
+    jobInfo_[jobQueue_.getNumberOfJobs() - 1] = info;
+    return true;
 }
 
-void DataCopyScene::destroy()
+void DataCopyScene::onJobFinished(uint8_t jobIndex)
 {
-    sprite_free(dialogWidgetSprite_);
-    dialogWidgetSprite_ = nullptr;
-    sprite_free(progressBackgroundSprite_);
-    progressBackgroundSprite_ = nullptr;
+    const CopyJob& job = jobQueue_.getJob(jobIndex);
+    DataCopyJobInfo& info = jobInfo_[jobIndex];
 
-    if(copier_)
+    if(job.failed)
+    {
+        setDialogDataText(*info.resultDialog, "ERROR: Only %u of %u bytes could be copied!", job.destination->getNumberOfBytesWritten(), job.totalBytes);
+    }
+    else if(info.compressedDestination && info.compressedDestination->hasFailed())
+    {
+        // the last block and the header only get written when the destination is closed
+        setDialogDataText(*info.resultDialog, "ERROR: The compressed backup could not be written to the SD card!");
+    }
+    else if(info.snapshotDestination && info.snapshotDestination->hasFailed())
+    {
+        // the manifest only gets written when the destination is closed, so this can still fail after all the data was copied
+        setDialogDataText(*info.resultDialog, "ERROR: The save snapshot could not be stored on the SD card!");
+    }
+    else if(info.controllerPakDestination && !info.controllerPakDestination->isStored())
     {
-        delete copier_;
-        copier_ = nullptr;
+        // the note only gets written when the destination is closed, so this can still fail after all the data was copied
+        setDialogDataText(*info.resultDialog, "ERROR: The save could not be stored on the Controller Pak! Please check whether it has enough free pages.");
+    }
+    else if(info.addToLibrary)
+    {
+        info.libraryEntry.size = job.totalBytes;
+        info.libraryEntry.crc32 = (info.hashDestination && !job.copier->isDestinationFailed(1)) ? info.hashDestination->getCRC32() : 0;
+        if(info.hashDestination && !job.copier->isDestinationFailed(1) && info.hashDestination->isMainChecksumValid())
+        {
+            info.libraryEntry.flags |= SAVE_LIBRARY_ENTRY_FLAG_CHECKSUM_VALID;
+        }
+        if(!saveLibrary_.addEntry(info.libraryEntry))
+        {
+            debugf("[DataCopyScene]: WARN: could not add %s to the save library\r\n", info.libraryEntry.path);
+        }
     }
 
-    if(copySource_)
+    if(info.diffDestination && info.operation != DataCopyOperation::CLONE_SAVE)
     {
-        delete copySource_;
-        copySource_ = nullptr;
+        // the save of the cartridge was (partially) replaced, so the cached save data is outdated
+        deps_.gameSession.invalidate();
     }
 
-    if(copyDestination_)
+    if(info.statsDialog)
     {
-        delete copyDestination_;
-        copyDestination_ = nullptr;
+        fillStatsDialog(info, job);
+        info.statsDialog = nullptr;
     }
+    // the dialog widget takes care of deleting it
+    info.resultDialog = nullptr;
+}
 
-    deps_.tpakManager.setRAMEnabled(false);
-    SceneWithProgressBar::destroy();
+bool DataCopyScene::hasDestinationFailedOnClose(const DataCopyJobInfo& info) const
+{
+    // these destinations only finish writing their output when they are closed, so they can still fail after all the data was copied
+    return ((info.snapshotDestination && info.snapshotDestination->hasFailed()) || (info.compressedDestination && info.compressedDestination->hasFailed()));
 }
 
-void DataCopyScene::processUserInput()
+void DataCopyScene::fillStatsDialog(const DataCopyJobInfo& info, const CopyJob& job)
 {
-    if(copier_ && copyDestination_ && copyDestination_->getNumberOfBytesWritten() < totalBytesToCopy_)
+    const uint32_t numKiloBytes = job.totalBytes / 1024;
+    const uint32_t elapsedTimeInMs = static_cast<uint32_t>(TICKS_TO_MS(job.endTime - job.startTime));
+    char crcText[24];
+
+    if(info.hashDestination && !job.copier->isDestinationFailed(1))
+    {
+        snprintf(crcText, sizeof(crcText), " CRC32: %08lX", static_cast<unsigned long>(info.hashDestination->getCRC32()));
+    }
+    else
     {
-        const uint32_t numBytesToCopy = std::min<uint32_t>(COPY_CHUNK_SIZE_IN_BYTES, totalBytesToCopy_ - copyDestination_->getNumberOfBytesWritten());
-        copier_->copyChunk(numBytesToCopy);
+        crcText[0] = '\0';
+    }
 
-        setProgress(static_cast<double>(copyDestination_->getNumberOfBytesWritten()) / static_cast<double>(totalBytesToCopy_));
+    if(job.failed || hasDestinationFailedOnClose(info))
+    {
+        setDialogDataText(*info.statsDialog, "Please check the SD card and the cartridge and try again.");
     }
+    else if(info.snapshotDestination)
+    {
+        setDialogDataText(*info.statsDialog, "%u of %u blocks were new and had to be written to the SD card.", info.snapshotDestination->getNumberOfNewBlocks(), info.snapshotDestination->getNumberOfBlocks());
+    }
+    else if(info.diffDestination)
+    {
+        if(info.diffDestination->getNumberOfBlockErrors())
+        {
+            setDialogDataText(*info.statsDialog, "ERROR: %u of %u written blocks failed verification! Please try again.", info.diffDestination->getNumberOfBlockErrors(), info.diffDestination->getNumberOfBlocksWritten());
+        }
+        else
+        {
+            setDialogDataText(*info.statsDialog, "%u of %u blocks differed and were written. Everything was verified in %u ms.", info.diffDestination->getNumberOfBlocksWritten(), info.diffDestination->getNumberOfBlocksCompared(), elapsedTimeInMs);
+        }
+    }
+    else if(info.controllerPakDestination)
+    {
+        setDialogDataText(*info.statsDialog, "%u KB was compressed to %u Controller Pak pages in %u ms.", numKiloBytes, info.controllerPakDestination->getNumberOfPages(), elapsedTimeInMs);
+    }
+    else if(info.compressedDestination)
+    {
+        const uint32_t compressedSize = info.compressedDestination->getNumberOfCompressedBytesWritten();
+        const uint32_t ratioInPercent = (job.totalBytes) ? static_cast<uint32_t>((static_cast<uint64_t>(compressedSize) * 100) / job.totalBytes) : 0;
+        setDialogDataText(*info.statsDialog, "%u KB was compressed to %u KB (%u%%) in %u ms.%s", numKiloBytes, (compressedSize + 1023) / 1024, ratioInPercent, elapsedTimeInMs, crcText);
+    }
+    else
+    {
+        setDialogDataText(*info.statsDialog, "%u KB was copied in %u ms.%s", numKiloBytes, elapsedTimeInMs, crcText);
+    }
+}
 
-    if(copier_ && copyDestination_ && copyDestination_->getNumberOfBytesWritten() >= totalBytesToCopy_)
+void DataCopyScene::fillSummaryDialog()
+{
+    char* cur = summaryDialog_->text;
+    char* const end = summaryDialog_->text + DIALOG_TEXT_SIZE;
+    uint32_t elapsedTimeInMs;
+    uint32_t kiloBytesPerSecond;
+    int ret;
+
+    for(uint8_t i = 0; i < jobQueue_.getNumberOfJobs() && cur < end; ++i)
     {
-        deps_.tpakManager.setRAMEnabled(false);
-        copyDestination_->close();
-        delete copySource_;
-        copySource_ = nullptr;
-        delete copyDestination_;
-        copyDestination_ = nullptr;
-        delete copier_;
+        const CopyJob& job = jobQueue_.getJob(i);
+        const char* lineEnd = (i + 1 < jobQueue_.getNumberOfJobs()) ? "\n" : "";
 
-        // The copy operation is done, now advance the blocked dialog entry to the final one
-        advanceDialog();
+        if(job.failed || hasDestinationFailedOnClose(jobInfo_[i]))
+        {
+            ret = snprintf(cur, end - cur, "%s: FAILED%s", getOperationName(jobInfo_[i].operation), lineEnd);
+        }
+        else
+        {
+            elapsedTimeInMs = static_cast<uint32_t>(TICKS_TO_MS(job.endTime - job.startTime));
+            kiloBytesPerSecond = (elapsedTimeInMs) ? static_cast<uint32_t>((static_cast<uint64_t>(job.totalBytes) * 1000) / (static_cast<uint64_t>(elapsedTimeInMs) * 1024)) : 0;
+            ret = snprintf(cur, end - cur, "%s: %u KB in %u ms (%u KB/s)%s", getOperationName(jobInfo_[i].operation), job.totalBytes / 1024, elapsedTimeInMs, kiloBytesPerSecond, lineEnd);
+        }
+
+        if(ret < 0)
+        {
+            break;
+        }
+        cur += ret;
     }
+}
 
-    SceneWithProgressBar::processUserInput();
+void DataCopyScene::fillWipeStatsDialog(uint32_t elapsedTimeInMs)
+{
+    if(wipeFailed_)
+    {
+        setDialogDataText(*wipeStatsDialog_, "ERROR: The transfer pak reported errors while wiping. Please try again.");
+    }
+    else
+    {
+        setDialogDataText(*wipeStatsDialog_, "%u KB was wiped and verified in %u ms.", totalBytesToWipe_ / 1024, elapsedTimeInMs);
+    }
 }
 
-void DataCopyScene::render(RDPQGraphics& gfx, const Rectangle& sceneBounds)
+bool DataCopyScene::openCloneTargetPak(const gameboy_cartridge_header& sourceHeader)
 {
-    SceneWithProgressBar::render(gfx, sceneBounds);
+    gameboy_cartridge_header targetHeader;
+    bool found = false;
+
+    for(int i = 0; i < JOYPAD_PORT_COUNT; ++i)
+    {
+        const joypad_port_t port = static_cast<joypad_port_t>(i);
+        if(port == deps_.tpakManager.getPort())
+        {
+            continue;
+        }
+
+        cloneTargetPakManager_.setPort(port);
+        if(cloneTargetPakManager_.hasTransferPak())
+        {
+            found = true;
+            break;
+        }
+    }
+
+    if(!found)
+    {
+        setDialogDataText(diag_, "ERROR: Please connect a second controller with a transfer pak to clone to!");
+        return false;
+    }
+
+    cloneTargetPakManager_.setPower(true);
+    if(!cloneTargetPakManager_.readCartridgeHeader(targetHeader))
+    {
+        setDialogDataText(diag_, "ERROR: Could not read the cartridge in controller port %d!", static_cast<int>(cloneTargetPakManager_.getPort()) + 1);
+        cloneTargetPakManager_.setPower(false);
+        return false;
+    }
+
+    // only clone between cartridges of the same game. Otherwise we'd corrupt the target save.
+    if(memcmp(sourceHeader.new_title.title, targetHeader.new_title.title, 11) || sourceHeader.ram_size_code != targetHeader.ram_size_code)
+    {
+        setDialogDataText(diag_, "ERROR: The cartridge in controller port %d is not the same game!", static_cast<int>(cloneTargetPakManager_.getPort()) + 1);
+        cloneTargetPakManager_.setPower(false);
+        return false;
+    }
+
+    cloneTargetPakManager_.setRAMEnabled(true);
+    cloneTargetSaveManager_ = new TransferPakSaveManager(cloneTargetPakManager_);
+    return true;
 }
 
-void DataCopyScene::onDialogDone()
+void DataCopyScene::closeCloneTargetPak()
 {
-    deps_.sceneManager.goBackToPreviousScene();
+    if(!cloneTargetPakManager_.isPoweredOn())
+    {
+        return;
+    }
+
+    delete cloneTargetSaveManager_;
+    cloneTargetSaveManager_ = nullptr;
+
+    cloneTargetPakManager_.setRAMEnabled(false);
+    cloneTargetPakManager_.setPower(false);
+}
+
+bool DataCopyScene::findControllerPakPort(joypad_port_t& outPort) const
+{
+    for(int i = 0; i < JOYPAD_PORT_COUNT; ++i)
+    {
+        const joypad_port_t port = static_cast<joypad_port_t>(i);
+        if(port == deps_.tpakManager.getPort())
+        {
+            continue;
+        }
+
+        if(joypad_is_connected(port) && joypad_get_accessory_type(port) == JOYPAD_ACCESSORY_TYPE_CONTROLLER_PAK)
+        {
+            outPort = port;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DataCopyScene::fillSaveLibraryEntry(SaveLibraryEntry& entry, const gameboy_cartridge_header& gbHeader, const char* path)
+{
+    SaveChecksumRegion checksumRegion;
+    uint32_t playTimeOffset = 0;
+    uint8_t playTime[3];
+    // normally, the main checksum gets validated by the copy job while the save streams by (see addCopyJob()).
+    // We only need the game reader (and a separate pass over the save) if we don't know the checksum layout of the game
+    const bool validateChecksumWithReader = !getMainChecksumRegion(deps_.generation, deps_.specificGenVersion, deps_.localization, checksumRegion);
+
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.path, path, sizeof(entry.path) - 1);
+    memcpy(entry.gameTitle, gbHeader.new_title.title, 11);
+    strncpy(entry.trainerName, deps_.playerName, sizeof(entry.trainerName) - 1);
+    entry.generation = deps_.generation;
+    entry.specificGenVersion = deps_.specificGenVersion;
+
+    deps_.tpakManager.setRAMEnabled(true);
+
+    // the trainer ID is cached by the session
+    entry.trainerID = deps_.gameSession.getTrainerID();
+
+    if(deps_.gameSession.getGen1Reader())
+    {
+        const Gen1LocalizationLanguage language = static_cast<Gen1LocalizationLanguage>(deps_.localization);
+
+        if(validateChecksumWithReader && deps_.gameSession.getGen1Reader()->isMainChecksumValid())
+        {
+            entry.flags |= SAVE_LIBRARY_ENTRY_FLAG_CHECKSUM_VALID;
+        }
+        // the japanese games have a different save layout
+        if(language != Gen1LocalizationLanguage::JAPANESE)
+        {
+            playTimeOffset = GEN1_PLAYTIME_OFFSET;
+        }
+    }
+    else if(deps_.gameSession.getGen2Reader())
+    {
+        const Gen2LocalizationLanguage language = static_cast<Gen2LocalizationLanguage>(deps_.localization);
+        const Gen2GameType gameType = static_cast<Gen2GameType>(deps_.specificGenVersion);
+
+        if(validateChecksumWithReader && deps_.gameSession.getGen2Reader()->isMainChecksumValid())
+        {
+            entry.flags |= SAVE_LIBRARY_ENTRY_FLAG_CHECKSUM_VALID;
+        }
+        if(language != Gen2LocalizationLanguage::JAPANESE && language != Gen2LocalizationLanguage::KOREAN)
+        {
+            playTimeOffset = (gameType == Gen2GameType::CRYSTAL) ? GEN2_CRYSTAL_PLAYTIME_OFFSET : GEN2_GOLDSILVER_PLAYTIME_OFFSET;
+        }
+    }
+
+    if(playTimeOffset && saveManager_.seek(playTimeOffset) && saveManager_.read(playTime, sizeof(playTime)))
+    {
+        if(deps_.generation == 1)
+        {
+            // gen 1: hours (1 byte), a "maxed out" flag and minutes
+            entry.playTimeHours = playTime[0];
+            entry.playTimeMinutes = playTime[2];
+        }
+        else
+        {
+            // gen 2: hours (big endian 16 bit) and minutes
+            entry.playTimeHours = static_cast<uint16_t>((playTime[0] << 8) | playTime[1]);
+            entry.playTimeMinutes = playTime[2];
+        }
+        entry.flags |= SAVE_LIBRARY_ENTRY_FLAG_HAS_PLAYTIME;
+    }
+
+    // the copy job reads the save from the current position of saveManager_
+    saveManager_.seek(0);
 }
 
 void DataCopyScene::setupDialog(DialogWidgetStyle& style)
@@ -2,6 +2,9 @@
 #include "scenes/SceneManager.h"
 #include "scenes/StatsScene.h"
 #include "transferpak/TransferPakManager.h"
+#include "save/SaveUndoJournal.h"
+#include "save/SaveEditTransaction.h"
+#include "core/GameSession.h"
 
 static const Rectangle menuListBounds = {20, 20, 280, 0};
 static const Rectangle imgScrollArrowUpBounds = {.x = 154, .y = 14, .width = 11, .height = 6};
@@ -21,14 +24,14 @@ static void injectDistributionPokemon(void* context, const void* data)
 DistributionPokemonListScene::DistributionPokemonListScene(SceneDependencies& deps, void* context)
     : MenuScene(deps, context)
     , romReader_(deps.tpakManager)
-    , saveManager_(deps.tpakManager)
-    , gen1Reader_(romReader_, saveManager_, static_cast<Gen1GameType>(deps.specificGenVersion), static_cast<Gen1LocalizationLanguage>(deps.localization))
-    , gen2Reader_(romReader_, saveManager_, static_cast<Gen2GameType>(deps.specificGenVersion), static_cast<Gen2LocalizationLanguage>(deps.localization))
     , iconFactory_(romReader_)
     , customListFiller_(menuList_)
     , diag_()
+    , summaryDiag_()
     , iconBackgroundSprite_(nullptr)
     , pokeToInject_(nullptr)
+    , bulkInjectionPending_(false)
+    , startButtonPressed_(false)
 {
 }
 
@@ -63,10 +66,30 @@ bool DistributionPokemonListScene::handleUserInput(joypad_port_t port, const joy
         pokeToInject_ = nullptr;
         return true;
     }
-    else
+    else if(bulkInjectionPending_)
     {
-        return MenuScene::handleUserInput(port, inputs);
+        injectAllPokemon();
+        bulkInjectionPending_ = false;
+        return true;
     }
+    else if(MenuScene::handleUserInput(port, inputs))
+    {
+        return true;
+    }
+
+    // the start button receives all pokémon of the list at once. Like the B button, we only act on its release
+    if(inputs.btn.start && !startButtonPressed_)
+    {
+        startButtonPressed_ = true;
+        return true;
+    }
+    else if(!inputs.btn.start && startButtonPressed_)
+    {
+        startButtonPressed_ = false;
+        triggerBulkInjection();
+        return true;
+    }
+    return false;
 }
 
 void DistributionPokemonListScene::triggerPokemonInjection(const void* data)
@@ -87,6 +110,10 @@ void DistributionPokemonListScene::injectPokemon(const void* data)
 
     deps_.tpakManager.setRAMEnabled(true);
 
+    // keep the original contents of the blocks we modify on the SD card, so the injection can be undone
+    SaveUndoJournal undoJournal(deps_.tpakManager);
+    undoJournal.begin();
+
     statsContext = new StatsSceneContext{
         .showReceivedPokemonDialog = true
     };
@@ -96,23 +123,23 @@ void DistributionPokemonListScene::injectPokemon(const void* data)
     case DistributionPokemonListType::GEN1:
         g1Poke = static_cast<const Gen1DistributionPokemon*>(data);
         statsContext->poke_g1 = g1Poke->poke;
-        // I have not used gen1Reader_->addDistributionPokemon here because I want to show the resulting pokemon in a stats screen
+        // I have not used Gen1GameReader::addDistributionPokemon here because I want to show the resulting pokemon in a stats screen
         // gen1_prepareDistributionPokemon() + addPokemon() gives me access to the resulting Gen1TrainerPokemon instance
         // in which things are done like IV generation, OT name decision, OT id
-        gen1_prepareDistributionPokemon(gen1Reader_, (*g1Poke), statsContext->poke_g1, trainerName);
-        gen1Reader_.addPokemon(statsContext->poke_g1, trainerName);
+        gen1_prepareDistributionPokemon(*deps_.gameSession.getGen1Reader(), (*g1Poke), statsContext->poke_g1, trainerName);
+        deps_.gameSession.getGen1Reader()->addPokemon(statsContext->poke_g1, trainerName);
         break;
     case DistributionPokemonListType::GEN2:
     case DistributionPokemonListType::GEN2_POKEMON_CENTER_NEW_YORK:
         g2Poke = static_cast<const Gen2DistributionPokemon*>(data);
         statsContext->poke_g2 = g2Poke->poke;
         statsContext->isEgg = g2Poke->isEgg;
-        // I have not used gen2Reader_->addDistributionPokemon here because I want to show the resulting pokemon in a stats screen
+        // I have not used Gen2GameReader::addDistributionPokemon here because I want to show the resulting pokemon in a stats screen
         // gen2_prepareDistributionPokemon() + addPokemon() gives me access to the resulting Gen2TrainerPokemon instance
         // in which things are done like IV generation, OT name decision, OT id, shininess
-        gen2_prepareDistributionPokemon(gen2Reader_, (*g2Poke), statsContext->poke_g2, trainerName);
-        gen2Reader_.addPokemon(statsContext->poke_g2, g2Poke->isEgg, trainerName);
-        gen2Reader_.finishSave();
+        gen2_prepareDistributionPokemon(*deps_.gameSession.getGen2Reader(), (*g2Poke), statsContext->poke_g2, trainerName);
+        deps_.gameSession.getGen2Reader()->addPokemon(statsContext->poke_g2, g2Poke->isEgg, trainerName);
+        deps_.gameSession.getGen2Reader()->finishSave();
         break;
     default:
         debugf("%s: ERROR: got DistributionPokemonListType::INVALID! This should never happen!\r\n", __FUNCTION__);
@@ -133,6 +160,9 @@ void DistributionPokemonListScene::injectPokemon(const void* data)
     }
 
     deps_.tpakManager.finishWrites();
+    undoJournal.end();
+    // the pokémon was added with the game reader directly, so the cached party is outdated
+    deps_.gameSession.invalidate();
 
     // The reason is the same as previous setRAMEnabled(false) statement above
     deps_.tpakManager.setRAMEnabled(false);
@@ -143,6 +173,116 @@ void DistributionPokemonListScene::injectPokemon(const void* data)
     // operation done. Now the dialog can be advanced and we can show confirmation that the user got the pokémon
 }
 
+void DistributionPokemonListScene::triggerBulkInjection()
+{
+    if(!context_->numMenuEntries)
+    {
+        return;
+    }
+    bulkInjectionPending_ = true;
+
+    setDialogDataText(diag_, "Saving all Pokémon... Don't turn off the power.");
+    diag_.userAdvanceBlocked = true;
+    showDialog(&diag_);
+}
+
+void DistributionPokemonListScene::injectAllPokemon()
+{
+    const DistributionPokemonMenuItemData* entries = static_cast<const DistributionPokemonMenuItemData*>(context_->menuEntries);
+    const DistributionPokemonListType listType = convert(context_)->listType;
+    const uint32_t numEntries = context_->numMenuEntries;
+    const Gen1DistributionPokemon* g1DistributionPoke;
+    const Gen2DistributionPokemon* g2DistributionPoke;
+    Gen1TrainerPokemon g1Poke;
+    Gen2TrainerPokemon g2Poke;
+    const char* trainerName;
+    uint16_t numRanges;
+    uint16_t numBlocksWritten = 0;
+    uint8_t numQueued = 0;
+    uint8_t numReceived;
+    bool queued;
+    bool success;
+
+    deps_.tpakManager.setRAMEnabled(true);
+
+    // allocated on the heap because of the size of the queued edits.
+    // The OT name and ID of the distribution pokémon are read through the readers of the transaction as well: the ones of the GameSession
+    // share the SRAM with it while the transaction is open.
+    SaveEditTransaction* transaction = new SaveEditTransaction(deps_.tpakManager, deps_.generation, deps_.specificGenVersion, deps_.localization);
+
+    for(uint32_t i = 0; i < numEntries; ++i)
+    {
+        switch(listType)
+        {
+        case DistributionPokemonListType::GEN1:
+            g1DistributionPoke = static_cast<const Gen1DistributionPokemon*>(entries[i].itemParam);
+            g1Poke = g1DistributionPoke->poke;
+            gen1_prepareDistributionPokemon(*transaction->getGen1Reader(), (*g1DistributionPoke), g1Poke, trainerName);
+            queued = transaction->addGen1Pokemon(g1Poke, trainerName);
+            break;
+        case DistributionPokemonListType::GEN2:
+        case DistributionPokemonListType::GEN2_POKEMON_CENTER_NEW_YORK:
+            g2DistributionPoke = static_cast<const Gen2DistributionPokemon*>(entries[i].itemParam);
+            g2Poke = g2DistributionPoke->poke;
+            gen2_prepareDistributionPokemon(*transaction->getGen2Reader(), (*g2DistributionPoke), g2Poke, trainerName);
+            queued = transaction->addGen2Pokemon(g2Poke, g2DistributionPoke->isEgg, trainerName);
+            break;
+        default:
+            queued = false;
+            break;
+        }
+
+        if(!queued)
+        {
+            break;
+        }
+        ++numQueued;
+    }
+
+    // apply everything in RAM first, so we know how many pokémon actually found a spot before anything gets written
+    transaction->dryRun(nullptr, 0, numRanges);
+    numReceived = numQueued - transaction->getNumberOfFailedEdits();
+
+    // keep the original contents of the blocks we modify on the SD card, so the injection can be undone
+    SaveUndoJournal undoJournal(deps_.tpakManager);
+    undoJournal.begin();
+    success = transaction->commit(numBlocksWritten);
+    deps_.tpakManager.finishWrites();
+    undoJournal.end();
+
+    delete transaction;
+    transaction = nullptr;
+
+    // the pokémon were added behind the back of the session, so the cached party is outdated
+    deps_.gameSession.invalidate();
+    /* Quote:
+     * "It is recommended to disable external RAM after accessing it, in order to protect its contents from corruption
+     *  during power down of the Game Boy or removal of the cartridge."
+     *
+     * source: https://gbdev.io/pandocs/MBC1.html
+     */
+    deps_.tpakManager.setRAMEnabled(false);
+
+    debugf("[DistributionPokemonListScene]: bulk injection: %hu of %lu pokémon received, %u blocks written\r\n", numReceived, numEntries, numBlocksWritten);
+
+    if(!success)
+    {
+        setDialogDataText(summaryDiag_, "ERROR: Something went wrong while saving the Pokémon to the cartridge!");
+    }
+    else if(numReceived < numEntries)
+    {
+        setDialogDataText(summaryDiag_, "%s received %hu of %lu Pokémon! The others didn't fit in the party or the current PC box.", deps_.playerName, numReceived, numEntries);
+    }
+    else
+    {
+        setDialogDataText(summaryDiag_, "%s received all %lu Pokémon!", deps_.playerName, numEntries);
+    }
+
+    // the summary replaces the stats scene of the single injection. Once it's done, we go back to the previous menu.
+    diag_.userAdvanceBlocked = false;
+    showDialog(&summaryDiag_);
+}
+
 void DistributionPokemonListScene::onDialogDone()
 {
     if(diag_.userAdvanceBlocked)
@@ -287,7 +427,7 @@ void DistributionPokemonListScene::loadDistributionPokemonList()
                 .generation = deps_.generation,
                 .specificGenVersion = deps_.specificGenVersion,
                 .localization = deps_.localization,
-                .iconType = (uint8_t)gen1Reader_.getPokemonIconType(gen1List[i]->poke.poke_index)
+                .iconType = deps_.gameSession.getSpeciesTables().getPokemonIconType(gen1List[i]->poke.poke_index)
             };
         }
     }
@@ -303,7 +443,7 @@ void DistributionPokemonListScene::loadDistributionPokemonList()
             }
             else
             {
-                iconType = (uint8_t)gen2Reader_.getPokemonIconType(gen2List[i]->poke.poke_index);
+                iconType = deps_.gameSession.getSpeciesTables().getPokemonIconType(gen2List[i]->poke.poke_index);
             }
 
             menuEntry->title = gen2List[i]->name;
@@ -1,16 +1,16 @@
 #include "scenes/InitTransferPakScene.h"
 #include "scenes/MenuScene.h"
 #include "scenes/SceneManager.h"
+#include "scenes/SelectFileScene.h"
 #include "transferpak/TransferPakManager.h"
-#include "transferpak/TransferPakRomReader.h"
-#include "transferpak/TransferPakSaveManager.h"
-#include "gen1/Gen1GameReader.h"
-#include "gen2/Gen2GameReader.h"
+#include "core/GameSession.h"
 #include "menu/MenuEntries.h"
+#include "core/DragonUtils.h"
 
 #include <unistd.h>
 
 static const Rectangle tpakDetectWidgetBounds = {60, 44, 200, 116};
+static const Rectangle virtualCartridgeHintBounds = {0, 210, 320, 16};
 
 
 static void dialogFinishedCallback(void* context)
@@ -25,8 +25,9 @@ static void tpakWidgetStateChangedCallback(void* context, TransferPakWidgetState
     scene->onTransferPakWidgetStateChanged(newState);
 }
 
-InitTransferPakScene::InitTransferPakScene(SceneDependencies& deps, void*)
+InitTransferPakScene::InitTransferPakScene(SceneDependencies& deps, void* context)
     : SceneWithDialogWidget(deps)
+    , context_((InitTransferPakSceneContext*)context)
     , menu9SliceSprite_(nullptr)
     , tpakDetectWidget_(deps.animationManager, deps.tpakManager)
     , tpakDetectWidgetSegment_(WidgetFocusChainSegment{
@@ -35,6 +36,9 @@ InitTransferPakScene::InitTransferPakScene(SceneDependencies& deps, void*)
     , diagData_({0})
     , pokeMe64TextSettings_()
     , gameTypeString_(nullptr)
+    , randomSeed_(0)
+    , startButtonPressed_(false)
+    , virtualCartridgeFailed_(false)
 {
 }
 
@@ -65,6 +69,19 @@ void InitTransferPakScene::init()
     {
         randomSeed_ += static_cast<unsigned int>(systemEntropy[i]) << (i * 8);
     }
+
+    if(context_ && context_->virtualCartridgeSavePath.get())
+    {
+        // from now on, the .sav file replaces the cartridge in the transfer pak
+        if(!deps_.tpakManager.openVirtualCartridge(context_->virtualCartridgeSavePath.get()))
+        {
+            virtualCartridgeFailed_ = true;
+            setDialogDataText(diagData_, "We could not load %s!", context_->virtualCartridgeSavePath.get());
+            dialogWidget_.appendDialogData(&diagData_);
+            dialogWidget_.setVisible(true);
+            setFocusChain(&dialogFocusChainSegment_);
+        }
+    }
 }
 
 void InitTransferPakScene::destroy()
@@ -80,13 +97,50 @@ void InitTransferPakScene::render(RDPQGraphics& gfx, const Rectangle& sceneBound
     gfx.drawText(Rectangle{0, 10, 320, 16}, "PokeMe64 by risingPhil. Version 0.3", pokeMe64TextSettings_);
     tpakDetectWidget_.render(gfx, sceneBounds);
 
+    if(sdcard_mounted && !deps_.tpakManager.isVirtualCartridge() && tpakDetectWidget_.getState() == TransferPakWidgetState::UNKNOWN)
+    {
+        gfx.drawText(virtualCartridgeHintBounds, "Press START to load a .sav file instead", pokeMe64TextSettings_);
+    }
+
     SceneWithDialogWidget::render(gfx, sceneBounds);
 }
 
+bool InitTransferPakScene::handleUserInput(joypad_port_t port, const joypad_inputs_t& inputs)
+{
+    if(SceneWithDialogWidget::handleUserInput(port, inputs))
+    {
+        return true;
+    }
+
+    // we only handle the start button release
+    if(inputs.btn.start && !startButtonPressed_)
+    {
+        startButtonPressed_ = true;
+        return true;
+    }
+    else if(!inputs.btn.start && startButtonPressed_)
+    {
+        startButtonPressed_ = false;
+        if(sdcard_mounted && !deps_.tpakManager.isVirtualCartridge() && tpakDetectWidget_.getState() == TransferPakWidgetState::UNKNOWN)
+        {
+            goToVirtualCartridgeFileSelection();
+        }
+        return true;
+    }
+    return false;
+}
+
 void InitTransferPakScene::onDialogDone()
 {
     MenuSceneContext* menuContext = nullptr;
 
+    if(virtualCartridgeFailed_)
+    {
+        // back to the file selection
+        deps_.sceneManager.goBackToPreviousScene();
+        return;
+    }
+
     if(tpakDetectWidget_.getState() == TransferPakWidgetState::NO_SAVE_FOUND)
     {
         menuContext = new MenuSceneContext{
@@ -150,6 +204,7 @@ void InitTransferPakScene::onTransferPakWidgetStateChanged(TransferPakWidgetStat
     if(newState == TransferPakWidgetState::VALID_SAVE_FOUND)
     {
         debugf("[InitTransferPakScene]: Game found!\r\n");
+        const uint64_t metadataStartTime = get_ticks();
         loadGameType();
         deps_.tpakManager.setRAMEnabled(true);
         loadSaveMetadata();
@@ -165,7 +220,17 @@ void InitTransferPakScene::onTransferPakWidgetStateChanged(TransferPakWidgetStat
          */
         deps_.tpakManager.setRAMEnabled(false); 
 
-        setDialogDataText(diagData_, "Hi %s! We've detected Pokémon %s in the N64 Transfer Pak. Let's go!", deps_.playerName, gameTypeString_);
+        const uint64_t now = get_ticks();
+        debugf("[InitTransferPakScene]: loading the save metadata took %lu ms, %lu ms since the start of the detection\r\n", static_cast<uint32_t>(TICKS_TO_MS(now - metadataStartTime)), static_cast<uint32_t>(TICKS_TO_MS(now - tpakDetectWidget_.getDetectionStartTime())));
+
+        if(deps_.tpakManager.isVirtualCartridge())
+        {
+            setDialogDataText(diagData_, "Hi %s! We've loaded your Pokémon %s save from the SD card. Let's go!", deps_.playerName, gameTypeString_);
+        }
+        else
+        {
+            setDialogDataText(diagData_, "Hi %s! We've detected Pokémon %s in the N64 Transfer Pak. Let's go!", deps_.playerName, gameTypeString_);
+        }
         dialogWidget_.appendDialogData(&diagData_);
         dialogWidget_.setVisible(true);
         setFocusChain(&dialogFocusChainSegment_);
@@ -175,7 +240,14 @@ void InitTransferPakScene::onTransferPakWidgetStateChanged(TransferPakWidgetStat
         debugf("[InitTransferPakScene]: Game found, but no save found!\r\n");
         loadGameType();
 
-        setDialogDataText(diagData_, "We can't find a save in your Pokemon %s cartridge. You'll only be able to backup/restore!", gameTypeString_);
+        if(deps_.tpakManager.isVirtualCartridge())
+        {
+            setDialogDataText(diagData_, "The .sav file doesn't contain a valid Pokemon %s save. You'll only be able to backup/restore!", gameTypeString_);
+        }
+        else
+        {
+            setDialogDataText(diagData_, "We can't find a save in your Pokemon %s cartridge. You'll only be able to backup/restore!", gameTypeString_);
+        }
         dialogWidget_.appendDialogData(&diagData_);
         dialogWidget_.setVisible(true);
         setFocusChain(&dialogFocusChainSegment_);
@@ -187,7 +259,15 @@ void InitTransferPakScene::onTransferPakWidgetStateChanged(TransferPakWidgetStat
         case TransferPakWidgetState::GB_HEADER_VALIDATION_FAILED:
         case TransferPakWidgetState::NO_GAME_FOUND:
         case TransferPakWidgetState::NO_TRANSFER_PAK_FOUND:
-            setDialogDataText(diagData_, "We could not find a suitable game cartridge! Please turn the console off and try again!");
+            if(deps_.tpakManager.isVirtualCartridge())
+            {
+                // without a ROM file next to the .sav file, we need the cartridge in the transfer pak for the ROM
+                setDialogDataText(diagData_, "We could not find a .gb file next to the .sav file, nor a suitable game cartridge! Please turn the console off and try again!");
+            }
+            else
+            {
+                setDialogDataText(diagData_, "We could not find a suitable game cartridge! Please turn the console off and try again!");
+            }
             diagData_.userAdvanceBlocked = true;
             dialogWidget_.appendDialogData(&diagData_);
             dialogWidget_.setVisible(true);
@@ -282,8 +362,6 @@ void InitTransferPakScene::loadGameType()
 
 void InitTransferPakScene::loadSaveMetadata()
 {
-    TransferPakRomReader romReader(deps_.tpakManager);
-    TransferPakSaveManager saveManager(deps_.tpakManager);
     Gen1GameType gen1Type;
     Gen2GameType gen2Type;
     uint16_t trainerID = 0;
@@ -292,22 +370,24 @@ void InitTransferPakScene::loadSaveMetadata()
 
     if(gen1Type != Gen1GameType::INVALID)
     {
-        const Gen1LocalizationLanguage language = gen1_determineGameLanguage(romReader, gen1Type);
+        // the language was already determined by the widget while it was validating the save
+        const Gen1LocalizationLanguage language = static_cast<Gen1LocalizationLanguage>(tpakDetectWidget_.getLocalization());
 
-        Gen1GameReader gameReader(romReader, saveManager, gen1Type, language);
-        const char* trainerName = gameReader.getTrainerName();
-        trainerID = gameReader.getTrainerID();
         deps_.localization = static_cast<uint8_t>(language);
+        // from now on, everything uses the game reader of the session
+        deps_.gameSession.start(1, static_cast<uint8_t>(gen1Type), deps_.localization);
+        const char* trainerName = deps_.gameSession.getTrainerName();
+        trainerID = deps_.gameSession.getTrainerID();
         strncpy(deps_.playerName, trainerName, sizeof(deps_.playerName) - 1);
     }
     else if(gen2Type != Gen2GameType::INVALID)
     {
-        const Gen2LocalizationLanguage language = gen2_determineGameLanguage(romReader, gen2Type);
+        const Gen2LocalizationLanguage language = static_cast<Gen2LocalizationLanguage>(tpakDetectWidget_.getLocalization());
 
-        Gen2GameReader gameReader(romReader, saveManager, gen2Type, language);
-        const char* trainerName = gameReader.getTrainerName();
-        trainerID = gameReader.getTrainerID();
         deps_.localization = static_cast<uint8_t>(language);
+        deps_.gameSession.start(2, static_cast<uint8_t>(gen2Type), deps_.localization);
+        const char* trainerName = deps_.gameSession.getTrainerName();
+        trainerID = deps_.gameSession.getTrainerID();
         if(language != Gen2LocalizationLanguage::KOREAN)
         {
             strncpy(deps_.playerName, trainerName, sizeof(deps_.playerName) - 1);
@@ -326,3 +406,28 @@ void InitTransferPakScene::loadSaveMetadata()
         randomSeed_ += deps_.playerName[i];
     }
 }
+
+void InitTransferPakScene::goToVirtualCartridgeFileSelection()
+{
+    auto nextSceneContext = new InitTransferPakSceneContext{
+        .virtualCartridgeSavePath = nullptr
+    };
+
+    auto fileSelectContext = new SelectFileSceneContext{
+        .titleText = "Select Save file",
+        .nextScene = {
+            .type = SceneType::INIT_TRANSFERPAK,
+            .context = nextSceneContext,
+            .deleteContextFunc = deleteInitTransferPakSceneContext
+        },
+        .initialPath = nullptr,
+        .fileExtensionFilter = ".sav"
+    };
+    deps_.sceneManager.switchScene(SceneType::SELECT_FILE, deleteSelectFileSceneContext, fileSelectContext);
+}
+
+void deleteInitTransferPakSceneContext(void* context)
+{
+    auto sceneContext = (InitTransferPakSceneContext*)context;
+    delete sceneContext;
+}
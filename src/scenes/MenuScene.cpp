@@ -10,6 +10,7 @@
 static const Rectangle menuListBounds = {100, 30, 160, 0};
 static const Rectangle imgScrollArrowUpBounds = {.x = 170, .y = 24, .width = 11, .height = 6};
 static const Rectangle imgScrollArrowDownBounds = {.x = 170, .y = 180, .width = 11, .height = 6};
+static const uint16_t SPECIES_TABLES_SPECIES_PER_FRAME = 8;
 
 static void dialogFinishedCallback(void* context)
 {
@@ -92,6 +93,10 @@ void MenuScene::destroy()
 
 void MenuScene::render(RDPQGraphics& gfx, const Rectangle& sceneBounds)
 {
+    // The menu is where the user ends up right after the game was detected. So this is where we fill the species tables
+    // of the session. Other scenes may be running multi-frame transfer pak jobs of their own, so we don't do it there.
+    deps_.gameSession.stepSpeciesTables(SPECIES_TABLES_SPECIES_PER_FRAME);
+
     menuList_.render(gfx, sceneBounds);
     cursorWidget_.render(gfx, sceneBounds);
     SceneWithDialogWidget::render(gfx, sceneBounds);
@@ -123,7 +128,23 @@ bool MenuScene::handleUserInput(joypad_port_t port, const joypad_inputs_t& input
                 .shouldDeleteWhenDone = true
             };
 
-            setDialogDataText(*diag, "Please turn the console off to switch gameboy cartridges!");
+            if(deps_.tpakManager.isVirtualCartridge())
+            {
+                // every edit already wrote back its changes when it was done. But if one of those write backs failed,
+                // the changes are still in RAM and this is the last chance to get them into the .sav file
+                if(deps_.tpakManager.writeBackVirtualCartridge())
+                {
+                    setDialogDataText(*diag, "Your changes were written to the .sav file. Please turn the console off to switch saves!");
+                }
+                else
+                {
+                    setDialogDataText(*diag, "ERROR: We could not write your changes to the .sav file!");
+                }
+            }
+            else
+            {
+                setDialogDataText(*diag, "Please turn the console off to switch gameboy cartridges!");
+            }
 
             showDialog(diag);
         }
@@ -0,0 +1,611 @@
+#include "scenes/PokemonBoxBrowserScene.h"
+#include "scenes/SceneManager.h"
+#include "scenes/StatsScene.h"
+#include "transferpak/TransferPakManager.h"
+#include "core/GameSession.h"
+#include "core/DragonUtils.h"
+
+#include <cstring>
+
+static const Rectangle headerBounds = {20, 6, 280, 16};
+static const Rectangle emptyBoxBounds = {20, 40, 280, 16};
+static const Rectangle menuListBounds = {20, 26, 280, 0};
+static const Rectangle imgScrollArrowUpBounds = {.x = 154, .y = 20, .width = 11, .height = 6};
+static const Rectangle imgScrollArrowDownBounds = {.x = 154, .y = 220, .width = 11, .height = 6};
+
+static const PokemonBoxSortKey SORT_BY_SPECIES = PokemonBoxSortKey::SPECIES;
+static const PokemonBoxSortKey SORT_BY_LEVEL = PokemonBoxSortKey::LEVEL;
+
+static void openBoxSlot(void* context, const void* param)
+{
+    auto scene = static_cast<PokemonBoxBrowserScene*>(context);
+    scene->openSlot(*static_cast<const PokemonBoxIndexEntry*>(param));
+}
+
+static void chooseSortKey(void* context, const void* param)
+{
+    auto scene = static_cast<PokemonBoxBrowserScene*>(context);
+    scene->onSortKeyChosen(*static_cast<const PokemonBoxSortKey*>(param));
+}
+
+static void cancelSort(void* context, const void* param)
+{
+    auto scene = static_cast<PokemonBoxBrowserScene*>(context);
+    scene->advanceDialog();
+}
+
+PokemonBoxBrowserScene::PokemonBoxBrowserScene(SceneDependencies& deps, void* context)
+    : MenuScene(deps, context)
+    , romReader_(deps.tpakManager)
+    , iconFactory_(romReader_)
+    , customListFiller_(menuList_)
+    , itemStyle_()
+    , entries_()
+    , titles_()
+    , headerText_()
+    , headerTextSettings_()
+    , diag_()
+    , exporter_(deps.tpakManager)
+    , sorter_(deps.tpakManager)
+    , timeCapsule_(deps.tpakManager)
+    , sortDiag_()
+    , sortOptions_()
+    , boxIndex_(nullptr)
+    , iconBackgroundSprite_(nullptr)
+    , currentBox_(0)
+    , numEntries_(0)
+    , boxSwitchButtonPressed_(false)
+    , startButtonPressed_(false)
+    , zButtonPressed_(false)
+    , cRightButtonPressed_(false)
+    , sortKey_(PokemonBoxSortKey::SPECIES)
+    , sortKeyChosen_(false)
+    , sortPending_(false)
+    , timeCapsulePending_(false)
+{
+}
+
+PokemonBoxBrowserScene::~PokemonBoxBrowserScene()
+{
+}
+
+void PokemonBoxBrowserScene::init()
+{
+    iconBackgroundSprite_ = sprite_load("rom://bg-party-icon.sprite");
+
+    // this is the only time we read the boxes from the save (unless the session was invalidated in the meantime)
+    deps_.tpakManager.setRAMEnabled(true);
+    boxIndex_ = deps_.gameSession.getBoxIndex();
+    deps_.tpakManager.setRAMEnabled(false);
+
+    if(boxIndex_)
+    {
+        loadBox(boxIndex_->getCurrentBoxIndex());
+    }
+
+    headerTextSettings_ = TextRenderSettings{
+        .fontId = mainFontId_,
+        .fontStyleId = fontStyleWhiteId_,
+        .halign = ALIGN_CENTER
+    };
+
+    MenuScene::init();
+
+    if(!boxIndex_)
+    {
+        setDialogDataText(diag_, "Sorry! The PC boxes of this game can't be shown.");
+        showDialog(&diag_);
+    }
+}
+
+void PokemonBoxBrowserScene::destroy()
+{
+    menuList_.clearWidgets();
+    customListFiller_.deleteWidgets();
+
+    MenuScene::destroy();
+
+    sprite_free(iconBackgroundSprite_);
+    iconBackgroundSprite_ = nullptr;
+}
+
+void PokemonBoxBrowserScene::render(RDPQGraphics& gfx, const Rectangle& sceneBounds)
+{
+    if(boxIndex_)
+    {
+        gfx.drawText(headerBounds, headerText_, headerTextSettings_);
+        if(!numEntries_)
+        {
+            gfx.drawText(emptyBoxBounds, "This box is empty.", headerTextSettings_);
+        }
+    }
+    MenuScene::render(gfx, sceneBounds);
+}
+
+bool PokemonBoxBrowserScene::handleUserInput(joypad_port_t port, const joypad_inputs_t& inputs)
+{
+    int8_t direction;
+
+    if(exporter_.isStarted() && !exporter_.isFinished())
+    {
+        stepExport();
+        return true;
+    }
+    else if(sortKeyChosen_)
+    {
+        // show the "Sorting..." dialog first. The sort itself happens on the next call
+        sortKeyChosen_ = false;
+        sortPending_ = true;
+        setDialogDataText(diag_, "Sorting all boxes... Don't turn off the power.");
+        diag_.userAdvanceBlocked = true;
+        showDialog(&diag_);
+        return true;
+    }
+    else if(sortPending_)
+    {
+        sortBoxes();
+        return true;
+    }
+    else if(timeCapsulePending_)
+    {
+        moveBoxToOtherCartridge();
+        return true;
+    }
+    else if(MenuScene::handleUserInput(port, inputs))
+    {
+        return true;
+    }
+    if(!boxIndex_)
+    {
+        return false;
+    }
+
+    // like the B button, we only act on the release of the start button
+    if(inputs.btn.start && !startButtonPressed_)
+    {
+        startButtonPressed_ = true;
+        return true;
+    }
+    else if(!inputs.btn.start && startButtonPressed_)
+    {
+        startButtonPressed_ = false;
+        startExport();
+        return true;
+    }
+
+    if(inputs.btn.z && !zButtonPressed_)
+    {
+        zButtonPressed_ = true;
+        return true;
+    }
+    else if(!inputs.btn.z && zButtonPressed_)
+    {
+        zButtonPressed_ = false;
+        showSortOptions();
+        return true;
+    }
+
+    if(inputs.btn.c_right && !cRightButtonPressed_)
+    {
+        cRightButtonPressed_ = true;
+        return true;
+    }
+    else if(!inputs.btn.c_right && cRightButtonPressed_)
+    {
+        cRightButtonPressed_ = false;
+        // show the dialog first: finding and reading the other cartridge takes a moment
+        timeCapsulePending_ = true;
+        setDialogDataText(diag_, "Moving box %hu to the other cartridge... Don't turn off the power.", static_cast<uint8_t>(currentBox_ + 1));
+        diag_.userAdvanceBlocked = true;
+        showDialog(&diag_);
+        return true;
+    }
+
+    if(inputs.btn.l || inputs.btn.d_left)
+    {
+        direction = -1;
+    }
+    else if(inputs.btn.r || inputs.btn.d_right)
+    {
+        direction = 1;
+    }
+    else
+    {
+        direction = 0;
+    }
+
+    // switch only once per button press
+    if(direction && !boxSwitchButtonPressed_)
+    {
+        boxSwitchButtonPressed_ = true;
+        switchBox(direction);
+        return true;
+    }
+    else if(!direction)
+    {
+        boxSwitchButtonPressed_ = false;
+    }
+    return false;
+}
+
+void PokemonBoxBrowserScene::onDialogDone()
+{
+    if(!boxIndex_)
+    {
+        // there's nothing to browse
+        deps_.sceneManager.goBackToPreviousScene();
+        return;
+    }
+    MenuScene::onDialogDone();
+    // the list items have their own focus indication
+    cursorWidget_.setVisible(false);
+}
+
+void PokemonBoxBrowserScene::openSlot(const PokemonBoxIndexEntry& entry)
+{
+    const uint8_t slotIndex = static_cast<uint8_t>(&entry - boxIndex_->getEntry(currentBox_, 0));
+    const char* trainerName;
+    const char* nickname;
+    bool success;
+
+    auto statsContext = new StatsSceneContext{
+        .showReceivedPokemonDialog = false,
+        .isEgg = ((entry.flags & POKEMON_BOX_INDEX_FLAG_EGG) != 0)
+    };
+
+    // now we need the full record of this slot
+    deps_.tpakManager.setRAMEnabled(true);
+    if(deps_.generation == 1)
+    {
+        Gen1Box box = deps_.gameSession.getGen1Reader()->getBox(currentBox_);
+        success = box.getPokemon(slotIndex, statsContext->poke_g1);
+        trainerName = box.getOriginalTrainerOfPokemon(slotIndex);
+        strncpy(statsContext->trainerName, trainerName, sizeof(statsContext->trainerName) - 1);
+        nickname = box.getPokemonNickname(slotIndex);
+        strncpy(statsContext->nickname, nickname, sizeof(statsContext->nickname) - 1);
+    }
+    else
+    {
+        Gen2Box box = deps_.gameSession.getGen2Reader()->getBox(currentBox_);
+        success = box.getPokemon(slotIndex, statsContext->poke_g2, statsContext->isEgg);
+        trainerName = box.getOriginalTrainerOfPokemon(slotIndex);
+        strncpy(statsContext->trainerName, trainerName, sizeof(statsContext->trainerName) - 1);
+        nickname = box.getPokemonNickname(slotIndex);
+        strncpy(statsContext->nickname, nickname, sizeof(statsContext->nickname) - 1);
+    }
+    deps_.tpakManager.setRAMEnabled(false);
+
+    if(!success)
+    {
+        debugf("[PokemonBoxBrowserScene]: ERROR: could not read box %hu slot %hu\r\n", currentBox_, slotIndex);
+        delete statsContext;
+        setDialogDataText(diag_, "ERROR: Could not read this Pokémon from the save!");
+        showDialog(&diag_);
+        return;
+    }
+
+    deps_.sceneManager.switchScene(SceneType::STATS, deleteStatsSceneContext, statsContext);
+}
+
+void PokemonBoxBrowserScene::onSortKeyChosen(PokemonBoxSortKey key)
+{
+    sortKey_ = key;
+    sortKeyChosen_ = true;
+}
+
+void PokemonBoxBrowserScene::startExport()
+{
+    deps_.tpakManager.setRAMEnabled(true);
+    const bool started = exporter_.start(deps_.generation, deps_.specificGenVersion, deps_.localization, deps_.playerName);
+    deps_.tpakManager.setRAMEnabled(false);
+
+    if(!started)
+    {
+        setDialogDataText(diag_, (sdcard_mounted) ? "ERROR: Could not create the export directory on the SD card!" : "ERROR: SD card is not mounted!");
+        showDialog(&diag_);
+        return;
+    }
+
+    setDialogDataText(diag_, "Exporting all Pokémon... 0%%");
+    diag_.userAdvanceBlocked = true;
+    showDialog(&diag_);
+}
+
+void PokemonBoxBrowserScene::stepExport()
+{
+    deps_.tpakManager.setRAMEnabled(true);
+    const bool finished = exporter_.step();
+    deps_.tpakManager.setRAMEnabled(false);
+
+    if(!finished)
+    {
+        setDialogDataText(diag_, "Exporting all Pokémon... %hu%%", exporter_.getProgress());
+        return;
+    }
+
+    if(exporter_.hasFailed())
+    {
+        setDialogDataText(diag_, "ERROR: Could not export all Pokémon! %u were written to %s", exporter_.getNumberOfExportedPokemon(), exporter_.getOutputDirectory());
+    }
+    else
+    {
+        setDialogDataText(diag_, "Exported %u Pokémon to %s", exporter_.getNumberOfExportedPokemon(), exporter_.getOutputDirectory());
+    }
+    diag_.userAdvanceBlocked = false;
+}
+
+void PokemonBoxBrowserScene::showSortOptions()
+{
+    sortOptions_[0] = MenuItemData{
+        .title = "Species",
+        .onConfirmAction = chooseSortKey,
+        .context = this,
+        .itemParam = &SORT_BY_SPECIES
+    };
+    sortOptions_[1] = MenuItemData{
+        .title = "Level",
+        .onConfirmAction = chooseSortKey,
+        .context = this,
+        .itemParam = &SORT_BY_LEVEL
+    };
+    sortOptions_[2] = MenuItemData{
+        .title = "Cancel",
+        .onConfirmAction = cancelSort,
+        .context = this
+    };
+
+    sortDiag_ = DialogData{
+        .options = {
+            .items = sortOptions_,
+            .number = 3,
+            .shouldDeleteWhenDone = false
+        },
+        .shouldDeleteWhenDone = false
+    };
+    setDialogDataText(sortDiag_, "Sort all boxes by...");
+    showDialog(&sortDiag_);
+}
+
+void PokemonBoxBrowserScene::sortBoxes()
+{
+    PokemonBoxSortResult result;
+    bool success;
+
+    sortPending_ = false;
+
+    deps_.tpakManager.setRAMEnabled(true);
+    success = sorter_.sortBoxes(*boxIndex_, sortKey_, deps_.gameSession.getSpeciesTables(), deps_.generation, deps_.specificGenVersion, deps_.localization, result);
+    if(result.numSortedBoxes || !success)
+    {
+        // the pokémon were moved behind the back of the session, so the box index needs to be rebuilt
+        deps_.gameSession.invalidate();
+        boxIndex_ = deps_.gameSession.getBoxIndex();
+    }
+    deps_.tpakManager.setRAMEnabled(false);
+
+    if(!boxIndex_)
+    {
+        setDialogDataText(diag_, "ERROR: Could not read the PC boxes after sorting them!");
+    }
+    else
+    {
+        // show the sorted version of the box we're looking at
+        switchBox(0);
+
+        if(!success)
+        {
+            setDialogDataText(diag_, "ERROR: Could not sort the boxes!");
+        }
+        else if(!result.numSortedBoxes)
+        {
+            setDialogDataText(diag_, "All boxes were already sorted.");
+        }
+        else
+        {
+            setDialogDataText(diag_, "Moved %u Pokémon in %hu boxes. Wrote %lu bytes instead of %lu.", result.numMovedPokemon, result.numSortedBoxes, result.numBytesWritten, result.numBytesFullRewrite);
+        }
+    }
+    diag_.userAdvanceBlocked = false;
+}
+
+void PokemonBoxBrowserScene::moveBoxToOtherCartridge()
+{
+    PokemonTimeCapsuleResult result;
+    PokemonTimeCapsuleStatus status;
+
+    timeCapsulePending_ = false;
+    diag_.userAdvanceBlocked = false;
+
+    status = timeCapsule_.openDestination();
+    switch(status)
+    {
+    case PokemonTimeCapsuleStatus::OK:
+        break;
+    case PokemonTimeCapsuleStatus::NO_SECOND_TRANSFER_PAK:
+        setDialogDataText(diag_, "ERROR: Please connect a second controller with a transfer pak and a Gen 1 or Gen 2 cartridge!");
+        return;
+    case PokemonTimeCapsuleStatus::UNSUPPORTED_GAME:
+        setDialogDataText(diag_, "ERROR: The cartridge in controller port %d is not a supported Pokémon game!", static_cast<int>(timeCapsule_.getDestinationPort()) + 1);
+        return;
+    case PokemonTimeCapsuleStatus::INVALID_SAVE:
+    default:
+        setDialogDataText(diag_, "ERROR: The cartridge in controller port %d doesn't have a valid save!", static_cast<int>(timeCapsule_.getDestinationPort()) + 1);
+        return;
+    }
+
+    status = timeCapsule_.moveBox(deps_.generation, deps_.specificGenVersion, deps_.localization, deps_.gameSession.getSpeciesTables(), currentBox_, result);
+    timeCapsule_.closeDestination();
+
+    if(result.numMoved || status != PokemonTimeCapsuleStatus::OK)
+    {
+        // the box changed behind the back of the session, so the box index needs to be rebuilt
+        deps_.tpakManager.setRAMEnabled(true);
+        deps_.gameSession.invalidate();
+        boxIndex_ = deps_.gameSession.getBoxIndex();
+        deps_.tpakManager.setRAMEnabled(false);
+    }
+
+    if(!boxIndex_)
+    {
+        setDialogDataText(diag_, "ERROR: Could not read the PC boxes after moving the Pokémon!");
+        return;
+    }
+    switchBox(0);
+
+    if(status != PokemonTimeCapsuleStatus::OK && result.numMoved)
+    {
+        // the destination cartridge was written, but removing them from this one failed
+        setDialogDataText(diag_, "ERROR: %hu Pokémon were copied, but couldn't be removed from this cartridge!", result.numMoved);
+    }
+    else if(status != PokemonTimeCapsuleStatus::OK)
+    {
+        setDialogDataText(diag_, "ERROR: Could not move the Pokémon!");
+    }
+    else if(!result.numMoved && !result.numIncompatible && !result.numNoRoom)
+    {
+        setDialogDataText(diag_, "This box is empty. There's nothing to move.");
+    }
+    else
+    {
+        setDialogDataText(diag_, "Moved %hu Pokémon (%hu can't go, %hu without room). Wrote %lu + %lu bytes.", result.numMoved, result.numIncompatible, result.numNoRoom, result.numBytesWrittenSource, result.numBytesWrittenDestination);
+    }
+}
+
+void PokemonBoxBrowserScene::setupMenu()
+{
+    const VerticalListStyle listStyle = {
+        .margin = {
+            .top = 5,
+            .bottom = 5
+        },
+        .verticalSpacingBetweenWidgets = 1,
+        .autogrow = {
+            .enabled = true,
+            .maxHeight = 190
+        }
+    };
+
+    menuList_.setStyle(listStyle);
+    menuList_.setBounds(menuListBounds);
+    menuList_.setVisible(true);
+    menuList_.registerScrollWindowListener(this);
+
+    cursorWidget_.setVisible(false);
+
+    itemStyle_ = {
+        .size = {280, 22},
+        .background = {
+            .sprite = menu9SliceSprite_,
+            .spriteSettings = {
+                .renderMode = SpriteRenderMode::NINESLICE,
+                .srcRect = { 6, 6, 6, 6 }
+            }
+        },
+        .icon = {
+            .style = {
+                .background = {
+                    .sprite = iconBackgroundSprite_
+                },
+                .icon = {
+                    .bounds = { 2, 2, 16, 16 },
+                    .yOffsetWhenTheresNoFrame2 = -1
+                },
+                .fpsWhenFocused = 8,
+                .fpsWhenNotFocused = 2
+            },
+            .bounds = {0, 1, 20, 20}
+        },
+        .titleNotFocused = {
+            .fontId = mainFontId_,
+            .fontStyleId = fontStyleWhiteId_
+        },
+        .titleFocused = {
+            .fontId = mainFontId_,
+            .fontStyleId = fontStyleYellowId_
+        },
+        .leftMargin = 24,
+        .topMargin = 4
+    };
+
+    customListFiller_.addItems(entries_, numEntries_, itemStyle_);
+
+    const ImageWidgetStyle scrollArrowUpStyle = {
+        .image = {
+            .sprite = uiArrowUpSprite_,
+            .spriteBounds = {0, 0, imgScrollArrowUpBounds.width, imgScrollArrowUpBounds.height}
+        }
+    };
+
+    scrollArrowUp_.setStyle(scrollArrowUpStyle);
+    scrollArrowUp_.setBounds(imgScrollArrowUpBounds);
+
+    const ImageWidgetStyle scrollArrowDownStyle = {
+        .image = {
+            .sprite = uiArrowDownSprite_,
+            .spriteBounds = { 0, 0, imgScrollArrowDownBounds.width, imgScrollArrowDownBounds.height}
+        }
+    };
+
+    scrollArrowDown_.setStyle(scrollArrowDownStyle);
+    scrollArrowDown_.setBounds(imgScrollArrowDownBounds);
+}
+
+void PokemonBoxBrowserScene::loadBox(uint8_t boxIndex)
+{
+    const PokemonBoxIndexEntry* entry;
+    const char* pokeName;
+
+    currentBox_ = boxIndex;
+    numEntries_ = boxIndex_->getNumberOfPokemon(boxIndex);
+
+    for(uint8_t i = 0; i < numEntries_; ++i)
+    {
+        entry = boxIndex_->getEntry(boxIndex, i);
+
+        // the names come from the species tables in RAM
+        if(entry->flags & POKEMON_BOX_INDEX_FLAG_EGG)
+        {
+            strcpy(titles_[i], "EGG");
+        }
+        else
+        {
+            if(deps_.generation == 2 && deps_.localization == (uint8_t)Gen2LocalizationLanguage::KOREAN)
+            {
+                pokeName = "Pokémon";
+            }
+            else
+            {
+                pokeName = deps_.gameSession.getSpeciesTables().getPokemonName(entry->speciesIndex);
+            }
+            snprintf(titles_[i], POKEMON_BOX_BROWSER_SCENE_TITLE_SIZE, "%s  L%hu", pokeName, entry->level);
+        }
+
+        DistributionPokemonMenuItemData& menuEntry = entries_[i];
+        menuEntry.title = titles_[i];
+        menuEntry.onConfirmAction = openBoxSlot;
+        menuEntry.context = this;
+        menuEntry.itemParam = entry;
+        menuEntry.iconData = {
+            .iconFactory = &iconFactory_,
+            .generation = deps_.generation,
+            .specificGenVersion = deps_.specificGenVersion,
+            .localization = deps_.localization,
+            .iconType = entry->iconType
+        };
+    }
+
+    snprintf(headerText_, sizeof(headerText_), "< BOX %hu/%hu >", static_cast<uint8_t>(boxIndex + 1), boxIndex_->getNumberOfBoxes());
+}
+
+void PokemonBoxBrowserScene::switchBox(int8_t direction)
+{
+    const uint8_t numBoxes = boxIndex_->getNumberOfBoxes();
+    const uint8_t newBox = static_cast<uint8_t>((currentBox_ + numBoxes + direction) % numBoxes);
+
+    // the filler owns the item widgets. Remove them from the list before deleting them
+    menuList_.clearWidgets();
+    customListFiller_.deleteWidgets();
+
+    loadBox(newBox);
+    customListFiller_.addItems(entries_, numEntries_, itemStyle_);
+}
@@ -0,0 +1,303 @@
+#include "scenes/PokemonImportScene.h"
+#include "scenes/SceneManager.h"
+#include "core/GameSession.h"
+#include "core/DragonUtils.h"
+
+#include <cstring>
+#include <strings.h>
+
+static const Rectangle menuListBounds = {20, 30, 280, 0};
+static const Rectangle imgScrollArrowUpBounds = {.x = 154, .y = 24, .width = 11, .height = 6};
+static const Rectangle imgScrollArrowDownBounds = {.x = 154, .y = 180, .width = 11, .height = 6};
+
+static void toggleImportFile(void* context, const void* param)
+{
+    auto scene = static_cast<PokemonImportScene*>(context);
+    scene->toggleFile(*static_cast<const uint8_t*>(param));
+}
+
+// the index of every menu entry, so we can pass it as the itemParam
+static const uint8_t fileIndices[POKEMON_IMPORTER_MAX_FILES] = {
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
+    10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+    20, 21, 22, 23, 24, 25, 26, 27, 28, 29,
+    30, 31, 32, 33, 34, 35, 36, 37, 38, 39
+};
+
+PokemonImportScene::PokemonImportScene(SceneDependencies& deps, void* context)
+    : MenuScene(deps, context)
+    , importer_(deps.tpakManager)
+    , paths_()
+    , titles_()
+    , selected_()
+    , diag_()
+    , numSelected_(0)
+    , startButtonPressed_(false)
+    , importPending_(false)
+    , importDone_(false)
+{
+}
+
+PokemonImportScene::~PokemonImportScene()
+{
+}
+
+void PokemonImportScene::init()
+{
+    loadFiles();
+    MenuScene::init();
+
+    if(!sdcard_mounted)
+    {
+        setDialogDataText(diag_, "ERROR: SD card is not mounted!");
+        showDialog(&diag_);
+    }
+    else if(!context_->numMenuEntries)
+    {
+        setDialogDataText(diag_, "No .pk%hu files were found in %s", deps_.generation, POKEMON_IMPORTER_DIRECTORY);
+        showDialog(&diag_);
+    }
+    else
+    {
+        setDialogDataText(diag_, "Select the Pokémon to import with A. Then press START to put them in the PC boxes.");
+        showDialog(&diag_);
+    }
+}
+
+void PokemonImportScene::destroy()
+{
+    MenuScene::destroy();
+
+    delete[] context_->menuEntries;
+    context_->menuEntries = nullptr;
+    context_->numMenuEntries = 0;
+}
+
+bool PokemonImportScene::handleUserInput(joypad_port_t port, const joypad_inputs_t& inputs)
+{
+    if(importPending_)
+    {
+        importSelectedFiles();
+        return true;
+    }
+    else if(MenuScene::handleUserInput(port, inputs))
+    {
+        return true;
+    }
+
+    // like the B button, we only act on the release of the start button
+    if(inputs.btn.start && !startButtonPressed_)
+    {
+        startButtonPressed_ = true;
+        return true;
+    }
+    else if(!inputs.btn.start && startButtonPressed_)
+    {
+        startButtonPressed_ = false;
+        startImport();
+        return true;
+    }
+    return false;
+}
+
+void PokemonImportScene::onDialogDone()
+{
+    if(!context_->numMenuEntries || importDone_)
+    {
+        // there's nothing (left) to import
+        deps_.sceneManager.goBackToPreviousScene();
+        return;
+    }
+    MenuScene::onDialogDone();
+}
+
+void PokemonImportScene::toggleFile(uint8_t fileIndex)
+{
+    selected_[fileIndex] = !selected_[fileIndex];
+    if(selected_[fileIndex])
+    {
+        ++numSelected_;
+    }
+    else
+    {
+        --numSelected_;
+    }
+    // the menu item renders the title buffer directly, so this is enough to update it
+    titles_[fileIndex][1] = (selected_[fileIndex]) ? 'x' : ' ';
+}
+
+void PokemonImportScene::setupMenu()
+{
+    const VerticalListStyle listStyle = {
+        .background = {
+            .sprite = menu9SliceSprite_,
+            .spriteSettings = {
+                .renderMode = SpriteRenderMode::NINESLICE,
+                .srcRect = { 6, 6, 6, 6 }
+            }
+        },
+        .margin = {
+            .top = 5
+        },
+        .autogrow = {
+            .enabled = true,
+            .maxHeight = 150
+        }
+    };
+
+    const CursorStyle cursorStyle = {
+        .sprite  = cursorSprite_,
+        .idleMoveDiff = { 5, 0, 0, 0 },
+        .idleAnimationDurationInMs = 500,
+        .moveAnimationDurationInMs = 250
+    };
+
+    menuList_.setStyle(listStyle);
+    menuList_.setBounds(menuListBounds);
+    menuList_.setVisible(true);
+    cursorWidget_.setStyle(cursorStyle);
+    cursorWidget_.setVisible(true);
+    menuList_.registerFocusListener(this);
+    menuList_.registerScrollWindowListener(this);
+
+    const MenuItemStyle itemStyle = {
+        .size = {280, 16},
+        .titleNotFocused = {
+            .fontId = mainFontId_,
+            .fontStyleId = fontStyleWhiteId_
+        },
+        .titleFocused = {
+            .fontId = mainFontId_,
+            .fontStyleId = fontStyleYellowId_
+        },
+        .leftMargin = 35,
+        .topMargin = 1
+    };
+
+    menuListFiller_.addItems(context_->menuEntries, context_->numMenuEntries, itemStyle);
+
+    const ImageWidgetStyle scrollArrowUpStyle = {
+        .image = {
+            .sprite = uiArrowUpSprite_,
+            .spriteBounds = {0, 0, imgScrollArrowUpBounds.width, imgScrollArrowUpBounds.height}
+        }
+    };
+
+    scrollArrowUp_.setStyle(scrollArrowUpStyle);
+    scrollArrowUp_.setBounds(imgScrollArrowUpBounds);
+
+    const ImageWidgetStyle scrollArrowDownStyle = {
+        .image = {
+            .sprite = uiArrowDownSprite_,
+            .spriteBounds = { 0, 0, imgScrollArrowDownBounds.width, imgScrollArrowDownBounds.height}
+        }
+    };
+
+    scrollArrowDown_.setStyle(scrollArrowDownStyle);
+    scrollArrowDown_.setBounds(imgScrollArrowDownBounds);
+}
+
+void PokemonImportScene::loadFiles()
+{
+    const char* extension = (deps_.generation == 1) ? ".pk1" : ".pk2";
+    dir_t dirEnt;
+    size_t nameLength;
+    uint8_t numFiles = 0;
+    int ret;
+
+    context_->menuEntries = nullptr;
+    context_->numMenuEntries = 0;
+
+    if(!sdcard_mounted)
+    {
+        return;
+    }
+
+    ret = dir_findfirst(POKEMON_IMPORTER_DIRECTORY, &dirEnt);
+    while(ret == 0 && numFiles < POKEMON_IMPORTER_MAX_FILES)
+    {
+        nameLength = strnlen(dirEnt.d_name, sizeof(dirEnt.d_name));
+        // d_name gets overwritten by the next dir_findnext() call, so we build the path and title right away
+        if(dirEnt.d_type == DT_REG && nameLength > 4 && !strcasecmp(dirEnt.d_name + nameLength - 4, extension)
+            && snprintf(paths_[numFiles], POKEMON_IMPORT_SCENE_PATH_SIZE, "%s/%s", POKEMON_IMPORTER_DIRECTORY, dirEnt.d_name) < POKEMON_IMPORT_SCENE_PATH_SIZE)
+        {
+            snprintf(titles_[numFiles], POKEMON_IMPORT_SCENE_TITLE_SIZE, "[ ] %s", dirEnt.d_name);
+            selected_[numFiles] = false;
+            ++numFiles;
+        }
+        ret = dir_findnext(POKEMON_IMPORTER_DIRECTORY, &dirEnt);
+    }
+
+    if(!numFiles)
+    {
+        return;
+    }
+
+    context_->menuEntries = new MenuItemData[numFiles];
+    context_->numMenuEntries = numFiles;
+    for(uint8_t i = 0; i < numFiles; ++i)
+    {
+        context_->menuEntries[i] = MenuItemData{
+            .title = titles_[i],
+            .onConfirmAction = toggleImportFile,
+            .context = this,
+            .itemParam = &fileIndices[i]
+        };
+    }
+}
+
+void PokemonImportScene::startImport()
+{
+    if(!numSelected_)
+    {
+        setDialogDataText(diag_, "Select the Pokémon to import with A first!");
+        showDialog(&diag_);
+        return;
+    }
+    importPending_ = true;
+
+    setDialogDataText(diag_, "Importing %hu Pokémon... Don't turn off the power.", numSelected_);
+    diag_.userAdvanceBlocked = true;
+    showDialog(&diag_);
+}
+
+void PokemonImportScene::importSelectedFiles()
+{
+    const char* selectedPaths[POKEMON_IMPORTER_MAX_FILES];
+    PokemonImportResult result;
+    uint8_t numPaths = 0;
+    bool success;
+
+    importPending_ = false;
+    importDone_ = true;
+
+    for(uint32_t i = 0; i < context_->numMenuEntries; ++i)
+    {
+        if(selected_[i])
+        {
+            selectedPaths[numPaths++] = paths_[i];
+        }
+    }
+
+    deps_.tpakManager.setRAMEnabled(true);
+    success = importer_.importFiles(deps_.generation, deps_.specificGenVersion, deps_.localization, selectedPaths, numPaths, result);
+    // the pokémon were written behind the back of the session, so the cached boxes are outdated
+    deps_.gameSession.invalidate();
+    /* Quote:
+     * "It is recommended to disable external RAM after accessing it, in order to protect its contents from corruption
+     *  during power down of the Game Boy or removal of the cartridge."
+     *
+     * source: https://gbdev.io/pandocs/MBC1.html
+     */
+    deps_.tpakManager.setRAMEnabled(false);
+
+    if(!success)
+    {
+        setDialogDataText(diag_, "ERROR: Could not import the Pokémon into this save!");
+    }
+    else
+    {
+        setDialogDataText(diag_, "Imported %hu Pokémon (%lu bytes written). Invalid files: %hu. No room: %hu.", result.numImported, result.numBytesWritten, result.numInvalid, result.numNoRoom);
+    }
+    diag_.userAdvanceBlocked = false;
+}
@@ -0,0 +1,234 @@
+#include "scenes/SaveLibraryScene.h"
+#include "scenes/SceneManager.h"
+#include "scenes/DataCopyScene.h"
+#include "core/DragonUtils.h"
+
+#include <cstring>
+
+static const Rectangle menuListBounds = {20, 30, 280, 0};
+static const Rectangle imgScrollArrowUpBounds = {.x = 154, .y = 24, .width = 11, .height = 6};
+static const Rectangle imgScrollArrowDownBounds = {.x = 154, .y = 180, .width = 11, .height = 6};
+
+static SaveLibrarySceneContext* convert(void* context)
+{
+    return static_cast<SaveLibrarySceneContext*>(context);
+}
+
+static void restoreLibraryEntry(void* context, const void* param)
+{
+    auto scene = static_cast<SaveLibraryScene*>(context);
+    scene->onEntryConfirmed(*static_cast<const SaveLibraryEntry*>(param));
+}
+
+SaveLibraryScene::SaveLibraryScene(SceneDependencies& deps, void* context)
+    : MenuScene(deps, context)
+    , saveLibrary_()
+    , entries_(nullptr)
+    , titles_(nullptr)
+    , diag_()
+    , skipped_(false)
+{
+}
+
+SaveLibraryScene::~SaveLibraryScene()
+{
+}
+
+void SaveLibraryScene::init()
+{
+    if(convert(context_)->goBackToPreviousSceneInstead)
+    {
+        // we ended up back here because the DataCopyScene is done restoring the backup.
+        // go back to the backup menu instead.
+        skipped_ = true;
+        deps_.sceneManager.goBackToPreviousScene();
+        return;
+    }
+
+    loadLibraryEntries();
+    MenuScene::init();
+
+    if(!sdcard_mounted)
+    {
+        setDialogDataText(diag_, "ERROR: SD card is not mounted!");
+        showDialog(&diag_);
+    }
+    else if(!context_->numMenuEntries)
+    {
+        setDialogDataText(diag_, "No backups of this game were found in the save library. Use \"Backup Save\" to make one!");
+        showDialog(&diag_);
+    }
+}
+
+void SaveLibraryScene::destroy()
+{
+    if(skipped_)
+    {
+        return;
+    }
+
+    MenuScene::destroy();
+
+    delete[] context_->menuEntries;
+    context_->menuEntries = nullptr;
+    context_->numMenuEntries = 0;
+
+    delete[] entries_;
+    entries_ = nullptr;
+    delete[] titles_;
+    titles_ = nullptr;
+}
+
+void SaveLibraryScene::onDialogDone()
+{
+    if(!context_->numMenuEntries)
+    {
+        // there's nothing to choose from
+        deps_.sceneManager.goBackToPreviousScene();
+        return;
+    }
+    MenuScene::onDialogDone();
+}
+
+void SaveLibraryScene::onEntryConfirmed(const SaveLibraryEntry& entry)
+{
+    auto dataCopyContext = new DataCopySceneContext{
+        .operation = DataCopyOperation::RESTORE_SAVE,
+        .saveToRestorePath = strdup(entry.path)
+    };
+
+    convert(context_)->goBackToPreviousSceneInstead = true;
+    deps_.sceneManager.switchScene(SceneType::COPY_DATA, deleteDataCopySceneContext, dataCopyContext);
+}
+
+void SaveLibraryScene::setupMenu()
+{
+    const VerticalListStyle listStyle = {
+        .background = {
+            .sprite = menu9SliceSprite_,
+            .spriteSettings = {
+                .renderMode = SpriteRenderMode::NINESLICE,
+                .srcRect = { 6, 6, 6, 6 }
+            }
+        },
+        .margin = {
+            .top = 5
+        },
+        .autogrow = {
+            .enabled = true,
+            .maxHeight = 150
+        }
+    };
+
+    const CursorStyle cursorStyle = {
+        .sprite  = cursorSprite_,
+        .idleMoveDiff = { 5, 0, 0, 0 },
+        .idleAnimationDurationInMs = 500,
+        .moveAnimationDurationInMs = 250
+    };
+
+    menuList_.setStyle(listStyle);
+    menuList_.setBounds(menuListBounds);
+    menuList_.setVisible(true);
+    cursorWidget_.setStyle(cursorStyle);
+    cursorWidget_.setVisible(true);
+    menuList_.registerFocusListener(this);
+    menuList_.registerScrollWindowListener(this);
+
+    const MenuItemStyle itemStyle = {
+        .size = {280, 16},
+        .titleNotFocused = {
+            .fontId = mainFontId_,
+            .fontStyleId = fontStyleWhiteId_
+        },
+        .titleFocused = {
+            .fontId = mainFontId_,
+            .fontStyleId = fontStyleYellowId_
+        },
+        .leftMargin = 35,
+        .topMargin = 1
+    };
+
+    menuListFiller_.addItems(context_->menuEntries, context_->numMenuEntries, itemStyle);
+
+    const ImageWidgetStyle scrollArrowUpStyle = {
+        .image = {
+            .sprite = uiArrowUpSprite_,
+            .spriteBounds = {0, 0, imgScrollArrowUpBounds.width, imgScrollArrowUpBounds.height}
+        }
+    };
+
+    scrollArrowUp_.setStyle(scrollArrowUpStyle);
+    scrollArrowUp_.setBounds(imgScrollArrowUpBounds);
+
+    const ImageWidgetStyle scrollArrowDownStyle = {
+        .image = {
+            .sprite = uiArrowDownSprite_,
+            .spriteBounds = { 0, 0, imgScrollArrowDownBounds.width, imgScrollArrowDownBounds.height}
+        }
+    };
+
+    scrollArrowDown_.setStyle(scrollArrowDownStyle);
+    scrollArrowDown_.setBounds(imgScrollArrowDownBounds);
+}
+
+void SaveLibraryScene::loadLibraryEntries()
+{
+    gameboy_cartridge_header gbHeader;
+    char gameTitle[12];
+    char playTimeText[12];
+    uint16_t numEntries = 0;
+
+    context_->menuEntries = nullptr;
+    context_->numMenuEntries = 0;
+
+    if(!sdcard_mounted || !saveLibrary_.load() || !deps_.tpakManager.readCartridgeHeader(gbHeader))
+    {
+        return;
+    }
+
+    memcpy(gameTitle, gbHeader.new_title.title, 11);
+    gameTitle[11] = '\0';
+
+    entries_ = new SaveLibraryEntry[SAVE_LIBRARY_SCENE_MAX_ENTRIES];
+    numEntries = saveLibrary_.readEntries(entries_, SAVE_LIBRARY_SCENE_MAX_ENTRIES, gameTitle);
+    if(!numEntries)
+    {
+        return;
+    }
+
+    titles_ = new char[numEntries * SAVE_LIBRARY_SCENE_TITLE_SIZE];
+    context_->menuEntries = new MenuItemData[numEntries];
+    context_->numMenuEntries = numEntries;
+
+    for(uint16_t i = 0; i < numEntries; ++i)
+    {
+        const SaveLibraryEntry& entry = entries_[i];
+        char* title = titles_ + (i * SAVE_LIBRARY_SCENE_TITLE_SIZE);
+
+        if(entry.flags & SAVE_LIBRARY_ENTRY_FLAG_HAS_PLAYTIME)
+        {
+            snprintf(playTimeText, sizeof(playTimeText), "%uh%02u", entry.playTimeHours, entry.playTimeMinutes);
+        }
+        else
+        {
+            strcpy(playTimeText, "--h--");
+        }
+
+        // mark the backups with an invalid checksum: the game would refuse to load them
+        snprintf(title, SAVE_LIBRARY_SCENE_TITLE_SIZE, "%s%s %05u %s%s", (entry.flags & SAVE_LIBRARY_ENTRY_FLAG_CHECKSUM_VALID) ? "" : "!", entry.trainerName, entry.trainerID, playTimeText, (entry.flags & SAVE_LIBRARY_ENTRY_FLAG_COMPRESSED) ? " LZ" : "");
+
+        context_->menuEntries[i] = MenuItemData{
+            .title = title,
+            .onConfirmAction = restoreLibraryEntry,
+            .context = this,
+            .itemParam = &entry
+        };
+    }
+}
+
+void deleteSaveLibrarySceneContext(void* context)
+{
+    auto toDelete = static_cast<SaveLibrarySceneContext*>(context);
+    delete toDelete;
+}
@@ -7,6 +7,9 @@
 #include "scenes/DistributionPokemonListScene.h"
 #include "scenes/SelectFileScene.h"
 #include "scenes/DataCopyScene.h"
+#include "scenes/SaveLibraryScene.h"
+#include "scenes/PokemonBoxBrowserScene.h"
+#include "scenes/PokemonImportScene.h"
 
 #include <libdragon.h>
 
@@ -14,12 +17,14 @@ static const uint16_t INPUT_BLOCK_TIME_AFTER_NEW_SCENE_IN_MS = 500;
 
 SceneManager::SceneManager(RDPQGraphics& gfx, AnimationManager& animationManager, FontManager& fontManager, TransferPakManager& tpakManager)
     : sceneHistory_()
+    , gameSession_(tpakManager)
     , sceneDeps_(SceneDependencies{
         .gfx = gfx,
         .animationManager = animationManager,
         .fontManager = fontManager,
         .tpakManager = tpakManager,
         .sceneManager = (*this),
+        .gameSession = gameSession_,
         .generation = 0,
         .specificGenVersion = 0
     })
@@ -151,6 +156,15 @@ void SceneManager::loadScene()
         case SceneType::ABOUT:
             scene_ = new AboutScene(sceneDeps_, newSceneContext_);
             break;
+        case SceneType::SAVE_LIBRARY:
+            scene_ = new SaveLibraryScene(sceneDeps_, newSceneContext_);
+            break;
+        case SceneType::POKEMON_BOX_BROWSER:
+            scene_ = new PokemonBoxBrowserScene(sceneDeps_, newSceneContext_);
+            break;
+        case SceneType::IMPORT_POKEMON:
+            scene_ = new PokemonImportScene(sceneDeps_, newSceneContext_);
+            break;
         default:
             break;
     }
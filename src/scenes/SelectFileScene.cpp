@@ -1,6 +1,7 @@
 #include "scenes/SelectFileScene.h"
 #include "scenes/SceneManager.h"
 #include "scenes/DataCopyScene.h"
+#include "scenes/InitTransferPakScene.h"
 
 static const Rectangle titleBounds = {20, 10, 280, 16};
 static const Rectangle fileBrowserBounds = {20, 30, 280, 180};
@@ -208,6 +209,11 @@ void SelectFileScene::onFileConfirmed(const char* path)
         auto nextSceneContext = (DataCopySceneContext*)context_->nextScene.context;
         nextSceneContext->saveToRestorePath = strdup(path);
     }
+    else if(context_->nextScene.type == SceneType::INIT_TRANSFERPAK)
+    {
+        auto nextSceneContext = (InitTransferPakSceneContext*)context_->nextScene.context;
+        nextSceneContext->virtualCartridgeSavePath = strdup(path);
+    }
     context_->goBackToPreviousSceneInstead = true;
     deps_.sceneManager.switchScene(context_->nextScene.type, context_->nextScene.deleteContextFunc, context_->nextScene.context);
 }
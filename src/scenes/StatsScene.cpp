@@ -3,6 +3,7 @@
 #include "core/FontManager.h"
 #include "scenes/SceneManager.h"
 #include "transferpak/TransferPakManager.h"
+#include "core/GameSession.h"
 #include "Moves.h"
 
 using OutputFormat = SpriteRenderer::OutputFormat;
@@ -30,24 +31,6 @@ static uint8_t getNumBytesPerColorFor(OutputFormat format)
     }
 }
 
-static Gen1GameType getGen1TypeFor(uint8_t generation, uint8_t specificGenVersion)
-{
-    if(generation != 1)
-    {
-        return Gen1GameType::INVALID;
-    }
-    return static_cast<Gen1GameType>(specificGenVersion);
-}
-
-static Gen2GameType getGen2TypeFor(uint8_t generation, uint8_t specificGenVersion)
-{
-    if(generation != 2)
-    {
-        return Gen2GameType::INVALID;
-    }
-    return static_cast<Gen2GameType>(specificGenVersion);
-}
-
 static void dialogFinishedCallback(void* context)
 {
     StatsScene* scene = (StatsScene*)context;
@@ -57,10 +40,6 @@ static void dialogFinishedCallback(void* context)
 StatsScene::StatsScene(SceneDependencies& deps, void* context)
     : SceneWithDialogWidget(deps)
     , diag_({0})
-    , romReader_(deps.tpakManager)
-    , saveManager_(deps.tpakManager)
-    , gen1GameReader_(romReader_, saveManager_, getGen1TypeFor(deps.generation, deps.specificGenVersion), static_cast<Gen1LocalizationLanguage>(deps.localization))
-    , gen2GameReader_(romReader_, saveManager_, getGen2TypeFor(deps.generation, deps.specificGenVersion), static_cast<Gen2LocalizationLanguage>(deps.localization))
     , menu9SliceSprite_(nullptr)
     , backgroundRenderSettings_({
             .renderMode = SpriteRenderMode::NINESLICE,
@@ -116,6 +95,9 @@ void StatsScene::init()
     const char* trainerName;
     const char* shinyText;
     bool shiny;
+    // the session only has the game reader of the generation of the cartridge
+    Gen1GameReader* gen1GameReader = deps_.gameSession.getGen1Reader();
+    Gen2GameReader* gen2GameReader = deps_.gameSession.getGen2Reader();
 
     menu9SliceSprite_ = sprite_load("rom://menu-bg-9slice.sprite");
     fontMainFontSmallId_ = deps_.fontManager.getFont("rom://Arial-small.font64");
@@ -129,50 +111,51 @@ void StatsScene::init()
     };
     deps_.fontManager.registerFontStyle(fontMainFontSmallId_, fontMainFontSmallWhiteId_, mainFontWhite);
     deps_.tpakManager.setRAMEnabled(true);
-    switch(deps_.generation)
+    if(gen1GameReader)
     {
-        case 1:
-            gen1_recalculatePokeStats(gen1GameReader_, context_->poke_g1);
-            pokeIndex = context_->poke_g1.poke_index;
-            level = context_->poke_g1.level;
-            pokeNumber = gen1GameReader_.getPokemonNumber(pokeIndex);
-            hp = context_->poke_g1.max_hp;
-            trainerID = context_->poke_g1.original_trainer_ID;
-            atk = context_->poke_g1.atk;
-            def = context_->poke_g1.def;
-            specAtk = context_->poke_g1.special;
-            speed = context_->poke_g1.speed;
-            move1Str = getMoveString(static_cast<Move>(context_->poke_g1.index_move1));
-            move2Str = getMoveString(static_cast<Move>(context_->poke_g1.index_move2));
-            move3Str = getMoveString(static_cast<Move>(context_->poke_g1.index_move3));
-            move4Str = getMoveString(static_cast<Move>(context_->poke_g1.index_move4));
-            pokeName = gen1GameReader_.getPokemonName(pokeIndex);
-            shiny = false;
-            snprintf(pokeStatsString_, sizeof(pokeStatsString_), "ATK:            %u\nDEF:            %u\nSPEC:          %u\nSPEED:        %u", atk, def, specAtk, speed);
-            break;
-        case 2:
-            gen2_recalculatePokeStats(gen2GameReader_, context_->poke_g2);
-            pokeIndex = context_->poke_g2.poke_index;
-            level = context_->poke_g2.level;
-            pokeNumber = pokeIndex;
-            hp = context_->poke_g2.max_hp;
-            trainerID = context_->poke_g2.original_trainer_ID;
-            atk = context_->poke_g2.atk;
-            def = context_->poke_g2.def;
-            specAtk = context_->poke_g2.special_atk;
-            specDef = context_->poke_g2.special_def;
-            speed = context_->poke_g2.speed;
-            move1Str = getMoveString(static_cast<Move>(context_->poke_g2.index_move1));
-            move2Str = getMoveString(static_cast<Move>(context_->poke_g2.index_move2));
-            move3Str = getMoveString(static_cast<Move>(context_->poke_g2.index_move3));
-            move4Str = getMoveString(static_cast<Move>(context_->poke_g2.index_move4));
-            pokeName = (deps_.localization != (uint8_t)Gen2LocalizationLanguage::KOREAN) ? gen2GameReader_.getPokemonName(pokeIndex) : "Pokémon";
-            shiny = gen2_isPokemonShiny(context_->poke_g2);
-            snprintf(pokeStatsString_, sizeof(pokeStatsString_), "ATK:            %u\nDEF:            %u\nSPEC. ATK:  %u\nSPEC. DEF:  %u\nSPEED:        %u", atk, def, specAtk, specDef, speed);
-            break;
-        default:
-            deps_.tpakManager.setRAMEnabled(false);
-            return;
+        gen1_recalculatePokeStats(*gen1GameReader, context_->poke_g1);
+        pokeIndex = context_->poke_g1.poke_index;
+        level = context_->poke_g1.level;
+        pokeNumber = deps_.gameSession.getSpeciesTables().getPokemonNumber(pokeIndex);
+        hp = context_->poke_g1.max_hp;
+        trainerID = context_->poke_g1.original_trainer_ID;
+        atk = context_->poke_g1.atk;
+        def = context_->poke_g1.def;
+        specAtk = context_->poke_g1.special;
+        speed = context_->poke_g1.speed;
+        move1Str = getMoveString(static_cast<Move>(context_->poke_g1.index_move1));
+        move2Str = getMoveString(static_cast<Move>(context_->poke_g1.index_move2));
+        move3Str = getMoveString(static_cast<Move>(context_->poke_g1.index_move3));
+        move4Str = getMoveString(static_cast<Move>(context_->poke_g1.index_move4));
+        pokeName = deps_.gameSession.getSpeciesTables().getPokemonName(pokeIndex);
+        shiny = false;
+        snprintf(pokeStatsString_, sizeof(pokeStatsString_), "ATK:            %u\nDEF:            %u\nSPEC:          %u\nSPEED:        %u", atk, def, specAtk, speed);
+    }
+    else if(gen2GameReader)
+    {
+        gen2_recalculatePokeStats(*gen2GameReader, context_->poke_g2);
+        pokeIndex = context_->poke_g2.poke_index;
+        level = context_->poke_g2.level;
+        pokeNumber = pokeIndex;
+        hp = context_->poke_g2.max_hp;
+        trainerID = context_->poke_g2.original_trainer_ID;
+        atk = context_->poke_g2.atk;
+        def = context_->poke_g2.def;
+        specAtk = context_->poke_g2.special_atk;
+        specDef = context_->poke_g2.special_def;
+        speed = context_->poke_g2.speed;
+        move1Str = getMoveString(static_cast<Move>(context_->poke_g2.index_move1));
+        move2Str = getMoveString(static_cast<Move>(context_->poke_g2.index_move2));
+        move3Str = getMoveString(static_cast<Move>(context_->poke_g2.index_move3));
+        move4Str = getMoveString(static_cast<Move>(context_->poke_g2.index_move4));
+        pokeName = (deps_.localization != (uint8_t)Gen2LocalizationLanguage::KOREAN) ? deps_.gameSession.getSpeciesTables().getPokemonName(pokeIndex) : "Pokémon";
+        shiny = gen2_isPokemonShiny(context_->poke_g2);
+        snprintf(pokeStatsString_, sizeof(pokeStatsString_), "ATK:            %u\nDEF:            %u\nSPEC. ATK:  %u\nSPEC. DEF:  %u\nSPEED:        %u", atk, def, specAtk, specDef, speed);
+    }
+    else
+    {
+        deps_.tpakManager.setRAMEnabled(false);
+        return;
     }
     deps_.tpakManager.setRAMEnabled(false);
 
@@ -196,6 +179,19 @@ void StatsScene::init()
         }
         showDialog(&diag_);
     }
+    else
+    {
+        // we're just showing a pokémon of the save. The dialog is what allows the user to go back
+        if(context_->isEgg)
+        {
+            setDialogDataText(diag_, "This EGG still needs some time to hatch.");
+        }
+        else
+        {
+            setDialogDataText(diag_, "%s the %s%s", context_->nickname, shinyText, pokeName);
+        }
+        showDialog(&diag_);
+    }
 }
 
 void StatsScene::destroy()
@@ -256,33 +252,32 @@ void StatsScene::loadPokemonSprite(uint8_t pokeIndex, bool shiny)
     uint8_t spriteHeightInPixels;
     const OutputFormat outputFormat = OutputFormat::RGBA16;
     const uint8_t numBytesPerColor = getNumBytesPerColorFor(outputFormat);
-    
-    switch(deps_.generation)
+    Gen1GameReader* gen1GameReader = deps_.gameSession.getGen1Reader();
+    Gen2GameReader* gen2GameReader = deps_.gameSession.getGen2Reader();
+
+    if(gen1GameReader)
     {
-        case 1:
-        {
-            Gen1PokeStats pokeStats;
-            gen1GameReader_.readPokemonStatsForIndex(pokeIndex, pokeStats);
-            gen1GameReader_.readColorPalette(gen1GameReader_.getColorPaletteIndexByPokemonNumber(pokeStats.pokedex_number), colorPalette);
-            spriteBuffer = gen1GameReader_.decodeSprite(pokeStats.sprite_bank, pokeStats.pointer_to_frontsprite);
-            spriteWidthInTiles = MAX_SPRITE_TILES_WIDTH;
-            spriteHeightInTiles = MAX_SPRITE_TILES_HEIGHT;
-            break;
-        }
-        case 2:
-        {
-            Gen2PokeStats pokeStats;
-            uint8_t bankIndex;
-            uint16_t bankPointer;
-            gen2GameReader_.readPokemonStatsForIndex(pokeIndex, pokeStats);
-            gen2GameReader_.readFrontSpritePointer(pokeIndex, bankIndex, bankPointer);
-            gen2GameReader_.readSpriteDimensions(pokeStats, spriteWidthInTiles, spriteHeightInTiles);
-            gen2GameReader_.readColorPaletteForPokemon(pokeIndex, shiny, colorPalette);
-            spriteBuffer = gen2GameReader_.decodeSprite(bankIndex, bankPointer);
-            break;
-        }
-        default:
-            return;
+        Gen1PokeStats pokeStats;
+        deps_.gameSession.getSpeciesTables().getGen1PokeStats(pokeIndex, pokeStats);
+        gen1GameReader->readColorPalette(gen1GameReader->getColorPaletteIndexByPokemonNumber(pokeStats.pokedex_number), colorPalette);
+        spriteBuffer = gen1GameReader->decodeSprite(pokeStats.sprite_bank, pokeStats.pointer_to_frontsprite);
+        spriteWidthInTiles = MAX_SPRITE_TILES_WIDTH;
+        spriteHeightInTiles = MAX_SPRITE_TILES_HEIGHT;
+    }
+    else if(gen2GameReader)
+    {
+        Gen2PokeStats pokeStats;
+        uint8_t bankIndex;
+        uint16_t bankPointer;
+        deps_.gameSession.getSpeciesTables().getGen2PokeStats(pokeIndex, pokeStats);
+        gen2GameReader->readFrontSpritePointer(pokeIndex, bankIndex, bankPointer);
+        gen2GameReader->readSpriteDimensions(pokeStats, spriteWidthInTiles, spriteHeightInTiles);
+        gen2GameReader->readColorPaletteForPokemon(pokeIndex, shiny, colorPalette);
+        spriteBuffer = gen2GameReader->decodeSprite(bankIndex, bankPointer);
+    }
+    else
+    {
+        return;
     }
 
     renderer.draw(spriteBuffer, outputFormat, colorPalette, spriteWidthInTiles, spriteHeightInTiles);
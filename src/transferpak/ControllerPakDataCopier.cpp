@@ -0,0 +1,502 @@
+#include "transferpak/ControllerPakDataCopier.h"
+
+#include <libdragon.h>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Identification of our notes in the Controller Pak note table.
+ * The game code is 3 characters followed by the region code, just like the retail games. The publisher code "00" isn't assigned to any publisher.
+ * Both are normally assigned by Nintendo. We just need something that isn't used by a retail game.
+ */
+static const uint8_t CONTROLLER_PAK_NOTE_GAME_CODE[4] = {'P', 'M', '6', 'E'};
+static const uint8_t CONTROLLER_PAK_NOTE_PUBLISHER_CODE[2] = {'0', '0'};
+static const uint8_t CONTROLLER_PAK_MAX_NOTES = 16;
+static const uint8_t CONTROLLER_PAK_NOTE_ENTRY_SIZE = 32;
+static const uint8_t CONTROLLER_PAK_NOTE_NAME_SIZE = 16;
+
+/**
+ * Layout of the Controller Pak, the same one libdragon uses for its mempak functions.
+ * Pages 1 and 2 hold the page table (and its backup): 2 bytes per page, of which the low byte is the next page of the note,
+ * CONTROLLER_PAK_PAGE_LAST for the last page of a note or CONTROLLER_PAK_PAGE_FREE for an unused page.
+ * Pages 3 and 4 hold the note table (16 entries of 32 bytes). The notes themselves use pages 5 to 127.
+ */
+static const uint8_t CONTROLLER_PAK_PAGE_TABLE_PAGE = 1;
+static const uint8_t CONTROLLER_PAK_PAGE_TABLE_BACKUP_PAGE = 2;
+static const uint8_t CONTROLLER_PAK_NOTE_TABLE_PAGE = 3;
+static const uint8_t CONTROLLER_PAK_FIRST_DATA_PAGE = 5;
+static const uint8_t CONTROLLER_PAK_NUM_PAGES = 128;
+static const uint8_t CONTROLLER_PAK_PAGE_LAST = 0x01;
+static const uint8_t CONTROLLER_PAK_PAGE_FREE = 0x03;
+
+static uint8_t calculatePageTableChecksum(const uint8_t* pageTable)
+{
+    uint32_t sum = 0;
+    for(uint8_t i = CONTROLLER_PAK_FIRST_DATA_PAGE; i < CONTROLLER_PAK_NUM_PAGES; ++i)
+    {
+        sum += pageTable[(i << 1) + 1];
+    }
+    return static_cast<uint8_t>(sum & 0xFF);
+}
+
+static bool readPageTable(joypad_port_t port, uint8_t* outPageTable)
+{
+    // just like libdragon, we fall back to the backup copy if the page table is corrupt
+    if(!read_mempak_sector(static_cast<int>(port), CONTROLLER_PAK_PAGE_TABLE_PAGE, outPageTable) && outPageTable[1] == calculatePageTableChecksum(outPageTable))
+    {
+        return true;
+    }
+    return (!read_mempak_sector(static_cast<int>(port), CONTROLLER_PAK_PAGE_TABLE_BACKUP_PAGE, outPageTable) && outPageTable[1] == calculatePageTableChecksum(outPageTable));
+}
+
+static uint8_t findFreePage(const uint8_t* pageTable)
+{
+    for(uint8_t i = CONTROLLER_PAK_FIRST_DATA_PAGE; i < CONTROLLER_PAK_NUM_PAGES; ++i)
+    {
+        if(pageTable[(i << 1) + 1] == CONTROLLER_PAK_PAGE_FREE)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static uint8_t findFreeNoteSlot(joypad_port_t port)
+{
+    entry_structure_t entry;
+
+    for(uint8_t i = 0; i < CONTROLLER_PAK_MAX_NOTES; ++i)
+    {
+        if(!get_mempak_entry(static_cast<int>(port), i, &entry) && !entry.valid)
+        {
+            return i;
+        }
+    }
+    return CONTROLLER_PAK_MAX_NOTES;
+}
+
+/**
+ * Converts a character of a name generated by generateControllerPakNoteName() into the character set of the Controller Pak
+ */
+static uint8_t toNoteNameCharacter(char c)
+{
+    if(c >= '0' && c <= '9')
+    {
+        return static_cast<uint8_t>(0x10 + (c - '0'));
+    }
+    else if(c >= 'A' && c <= 'Z')
+    {
+        return static_cast<uint8_t>(0x1A + (c - 'A'));
+    }
+    else if(c == '-')
+    {
+        return 0x3B;
+    }
+    // space
+    return 0x0F;
+}
+
+/**
+ * Fills in a note table entry in the same format as libdragon's write_mempak_entry_data()
+ */
+static void buildNoteEntry(uint8_t* outEntry, uint8_t firstPage, const char* noteName)
+{
+    memset(outEntry, 0, CONTROLLER_PAK_NOTE_ENTRY_SIZE);
+    memcpy(outEntry, CONTROLLER_PAK_NOTE_GAME_CODE, sizeof(CONTROLLER_PAK_NOTE_GAME_CODE));
+    memcpy(outEntry + 4, CONTROLLER_PAK_NOTE_PUBLISHER_CODE, sizeof(CONTROLLER_PAK_NOTE_PUBLISHER_CODE));
+    outEntry[7] = firstPage;
+    // status: the note is in use
+    outEntry[8] = 0x02;
+
+    for(uint8_t i = 0; i < CONTROLLER_PAK_NOTE_NAME_SIZE && noteName[i] != '\0'; ++i)
+    {
+        outEntry[0x10 + i] = toNoteNameCharacter(noteName[i]);
+    }
+}
+
+static bool findNote(joypad_port_t port, const char* noteName, entry_structure_t& outEntry)
+{
+    for(uint8_t i = 0; i < CONTROLLER_PAK_MAX_NOTES; ++i)
+    {
+        if(get_mempak_entry(static_cast<int>(port), i, &outEntry))
+        {
+            continue;
+        }
+
+        if(outEntry.valid && !strcmp(outEntry.name, noteName))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void generateControllerPakNoteName(char* outputName, const gameboy_cartridge_header& gbHeader)
+{
+    char c;
+    uint8_t i;
+
+    memcpy(outputName, "PM64 ", 5);
+    for(i = 0; i < 11; ++i)
+    {
+        c = gbHeader.new_title.title[i];
+        if(c == '\0')
+        {
+            break;
+        }
+
+        // the Controller Pak only has a limited character set. Stick to upper case letters, digits and spaces
+        if(c >= 'a' && c <= 'z')
+        {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+        else if(!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == ' '))
+        {
+            c = '-';
+        }
+        outputName[5 + i] = c;
+    }
+    outputName[5 + i] = '\0';
+}
+
+ControllerPakCopyDestination::ControllerPakCopyDestination(joypad_port_t port, const char* noteName, bool resetRTC)
+    : compressor_(nullptr)
+    , image_(nullptr)
+    , port_(port)
+    , noteName_()
+    , existingEntry_()
+    , pageTable_()
+    , pakPages_()
+    , numAvailablePages_(0)
+    , numPages_(0)
+    , numPagesWritten_(0)
+    , hasExistingEntry_(false)
+    , failed_(false)
+    , stored_(false)
+{
+    FILE* imageFile;
+    int freePages;
+
+    strncpy(noteName_, noteName, sizeof(noteName_) - 1);
+
+    if(validate_mempak(static_cast<int>(port_)))
+    {
+        debugf("[ControllerPakCopyDestination]: ERROR: no valid controller pak on port %d\r\n", static_cast<int>(port_));
+        return;
+    }
+
+    freePages = get_mempak_free_space(static_cast<int>(port_));
+    if(freePages < 0 || !readPageTable(port_, pageTable_))
+    {
+        return;
+    }
+    numAvailablePages_ = static_cast<uint8_t>(freePages);
+
+    // the previous backup of this game gets replaced, so its pages are available as well
+    hasExistingEntry_ = findNote(port_, noteName_, existingEntry_);
+    if(hasExistingEntry_)
+    {
+        numAvailablePages_ += existingEntry_.blocks;
+    }
+
+    if(!numAvailablePages_)
+    {
+        debugf("[ControllerPakCopyDestination]: ERROR: the controller pak is full\r\n");
+        return;
+    }
+
+    image_ = static_cast<uint8_t*>(malloc(numAvailablePages_ * CONTROLLER_PAK_PAGE_SIZE));
+    if(!image_)
+    {
+        return;
+    }
+
+    // the compressed data is written to the image in RAM. If it doesn't fit in the available pages, the write will fail
+    imageFile = fmemopen(image_, numAvailablePages_ * CONTROLLER_PAK_PAGE_SIZE, "wb");
+    if(!imageFile)
+    {
+        free(image_);
+        image_ = nullptr;
+        return;
+    }
+    // write() needs to find the compressed data in image_ right away to write the completed pages
+    setvbuf(imageFile, nullptr, _IONBF, 0);
+
+    compressor_ = new TransferPakCompressedFileCopyDestination(imageFile, resetRTC);
+}
+
+ControllerPakCopyDestination::~ControllerPakCopyDestination()
+{
+    close();
+}
+
+bool ControllerPakCopyDestination::readyForTransfer() const
+{
+    return (compressor_ && compressor_->readyForTransfer());
+}
+
+uint16_t ControllerPakCopyDestination::getCurrentBankIndex() const
+{
+    return 1;
+}
+
+uint32_t ControllerPakCopyDestination::getNumberOfBytesWritten() const
+{
+    return (compressor_) ? compressor_->getNumberOfBytesWritten() : 0;
+}
+
+uint32_t ControllerPakCopyDestination::write(uint8_t* buffer, uint32_t bytesToWrite)
+{
+    uint32_t ret;
+
+    if(!compressor_ || failed_)
+    {
+        return 0;
+    }
+
+    ret = compressor_->write(buffer, bytesToWrite);
+
+    // write the pages the compressor completed in the meantime. The first page gets written again by close(), once the total size is filled in.
+    if(!writePages(static_cast<uint8_t>(compressor_->getNumberOfCompressedBytesWritten() / CONTROLLER_PAK_PAGE_SIZE)))
+    {
+        return 0;
+    }
+    return ret;
+}
+
+void ControllerPakCopyDestination::close()
+{
+    uint8_t noteEntry[CONTROLLER_PAK_NOTE_ENTRY_SIZE];
+    uint32_t imageSize;
+    uint8_t noteSlot;
+    bool failed;
+
+    if(!compressor_)
+    {
+        return;
+    }
+
+    // this flushes the last block and fills in the total size in the header
+    compressor_->close();
+    imageSize = compressor_->getNumberOfCompressedBytesWritten();
+    failed = (failed_ || compressor_->hasFailed());
+
+    delete compressor_;
+    compressor_ = nullptr;
+
+    numPages_ = static_cast<uint8_t>((imageSize + CONTROLLER_PAK_PAGE_SIZE - 1) / CONTROLLER_PAK_PAGE_SIZE);
+
+    if(failed || !numPages_)
+    {
+        debugf("[ControllerPakCopyDestination]: ERROR: the data doesn't fit on the controller pak\r\n");
+        free(image_);
+        image_ = nullptr;
+        return;
+    }
+
+    memset(image_ + imageSize, 0, (numPages_ * CONTROLLER_PAK_PAGE_SIZE) - imageSize);
+
+    // only the first page (with the total size) and the last few pages (the last compressed block) remain to be written
+    if((numPagesWritten_ && !writePage(0)) || !writePages(numPages_))
+    {
+        free(image_);
+        image_ = nullptr;
+        return;
+    }
+
+    free(image_);
+    image_ = nullptr;
+
+    noteSlot = findFreeNoteSlot(port_);
+    if(noteSlot == CONTROLLER_PAK_MAX_NOTES && hasExistingEntry_)
+    {
+        if(!deleteExistingNote())
+        {
+            return;
+        }
+        noteSlot = findFreeNoteSlot(port_);
+    }
+
+    if(noteSlot == CONTROLLER_PAK_MAX_NOTES)
+    {
+        debugf("[ControllerPakCopyDestination]: ERROR: the note table of the controller pak is full\r\n");
+        return;
+    }
+
+    // now link our pages: the backup copy of the page table goes first, just like libdragon does
+    pageTable_[1] = calculatePageTableChecksum(pageTable_);
+    if(write_mempak_sector(static_cast<int>(port_), CONTROLLER_PAK_PAGE_TABLE_BACKUP_PAGE, pageTable_) || write_mempak_sector(static_cast<int>(port_), CONTROLLER_PAK_PAGE_TABLE_PAGE, pageTable_))
+    {
+        debugf("[ControllerPakCopyDestination]: ERROR: could not write the page table\r\n");
+        return;
+    }
+
+    buildNoteEntry(noteEntry, pakPages_[0], noteName_);
+    if(write_mempak_address(static_cast<int>(port_), static_cast<uint16_t>(CONTROLLER_PAK_NOTE_TABLE_PAGE * CONTROLLER_PAK_PAGE_SIZE + noteSlot * CONTROLLER_PAK_NOTE_ENTRY_SIZE), noteEntry))
+    {
+        debugf("[ControllerPakCopyDestination]: ERROR: could not write the note table entry\r\n");
+        return;
+    }
+
+    stored_ = true;
+    // there was enough room for both, so the previous backup only gets deleted now
+    if(hasExistingEntry_)
+    {
+        delete_mempak_entry(static_cast<int>(port_), &existingEntry_);
+        hasExistingEntry_ = false;
+    }
+}
+
+uint8_t ControllerPakCopyDestination::getNumberOfPages() const
+{
+    if(compressor_)
+    {
+        return static_cast<uint8_t>((compressor_->getNumberOfCompressedBytesWritten() + CONTROLLER_PAK_PAGE_SIZE - 1) / CONTROLLER_PAK_PAGE_SIZE);
+    }
+    return numPages_;
+}
+
+bool ControllerPakCopyDestination::isStored() const
+{
+    return stored_;
+}
+
+bool ControllerPakCopyDestination::writePages(uint8_t endPageIndex)
+{
+    while(numPagesWritten_ < endPageIndex)
+    {
+        if(!writePage(numPagesWritten_))
+        {
+            return false;
+        }
+        ++numPagesWritten_;
+    }
+    return true;
+}
+
+bool ControllerPakCopyDestination::writePage(uint8_t pageIndex)
+{
+    uint8_t pakPage;
+
+    if(pageIndex == numPagesWritten_)
+    {
+        pakPage = findFreePage(pageTable_);
+        // we ran out of free pages. Time to get rid of the previous backup
+        if(!pakPage && hasExistingEntry_ && deleteExistingNote())
+        {
+            pakPage = findFreePage(pageTable_);
+        }
+
+        if(!pakPage)
+        {
+            debugf("[ControllerPakCopyDestination]: ERROR: no free page left on the controller pak\r\n");
+            failed_ = true;
+            return false;
+        }
+
+        // link it to the previous page of the note. The page table only gets written to the controller pak by close()
+        if(pageIndex)
+        {
+            pageTable_[(pakPages_[pageIndex - 1] << 1) + 1] = pakPage;
+        }
+        pageTable_[(pakPage << 1) + 1] = CONTROLLER_PAK_PAGE_LAST;
+        pakPages_[pageIndex] = pakPage;
+    }
+
+    if(write_mempak_sector(static_cast<int>(port_), pakPages_[pageIndex], image_ + pageIndex * CONTROLLER_PAK_PAGE_SIZE))
+    {
+        debugf("[ControllerPakCopyDestination]: ERROR: could not write page %hu\r\n", pakPages_[pageIndex]);
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool ControllerPakCopyDestination::deleteExistingNote()
+{
+    uint8_t pakPage = static_cast<uint8_t>(existingEntry_.inode);
+    uint8_t nextPakPage;
+
+    hasExistingEntry_ = false;
+    // this only frees the pages of the old note in the page table on the controller pak. Ours aren't in there yet.
+    if(delete_mempak_entry(static_cast<int>(port_), &existingEntry_))
+    {
+        debugf("[ControllerPakCopyDestination]: ERROR: could not delete the previous note\r\n");
+        failed_ = true;
+        return false;
+    }
+
+    // so free the same pages in our copy as well
+    for(uint8_t i = 0; i < CONTROLLER_PAK_NUM_DATA_PAGES && pakPage >= CONTROLLER_PAK_FIRST_DATA_PAGE && pakPage < CONTROLLER_PAK_NUM_PAGES; ++i)
+    {
+        nextPakPage = pageTable_[(pakPage << 1) + 1];
+        pageTable_[(pakPage << 1) + 1] = CONTROLLER_PAK_PAGE_FREE;
+        pakPage = nextPakPage;
+    }
+    return true;
+}
+
+ControllerPakCopySource::ControllerPakCopySource(joypad_port_t port, const char* noteName)
+    : decompressor_(nullptr)
+    , image_(nullptr)
+{
+    entry_structure_t entry;
+    int ret;
+
+    if(validate_mempak(static_cast<int>(port)) || !findNote(port, noteName, entry))
+    {
+        debugf("[ControllerPakCopySource]: ERROR: note %s not found on port %d\r\n", noteName, static_cast<int>(port));
+        return;
+    }
+
+    image_ = static_cast<uint8_t*>(malloc(entry.blocks * CONTROLLER_PAK_PAGE_SIZE));
+    if(!image_)
+    {
+        return;
+    }
+
+    ret = read_mempak_entry_data(static_cast<int>(port), &entry, image_);
+    if(ret)
+    {
+        debugf("[ControllerPakCopySource]: ERROR: read_mempak_entry_data got error %d\r\n", ret);
+        free(image_);
+        image_ = nullptr;
+        return;
+    }
+
+    decompressor_ = new TransferPakCompressedFileCopySource(fmemopen(image_, entry.blocks * CONTROLLER_PAK_PAGE_SIZE, "rb"));
+}
+
+ControllerPakCopySource::~ControllerPakCopySource()
+{
+    // the decompressor closes the stream on top of image_, so it needs to go first
+    delete decompressor_;
+    decompressor_ = nullptr;
+    free(image_);
+    image_ = nullptr;
+}
+
+bool ControllerPakCopySource::readyForTransfer() const
+{
+    return (decompressor_ && decompressor_->readyForTransfer());
+}
+
+uint16_t ControllerPakCopySource::getCurrentBankIndex() const
+{
+    return 1;
+}
+
+uint32_t ControllerPakCopySource::getNumberOfBytesRead() const
+{
+    return (decompressor_) ? decompressor_->getNumberOfBytesRead() : 0;
+}
+
+uint32_t ControllerPakCopySource::read(uint8_t* buffer, uint32_t bytesToRead)
+{
+    return (decompressor_) ? decompressor_->read(buffer, bytesToRead) : 0;
+}
+
+uint32_t ControllerPakCopySource::getTotalSize() const
+{
+    return (decompressor_) ? decompressor_->getTotalSize() : 0;
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "transferpak/CopyJobQueue.h"
+
+#include <libdragon.h>
+#include <cstring>
+
+CopyJobQueue::CopyJobQueue()
+    : jobs_()
+    , numJobs_(0)
+    , currentJobIndex_(0)
+{
+}
+
+CopyJobQueue::~CopyJobQueue()
+{
+    clear();
+}
+
+bool CopyJobQueue::addJob(ITransferPakDataCopySource* source, ITransferPakDataCopyDestination* destination, uint32_t totalBytes, ITransferPakDataCopyDestination* extraDestination)
+{
+    if(numJobs_ >= COPY_JOB_QUEUE_MAX_JOBS)
+    {
+        debugf("[CopyJobQueue]: ERROR: the queue is full\r\n");
+        delete source;
+        delete destination;
+        delete extraDestination;
+        return false;
+    }
+
+    CopyJob& job = jobs_[numJobs_];
+    job = {
+        .source = source,
+        .destination = destination,
+        .extraDestination = extraDestination,
+        .copier = nullptr,
+        .totalBytes = totalBytes,
+        .startTime = 0,
+        .endTime = 0,
+        .failed = false,
+        .done = false
+    };
+    ++numJobs_;
+    return true;
+}
+
+uint8_t CopyJobQueue::getNumberOfJobs() const
+{
+    return numJobs_;
+}
+
+const CopyJob& CopyJobQueue::getJob(uint8_t index) const
+{
+    return jobs_[index];
+}
+
+uint8_t CopyJobQueue::getCurrentJobIndex() const
+{
+    return currentJobIndex_;
+}
+
+uint32_t CopyJobQueue::getTotalBytes() const
+{
+    uint32_t ret = 0;
+
+    for(uint8_t i = 0; i < numJobs_; ++i)
+    {
+        ret += jobs_[i].totalBytes;
+    }
+    return ret;
+}
+
+uint32_t CopyJobQueue::getTotalBytesCopied() const
+{
+    uint32_t ret = 0;
+
+    for(uint8_t i = 0; i < numJobs_; ++i)
+    {
+        if(jobs_[i].done)
+        {
+            // count failed jobs as complete. Otherwise the progress bar would never reach the end
+            ret += jobs_[i].totalBytes;
+        }
+        else if(jobs_[i].copier)
+        {
+            ret += jobs_[i].copier->getNumberOfBytesRead();
+        }
+    }
+    return ret;
+}
+
+bool CopyJobQueue::isDone() const
+{
+    return (currentJobIndex_ >= numJobs_);
+}
+
+bool CopyJobQueue::hasFailedJobs() const
+{
+    for(uint8_t i = 0; i < numJobs_; ++i)
+    {
+        if(jobs_[i].failed)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CopyJobQueue::processChunk(uint32_t numBytesToCopy)
+{
+    if(isDone())
+    {
+        return;
+    }
+
+    CopyJob& job = jobs_[currentJobIndex_];
+    if(!job.copier)
+    {
+        startJob(job);
+    }
+
+    // an empty job (for instance: a cartridge without SRAM) has nothing to copy and is done right away
+    if(!job.failed && job.totalBytes)
+    {
+        const uint32_t bytesRead = job.copier->getNumberOfBytesRead();
+        const uint32_t bytesToCopy = (numBytesToCopy < job.totalBytes - bytesRead) ? numBytesToCopy : (job.totalBytes - bytesRead);
+
+        // the primary destination (index 0) is the one the user asked for. If that one fails, there's no point in continuing the job.
+        // the extra destination failing doesn't abort the job though.
+        if(!job.copier->copyChunk(bytesToCopy) || job.copier->isDestinationFailed(0))
+        {
+            job.failed = true;
+        }
+    }
+
+    if(job.failed || job.copier->getNumberOfBytesRead() >= job.totalBytes)
+    {
+        finishJob(job);
+        ++currentJobIndex_;
+    }
+}
+
+void CopyJobQueue::clear()
+{
+    for(uint8_t i = 0; i < numJobs_; ++i)
+    {
+        delete jobs_[i].copier;
+        delete jobs_[i].source;
+        delete jobs_[i].destination;
+        delete jobs_[i].extraDestination;
+    }
+    memset(jobs_, 0, sizeof(jobs_));
+    numJobs_ = 0;
+    currentJobIndex_ = 0;
+}
+
+void CopyJobQueue::startJob(CopyJob& job)
+{
+    job.startTime = get_ticks();
+    job.copier = new TransferPakDataCopier(*job.source, *job.destination);
+    if(job.extraDestination)
+    {
+        job.copier->addDestination(*job.extraDestination);
+    }
+    job.failed = (!job.source->readyForTransfer() || job.copier->isDestinationFailed(0));
+}
+
+void CopyJobQueue::finishJob(CopyJob& job)
+{
+    job.destination->close();
+    if(job.extraDestination)
+    {
+        job.extraDestination->close();
+    }
+    job.endTime = get_ticks();
+    job.done = true;
+}
@@ -1,8 +1,32 @@
 #include "transferpak/TransferPakDataCopier.h"
 #include "transferpak/TransferPakRomReader.h"
 #include "transferpak/TransferPakSaveManager.h"
+#include "core/Hash.h"
 
+#include <libdragon.h>
 #include <cstring>
+#include <cstdlib>
+
+/**
+ * The game checks bit 7 on the sRTCStatusFlags field in SRAM
+ * this is set when the game detects wrong RTC register values.
+ * In order to let the game prompt to reconfigure the RTC clock, we just have to set this bit
+ * Based on sRTCStatusFlags, RecordRTCStatus, .set_bit_7 in
+ * https://github.com/pret/pokecrystal
+ * https://github.com/pret/pokegold
+ */
+static const uint32_t GEN2_RTC_STATUS_FLAGS_OFFSET = 0xC60;
+static const uint8_t GEN2_RTC_STATUS_FLAGS_RESET_VALUE = 0xC0;
+
+/**
+ * The compressed file format is:
+ * - a file header: magic (4 bytes) + total uncompressed size (4 bytes, big endian)
+ * - a sequence of blocks: uncompressed size (2 bytes, big endian) + stored size (2 bytes, big endian) + stored data
+ * If the stored size equals the uncompressed size, the block is stored uncompressed.
+ */
+static const char COMPRESSED_FILE_MAGIC[4] = {'P', 'M', 'L', 'Z'};
+static const uint8_t COMPRESSED_FILE_HEADER_SIZE = 8;
+static const uint8_t COMPRESSED_BLOCK_HEADER_SIZE = 4;
 
 ITransferPakDataCopySource::~ITransferPakDataCopySource()
 {
@@ -121,6 +145,129 @@ uint32_t TransferPakFileCopySource::read(uint8_t* buffer, uint32_t bytesToRead)
     return ret;
 }
 
+TransferPakCompressedFileCopySource::TransferPakCompressedFileCopySource(const char* filePath)
+    : TransferPakCompressedFileCopySource(fopen(filePath, "r"))
+{
+}
+
+TransferPakCompressedFileCopySource::TransferPakCompressedFileCopySource(FILE* inputFile)
+    : inputFile_(inputFile)
+    , blockBuffer_()
+    , compressedBuffer_()
+    , bytesRead_(0)
+    , totalSize_(0)
+    , blockSize_(0)
+    , blockOffset_(0)
+    , valid_(false)
+{
+    uint8_t header[COMPRESSED_FILE_HEADER_SIZE];
+
+    if(!inputFile_)
+    {
+        return;
+    }
+
+    if(fread(header, 1, sizeof(header), inputFile_) != sizeof(header) || memcmp(header, COMPRESSED_FILE_MAGIC, sizeof(COMPRESSED_FILE_MAGIC)))
+    {
+        return;
+    }
+    totalSize_ = (static_cast<uint32_t>(header[4]) << 24) | (static_cast<uint32_t>(header[5]) << 16) | (static_cast<uint32_t>(header[6]) << 8) | header[7];
+    valid_ = true;
+}
+
+TransferPakCompressedFileCopySource::~TransferPakCompressedFileCopySource()
+{
+    if(inputFile_)
+    {
+        fclose(inputFile_);
+        inputFile_ = nullptr;
+    }
+}
+
+bool TransferPakCompressedFileCopySource::readyForTransfer() const
+{
+    return (inputFile_ != nullptr && valid_);
+}
+
+uint16_t TransferPakCompressedFileCopySource::getCurrentBankIndex() const
+{
+    return 1;
+}
+
+uint32_t TransferPakCompressedFileCopySource::getNumberOfBytesRead() const
+{
+    return bytesRead_;
+}
+
+uint32_t TransferPakCompressedFileCopySource::read(uint8_t* buffer, uint32_t bytesToRead)
+{
+    uint32_t bytesRemaining = bytesToRead;
+    uint16_t currentRead;
+
+    while(bytesRemaining > 0)
+    {
+        if(blockOffset_ >= blockSize_ && !loadNextBlock())
+        {
+            break;
+        }
+
+        currentRead = static_cast<uint16_t>((bytesRemaining < static_cast<uint32_t>(blockSize_ - blockOffset_)) ? bytesRemaining : (blockSize_ - blockOffset_));
+        memcpy(buffer, blockBuffer_ + blockOffset_, currentRead);
+        buffer += currentRead;
+        blockOffset_ += currentRead;
+        bytesRemaining -= currentRead;
+    }
+
+    const uint32_t ret = bytesToRead - bytesRemaining;
+    bytesRead_ += ret;
+    return ret;
+}
+
+uint32_t TransferPakCompressedFileCopySource::getTotalSize() const
+{
+    return totalSize_;
+}
+
+bool TransferPakCompressedFileCopySource::loadNextBlock()
+{
+    uint8_t blockHeader[COMPRESSED_BLOCK_HEADER_SIZE];
+    uint16_t rawSize;
+    uint16_t storedSize;
+
+    if(!valid_ || fread(blockHeader, 1, sizeof(blockHeader), inputFile_) != sizeof(blockHeader))
+    {
+        return false;
+    }
+
+    rawSize = static_cast<uint16_t>((blockHeader[0] << 8) | blockHeader[1]);
+    storedSize = static_cast<uint16_t>((blockHeader[2] << 8) | blockHeader[3]);
+
+    if(!rawSize || rawSize > LZ_MAX_BLOCK_SIZE || storedSize > rawSize)
+    {
+        valid_ = false;
+        return false;
+    }
+
+    if(storedSize == rawSize)
+    {
+        // block was stored uncompressed
+        valid_ = (fread(blockBuffer_, 1, rawSize, inputFile_) == rawSize);
+    }
+    else
+    {
+        valid_ = (fread(compressedBuffer_, 1, storedSize, inputFile_) == storedSize) && (lzDecompressBlock(compressedBuffer_, storedSize, blockBuffer_, rawSize) == rawSize);
+    }
+
+    if(!valid_)
+    {
+        return false;
+    }
+
+    blockSize_ = rawSize;
+    blockOffset_ = 0;
+    return true;
+}
+
 TransferPakNullCopySource::TransferPakNullCopySource()
     : bytesRead_(0)
 {
@@ -189,6 +336,108 @@ void TransferPakSaveManagerDestination::close()
     // dummy
 }
 
+TransferPakSaveManagerDiffDestination::TransferPakSaveManagerDiffDestination(TransferPakSaveManager& saveManager)
+    : saveManager_(saveManager)
+    , blockBuffer_()
+    , bytesWritten_(0)
+    , numBlocksCompared_(0)
+    , numBlocksWritten_(0)
+    , numBlockErrors_(0)
+    , blockBufferUsed_(0)
+{
+}
+
+TransferPakSaveManagerDiffDestination::~TransferPakSaveManagerDiffDestination()
+{
+    close();
+}
+
+bool TransferPakSaveManagerDiffDestination::readyForTransfer() const
+{
+    return true;
+}
+
+uint16_t TransferPakSaveManagerDiffDestination::getCurrentBankIndex() const
+{
+    return saveManager_.getCurrentBankIndex();
+}
+
+uint32_t TransferPakSaveManagerDiffDestination::getNumberOfBytesWritten() const
+{
+    return bytesWritten_;
+}
+
+uint32_t TransferPakSaveManagerDiffDestination::write(uint8_t* buffer, uint32_t bytesToWrite)
+{
+    uint32_t bytesRemaining = bytesToWrite;
+    uint8_t currentWrite;
+
+    while(bytesRemaining > 0)
+    {
+        currentWrite = static_cast<uint8_t>((bytesRemaining < static_cast<uint32_t>(TPAK_BLOCK_SIZE - blockBufferUsed_)) ? bytesRemaining : (TPAK_BLOCK_SIZE - blockBufferUsed_));
+        memcpy(blockBuffer_ + blockBufferUsed_, buffer, currentWrite);
+        buffer += currentWrite;
+        blockBufferUsed_ += currentWrite;
+        bytesRemaining -= currentWrite;
+
+        if(blockBufferUsed_ == TPAK_BLOCK_SIZE)
+        {
+            flushBlock();
+        }
+    }
+    bytesWritten_ += bytesToWrite;
+    return bytesToWrite;
+}
+
+void TransferPakSaveManagerDiffDestination::close()
+{
+    if(!blockBufferUsed_)
+    {
+        return;
+    }
+
+    // SRAM sizes are always a multiple of 32 bytes, so this only happens if the copy was aborted halfway.
+    // Fall back to a regular read-modify-write for the remaining bytes
+    saveManager_.write(blockBuffer_, blockBufferUsed_);
+    blockBufferUsed_ = 0;
+}
+
+uint32_t TransferPakSaveManagerDiffDestination::getNumberOfBlocksCompared() const
+{
+    return numBlocksCompared_;
+}
+
+uint32_t TransferPakSaveManagerDiffDestination::getNumberOfBlocksWritten() const
+{
+    return numBlocksWritten_;
+}
+
+uint32_t TransferPakSaveManagerDiffDestination::getNumberOfBlockErrors() const
+{
+    return numBlockErrors_;
+}
+
+void TransferPakSaveManagerDiffDestination::flushBlock()
+{
+    const SRAMBlockWriteResult result = saveManager_.writeBlockIfChanged(blockBuffer_);
+
+    ++numBlocksCompared_;
+    switch(result)
+    {
+        case SRAMBlockWriteResult::UNCHANGED:
+            break;
+        case SRAMBlockWriteResult::WRITTEN:
+            ++numBlocksWritten_;
+            break;
+        case SRAMBlockWriteResult::VERIFY_FAILED:
+        case SRAMBlockWriteResult::TRANSFER_ERROR:
+            ++numBlocksWritten_;
+            ++numBlockErrors_;
+            break;
+    }
+    blockBufferUsed_ = 0;
+}
+
 TransferPakFileCopyDestination::TransferPakFileCopyDestination(const char* pathOnSDCard, bool resetRTC)
     : outputFile_(nullptr)
     , bytesWritten_(0)
@@ -233,14 +482,8 @@ void TransferPakFileCopyDestination::close()
 
     if(resetRTC_)
     {
-        // The game checks bit 7 on the sRTCStatusFlags field in SRAM
-        // this is set when the game detects wrong RTC register values.
-        // In order to let the game prompt to reconfigure the RTC clock, we just have to set this bit
-        // Based on sRTCStatusFlags, RecordRTCStatus, .set_bit_7 in
-        // https://github.com/pret/pokecrystal
-        // https://github.com/pret/pokegold
-        const uint8_t rtcStatusFieldValue = 0xC0;
-        if(fseek(outputFile_, 0xC60, SEEK_SET) == 0)
+        const uint8_t rtcStatusFieldValue = GEN2_RTC_STATUS_FLAGS_RESET_VALUE;
+        if(fseek(outputFile_, GEN2_RTC_STATUS_FLAGS_OFFSET, SEEK_SET) == 0)
         {
             // seek successful
             fwrite(&rtcStatusFieldValue, 1, 1, outputFile_);
@@ -251,16 +494,303 @@ void TransferPakFileCopyDestination::close()
     outputFile_ = nullptr;
 }
 
+TransferPakCompressedFileCopyDestination::TransferPakCompressedFileCopyDestination(const char* pathOnSDCard, bool resetRTC)
+    : TransferPakCompressedFileCopyDestination(fopen(pathOnSDCard, "w"), resetRTC)
+{
+    // we need to know the path to be able to remove the file again if writing it fails
+    outputPath_ = strdup(pathOnSDCard);
+}
+
+TransferPakCompressedFileCopyDestination::TransferPakCompressedFileCopyDestination(FILE* outputFile, bool resetRTC)
+    : outputFile_(outputFile)
+    , outputPath_(nullptr)
+    , blockBuffer_()
+    , compressedBuffer_()
+    , hashTable_()
+    , bytesWritten_(0)
+    , compressedBytesWritten_(0)
+    , blockBufferUsed_(0)
+    , resetRTC_(resetRTC)
+    , failed_(false)
+{
+    uint8_t header[COMPRESSED_FILE_HEADER_SIZE] = {0};
+
+    if(!outputFile_)
+    {
+        return;
+    }
+
+    // the total size gets filled in when we close the file
+    memcpy(header, COMPRESSED_FILE_MAGIC, sizeof(COMPRESSED_FILE_MAGIC));
+    failed_ = (fwrite(header, 1, sizeof(header), outputFile_) != sizeof(header));
+    compressedBytesWritten_ = sizeof(header);
+}
+
+TransferPakCompressedFileCopyDestination::~TransferPakCompressedFileCopyDestination()
+{
+    close();
+    free(outputPath_);
+    outputPath_ = nullptr;
+}
+
+bool TransferPakCompressedFileCopyDestination::readyForTransfer() const
+{
+    return (outputFile_ != nullptr && !failed_);
+}
+
+uint16_t TransferPakCompressedFileCopyDestination::getCurrentBankIndex() const
+{
+    return 1;
+}
+
+uint32_t TransferPakCompressedFileCopyDestination::getNumberOfBytesWritten() const
+{
+    return bytesWritten_;
+}
+
+uint32_t TransferPakCompressedFileCopyDestination::write(uint8_t* buffer, uint32_t bytesToWrite)
+{
+    uint32_t bytesRemaining = bytesToWrite;
+    uint16_t currentWrite;
+
+    if(!outputFile_ || failed_)
+    {
+        return 0;
+    }
+
+    while(bytesRemaining > 0)
+    {
+        currentWrite = static_cast<uint16_t>((bytesRemaining < static_cast<uint32_t>(LZ_MAX_BLOCK_SIZE - blockBufferUsed_)) ? bytesRemaining : (LZ_MAX_BLOCK_SIZE - blockBufferUsed_));
+        memcpy(blockBuffer_ + blockBufferUsed_, buffer, currentWrite);
+        buffer += currentWrite;
+        blockBufferUsed_ += currentWrite;
+        bytesRemaining -= currentWrite;
+
+        if(blockBufferUsed_ == LZ_MAX_BLOCK_SIZE && !flushBlock())
+        {
+            break;
+        }
+    }
+
+    const uint32_t ret = bytesToWrite - bytesRemaining;
+    bytesWritten_ += ret;
+    return ret;
+}
+
+void TransferPakCompressedFileCopyDestination::close()
+{
+    uint8_t totalSize[4];
+
+    if(!outputFile_)
+    {
+        return;
+    }
+
+    if(blockBufferUsed_ && !failed_)
+    {
+        flushBlock();
+    }
+
+    // a file with a valid total size, but missing blocks would look like a valid backup. So we only fill in the size if everything was written
+    if(!failed_)
+    {
+        totalSize[0] = static_cast<uint8_t>(bytesWritten_ >> 24);
+        totalSize[1] = static_cast<uint8_t>(bytesWritten_ >> 16);
+        totalSize[2] = static_cast<uint8_t>(bytesWritten_ >> 8);
+        totalSize[3] = static_cast<uint8_t>(bytesWritten_);
+        failed_ = (fseek(outputFile_, sizeof(COMPRESSED_FILE_MAGIC), SEEK_SET) != 0 || fwrite(totalSize, 1, sizeof(totalSize), outputFile_) != sizeof(totalSize));
+    }
+
+    if(fclose(outputFile_) != 0)
+    {
+        failed_ = true;
+    }
+    outputFile_ = nullptr;
+
+    if(failed_ && outputPath_)
+    {
+        debugf("[TransferPakCompressedFileCopyDestination]: ERROR: could not write %s. Removing it\r\n", outputPath_);
+        remove(outputPath_);
+    }
+}
+
+uint32_t TransferPakCompressedFileCopyDestination::getNumberOfCompressedBytesWritten() const
+{
+    return compressedBytesWritten_;
+}
+
+bool TransferPakCompressedFileCopyDestination::hasFailed() const
+{
+    return failed_;
+}
+
+bool TransferPakCompressedFileCopyDestination::flushBlock()
+{
+    uint8_t blockHeader[COMPRESSED_BLOCK_HEADER_SIZE];
+    // bytesWritten_ doesn't include the current block yet.
+    const uint32_t blockStartOffset = bytesWritten_ - (bytesWritten_ % LZ_MAX_BLOCK_SIZE);
+    const uint8_t* storedData;
+    uint16_t storedSize;
+
+    if(resetRTC_ && GEN2_RTC_STATUS_FLAGS_OFFSET >= blockStartOffset && GEN2_RTC_STATUS_FLAGS_OFFSET < blockStartOffset + blockBufferUsed_)
+    {
+        // see TransferPakFileCopyDestination::close(). We can't patch the compressed file afterwards, so we patch the block instead
+        blockBuffer_[GEN2_RTC_STATUS_FLAGS_OFFSET - blockStartOffset] = GEN2_RTC_STATUS_FLAGS_RESET_VALUE;
+    }
+
+    // we only accept the compressed data if it's smaller than the input. Otherwise we store the block as-is
+    storedSize = lzCompressBlock(blockBuffer_, blockBufferUsed_, compressedBuffer_, blockBufferUsed_ - 1, hashTable_);
+    if(storedSize)
+    {
+        storedData = compressedBuffer_;
+    }
+    else
+    {
+        storedData = blockBuffer_;
+        storedSize = blockBufferUsed_;
+    }
+
+    blockHeader[0] = static_cast<uint8_t>(blockBufferUsed_ >> 8);
+    blockHeader[1] = static_cast<uint8_t>(blockBufferUsed_);
+    blockHeader[2] = static_cast<uint8_t>(storedSize >> 8);
+    blockHeader[3] = static_cast<uint8_t>(storedSize);
+
+    if(fwrite(blockHeader, 1, sizeof(blockHeader), outputFile_) != sizeof(blockHeader) || fwrite(storedData, 1, storedSize, outputFile_) != storedSize)
+    {
+        debugf("[TransferPakCompressedFileCopyDestination]: ERROR: could not write block\r\n");
+        failed_ = true;
+        return false;
+    }
+
+    compressedBytesWritten_ += sizeof(blockHeader) + storedSize;
+    blockBufferUsed_ = 0;
+    return true;
+}
+
+TransferPakHashCopyDestination::TransferPakHashCopyDestination()
+    : checksumRegion_({0})
+    , crc_(0)
+    , bytesWritten_(0)
+    , byteSum_(0)
+    , storedChecksum_(0)
+    , checksumGeneration_(0)
+    , checksumValid_(false)
+{
+}
+
+TransferPakHashCopyDestination::~TransferPakHashCopyDestination()
+{
+}
+
+bool TransferPakHashCopyDestination::readyForTransfer() const
+{
+    return true;
+}
+
+uint16_t TransferPakHashCopyDestination::getCurrentBankIndex() const
+{
+    return 1;
+}
+
+uint32_t TransferPakHashCopyDestination::getNumberOfBytesWritten() const
+{
+    return bytesWritten_;
+}
+
+uint32_t TransferPakHashCopyDestination::write(uint8_t* buffer, uint32_t bytesToWrite)
+{
+    crc_ = crc32(buffer, bytesToWrite, crc_);
+    if(checksumGeneration_)
+    {
+        updateMainChecksum(buffer, bytesToWrite);
+    }
+    bytesWritten_ += bytesToWrite;
+    return bytesToWrite;
+}
+
+void TransferPakHashCopyDestination::close()
+{
+    const uint32_t checksumEndOffset = checksumRegion_.checksumOffset + ((checksumGeneration_ == 1) ? 1 : 2);
+
+    if(!checksumGeneration_ || bytesWritten_ <= checksumRegion_.endOffset || bytesWritten_ < checksumEndOffset)
+    {
+        // we didn't get to see the whole region and the stored checksum
+        checksumValid_ = false;
+        return;
+    }
+
+    // Gen 1 stores the inverted 8 bit sum. Gen 2 stores the 16 bit sum
+    checksumValid_ = (checksumGeneration_ == 1) ? (storedChecksum_ == static_cast<uint8_t>(~byteSum_)) : (storedChecksum_ == static_cast<uint16_t>(byteSum_));
+}
+
+uint32_t TransferPakHashCopyDestination::getCRC32() const
+{
+    return crc_;
+}
+
+void TransferPakHashCopyDestination::setMainChecksumRegion(uint8_t generation, const SaveChecksumRegion& region)
+{
+    checksumRegion_ = region;
+    checksumGeneration_ = generation;
+    byteSum_ = 0;
+    storedChecksum_ = 0;
+}
+
+bool TransferPakHashCopyDestination::isMainChecksumValid() const
+{
+    return checksumValid_;
+}
+
+void TransferPakHashCopyDestination::updateMainChecksum(const uint8_t* buffer, uint32_t size)
+{
+    const uint32_t bufferEndOffset = bytesWritten_ + size;
+    const uint32_t sumStartOffset = (bytesWritten_ > checksumRegion_.startOffset) ? bytesWritten_ : checksumRegion_.startOffset;
+    const uint32_t sumEndOffset = (bufferEndOffset < checksumRegion_.endOffset + 1) ? bufferEndOffset : checksumRegion_.endOffset + 1;
+    const uint8_t checksumSize = (checksumGeneration_ == 1) ? 1 : 2;
+    uint32_t offset;
+
+    for(offset = sumStartOffset; offset < sumEndOffset; ++offset)
+    {
+        byteSum_ += buffer[offset - bytesWritten_];
+    }
+
+    // the stored checksum. Gen 2 stores it in little endian
+    for(uint8_t i = 0; i < checksumSize; ++i)
+    {
+        offset = checksumRegion_.checksumOffset + i;
+        if(offset >= bytesWritten_ && offset < bufferEndOffset)
+        {
+            storedChecksum_ |= static_cast<uint16_t>(buffer[offset - bytesWritten_] << (i * 8));
+        }
+    }
+}
+
 TransferPakDataCopier::TransferPakDataCopier(ITransferPakDataCopySource& source, ITransferPakDataCopyDestination& destination)
     : source_(source)
-    , destination_(destination)
+    , destinations_()
+    , destinationFailed_()
+    , numDestinations_(0)
 {
+    addDestination(destination);
 }
 
 TransferPakDataCopier::~TransferPakDataCopier()
 {
 }
 
+bool TransferPakDataCopier::addDestination(ITransferPakDataCopyDestination& destination)
+{
+    if(numDestinations_ >= TRANSFERPAK_DATACOPIER_MAX_DESTINATIONS)
+    {
+        return false;
+    }
+
+    destinations_[numDestinations_] = &destination;
+    destinationFailed_[numDestinations_] = !destination.readyForTransfer();
+    ++numDestinations_;
+    return true;
+}
+
 uint16_t TransferPakDataCopier::getCurrentBankIndex() const
 {
     return source_.getCurrentBankIndex();
@@ -277,19 +807,64 @@ size_t TransferPakDataCopier::copyChunk(uint32_t numBytesToCopy)
     uint8_t buffer[bufferSize];
     uint32_t bytesRemaining = numBytesToCopy;
     uint32_t bytesToRead;
+    uint32_t bytesRead;
+    bool anyDestinationLeft;
 
     while(bytesRemaining > 0)
     {
         bytesToRead = (bufferSize < bytesRemaining) ? bufferSize : bytesRemaining;
 
-        if(!source_.read(buffer, bytesToRead))
+        bytesRead = source_.read(buffer, bytesToRead);
+        if(!bytesRead)
         {
             // no bytes read. Abort
             break;
         }
 
-        // now write the bytes to the destination
-        bytesRemaining -= destination_.write(buffer, bytesToRead);
+        // now write the bytes to every destination
+        anyDestinationLeft = false;
+        for(uint8_t i = 0; i < numDestinations_; ++i)
+        {
+            if(!destinationFailed_[i])
+            {
+                destinationFailed_[i] = !writeToDestination(i, buffer, bytesRead);
+                anyDestinationLeft |= !destinationFailed_[i];
+            }
+        }
+        bytesRemaining -= bytesRead;
+
+        if(!anyDestinationLeft)
+        {
+            // there's no point in reading more
+            break;
+        }
     }
     return numBytesToCopy - bytesRemaining;
+}
+
+bool TransferPakDataCopier::isDestinationFailed(uint8_t index) const
+{
+    return (index >= numDestinations_ || destinationFailed_[index]);
+}
+
+bool TransferPakDataCopier::writeToDestination(uint8_t index, uint8_t* buffer, uint32_t bytesToWrite)
+{
+    // A destination may accept less than we offered (for example: a full SD card buffer).
+    // we keep offering the rest as long as it makes progress. If it doesn't accept anything anymore, it has failed.
+    // The data was only read once, so we can't give it another chance later on.
+    ITransferPakDataCopyDestination& destination = *destinations_[index];
+    uint32_t bytesWritten;
+
+    while(bytesToWrite > 0)
+    {
+        bytesWritten = destination.write(buffer, bytesToWrite);
+        if(!bytesWritten)
+        {
+            debugf("[TransferPakDataCopier]: destination %hu stopped accepting data\r\n", index);
+            return false;
+        }
+        buffer += bytesWritten;
+        bytesToWrite -= bytesWritten;
+    }
+    return true;
 }
\ No newline at end of file
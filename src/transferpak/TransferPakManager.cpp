@@ -7,9 +7,16 @@
 #define TPAK_ADDRESS_DATA   0xC000
 
 static const uint16_t sramBankStartGBAddress = 0xA000;
+static const uint16_t sramBankEndGBAddress = 0xC000;
+
+ITransferPakSRAMWriteListener::~ITransferPakSRAMWriteListener()
+{
+}
 
 TransferPakManager::TransferPakManager()
-    : port_(JOYPAD_PORT_1)
+    : virtualCartridge_()
+    , sramWriteListener_(nullptr)
+    , port_(JOYPAD_PORT_1)
     , isPoweredOn_(false)
     , currentSRAMBank_(0)
     , readBufferBankOffset_(0xFFFF)
@@ -39,6 +46,12 @@ void TransferPakManager::setPort(joypad_port_t port)
 
 bool TransferPakManager::hasTransferPak()
 {
+    if(isVirtualROM())
+    {
+        // the virtual cartridge doesn't need the transfer pak at all
+        return true;
+    }
+
     if(!joypad_is_connected(port_))
     {
         debugf("[TransferPakManager]: joypad not connected %d\r\n", (int)port_);
@@ -60,6 +73,12 @@ bool TransferPakManager::setPower(bool on)
     uint8_t status;
     int ret;
 
+    if(isVirtualROM())
+    {
+        isPoweredOn_ = on;
+        return true;
+    }
+
     if(on)
     {
         ret = tpak_init(static_cast<int>(port_));
@@ -97,14 +116,24 @@ bool TransferPakManager::setPower(bool on)
 
 uint8_t TransferPakManager::getStatus()
 {
+    if(isVirtualROM())
+    {
+        return TPAK_STATUS_READY;
+    }
     return tpak_get_status(static_cast<int>(port_));
 }
 
 bool TransferPakManager::readCartridgeHeader(gameboy_cartridge_header& cartridgeHeader)
 {
-    uint8_t status = getStatus();
+    uint8_t status;
     int ret;
 
+    if(isVirtualROM())
+    {
+        return virtualCartridge_.readCartridgeHeader(cartridgeHeader);
+    }
+
+    status = getStatus();
     while(!(status | TPAK_STATUS_READY))
     {
         debugf("[TransferPakManager]: ERROR: transfer pak not ready yet. Current status is %hu\r\n", status);
@@ -132,8 +161,15 @@ void TransferPakManager::switchGBROMBank(uint8_t bankIndex)
 
 //  debugf("[TransferPakManager]: %s(%hu)\r\n", __FUNCTION__, bankIndex);
 
-    memset(data, bankIndex, TPAK_BLOCK_SIZE);
-    tpak_write(port_, 0x2000, data, TPAK_BLOCK_SIZE);
+    if(isVirtualROM())
+    {
+        virtualCartridge_.switchROMBank(bankIndex);
+    }
+    else
+    {
+        memset(data, bankIndex, TPAK_BLOCK_SIZE);
+        tpak_write(port_, 0x2000, data, TPAK_BLOCK_SIZE);
+    }
 
     // invalidate read buffer
     readBufferBankOffset_ = 0xFFFF;
@@ -145,6 +181,21 @@ void TransferPakManager::setRAMEnabled(bool enabled)
 
 //  debugf("[TransferPakManager]: %s(%d)\r\n", __FUNCTION__, enabled);
 
+    if(virtualCartridge_.isOpen())
+    {
+        // the SRAM of the virtual cartridge is always accessible. But disabling it marks the end of an edit or copy job:
+        // that's when the changes need to go to the .sav file, so that they survive the console being turned off.
+        if(!enabled)
+        {
+            finishWrites();
+            if(!virtualCartridge_.writeBack())
+            {
+                debugf("[TransferPakManager]: ERROR: could not write back the virtual cartridge. The changes are kept in RAM\r\n");
+            }
+        }
+        return;
+    }
+
     const uint8_t valueToWrite = (enabled) ? 0xA : 0x0;
     memset(data, valueToWrite, TPAK_BLOCK_SIZE);
 
@@ -171,8 +222,11 @@ void TransferPakManager::switchGBSRAMBank(uint8_t bankIndex)
     // make sure to finish any writes in the write buffer before switching
     finishWrites();
     
-    memset(data, bankIndex, TPAK_BLOCK_SIZE);
-    tpak_write(port_, 0x4000, data, TPAK_BLOCK_SIZE);
+    if(!virtualCartridge_.isOpen())
+    {
+        memset(data, bankIndex, TPAK_BLOCK_SIZE);
+        tpak_write(port_, 0x4000, data, TPAK_BLOCK_SIZE);
+    }
 
     currentSRAMBank_ = bankIndex;
     // invalidate read and write buffer
@@ -180,6 +234,11 @@ void TransferPakManager::switchGBSRAMBank(uint8_t bankIndex)
     writeBufferSRAMBankOffset_ = 0xFFFF;
 }
 
+uint8_t TransferPakManager::getCurrentGBSRAMBank() const
+{
+    return currentSRAMBank_;
+}
+
 void TransferPakManager::switchMBC1BankingMode(uint8_t mode)
 {
     uint8_t data[TPAK_BLOCK_SIZE];
@@ -188,8 +247,11 @@ void TransferPakManager::switchMBC1BankingMode(uint8_t mode)
     // make sure to finish any writes in the write buffer before switching
     finishWrites();
 
-    memset(data, mode, TPAK_BLOCK_SIZE);
-    tpak_write(port_, 0x6000, data, TPAK_BLOCK_SIZE);
+    if(!isVirtualROM())
+    {
+        memset(data, mode, TPAK_BLOCK_SIZE);
+        tpak_write(port_, 0x6000, data, TPAK_BLOCK_SIZE);
+    }
 
     // invalidate read and write buffer
     readBufferBankOffset_ = 0xFFFF;
@@ -214,7 +276,7 @@ void TransferPakManager::read(uint16_t gbAddress, uint8_t* data, uint16_t size)
         readBufferBankOffset_ = alignedGbAddress;
         // we need to read into the readBuffer first
 //      debugf("[TransferPakManager]: %s -> tpak_read(%d, 0x%x, %p, %u)\r\n", __FUNCTION__, port_, readBufferBankOffset_, readBuffer_, TPAK_BLOCK_SIZE);
-        tpak_read(port_, readBufferBankOffset_, readBuffer_, TPAK_BLOCK_SIZE);
+        readBlock(readBufferBankOffset_, readBuffer_);
     }
 
 
@@ -236,7 +298,7 @@ void TransferPakManager::read(uint16_t gbAddress, uint8_t* data, uint16_t size)
             readBufferBankOffset_ += TPAK_BLOCK_SIZE;
             readBufOffset = 0;
 //          debugf("[TransferPakManager]: %s -> tpak_read(%d, 0x%x, %p, %u)\r\n", __FUNCTION__, port_, readBufferBankOffset_, readBuffer_, TPAK_BLOCK_SIZE);
-            tpak_read(port_, readBufferBankOffset_, readBuffer_, TPAK_BLOCK_SIZE);
+            readBlock(readBufferBankOffset_, readBuffer_);
         }
     }
 }
@@ -279,6 +341,10 @@ void TransferPakManager::writeSRAM(uint16_t SRAMBankOffset, const uint8_t* data,
         // don't modify writeBufferSRAMBankOffset_ before calling readSRAM, otherwise finishWrites() will write whatever
         // is in the writeBuffer because writeBufferSRAMBankOffset_ wouldn't be 0xFFFF anymore
         writeBufferSRAMBankOffset_ = alignedSRAMBankOffset;
+        if(sramWriteListener_)
+        {
+            sramWriteListener_->onBeforeSRAMBlockWrite(currentSRAMBank_, writeBufferSRAMBankOffset_, writeBuffer_);
+        }
     }
 
     while(bytesRemaining > 0)
@@ -301,6 +367,10 @@ void TransferPakManager::writeSRAM(uint16_t SRAMBankOffset, const uint8_t* data,
             // don't modify writeBufferSRAMBankOffset before readSRAM, otherwise finishWrites() in readSRAM would
             // write to the wrong offset
             writeBufferSRAMBankOffset_ = newOffset;
+            if(sramWriteListener_)
+            {
+                sramWriteListener_->onBeforeSRAMBlockWrite(currentSRAMBank_, writeBufferSRAMBankOffset_, writeBuffer_);
+            }
             writeBufferOffset = 0;
         }
     }
@@ -315,10 +385,188 @@ void TransferPakManager::finishWrites()
     }
 //  debugf("[TransferPakManager]: %s writeBufferSRAMOffset 0x%hx, buffer %p, blocksize %hu\r\n", __FUNCTION__, writeBufferSRAMBankOffset_, writeBuffer_, TPAK_BLOCK_SIZE);
 
-    tpak_write(port_, sramBankStartGBAddress + writeBufferSRAMBankOffset_, writeBuffer_, TPAK_BLOCK_SIZE);
+    writeBlock(sramBankStartGBAddress + writeBufferSRAMBankOffset_, writeBuffer_);
 
     // mark no pending writes
     writeBufferSRAMBankOffset_ = 0xFFFF;
     // also invalidate read buffer
     readBufferBankOffset_ = 0xFFFF;
-}
\ No newline at end of file
+}
+
+bool TransferPakManager::readSRAMBlock(uint16_t SRAMBankOffset, uint8_t* data)
+{
+    // make sure we don't read outdated data if there are pending writes
+    finishWrites();
+
+    const int ret = readBlock(sramBankStartGBAddress + SRAMBankOffset, data);
+    if(ret)
+    {
+        debugf("[TransferPakManager]: %s: tpak_read got error %d\r\n", __FUNCTION__, ret);
+    }
+    return (!ret);
+}
+
+bool TransferPakManager::writeSRAMBlock(uint16_t SRAMBankOffset, const uint8_t* data)
+{
+    // a pending write to the same block would overwrite this one later on. Get it out of the way first
+    finishWrites();
+    notifySRAMWriteListener(SRAMBankOffset);
+
+    const int ret = writeBlock(sramBankStartGBAddress + SRAMBankOffset, data);
+    if(ret)
+    {
+        debugf("[TransferPakManager]: %s: tpak_write got error %d\r\n", __FUNCTION__, ret);
+    }
+
+    // the read buffer might contain the old contents of this block
+    if(readBufferBankOffset_ == sramBankStartGBAddress + SRAMBankOffset)
+    {
+        readBufferBankOffset_ = 0xFFFF;
+    }
+    return (!ret);
+}
+
+bool TransferPakManager::fillSRAM(uint16_t SRAMBankOffset, uint8_t value, uint16_t size)
+{
+    uint8_t block[TPAK_BLOCK_SIZE];
+    const uint16_t headSize = std::min<uint16_t>(size, (TPAK_BLOCK_SIZE - (SRAMBankOffset % TPAK_BLOCK_SIZE)) % TPAK_BLOCK_SIZE);
+    uint16_t currentOffset = SRAMBankOffset;
+    uint16_t bytesRemaining = size;
+    bool success = true;
+    int ret;
+
+    memset(block, value, TPAK_BLOCK_SIZE);
+
+    if(headSize)
+    {
+        writeSRAM(currentOffset, block, headSize);
+        currentOffset += headSize;
+        bytesRemaining -= headSize;
+    }
+    // make sure the partial block is out of the way before we start writing blocks directly
+    finishWrites();
+
+    while(bytesRemaining >= TPAK_BLOCK_SIZE)
+    {
+        notifySRAMWriteListener(currentOffset);
+        // the joybus accessory write returns a CRC of the data it received. libdragon reports an error if it doesn't match.
+        // This gives us verification of every block without having to read it back.
+        ret = writeBlock(sramBankStartGBAddress + currentOffset, block);
+        if(ret)
+        {
+            debugf("[TransferPakManager]: %s: tpak_write at 0x%hx got error %d\r\n", __FUNCTION__, currentOffset, ret);
+            success = false;
+        }
+        currentOffset += TPAK_BLOCK_SIZE;
+        bytesRemaining -= TPAK_BLOCK_SIZE;
+    }
+
+    if(bytesRemaining)
+    {
+        writeSRAM(currentOffset, block, bytesRemaining);
+        finishWrites();
+    }
+
+    // the read buffer might contain the old contents
+    readBufferBankOffset_ = 0xFFFF;
+    return success;
+}
+
+void TransferPakManager::setSRAMWriteListener(ITransferPakSRAMWriteListener* listener)
+{
+    // pending writes belong to whoever was listening before
+    finishWrites();
+    sramWriteListener_ = listener;
+}
+
+void TransferPakManager::notifySRAMWriteListener(uint16_t SRAMBankOffset)
+{
+    uint8_t originalData[TPAK_BLOCK_SIZE];
+
+    if(!sramWriteListener_)
+    {
+        return;
+    }
+
+    readBlock(sramBankStartGBAddress + SRAMBankOffset, originalData);
+    sramWriteListener_->onBeforeSRAMBlockWrite(currentSRAMBank_, SRAMBankOffset, originalData);
+}
+
+bool TransferPakManager::openVirtualCartridge(const char* savePath)
+{
+    // pending writes belong to the cartridge in the transfer pak
+    finishWrites();
+    readBufferBankOffset_ = 0xFFFF;
+
+    if(!virtualCartridge_.open(savePath))
+    {
+        return false;
+    }
+    // the virtual cartridge starts in SRAM bank 0 and ROM bank 1
+    currentSRAMBank_ = 0;
+    return true;
+}
+
+bool TransferPakManager::writeBackVirtualCartridge()
+{
+    finishWrites();
+    return virtualCartridge_.writeBack();
+}
+
+bool TransferPakManager::closeVirtualCartridge()
+{
+    finishWrites();
+    if(!virtualCartridge_.close())
+    {
+        // the virtual cartridge stays open with its changes
+        return false;
+    }
+    readBufferBankOffset_ = 0xFFFF;
+    // we don't know which SRAM bank the real cartridge has selected. Make sure the next switchGBSRAMBank() call goes through
+    currentSRAMBank_ = 0xFF;
+    return true;
+}
+
+bool TransferPakManager::isVirtualCartridge() const
+{
+    return virtualCartridge_.isOpen();
+}
+
+const VirtualCartridge& TransferPakManager::getVirtualCartridge() const
+{
+    return virtualCartridge_;
+}
+
+bool TransferPakManager::isVirtualROM() const
+{
+    return (virtualCartridge_.isOpen() && virtualCartridge_.hasRom());
+}
+
+int TransferPakManager::readBlock(uint16_t gbAddress, uint8_t* data)
+{
+    if(virtualCartridge_.isOpen())
+    {
+        if(gbAddress >= sramBankStartGBAddress && gbAddress < sramBankEndGBAddress)
+        {
+            virtualCartridge_.readSRAM(currentSRAMBank_, gbAddress - sramBankStartGBAddress, data, TPAK_BLOCK_SIZE);
+            return 0;
+        }
+        else if(virtualCartridge_.hasRom())
+        {
+            virtualCartridge_.readROM(gbAddress, data, TPAK_BLOCK_SIZE);
+            return 0;
+        }
+    }
+    return tpak_read(port_, gbAddress, data, TPAK_BLOCK_SIZE);
+}
+
+int TransferPakManager::writeBlock(uint16_t gbAddress, const uint8_t* data)
+{
+    if(virtualCartridge_.isOpen() && gbAddress >= sramBankStartGBAddress && gbAddress < sramBankEndGBAddress)
+    {
+        virtualCartridge_.writeSRAM(currentSRAMBank_, gbAddress - sramBankStartGBAddress, data, TPAK_BLOCK_SIZE);
+        return 0;
+    }
+    // tpak_write() doesn't modify the data, it just isn't declared const
+    return tpak_write(port_, gbAddress, const_cast<uint8_t*>(data), TPAK_BLOCK_SIZE);
+}
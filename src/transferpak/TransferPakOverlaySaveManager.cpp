@@ -0,0 +1,358 @@
+#include "transferpak/TransferPakOverlaySaveManager.h"
+
+#include <cstring>
+
+static const uint16_t GB_SRAM_BANK_SIZE = 0x2000;
+
+TransferPakOverlaySaveManager::TransferPakOverlaySaveManager(TransferPakManager& pakManager)
+    : cartridgeSaveManager_(pakManager)
+    , blockSlots_()
+    , modifiedBlocks_(new uint8_t[TPAK_OVERLAY_MAX_BLOCKS * TPAK_BLOCK_SIZE])
+    , originalBlocks_(new uint8_t[TPAK_OVERLAY_MAX_BLOCKS * TPAK_BLOCK_SIZE])
+    , offset_(0)
+    , numSlotsUsed_(0)
+    , overflowed_(false)
+{
+    reset();
+}
+
+TransferPakOverlaySaveManager::~TransferPakOverlaySaveManager()
+{
+    delete[] modifiedBlocks_;
+    modifiedBlocks_ = nullptr;
+    delete[] originalBlocks_;
+    originalBlocks_ = nullptr;
+}
+
+bool TransferPakOverlaySaveManager::readByte(uint8_t& outByte)
+{
+    return read(&outByte, 1);
+}
+
+void TransferPakOverlaySaveManager::writeByte(uint8_t byte)
+{
+    write(&byte, 1);
+}
+
+bool TransferPakOverlaySaveManager::read(uint8_t* outBuffer, uint32_t bytesToRead)
+{
+    uint32_t bytesRemaining = bytesToRead;
+    uint16_t blockOffset;
+    uint16_t currentRead;
+    int16_t slot;
+
+    // we go block by block, because every block can either come from the overlay or from the cartridge
+    while(bytesRemaining > 0)
+    {
+        blockOffset = static_cast<uint16_t>(offset_ % TPAK_BLOCK_SIZE);
+        currentRead = TPAK_BLOCK_SIZE - blockOffset;
+        if(currentRead > bytesRemaining)
+        {
+            currentRead = static_cast<uint16_t>(bytesRemaining);
+        }
+
+        slot = getSlot(offset_);
+        if(slot >= 0)
+        {
+            memcpy(outBuffer, modifiedBlocks_ + (slot * TPAK_BLOCK_SIZE) + blockOffset, currentRead);
+        }
+        else
+        {
+            cartridgeSaveManager_.seek(offset_);
+            cartridgeSaveManager_.read(outBuffer, currentRead);
+        }
+
+        outBuffer += currentRead;
+        bytesRemaining -= currentRead;
+        offset_ += currentRead;
+    }
+    return true;
+}
+
+void TransferPakOverlaySaveManager::write(const uint8_t* buffer, uint32_t bytesToWrite)
+{
+    uint32_t bytesRemaining = bytesToWrite;
+    uint16_t blockOffset;
+    uint16_t currentWrite;
+    int16_t slot;
+
+    while(bytesRemaining > 0)
+    {
+        blockOffset = static_cast<uint16_t>(offset_ % TPAK_BLOCK_SIZE);
+        currentWrite = TPAK_BLOCK_SIZE - blockOffset;
+        if(currentWrite > bytesRemaining)
+        {
+            currentWrite = static_cast<uint16_t>(bytesRemaining);
+        }
+
+        slot = getOrCreateSlot(offset_);
+        if(slot >= 0)
+        {
+            memcpy(modifiedBlocks_ + (slot * TPAK_BLOCK_SIZE) + blockOffset, buffer, currentWrite);
+        }
+        else if(!overflowed_)
+        {
+            debugf("[TransferPakOverlaySaveManager]: ERROR: write at 0x%lx doesn't fit in the overlay!\r\n", offset_);
+            overflowed_ = true;
+        }
+
+        buffer += currentWrite;
+        bytesRemaining -= currentWrite;
+        offset_ += currentWrite;
+    }
+}
+
+uint8_t TransferPakOverlaySaveManager::peek()
+{
+    uint8_t result;
+
+    read(&result, 1);
+    --offset_;
+    return result;
+}
+
+bool TransferPakOverlaySaveManager::advance(uint32_t numBytes)
+{
+    return seek(offset_ + numBytes);
+}
+
+bool TransferPakOverlaySaveManager::rewind(uint32_t numBytes)
+{
+    return seek(offset_ - numBytes);
+}
+
+bool TransferPakOverlaySaveManager::seek(uint32_t absoluteOffset)
+{
+    // the cartridge save manager only gets seeked when we actually need to read from the cartridge
+    offset_ = absoluteOffset;
+    return true;
+}
+
+uint8_t TransferPakOverlaySaveManager::getCurrentBankIndex() const
+{
+    return static_cast<uint8_t>(offset_ / GB_SRAM_BANK_SIZE);
+}
+
+bool TransferPakOverlaySaveManager::hasOverflowed() const
+{
+    return overflowed_;
+}
+
+uint16_t TransferPakOverlaySaveManager::getNumberOfTouchedBlocks() const
+{
+    return numSlotsUsed_;
+}
+
+uint32_t TransferPakOverlaySaveManager::getChangedRanges(SaveByteRange* outRanges, uint16_t maxRanges, uint16_t& outNumRanges) const
+{
+    uint32_t numBytesChanged = 0;
+    uint32_t offset;
+    const uint8_t* modified;
+    const uint8_t* original;
+    // whether the last byte we looked at was changed. Used to merge ranges that span multiple blocks
+    bool inRange = false;
+    uint32_t lastChangedOffset = 0;
+    int16_t slot;
+
+    outNumRanges = 0;
+
+    // blockSlots_ is ordered by offset, so we find the ranges in ascending order
+    for(uint16_t blockIndex = 0; blockIndex < (TPAK_OVERLAY_MAX_SAVE_SIZE / TPAK_BLOCK_SIZE); ++blockIndex)
+    {
+        slot = blockSlots_[blockIndex];
+        if(slot < 0)
+        {
+            continue;
+        }
+
+        modified = modifiedBlocks_ + (slot * TPAK_BLOCK_SIZE);
+        original = originalBlocks_ + (slot * TPAK_BLOCK_SIZE);
+        for(uint8_t i = 0; i < TPAK_BLOCK_SIZE; ++i)
+        {
+            if(modified[i] == original[i])
+            {
+                continue;
+            }
+
+            offset = (static_cast<uint32_t>(blockIndex) * TPAK_BLOCK_SIZE) + i;
+            ++numBytesChanged;
+            if(inRange && offset == lastChangedOffset + 1)
+            {
+                if(outRanges && outNumRanges <= maxRanges)
+                {
+                    ++outRanges[outNumRanges - 1].size;
+                }
+            }
+            else
+            {
+                if(outRanges && outNumRanges < maxRanges)
+                {
+                    outRanges[outNumRanges] = SaveByteRange{
+                        .offset = offset,
+                        .size = 1
+                    };
+                }
+                ++outNumRanges;
+                inRange = true;
+            }
+            lastChangedOffset = offset;
+        }
+    }
+    return numBytesChanged;
+}
+
+int32_t TransferPakOverlaySaveManager::getByteSumDelta(uint32_t startOffset, uint32_t endOffset) const
+{
+    int32_t delta = 0;
+    const uint8_t* modified;
+    const uint8_t* original;
+    uint32_t blockStartOffset;
+    uint8_t firstByte;
+    uint8_t lastByte;
+    int16_t slot;
+
+    if(endOffset >= TPAK_OVERLAY_MAX_SAVE_SIZE)
+    {
+        endOffset = TPAK_OVERLAY_MAX_SAVE_SIZE - 1;
+    }
+
+    for(uint32_t blockIndex = startOffset / TPAK_BLOCK_SIZE; blockIndex <= endOffset / TPAK_BLOCK_SIZE; ++blockIndex)
+    {
+        slot = blockSlots_[blockIndex];
+        if(slot < 0)
+        {
+            continue;
+        }
+
+        // the first and last block may only be partially inside the range
+        blockStartOffset = blockIndex * TPAK_BLOCK_SIZE;
+        firstByte = (startOffset > blockStartOffset) ? static_cast<uint8_t>(startOffset - blockStartOffset) : 0;
+        lastByte = (endOffset < blockStartOffset + TPAK_BLOCK_SIZE - 1) ? static_cast<uint8_t>(endOffset - blockStartOffset) : TPAK_BLOCK_SIZE - 1;
+
+        modified = modifiedBlocks_ + (slot * TPAK_BLOCK_SIZE);
+        original = originalBlocks_ + (slot * TPAK_BLOCK_SIZE);
+        for(uint8_t i = firstByte; i <= lastByte; ++i)
+        {
+            delta += static_cast<int32_t>(modified[i]) - static_cast<int32_t>(original[i]);
+        }
+    }
+    return delta;
+}
+
+bool TransferPakOverlaySaveManager::readOriginal(uint32_t absoluteOffset, uint8_t* outBuffer, uint32_t bytesToRead)
+{
+    uint16_t blockOffset;
+    uint16_t currentRead;
+    int16_t slot;
+
+    while(bytesToRead > 0)
+    {
+        blockOffset = static_cast<uint16_t>(absoluteOffset % TPAK_BLOCK_SIZE);
+        currentRead = TPAK_BLOCK_SIZE - blockOffset;
+        if(currentRead > bytesToRead)
+        {
+            currentRead = static_cast<uint16_t>(bytesToRead);
+        }
+
+        slot = getSlot(absoluteOffset);
+        if(slot >= 0)
+        {
+            memcpy(outBuffer, originalBlocks_ + (slot * TPAK_BLOCK_SIZE) + blockOffset, currentRead);
+        }
+        else
+        {
+            cartridgeSaveManager_.seek(absoluteOffset);
+            cartridgeSaveManager_.read(outBuffer, currentRead);
+        }
+
+        outBuffer += currentRead;
+        bytesToRead -= currentRead;
+        absoluteOffset += currentRead;
+    }
+    return true;
+}
+
+bool TransferPakOverlaySaveManager::commit(uint16_t& outNumBlocksWritten)
+{
+    const uint8_t* modified;
+    bool success = true;
+    int16_t slot;
+
+    outNumBlocksWritten = 0;
+    if(overflowed_)
+    {
+        debugf("[TransferPakOverlaySaveManager]: ERROR: not committing an incomplete set of changes!\r\n");
+        return false;
+    }
+
+    // write the blocks in ascending order. This minimizes the number of SRAM bank switches
+    for(uint16_t blockIndex = 0; blockIndex < (TPAK_OVERLAY_MAX_SAVE_SIZE / TPAK_BLOCK_SIZE); ++blockIndex)
+    {
+        slot = blockSlots_[blockIndex];
+        if(slot < 0)
+        {
+            continue;
+        }
+
+        modified = modifiedBlocks_ + (slot * TPAK_BLOCK_SIZE);
+        if(!memcmp(modified, originalBlocks_ + (slot * TPAK_BLOCK_SIZE), TPAK_BLOCK_SIZE))
+        {
+            // the edits wrote the same data as what was already there
+            continue;
+        }
+
+        cartridgeSaveManager_.seek(static_cast<uint32_t>(blockIndex) * TPAK_BLOCK_SIZE);
+        switch(cartridgeSaveManager_.writeBlockIfChanged(modified))
+        {
+            case SRAMBlockWriteResult::WRITTEN:
+                ++outNumBlocksWritten;
+                break;
+            case SRAMBlockWriteResult::UNCHANGED:
+                break;
+            default:
+                debugf("[TransferPakOverlaySaveManager]: ERROR: could not write block %u\r\n", blockIndex);
+                success = false;
+                break;
+        }
+    }
+    return success;
+}
+
+void TransferPakOverlaySaveManager::reset()
+{
+    for(uint16_t i = 0; i < (TPAK_OVERLAY_MAX_SAVE_SIZE / TPAK_BLOCK_SIZE); ++i)
+    {
+        blockSlots_[i] = -1;
+    }
+    numSlotsUsed_ = 0;
+    overflowed_ = false;
+}
+
+int16_t TransferPakOverlaySaveManager::getSlot(uint32_t absoluteOffset) const
+{
+    if(absoluteOffset >= TPAK_OVERLAY_MAX_SAVE_SIZE)
+    {
+        return -1;
+    }
+    return blockSlots_[absoluteOffset / TPAK_BLOCK_SIZE];
+}
+
+int16_t TransferPakOverlaySaveManager::getOrCreateSlot(uint32_t absoluteOffset)
+{
+    int16_t slot = getSlot(absoluteOffset);
+    const uint32_t blockStartOffset = absoluteOffset - (absoluteOffset % TPAK_BLOCK_SIZE);
+
+    if(slot >= 0 || absoluteOffset >= TPAK_OVERLAY_MAX_SAVE_SIZE || numSlotsUsed_ >= TPAK_OVERLAY_MAX_BLOCKS)
+    {
+        return slot;
+    }
+
+    slot = static_cast<int16_t>(numSlotsUsed_);
+    cartridgeSaveManager_.seek(blockStartOffset);
+    cartridgeSaveManager_.read(originalBlocks_ + (slot * TPAK_BLOCK_SIZE), TPAK_BLOCK_SIZE);
+    memcpy(modifiedBlocks_ + (slot * TPAK_BLOCK_SIZE), originalBlocks_ + (slot * TPAK_BLOCK_SIZE), TPAK_BLOCK_SIZE);
+
+    blockSlots_[absoluteOffset / TPAK_BLOCK_SIZE] = slot;
+    ++numSlotsUsed_;
+    return slot;
+}
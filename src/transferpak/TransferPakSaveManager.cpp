@@ -1,6 +1,8 @@
 #include "transferpak/TransferPakSaveManager.h"
 #include "transferpak/TransferPakManager.h"
 
+#include <cstring>
+
 static uint16_t GB_SRAM_BANK_SIZE = 0x2000;
 
 static uint16_t getSRAMBankOffset(uint32_t absoluteSRAMOffset)
@@ -99,22 +101,72 @@ bool TransferPakSaveManager::rewind(uint32_t numBytes)
 
 bool TransferPakSaveManager::seek(uint32_t absoluteOffset)
 {
-    const uint8_t previousBankIndex = getCurrentBankIndex();
     uint8_t newBankIndex;
 
     sramOffset_ = absoluteOffset;
     newBankIndex = getCurrentBankIndex();
 
-//  debugf("[TransferPakSaveManager]: %s(%lx) -> previousBankIndex %hu, newBankIndex %hu\r\n", __FUNCTION__, absoluteOffset, previousBankIndex, newBankIndex);
+//  debugf("[TransferPakSaveManager]: %s(%lx) -> newBankIndex %hu\r\n", __FUNCTION__, absoluteOffset, newBankIndex);
 
-    if(previousBankIndex != newBankIndex)
-    {
-        pakManager_.switchGBSRAMBank(newBankIndex);
-    }
+    // Don't skip this when our own bank index didn't change: another TransferPakSaveManager (or the SaveUndoJournal) on the same
+    // TransferPakManager may have switched the bank in the meantime. The TransferPakManager already skips redundant bank switches.
+    pakManager_.switchGBSRAMBank(newBankIndex);
     return true;
 }
 
 uint8_t TransferPakSaveManager::getCurrentBankIndex() const
 {
     return static_cast<uint8_t>(sramOffset_ / GB_SRAM_BANK_SIZE);
+}
+
+SRAMBlockWriteResult TransferPakSaveManager::writeBlockIfChanged(const uint8_t* block)
+{
+    uint8_t cartBlock[TPAK_BLOCK_SIZE];
+    const uint16_t bankOffset = getSRAMBankOffset(sramOffset_);
+    SRAMBlockWriteResult result;
+
+    if(!pakManager_.readSRAMBlock(bankOffset, cartBlock))
+    {
+        result = SRAMBlockWriteResult::TRANSFER_ERROR;
+    }
+    else if(!memcmp(cartBlock, block, TPAK_BLOCK_SIZE))
+    {
+        // reading the block also verified it. Nothing to do
+        result = SRAMBlockWriteResult::UNCHANGED;
+    }
+    else if(!pakManager_.writeSRAMBlock(bankOffset, block) || !pakManager_.readSRAMBlock(bankOffset, cartBlock))
+    {
+        result = SRAMBlockWriteResult::TRANSFER_ERROR;
+    }
+    else
+    {
+        result = (memcmp(cartBlock, block, TPAK_BLOCK_SIZE)) ? SRAMBlockWriteResult::VERIFY_FAILED : SRAMBlockWriteResult::WRITTEN;
+    }
+
+    advance(TPAK_BLOCK_SIZE);
+    return result;
+}
+
+bool TransferPakSaveManager::fill(uint8_t value, uint32_t size)
+{
+    uint32_t bytesRemaining = size;
+    uint16_t bytesLeftInCurrentBank;
+    uint16_t currentWrite;
+    bool success = true;
+
+    while(bytesRemaining > 0)
+    {
+        bytesLeftInCurrentBank = calculateBytesLeftInCurrentBank(sramOffset_);
+        currentWrite = (bytesRemaining > bytesLeftInCurrentBank) ? bytesLeftInCurrentBank : static_cast<uint16_t>(bytesRemaining);
+
+        if(!pakManager_.fillSRAM(getSRAMBankOffset(sramOffset_), value, currentWrite))
+        {
+            success = false;
+        }
+        bytesRemaining -= currentWrite;
+
+        // this switches to the next bank when needed
+        advance(currentWrite);
+    }
+    return success;
 }
\ No newline at end of file
@@ -0,0 +1,366 @@
+#include "transferpak/VirtualCartridge.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static const uint16_t GB_CARTRIDGE_HEADER_OFFSET = 0x100;
+static const uint16_t NUM_DIRTY_BLOCKS = VIRTUAL_CARTRIDGE_SRAM_SIZE / VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE;
+
+/**
+ * @brief Opens the ROM file that belongs to the given .sav file: a .gb or .gbc file with the same name in the same directory
+ */
+static FILE* openMatchingRomFile(const char* savePath)
+{
+    static const char* romExtensions[] = {".gb", ".gbc"};
+    char romPath[VIRTUAL_CARTRIDGE_PATH_SIZE];
+    const char* extension = strrchr(savePath, '.');
+    const size_t baseNameLength = (extension) ? static_cast<size_t>(extension - savePath) : strlen(savePath);
+    FILE* f;
+
+    for(uint8_t i = 0; i < sizeof(romExtensions) / sizeof(romExtensions[0]); ++i)
+    {
+        if(baseNameLength + strlen(romExtensions[i]) >= sizeof(romPath))
+        {
+            return nullptr;
+        }
+        memcpy(romPath, savePath, baseNameLength);
+        strcpy(romPath + baseNameLength, romExtensions[i]);
+
+        f = fopen(romPath, "r");
+        if(f)
+        {
+            debugf("[VirtualCartridge]: using ROM file %s\r\n", romPath);
+            return f;
+        }
+    }
+    return nullptr;
+}
+
+VirtualCartridge::VirtualCartridge()
+    : romFile_(nullptr)
+    , sram_(nullptr)
+    , romBank0_(nullptr)
+    , romBankX_(nullptr)
+    , romSize_(0)
+    , dirtyBlocks_()
+    , savePath_()
+    , currentROMBank_(1)
+    , loadedROMBank_(0)
+    , dirty_(false)
+{
+}
+
+VirtualCartridge::~VirtualCartridge()
+{
+    if(!close())
+    {
+        // nothing we can do anymore at this point
+        release();
+    }
+}
+
+bool VirtualCartridge::open(const char* savePath)
+{
+    const uint64_t startTime = get_ticks();
+    FILE* f;
+    size_t bytesRead;
+
+    // don't drop the changes of the previous save if they couldn't be written back
+    if(!close() || strlen(savePath) >= sizeof(savePath_))
+    {
+        return false;
+    }
+
+    f = fopen(savePath, "r");
+    if(!f)
+    {
+        debugf("[VirtualCartridge]: ERROR: could not open %s\r\n", savePath);
+        return false;
+    }
+
+    sram_ = static_cast<uint8_t*>(malloc(VIRTUAL_CARTRIDGE_SRAM_SIZE));
+    if(!sram_)
+    {
+        debugf("[VirtualCartridge]: ERROR: out of memory\r\n");
+        fclose(f);
+        return false;
+    }
+
+    // load the whole save with a single read
+    bytesRead = fread(sram_, 1, VIRTUAL_CARTRIDGE_SRAM_SIZE, f);
+    fclose(f);
+    if(bytesRead != VIRTUAL_CARTRIDGE_SRAM_SIZE)
+    {
+        debugf("[VirtualCartridge]: ERROR: %s is too small to be a save (%u bytes)\r\n", savePath, static_cast<unsigned>(bytesRead));
+        free(sram_);
+        sram_ = nullptr;
+        return false;
+    }
+    strcpy(savePath_, savePath);
+
+    romFile_ = openMatchingRomFile(savePath);
+    if(romFile_)
+    {
+        fseek(romFile_, 0, SEEK_END);
+        romSize_ = static_cast<uint32_t>(ftell(romFile_));
+
+        romBank0_ = static_cast<uint8_t*>(malloc(VIRTUAL_CARTRIDGE_ROM_BANK_SIZE));
+        romBankX_ = static_cast<uint8_t*>(malloc(VIRTUAL_CARTRIDGE_ROM_BANK_SIZE));
+        if(!romBank0_ || !romBankX_)
+        {
+            debugf("[VirtualCartridge]: ERROR: out of memory\r\n");
+            // nothing has been written yet, so this only frees what we've allocated so far
+            release();
+            return false;
+        }
+
+        if(!loadROMBank(0, romBank0_))
+        {
+            debugf("[VirtualCartridge]: ERROR: could not read the ROM file. Using the cartridge ROM instead\r\n");
+            free(romBank0_);
+            free(romBankX_);
+            romBank0_ = nullptr;
+            romBankX_ = nullptr;
+            fclose(romFile_);
+            romFile_ = nullptr;
+            romSize_ = 0;
+        }
+    }
+
+    debugf("[VirtualCartridge]: opened %s in %lu ms\r\n", savePath_, static_cast<uint32_t>(TICKS_TO_MS(get_ticks() - startTime)));
+    return true;
+}
+
+bool VirtualCartridge::close()
+{
+    if(!writeBack())
+    {
+        // keep the mirror (and the dirty blocks) in RAM, so the changes aren't lost and the write back can be retried
+        debugf("[VirtualCartridge]: ERROR: could not write back the changes to %s. Keeping it open\r\n", savePath_);
+        return false;
+    }
+    release();
+    return true;
+}
+
+void VirtualCartridge::release()
+{
+    free(sram_);
+    sram_ = nullptr;
+    memset(dirtyBlocks_, 0, sizeof(dirtyBlocks_));
+    dirty_ = false;
+
+    if(romFile_)
+    {
+        fclose(romFile_);
+        romFile_ = nullptr;
+    }
+    free(romBank0_);
+    free(romBankX_);
+    romBank0_ = nullptr;
+    romBankX_ = nullptr;
+    romSize_ = 0;
+    savePath_[0] = '\0';
+    currentROMBank_ = 1;
+    loadedROMBank_ = 0;
+}
+
+bool VirtualCartridge::writeBack()
+{
+    const uint64_t startTime = get_ticks();
+    uint32_t numBytesWritten = 0;
+    uint16_t runStart;
+    uint16_t runSize;
+    uint16_t i = 0;
+    bool success = true;
+    FILE* f;
+
+    if(!sram_ || !dirty_)
+    {
+        return true;
+    }
+
+    // "r+" instead of "w": we only overwrite the modified parts and leave everything else (like appended RTC data) as it is
+    f = fopen(savePath_, "r+");
+    if(!f)
+    {
+        debugf("[VirtualCartridge]: ERROR: could not open %s for writing\r\n", savePath_);
+        return false;
+    }
+
+    while(i < NUM_DIRTY_BLOCKS)
+    {
+        if(!isBlockDirty(i))
+        {
+            ++i;
+            continue;
+        }
+
+        // write consecutive dirty blocks with a single write
+        runStart = i;
+        while(i < NUM_DIRTY_BLOCKS && isBlockDirty(i))
+        {
+            ++i;
+        }
+        runSize = (i - runStart) * VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE;
+
+        if(fseek(f, runStart * VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE, SEEK_SET) != 0 || fwrite(sram_ + (runStart * VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE), 1, runSize, f) != runSize)
+        {
+            debugf("[VirtualCartridge]: ERROR: could not write 0x%x bytes at 0x%x\r\n", runSize, runStart * VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE);
+            success = false;
+            break;
+        }
+        numBytesWritten += runSize;
+    }
+
+    if(fclose(f) != 0)
+    {
+        success = false;
+    }
+
+    if(success)
+    {
+        memset(dirtyBlocks_, 0, sizeof(dirtyBlocks_));
+        dirty_ = false;
+    }
+    debugf("[VirtualCartridge]: wrote back %lu bytes to %s in %lu ms%s\r\n", numBytesWritten, savePath_, static_cast<uint32_t>(TICKS_TO_MS(get_ticks() - startTime)), (success) ? "" : " (FAILED)");
+    return success;
+}
+
+bool VirtualCartridge::isOpen() const
+{
+    return (sram_ != nullptr);
+}
+
+bool VirtualCartridge::hasRom() const
+{
+    return (romFile_ != nullptr);
+}
+
+bool VirtualCartridge::isDirty() const
+{
+    return dirty_;
+}
+
+const char* VirtualCartridge::getSavePath() const
+{
+    return savePath_;
+}
+
+bool VirtualCartridge::readCartridgeHeader(gameboy_cartridge_header& cartridgeHeader)
+{
+    if(!romBank0_)
+    {
+        return false;
+    }
+    memcpy(&cartridgeHeader, romBank0_ + GB_CARTRIDGE_HEADER_OFFSET, sizeof(gameboy_cartridge_header));
+    return true;
+}
+
+void VirtualCartridge::switchROMBank(uint8_t bankIndex)
+{
+    // just like on the MBC, bank 0 can't be mapped to the switchable area: you get bank 1 instead
+    currentROMBank_ = (bankIndex) ? bankIndex : 1;
+}
+
+void VirtualCartridge::readROM(uint16_t gbAddress, uint8_t* data, uint16_t size)
+{
+    uint16_t bankOffset;
+    uint16_t currentSize;
+
+    while(size > 0)
+    {
+        bankOffset = gbAddress % VIRTUAL_CARTRIDGE_ROM_BANK_SIZE;
+        currentSize = VIRTUAL_CARTRIDGE_ROM_BANK_SIZE - bankOffset;
+        if(currentSize > size)
+        {
+            currentSize = size;
+        }
+
+        if(!romBank0_ || gbAddress >= 2 * VIRTUAL_CARTRIDGE_ROM_BANK_SIZE)
+        {
+            memset(data, 0xFF, currentSize);
+        }
+        else if(gbAddress < VIRTUAL_CARTRIDGE_ROM_BANK_SIZE)
+        {
+            memcpy(data, romBank0_ + bankOffset, currentSize);
+        }
+        else
+        {
+            // only read the bank from the file once it is actually needed
+            if(loadedROMBank_ != currentROMBank_)
+            {
+                if(!loadROMBank(currentROMBank_, romBankX_))
+                {
+                    memset(romBankX_, 0xFF, VIRTUAL_CARTRIDGE_ROM_BANK_SIZE);
+                }
+                loadedROMBank_ = currentROMBank_;
+            }
+            memcpy(data, romBankX_ + bankOffset, currentSize);
+        }
+
+        gbAddress += currentSize;
+        data += currentSize;
+        size -= currentSize;
+    }
+}
+
+void VirtualCartridge::readSRAM(uint8_t bankIndex, uint16_t SRAMBankOffset, uint8_t* data, uint16_t size)
+{
+    const uint32_t offset = (bankIndex * VIRTUAL_CARTRIDGE_SRAM_BANK_SIZE) + SRAMBankOffset;
+
+    if(!sram_ || offset + size > VIRTUAL_CARTRIDGE_SRAM_SIZE)
+    {
+        memset(data, 0xFF, size);
+        return;
+    }
+    memcpy(data, sram_ + offset, size);
+}
+
+void VirtualCartridge::writeSRAM(uint8_t bankIndex, uint16_t SRAMBankOffset, const uint8_t* data, uint16_t size)
+{
+    const uint32_t offset = (bankIndex * VIRTUAL_CARTRIDGE_SRAM_BANK_SIZE) + SRAMBankOffset;
+
+    if(!sram_ || !size || offset + size > VIRTUAL_CARTRIDGE_SRAM_SIZE)
+    {
+        return;
+    }
+
+    if(!memcmp(sram_ + offset, data, size))
+    {
+        // nothing changes, so there's nothing to write back either
+        return;
+    }
+    memcpy(sram_ + offset, data, size);
+
+    for(uint16_t i = offset / VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE; i <= (offset + size - 1) / VIRTUAL_CARTRIDGE_DIRTY_BLOCK_SIZE; ++i)
+    {
+        dirtyBlocks_[i / 8] |= (1 << (i % 8));
+    }
+    dirty_ = true;
+}
+
+bool VirtualCartridge::loadROMBank(uint8_t bankIndex, uint8_t* buffer)
+{
+    const uint32_t bankStart = bankIndex * VIRTUAL_CARTRIDGE_ROM_BANK_SIZE;
+    size_t bytesRead;
+
+    if(!romFile_ || bankStart >= romSize_ || fseek(romFile_, bankStart, SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    bytesRead = fread(buffer, 1, VIRTUAL_CARTRIDGE_ROM_BANK_SIZE, romFile_);
+    if(!bytesRead)
+    {
+        return false;
+    }
+    // a ROM file that doesn't end at a bank boundary. Shouldn't happen, but don't return garbage for the rest
+    memset(buffer + bytesRead, 0xFF, VIRTUAL_CARTRIDGE_ROM_BANK_SIZE - bytesRead);
+    return true;
+}
+
+bool VirtualCartridge::isBlockDirty(uint16_t blockIndex) const
+{
+    return (dirtyBlocks_[blockIndex / 8] & (1 << (blockIndex % 8)));
+}
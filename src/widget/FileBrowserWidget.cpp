@@ -13,6 +13,36 @@ static void confirmFileCallback(void* context, const void* itemParam)
     fileBrowser->onConfirmFile((const char*)itemParam);
 }
 
+/**
+ * @brief Checks whether the given file name ends with one of the extensions in the filter.
+ * The filter may contain multiple extensions separated by '|'. (for example: ".sav|.sav.lz")
+ */
+static bool matchesFileExtensionFilter(const char* fileName, size_t fileNameLength, const char* filter)
+{
+    const char* extension = filter;
+    const char* extensionEnd;
+    size_t extensionLength;
+
+    while(*extension)
+    {
+        extensionEnd = strchr(extension, '|');
+        extensionLength = (extensionEnd) ? static_cast<size_t>(extensionEnd - extension) : strlen(extension);
+
+        // just like before multiple extensions were supported, a name that isn't longer than the extension isn't filtered out
+        if(fileNameLength <= extensionLength || !strncmp(fileName + fileNameLength - extensionLength, extension, extensionLength))
+        {
+            return true;
+        }
+
+        if(!extensionEnd)
+        {
+            break;
+        }
+        extension = extensionEnd + 1;
+    }
+    return false;
+}
+
 FileBrowserWidget::FileBrowserWidget(AnimationManager& animManager)
     : duplicatedDirEntNameList_()
     , itemWidgetList_()
@@ -232,7 +262,6 @@ void FileBrowserWidget::loadDirectoryItems()
     dir_t dirEnt;
     int ret;
     char* titleString;
-    size_t fileExtensionFilterLength;
     size_t dirNameLength;
 
     if(pathBuffer_[0] == '\0')
@@ -248,21 +277,16 @@ void FileBrowserWidget::loadDirectoryItems()
         return;
     }
 
-    fileExtensionFilterLength = (fileExtensionFilter_) ? strlen(fileExtensionFilter_) : 0;
-
     while(ret == 0)
     {
         dirNameLength = strnlen(dirEnt.d_name, sizeof(dirEnt.d_name));
 
         // apply file extension filter if one has been specified
-        if(dirEnt.d_type == DT_REG && fileExtensionFilter_ && dirNameLength > fileExtensionFilterLength)
+        if(dirEnt.d_type == DT_REG && fileExtensionFilter_ && !matchesFileExtensionFilter(dirEnt.d_name, dirNameLength, fileExtensionFilter_))
         {
-            if(strncmp(dirEnt.d_name + dirNameLength - fileExtensionFilterLength, fileExtensionFilter_, fileExtensionFilterLength))
-            {
-                // file extension doesn't matching, discard result
-                ret = dir_findnext(pathBuffer_, &dirEnt);
-                continue;
-            }
+            // file extension doesn't matching, discard result
+            ret = dir_findnext(pathBuffer_, &dirEnt);
+            continue;
         }
         // libdragon overwrites a dir_t instance on every dir_findnext call
         // and the dir_t instance has a static allocated d_name entry
@@ -6,6 +6,8 @@
 #include "gen2/Gen2GameReader.h"
 #include "tpak.h"
 
+#include <cstdio>
+
 /**
  * @brief This function allows you to specify a 32 bit RGBA color by specifying separate color components
  * and converting it to a RGBA16 uint16_t value at compile time
@@ -23,6 +25,42 @@ constexpr uint16_t colorToRGBA16(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 static const Rectangle textBounds = {0, 100, 200, 20};
 static const Rectangle cartridgeLabelBounds = {9, 26, 70, 62};
 
+/**
+ * @brief The number of bytes of the save we validate every frame. This keeps the widget responsive while the save is being checked.
+ */
+static const uint32_t SAVE_VALIDATION_BYTES_PER_FRAME = 256;
+
+static const char* getStateName(TransferPakWidgetState state)
+{
+    switch(state)
+    {
+    case TransferPakWidgetState::UNKNOWN:
+        return "UNKNOWN";
+    case TransferPakWidgetState::DETECTING_PAK:
+        return "DETECTING_PAK";
+    case TransferPakWidgetState::VALIDATING_GB_HEADER:
+        return "VALIDATING_GB_HEADER";
+    case TransferPakWidgetState::DETECTING_GAME:
+        return "DETECTING_GAME";
+    case TransferPakWidgetState::VALIDATING_GAME_SAVE:
+        return "VALIDATING_GAME_SAVE";
+    case TransferPakWidgetState::GB_HEADER_VALIDATION_FAILED:
+        return "GB_HEADER_VALIDATION_FAILED";
+    case TransferPakWidgetState::NO_TRANSFER_PAK_FOUND:
+        return "NO_TRANSFER_PAK_FOUND";
+    case TransferPakWidgetState::NO_GAME_FOUND:
+        return "NO_GAME_FOUND";
+    case TransferPakWidgetState::GAME_FOUND:
+        return "GAME_FOUND";
+    case TransferPakWidgetState::VALID_SAVE_FOUND:
+        return "VALID_SAVE_FOUND";
+    case TransferPakWidgetState::NO_SAVE_FOUND:
+        return "NO_SAVE_FOUND";
+    default:
+        return "INVALID";
+    }
+}
+
 static const uint16_t paletteBlue[] = {0, colorToRGBA16(0x20, 0x30, 0x81, 0xFF), colorToRGBA16(0x15, 0x3B, 0xB0, 0xFF), 0, 0, 0, 0, 0};
 static const uint16_t paletteRed[] = {0, colorToRGBA16(0xA7, 0x1F, 0x1B, 0xFF), colorToRGBA16(0xAA, 0x2A, 0x2A, 0xFF), 0, 0, 0, 0, 0};
 static const uint16_t paletteYellow[] = {0, colorToRGBA16(0xEA, 0xA8, 0x2C, 0xFF), colorToRGBA16(0xF4, 0xB0, 0x2E, 0xFF), 0, 0, 0, 0, 0};
@@ -45,6 +83,13 @@ TransferPakDetectionWidget::TransferPakDetectionWidget(AnimationManager& animMan
     , cartridgeLabelSprite_(nullptr)
     , cartridgeIconRenderSettings_()
     , cartridgeLabelRenderSettings_()
+    , saveValidator_(pakManager)
+    , pendingLabelSpritePath_(nullptr)
+    , detectionStartTime_(0)
+    , stateStartTime_(0)
+    , knownCartridge_({0})
+    , localization_(0)
+    , isKnownCartridge_(false)
     , focused_(false)
     , visible_(true)
 {
@@ -116,14 +161,34 @@ bool TransferPakDetectionWidget::handleUserInput(const joypad_inputs_t& userInpu
     }
     else if(currentState_ == TransferPakWidgetState::VALIDATING_GAME_SAVE)
     {
-        // We don't want to do this in the switchState flow in order to have the widget actually render something before starting this step
-        // (because validating the game save CRC might take a few seconds)
+        // We don't want to do this in the switchState flow in order to have the widget actually render something before starting this step.
+        // Validating the game save CRC takes a few seconds, so we do it in small steps every frame instead of blocking the UI.
+        bool finished;
+        bool ret;
+
         tpakManager_.setRAMEnabled(true);
-        const bool ret = validateGameSave();
+        if(!saveValidator_.isStarted() && !startGameSaveValidation())
+        {
+            // we don't know the checksum layout of this game. Let the game reader do it in one go.
+            ret = validateGameSave();
+            finished = true;
+        }
+        else
+        {
+            finished = stepGameSaveValidation();
+            ret = saveValidator_.isValid();
+        }
         tpakManager_.setRAMEnabled(false);
-        const TransferPakWidgetState newState = (ret) ? TransferPakWidgetState::VALID_SAVE_FOUND : TransferPakWidgetState::NO_SAVE_FOUND;
 
-        switchState(currentState_, newState);
+        // the first checksum step has been done by now, so loading the label sprite doesn't delay the start of the validation anymore
+        loadPendingCartridgeLabel();
+
+        if(finished)
+        {
+            saveValidator_.reset();
+            const TransferPakWidgetState newState = (ret) ? TransferPakWidgetState::VALID_SAVE_FOUND : TransferPakWidgetState::NO_SAVE_FOUND;
+            switchState(currentState_, newState);
+        }
     }
 
     previousInputState_ = userInput;
@@ -147,6 +212,9 @@ void TransferPakDetectionWidget::render(RDPQGraphics& gfx, const Rectangle& pare
     case TransferPakWidgetState::UNKNOWN:
         renderUnknownState(gfx, parentBounds);
         break;
+    case TransferPakWidgetState::VALIDATING_GAME_SAVE:
+        renderValidatingSaveState(gfx, parentBounds);
+        break;
     case TransferPakWidgetState::NO_TRANSFER_PAK_FOUND:
     case TransferPakWidgetState::GB_HEADER_VALIDATION_FAILED:
     case TransferPakWidgetState::NO_GAME_FOUND:
@@ -167,6 +235,16 @@ void TransferPakDetectionWidget::retrieveGameType(Gen1GameType& outGen1Type, Gen
     outGen2Type = gen2Type_;
 }
 
+uint8_t TransferPakDetectionWidget::getLocalization() const
+{
+    return localization_;
+}
+
+uint64_t TransferPakDetectionWidget::getDetectionStartTime() const
+{
+    return detectionStartTime_;
+}
+
 void TransferPakDetectionWidget::setStyle(const TransferPakDetectionWidgetStyle& style)
 {
     style_ = style;
@@ -182,6 +260,18 @@ void TransferPakDetectionWidget::switchState(TransferPakWidgetState previousStat
 {
     TransferPakWidgetState newState;
     bool ret;
+    const uint64_t now = get_ticks();
+
+    // log how long every stage took, so we can keep track of the boot-to-menu latency
+    if(previousState == TransferPakWidgetState::UNKNOWN)
+    {
+        detectionStartTime_ = now;
+    }
+    else
+    {
+        debugf("[TransferPakDetectionWidget]: %s took %lu ms\r\n", getStateName(previousState), static_cast<uint32_t>(TICKS_TO_MS(now - stateStartTime_)));
+    }
+    stateStartTime_ = now;
 
     currentState_ = state;
     switch(state)
@@ -206,6 +296,10 @@ void TransferPakDetectionWidget::switchState(TransferPakWidgetState previousStat
         newState = TransferPakWidgetState::VALIDATING_GAME_SAVE;
         switchState(state, newState);
         break;
+    case TransferPakWidgetState::VALID_SAVE_FOUND:
+    case TransferPakWidgetState::NO_SAVE_FOUND:
+        debugf("[TransferPakDetectionWidget]: detection finished after %lu ms\r\n", static_cast<uint32_t>(TICKS_TO_MS(now - detectionStartTime_)));
+        break;
     default:
         break;
     }
@@ -226,7 +320,17 @@ void TransferPakDetectionWidget::renderUnknownState(RDPQGraphics& gfx, const Rec
 void TransferPakDetectionWidget::renderValidatingSaveState(RDPQGraphics& gfx, const Rectangle& parentBounds)
 {
     const Rectangle absoluteTextBounds = addOffset(textBounds, bounds_);
-    gfx.drawText(absoluteTextBounds, "Checking save...", style_.textSettings);
+    char text[32];
+
+    if(saveValidator_.isStarted())
+    {
+        snprintf(text, sizeof(text), "Checking save... %hu%%", saveValidator_.getProgress());
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "Checking save...");
+    }
+    gfx.drawText(absoluteTextBounds, text, style_.textSettings);
 }
 
 void TransferPakDetectionWidget::renderErrorState(RDPQGraphics& gfx, const Rectangle& parentBounds)
@@ -293,6 +397,13 @@ bool TransferPakDetectionWidget::validateGameboyHeader()
         return false;
     }
 
+    // we've got the header anyway. If it's a known cartridge, we don't need to probe the ROM to find out which game it is
+    isKnownCartridge_ = identifyKnownCartridge(cartridgeHeader, knownCartridge_);
+    if(isKnownCartridge_)
+    {
+        debugf("[TransferPakDetectionWidget]: Known cartridge: gen %hu, game %hu, localization %hu\r\n", knownCartridge_.generation, knownCartridge_.specificGenVersion, knownCartridge_.localization);
+    }
+
     // For MBC1 cartridges, we need to set the MBC1 banking mode to 1.
     // If we don't, we can't actually switch SRAM banks.
     // It looks like only the Japanese cartridges use MBC1 though.
@@ -315,6 +426,13 @@ bool TransferPakDetectionWidget::detectGameType()
     GameboyCartridgeHeader cartridgeHeader;
     TransferPakRomReader romReader(tpakManager_);
 
+    if(isKnownCartridge_)
+    {
+        gen1Type_ = (knownCartridge_.generation == 1) ? static_cast<Gen1GameType>(knownCartridge_.specificGenVersion) : Gen1GameType::INVALID;
+        gen2Type_ = (knownCartridge_.generation == 2) ? static_cast<Gen2GameType>(knownCartridge_.specificGenVersion) : Gen2GameType::INVALID;
+        return true;
+    }
+
     readGameboyCartridgeHeader(romReader, cartridgeHeader);
 
     gen1Type_ = gen1_determineGameType(cartridgeHeader);
@@ -376,14 +494,22 @@ void TransferPakDetectionWidget::updateCartridgeIcon()
         }
     }
 
-    if(labelSpritePath)
+    pendingLabelSpritePath_ = labelSpritePath;
+}
+
+void TransferPakDetectionWidget::loadPendingCartridgeLabel()
+{
+    if(!pendingLabelSpritePath_)
     {
-        if(cartridgeLabelSprite_)
-        {
-            sprite_free(cartridgeLabelSprite_);
-        }
-        cartridgeLabelSprite_ = sprite_load(labelSpritePath);
+        return;
+    }
+
+    if(cartridgeLabelSprite_)
+    {
+        sprite_free(cartridgeLabelSprite_);
     }
+    cartridgeLabelSprite_ = sprite_load(pendingLabelSpritePath_);
+    pendingLabelSpritePath_ = nullptr;
 }
 
 bool TransferPakDetectionWidget::validateGameSave()
@@ -392,15 +518,46 @@ bool TransferPakDetectionWidget::validateGameSave()
     TransferPakSaveManager saveManager(tpakManager_);
     if(gen1Type_ != Gen1GameType::INVALID)
     {
-        Gen1GameReader gen1Reader(romReader, saveManager, gen1Type_);
+        Gen1GameReader gen1Reader(romReader, saveManager, gen1Type_, static_cast<Gen1LocalizationLanguage>(localization_));
 
         return gen1Reader.isMainChecksumValid();
     }
     else if(gen2Type_ != Gen2GameType::INVALID)
     {
-        Gen2GameReader gen2Reader(romReader, saveManager, gen2Type_);
+        Gen2GameReader gen2Reader(romReader, saveManager, gen2Type_, static_cast<Gen2LocalizationLanguage>(localization_));
 
         return gen2Reader.isMainChecksumValid();
     }
     return false;
-}
\ No newline at end of file
+}
+
+bool TransferPakDetectionWidget::startGameSaveValidation()
+{
+    TransferPakRomReader romReader(tpakManager_);
+
+    if(isKnownCartridge_)
+    {
+        localization_ = knownCartridge_.localization;
+        return saveValidator_.start(knownCartridge_.generation, knownCartridge_.specificGenVersion, localization_);
+    }
+
+    // unknown cartridge: we need to probe the ROM to find out the language
+    if(gen1Type_ != Gen1GameType::INVALID)
+    {
+        const Gen1LocalizationLanguage language = gen1_determineGameLanguage(romReader, gen1Type_);
+        localization_ = static_cast<uint8_t>(language);
+        return saveValidator_.start(1, static_cast<uint8_t>(gen1Type_), static_cast<uint8_t>(language));
+    }
+    else if(gen2Type_ != Gen2GameType::INVALID)
+    {
+        const Gen2LocalizationLanguage language = gen2_determineGameLanguage(romReader, gen2Type_);
+        localization_ = static_cast<uint8_t>(language);
+        return saveValidator_.start(2, static_cast<uint8_t>(gen2Type_), static_cast<uint8_t>(language));
+    }
+    return false;
+}
+
+bool TransferPakDetectionWidget::stepGameSaveValidation()
+{
+    return saveValidator_.step(SAVE_VALIDATION_BYTES_PER_FRAME);
+}
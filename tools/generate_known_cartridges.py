@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+Generates include/core/KnownCartridges.h from tools/known_cartridges.csv.
+
+Usage:
+    generate_known_cartridges.py <known_cartridges.csv>  > include/core/KnownCartridges.h
+    generate_known_cartridges.py --from-dump <rom.gb(c)> <generation> <game> <language>
+
+The second form reads the header of a ROM dump and prints the matching csv row, so you can append it to the list.
+"""
+
+import sys
+
+TITLE_OFFSET = 0x134
+TITLE_SIZE = 15
+DESTINATION_CODE_OFFSET = 0x14A
+VERSION_NUMBER_OFFSET = 0x14C
+GLOBAL_CHECKSUM_OFFSET = 0x14E
+
+ANY_VERSION = 0xFF
+ANY_GLOBAL_CHECKSUM = 0x0000
+
+
+def escape_title(title_bytes):
+    """Encodes the raw title bytes the way they are written in the csv (NUL bytes before the end become \\0)"""
+    title = title_bytes.rstrip(b'\0')
+    return title.decode('ascii').replace('\0', '\\0')
+
+
+def unescape_title(title):
+    raw = title.replace('\\0', '\0').encode('ascii')
+    if len(raw) > TITLE_SIZE:
+        raise ValueError('title "%s" is longer than %d bytes' % (title, TITLE_SIZE))
+    return raw.ljust(TITLE_SIZE, b'\0')
+
+
+def row_from_dump(path, generation, game, language):
+    with open(path, 'rb') as f:
+        rom = f.read(0x150)
+
+    title = rom[TITLE_OFFSET:TITLE_OFFSET + TITLE_SIZE]
+    destination = rom[DESTINATION_CODE_OFFSET]
+    version = rom[VERSION_NUMBER_OFFSET]
+    global_checksum = (rom[GLOBAL_CHECKSUM_OFFSET] << 8) | rom[GLOBAL_CHECKSUM_OFFSET + 1]
+    return '%s,%d,%d,%04X,%s,%s,%s' % (escape_title(title), destination, version, global_checksum, generation, game, language)
+
+
+def c_string(raw):
+    result = '"'
+    for b in raw:
+        if b < 0x20 or b >= 0x7F:
+            # end the literal after the escape, otherwise the next character could be taken as part of the hex escape
+            result += '\\x%02X" "' % b
+        else:
+            result += chr(b)
+    return result + '"'
+
+
+def generate_header(csv_path):
+    entries = []
+    with open(csv_path, 'r') as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            title, destination, version, global_checksum, generation, game, language = line.split(',')
+            entries.append({
+                'title': unescape_title(title),
+                'destination': int(destination),
+                'version': ANY_VERSION if version == '*' else int(version),
+                'global_checksum': ANY_GLOBAL_CHECKSUM if global_checksum == '*' else int(global_checksum, 16),
+                'generation': int(generation),
+                'game': game,
+                'language': language
+            })
+
+    out = []
+    out.append('#ifndef _KNOWNCARTRIDGES_H')
+    out.append('#define _KNOWNCARTRIDGES_H')
+    out.append('')
+    out.append('// This file was generated by tools/generate_known_cartridges.py from tools/known_cartridges.csv. Don\'t edit it by hand!')
+    out.append('')
+    out.append('#include "gen1/Gen1Common.h"')
+    out.append('#include "gen2/Gen2Common.h"')
+    out.append('')
+    out.append('#define KNOWN_CARTRIDGE_TITLE_SIZE %d' % TITLE_SIZE)
+    out.append('#define KNOWN_CARTRIDGE_ANY_VERSION 0x%02X' % ANY_VERSION)
+    out.append('#define KNOWN_CARTRIDGE_ANY_GLOBAL_CHECKSUM 0x%04X' % ANY_GLOBAL_CHECKSUM)
+    out.append('')
+    out.append('/**')
+    out.append(' * @brief The cartridge header fields of a known retail cartridge and the game type/localization it maps to')
+    out.append(' */')
+    out.append('typedef struct KnownCartridge')
+    out.append('{')
+    out.append('    // the title field of the header, including the manufacturer code (0x134-0x142)')
+    out.append('    char title[KNOWN_CARTRIDGE_TITLE_SIZE + 1];')
+    out.append('    uint8_t destinationCode;')
+    out.append('    uint8_t versionNumber;')
+    out.append('    uint16_t globalChecksum;')
+    out.append('    uint8_t generation;')
+    out.append('    uint8_t specificGenVersion;')
+    out.append('    uint8_t localization;')
+    out.append('} KnownCartridge;')
+    out.append('')
+    out.append('#define KNOWN_CARTRIDGE_COUNT %d' % len(entries))
+    out.append('')
+    if not entries:
+        # a zero-sized array isn't valid C++
+        out.append('#endif')
+        return '\n'.join(out) + '\n'
+
+    out.append('static constexpr KnownCartridge knownCartridges[KNOWN_CARTRIDGE_COUNT] = {')
+    for i, entry in enumerate(entries):
+        gen_prefix = 'Gen%d' % entry['generation']
+        out.append('    {')
+        out.append('        .title = %s,' % c_string(entry['title'].rstrip(b'\0')))
+        out.append('        .destinationCode = %d,' % entry['destination'])
+        out.append('        .versionNumber = 0x%02X,' % entry['version'])
+        out.append('        .globalChecksum = 0x%04X,' % entry['global_checksum'])
+        out.append('        .generation = %d,' % entry['generation'])
+        out.append('        .specificGenVersion = static_cast<uint8_t>(%sGameType::%s),' % (gen_prefix, entry['game']))
+        out.append('        .localization = static_cast<uint8_t>(%sLocalizationLanguage::%s)' % (gen_prefix, entry['language']))
+        out.append('    }%s' % (',' if i < len(entries) - 1 else ''))
+    out.append('};')
+    out.append('')
+    out.append('#endif')
+    return '\n'.join(out) + '\n'
+
+
+def main(argv):
+    if len(argv) == 6 and argv[1] == '--from-dump':
+        print(row_from_dump(argv[2], argv[3], argv[4], argv[5]))
+        return 0
+    if len(argv) == 2:
+        sys.stdout.write(generate_header(argv[1]))
+        return 0
+    sys.stderr.write(__doc__)
+    return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))